@@ -0,0 +1,73 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <toolbox/bm.hpp>
+#include <toolbox/hdr.hpp>
+
+TOOLBOX_BENCHMARK_MAIN
+
+using namespace std;
+using namespace toolbox;
+
+namespace {
+
+constexpr double Percentiles[] = {50, 90, 99, 99.9, 99.99, 100};
+
+HdrHistogram make_histogram()
+{
+    HdrHistogram h{1, 3600LL * 1000 * 1000 * 1000, 5};
+    for (int64_t i{1}; i <= 100000; ++i) {
+        h.record_value(i * 1000);
+    }
+    return h;
+}
+
+TOOLBOX_BENCHMARK(hdr_value_at_percentile)
+{
+    auto h = make_histogram();
+    while (ctx) {
+        for (auto _ : ctx.range(10)) {
+            h.record_value(1);
+            for (const auto p : Percentiles) {
+                bm::do_not_optimise(value_at_percentile(h, p));
+            }
+        }
+    }
+}
+
+TOOLBOX_BENCHMARK(hdr_values_at_percentiles)
+{
+    auto h = make_histogram();
+    int64_t values[size(Percentiles)];
+    while (ctx) {
+        for (auto _ : ctx.range(10)) {
+            h.record_value(1);
+            values_at_percentiles(h, Percentiles, values, size(Percentiles));
+            bm::do_not_optimise(values[0]);
+        }
+    }
+}
+
+TOOLBOX_BENCHMARK(hdr_record_value)
+{
+    auto h = make_histogram();
+    while (ctx) {
+        for (auto _ : ctx.range(1000)) {
+            bm::do_not_optimise(h.record_value(12345));
+        }
+    }
+}
+
+} // namespace
@@ -0,0 +1,181 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <toolbox/http/FastParser.hpp>
+#include <toolbox/http/Stream.hpp>
+#include <toolbox/http/Writer.hpp>
+
+#include <toolbox/bm.hpp>
+
+#include <string>
+
+TOOLBOX_BENCHMARK_MAIN
+
+using namespace std;
+using namespace toolbox;
+
+namespace {
+
+// A typical browser request.
+constexpr auto Request =                                                                     //
+    "GET /api/v1/orders?symbol=EURUSD&limit=100 HTTP/1.1\r\n"                                //
+    "Host: www.reactivemarkets.com\r\n"                                                      //
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:78.0) Gecko/20100101 Firefox/78.0\r\n"   //
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"            //
+    "Accept-Language: en-GB,en;q=0.5\r\n"                                                    //
+    "Accept-Encoding: gzip, deflate, br\r\n"                                                 //
+    "Referer: https://www.reactivemarkets.com/trading\r\n"                                   //
+    "Cookie: session=3f2a8c1d9e7b4a6f; theme=dark; locale=en_GB\r\n"                         //
+    "Connection: keep-alive\r\n"                                                             //
+    "Cache-Control: max-age=0\r\n"                                                           //
+    "\r\n"sv;
+
+template <template <typename> class EngineT>
+class BenchParser : public EngineT<BenchParser<EngineT>> {
+    using Parser = EngineT<BenchParser<EngineT>>;
+    friend Parser;
+
+  public:
+    using Parser::Parser;
+    using Parser::parse;
+
+    size_t messages() const noexcept { return messages_; }
+
+  private:
+    bool on_message_begin(CyclTime now) noexcept { return true; }
+    bool on_url(CyclTime now, string_view sv) noexcept
+    {
+        bm::do_not_optimise(sv);
+        return true;
+    }
+    bool on_status(CyclTime now, string_view sv) noexcept { return true; }
+    bool on_header_field(CyclTime now, string_view sv, First first) noexcept
+    {
+        bm::do_not_optimise(sv);
+        return true;
+    }
+    bool on_header_value(CyclTime now, string_view sv, First first) noexcept
+    {
+        bm::do_not_optimise(sv);
+        return true;
+    }
+    bool on_headers_end(CyclTime now) noexcept { return true; }
+    bool on_body(CyclTime now, string_view sv) noexcept { return true; }
+    bool on_message_end(CyclTime now) noexcept
+    {
+        ++messages_;
+        return true;
+    }
+    bool on_chunk_header(CyclTime now, size_t len) noexcept { return true; }
+    bool on_chunk_end(CyclTime now) noexcept { return true; }
+
+    size_t messages_{0};
+};
+
+// Each operation parses one complete request.
+template <template <typename> class EngineT>
+void parse_whole(bm::BenchmarkCtx& ctx)
+{
+    BenchParser<EngineT> p{HttpType::Request};
+    const auto now = CyclTime::now();
+    while (ctx) {
+        for (auto _ : ctx.range(1000)) {
+            p.parse(now, {Request.data(), Request.size()});
+        }
+    }
+    bm::do_not_optimise(p.messages());
+}
+
+// Each operation parses one request that arrives in two reads, with unconsumed input retained
+// in the buffer, as it would be by a connection.
+template <template <typename> class EngineT>
+void parse_split(bm::BenchmarkCtx& ctx)
+{
+    BenchParser<EngineT> p{HttpType::Request};
+    const auto now = CyclTime::now();
+    const auto half = Request.size() / 2;
+    while (ctx) {
+        for (auto _ : ctx.range(1000)) {
+            const auto n = p.parse(now, {Request.data(), half});
+            p.parse(now, {Request.data() + n, Request.size() - n});
+        }
+    }
+    bm::do_not_optimise(p.messages());
+}
+
+TOOLBOX_BENCHMARK(http_parser_whole)
+{
+    parse_whole<BasicHttpParser>(ctx);
+}
+
+TOOLBOX_BENCHMARK(fast_parser_whole)
+{
+    parse_whole<BasicHttpFastParser>(ctx);
+}
+
+TOOLBOX_BENCHMARK(http_parser_split)
+{
+    parse_split<BasicHttpParser>(ctx);
+}
+
+TOOLBOX_BENCHMARK(fast_parser_split)
+{
+    parse_split<BasicHttpFastParser>(ctx);
+}
+
+// Each operation scans the request for control characters, one line at a time.
+TOOLBOX_BENCHMARK(fast_parser_find_ctl)
+{
+    const auto* const last = Request.data() + Request.size();
+    while (ctx) {
+        for (auto _ : ctx.range(1000)) {
+            for (const auto* p = Request.data(); p != last; ++p) {
+                p = detail::find_ctl(p, last);
+            }
+        }
+    }
+}
+
+// Each operation formats a small JSON response, and consumes it from the output buffer.
+TOOLBOX_BENCHMARK(http_stream_response)
+{
+    Buffer buf;
+    HttpStream os{buf};
+    while (ctx) {
+        for (auto i : ctx.range(1000)) {
+            os.http_status(HttpStatus::Ok, ApplicationJson);
+            os << "{\"id\":" << i << ",\"px\":" << 1.2345 << ",\"qty\":" << 1000000 << '}';
+            os.commit();
+            buf.consume(buf.size());
+        }
+    }
+}
+
+TOOLBOX_BENCHMARK(http_writer_response)
+{
+    Buffer buf;
+    HttpResponseWriter w{buf};
+    const auto now = WallClock::now();
+    while (ctx) {
+        for (auto i : ctx.range(1000)) {
+            w.http_status(now, HttpStatus::Ok, ApplicationJson);
+            w << "{\"id\":" << i << ",\"px\":" << 1.2345 << ",\"qty\":" << 1000000 << '}';
+            w.commit();
+            buf.consume(buf.size());
+        }
+    }
+}
+
+} // namespace
@@ -0,0 +1,124 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <toolbox/bm.hpp>
+#include <toolbox/sys/LogFormat.hpp>
+#include <toolbox/util/Finally.hpp>
+
+#include <fcntl.h>
+
+TOOLBOX_BENCHMARK_MAIN
+
+using namespace std;
+using namespace toolbox;
+
+namespace {
+
+/// Redirect standard error, and therefore std_logger output, to /dev/null for the lifetime of the
+/// object.
+struct DevNull {
+    DevNull()
+    : fd{::open("/dev/null", O_WRONLY)}
+    , prev_fd{::dup(STDERR_FILENO)}
+    , prev_level{set_log_level(Log::Info)}
+    , prev_logger{set_logger(std_logger)}
+    {
+        ::dup2(fd, STDERR_FILENO);
+    }
+    ~DevNull()
+    {
+        ::dup2(prev_fd, STDERR_FILENO);
+        set_log_level(prev_level);
+        set_logger(prev_logger);
+        ::close(prev_fd);
+        ::close(fd);
+    }
+    int fd, prev_fd, prev_level;
+    Logger prev_logger;
+};
+
+template <LogTimeFormat FormatN>
+void log_header(bm::BenchmarkCtx& ctx)
+{
+    const auto prev_format = set_log_time_format(FormatN);
+    const auto finally
+        = make_finally([prev_format]() noexcept { set_log_time_format(prev_format); });
+    char buf[MaxLogHeader + 1];
+    while (ctx) {
+        for (auto _ : ctx.range(1000)) {
+            bm::do_not_optimise(format_log_header(buf, WallClock::now(), Log::Info, 12345));
+        }
+    }
+}
+
+TOOLBOX_BENCHMARK(log_header_local)
+{
+    log_header<LogTimeFormat::Local>(ctx);
+}
+
+TOOLBOX_BENCHMARK(log_header_iso8601)
+{
+    log_header<LogTimeFormat::Iso8601>(ctx);
+}
+
+TOOLBOX_BENCHMARK(log_header_epoch_ns)
+{
+    log_header<LogTimeFormat::EpochNs>(ctx);
+}
+
+TOOLBOX_BENCHMARK(std_logger_stream)
+{
+    DevNull dev_null;
+    while (ctx) {
+        for (auto _ : ctx.range(1000)) {
+            TOOLBOX_LOG(Log::Info) << "order " << 12345 << " filled at " << 101.25;
+        }
+    }
+}
+
+TOOLBOX_BENCHMARK(std_logger_logf)
+{
+    DevNull dev_null;
+    while (ctx) {
+        for (auto _ : ctx.range(1000)) {
+            TOOLBOX_LOGF(Log::Info, "order {} filled at {}", 12345, 101.25);
+        }
+    }
+}
+
+TOOLBOX_BENCHMARK(async_logger_stream)
+{
+    DevNull dev_null;
+    AsyncLogger logger{{1 << 24, Millis{1}, dev_null.fd, false, {"logger"}}};
+    while (ctx) {
+        for (auto _ : ctx.range(1000)) {
+            TOOLBOX_LOG(Log::Info) << "order " << 12345 << " filled at " << 101.25;
+        }
+    }
+}
+
+TOOLBOX_BENCHMARK(async_logger_logf)
+{
+    DevNull dev_null;
+    AsyncLogger logger{{1 << 24, Millis{1}, dev_null.fd, false, {"logger"}}};
+    while (ctx) {
+        for (auto _ : ctx.range(1000)) {
+            TOOLBOX_LOGF(Log::Info, "order {} filled at {}", 12345, 101.25);
+        }
+    }
+}
+
+} // namespace
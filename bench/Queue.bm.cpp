@@ -0,0 +1,129 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <toolbox/ipc/MagicRingBuffer.hpp>
+#include <toolbox/ipc/MpmcQueue.hpp>
+
+#include <toolbox/bm.hpp>
+
+TOOLBOX_BENCHMARK_MAIN
+
+using namespace std;
+using namespace toolbox;
+
+namespace {
+
+inline int64_t now_ns() noexcept
+{
+    return MonoClock::now().time_since_epoch().count();
+}
+
+// Producers send timestamps, and consumers record the one-way latency of each message. The latency
+// benchmarks send one message at a time; the throughput benchmarks send as fast as possible, so
+// that latency includes queuing, and the reported ops/s is the delivered message rate.
+
+void mpmc_push(bm::BenchmarkCtx& ctx, MpmcQueue<int64_t>& q, bool wait_empty)
+{
+    while (ctx) {
+        if (wait_empty && !q.empty()) {
+            continue;
+        }
+        q.push(now_ns());
+    }
+}
+
+void mpmc_pop(bm::BenchmarkCtx& ctx, MpmcQueue<int64_t>& q)
+{
+    int64_t ts;
+    while (ctx) {
+        if (q.pop(ts)) {
+            ctx.record(now_ns() - ts);
+        }
+    }
+}
+
+TOOLBOX_BENCHMARK(mpmc_queue_latency)
+{
+    MpmcQueue<int64_t> q{1024};
+    bm::BenchmarkThreads threads{ctx};
+    threads.add("producer", [&q](auto& ctx) { mpmc_push(ctx, q, true); });
+    threads.add("consumer", [&q](auto& ctx) { mpmc_pop(ctx, q); });
+    threads.run();
+}
+
+TOOLBOX_BENCHMARK(mpmc_queue_throughput)
+{
+    MpmcQueue<int64_t> q{1024};
+    bm::BenchmarkThreads threads{ctx};
+    threads.add("producer", [&q](auto& ctx) { mpmc_push(ctx, q, false); });
+    threads.add("consumer", [&q](auto& ctx) { mpmc_pop(ctx, q); });
+    threads.run();
+}
+
+TOOLBOX_BENCHMARK(mpmc_queue_throughput_2x2)
+{
+    MpmcQueue<int64_t> q{1024};
+    bm::BenchmarkThreads threads{ctx};
+    threads.add("producer", 2, [&q](auto& ctx) { mpmc_push(ctx, q, false); });
+    threads.add("consumer", 2, [&q](auto& ctx) { mpmc_pop(ctx, q); });
+    threads.run();
+}
+
+void ring_write(bm::BenchmarkCtx& ctx, MagicRingBuffer& rb, bool wait_empty)
+{
+    while (ctx) {
+        if (wait_empty && !rb.empty()) {
+            continue;
+        }
+        rb.write(now_ns());
+    }
+}
+
+void ring_read(bm::BenchmarkCtx& ctx, MagicRingBuffer& rb)
+{
+    while (ctx) {
+        // Consume all whole messages that are available.
+        rb.read(sizeof(int64_t), [&ctx](const char* data, size_t len) noexcept {
+            const auto now = now_ns();
+            const auto n = len / sizeof(int64_t);
+            for (size_t i{0}; i < n; ++i) {
+                int64_t ts;
+                memcpy(&ts, data + i * sizeof(ts), sizeof(ts));
+                ctx.record(now - ts);
+            }
+            return n * sizeof(int64_t);
+        });
+    }
+}
+
+TOOLBOX_BENCHMARK(magic_ring_buffer_latency)
+{
+    MagicRingBuffer rb{PageSize};
+    bm::BenchmarkThreads threads{ctx};
+    threads.add("writer", [&rb](auto& ctx) { ring_write(ctx, rb, true); });
+    threads.add("reader", [&rb](auto& ctx) { ring_read(ctx, rb); });
+    threads.run();
+}
+
+TOOLBOX_BENCHMARK(magic_ring_buffer_throughput)
+{
+    MagicRingBuffer rb{PageSize};
+    bm::BenchmarkThreads threads{ctx};
+    threads.add("writer", [&rb](auto& ctx) { ring_write(ctx, rb, false); });
+    threads.add("reader", [&rb](auto& ctx) { ring_read(ctx, rb); });
+    threads.run();
+}
+
+} // namespace
@@ -0,0 +1,133 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <toolbox/io/EventFd.hpp>
+#include <toolbox/io/MultiReactor.hpp>
+#include <toolbox/ipc/MpmcQueue.hpp>
+
+#include <toolbox/bm.hpp>
+
+#include <poll.h>
+
+TOOLBOX_BENCHMARK_MAIN
+
+using namespace std;
+using namespace toolbox;
+
+namespace {
+
+inline int64_t now_ns() noexcept
+{
+    return MonoClock::now().time_since_epoch().count();
+}
+
+// Wakeup benchmarks measure the one-way latency from a producer signalling an event, to a
+// consumer that is blocked waiting for it, being woken and handling the event.
+
+/// A queue of timestamps with an eventfd used to wake the consumer.
+struct Channel {
+    MpmcQueue<int64_t> q{1024};
+    EventFd efd{0, EFD_NONBLOCK};
+
+    void send(bool wait_empty)
+    {
+        if (!wait_empty || q.empty()) {
+            q.push(now_ns());
+            efd.write(1);
+        }
+    }
+    void drain(bm::BenchmarkCtx& ctx) noexcept
+    {
+        int64_t ts;
+        while (q.pop(ts)) {
+            ctx.record(now_ns() - ts);
+        }
+    }
+};
+
+void send_loop(bm::BenchmarkCtx& ctx, Channel& ch, bool wait_empty)
+{
+    while (ctx) {
+        ch.send(wait_empty);
+    }
+}
+
+void eventfd_wait_loop(bm::BenchmarkCtx& ctx, Channel& ch)
+{
+    pollfd pfd{ch.efd.fd(), POLLIN, 0};
+    while (ctx) {
+        // The timeout bounds the time taken to observe a stop request.
+        if (::poll(&pfd, 1, 10) > 0) {
+            ch.efd.read();
+            ch.drain(ctx);
+        }
+    }
+}
+
+TOOLBOX_BENCHMARK(eventfd_wakeup_latency)
+{
+    Channel ch;
+    bm::BenchmarkThreads threads{ctx};
+    threads.add("producer", [&ch](auto& ctx) { send_loop(ctx, ch, true); });
+    threads.add("consumer", [&ch](auto& ctx) { eventfd_wait_loop(ctx, ch); });
+    threads.run();
+}
+
+/// A consumer reactor that is woken by the channel's eventfd.
+struct ReactorConsumer {
+    explicit ReactorConsumer(Channel& ch)
+    : ch{ch}
+    {
+    }
+    void run(bm::BenchmarkCtx& ctx)
+    {
+        this->ctx = &ctx;
+        auto sub = reactor.handle(ch.efd.fd());
+        sub.add(PollEvents::Read, bind<&ReactorConsumer::on_io_event>(this));
+        while (ctx) {
+            reactor.poll(CyclTime::now(), 10ms);
+        }
+    }
+    void on_io_event(CyclTime now, int fd, PollEvents events)
+    {
+        ch.efd.read();
+        ch.drain(*ctx);
+    }
+    Channel& ch;
+    os::Reactor reactor{1024};
+    bm::BenchmarkCtx* ctx{nullptr};
+};
+
+TOOLBOX_BENCHMARK(reactor_wakeup_latency)
+{
+    Channel ch;
+    ReactorConsumer consumer{ch};
+    bm::BenchmarkThreads threads{ctx};
+    threads.add("producer", [&ch](auto& ctx) { send_loop(ctx, ch, true); });
+    threads.add("consumer", [&consumer](auto& ctx) { consumer.run(ctx); });
+    threads.run();
+}
+
+TOOLBOX_BENCHMARK(reactor_wakeup_throughput)
+{
+    Channel ch;
+    ReactorConsumer consumer{ch};
+    bm::BenchmarkThreads threads{ctx};
+    threads.add("producer", [&ch](auto& ctx) { send_loop(ctx, ch, false); });
+    threads.add("consumer", [&consumer](auto& ctx) { consumer.run(ctx); });
+    threads.run();
+}
+
+} // namespace
@@ -0,0 +1,65 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <toolbox/io/File.hpp>
+#include <toolbox/sys/LogFormat.hpp>
+
+#include <iostream>
+
+using namespace std;
+using namespace toolbox;
+
+namespace {
+
+/// Convert a binary log, as written by an AsyncLogger in binary mode, to text.
+void decode(int fd)
+{
+    LogDecoder decoder;
+    string in, out;
+    char buf[1 << 16];
+    for (;;) {
+        const auto n = os::read(fd, buf, sizeof(buf));
+        if (n == 0) {
+            break;
+        }
+        in.append(buf, n);
+        in.erase(0, decoder.decode(in, out));
+        cout << out;
+        out.clear();
+    }
+    if (!in.empty()) {
+        throw runtime_error{"truncated log"};
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    int ret = 1;
+    try {
+        if (argc < 2) {
+            decode(STDIN_FILENO);
+        }
+        for (int i{1}; i < argc; ++i) {
+            decode(os::open(argv[i], O_RDONLY).get());
+        }
+        ret = 0;
+    } catch (const std::exception& e) {
+        cerr << "exception: " << e.what() << endl;
+    }
+    return ret;
+}
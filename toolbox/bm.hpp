@@ -17,10 +17,12 @@
 #define TOOLBOX_BM_HPP
 
 #include "bm/Benchmark.hpp"
+#include "bm/Counters.hpp"
 #include "bm/Ctx.hpp"
 #include "bm/Range.hpp"
 #include "bm/Record.hpp"
 #include "bm/Suite.hpp"
+#include "bm/Threads.hpp"
 #include "bm/Utility.hpp"
 
 #endif // TOOLBOX_BM_HPP
@@ -47,7 +47,7 @@ class BenchmarkStore {
             os << runnable.first << '\n';
         }
     }
-    void run(ostream& os, const string& regex_str, bool randomise)
+    void run(ostream& os, const BenchmarkConfig& config, const string& regex_str, bool randomise)
     {
         vector<Benchmark*> filtered;
 
@@ -64,7 +64,7 @@ class BenchmarkStore {
         }
 
         if (!filtered.empty()) {
-            BenchmarkSuite suite{os, 1000.0};
+            BenchmarkSuite suite{os, config};
             for (auto* bm : filtered) {
                 suite.run(bm->name, bm->fn);
             }
@@ -87,6 +87,22 @@ Benchmark::Benchmark(const char* name, void (*fn)(BenchmarkCtx&))
 }
 
 namespace detail {
+namespace {
+BenchmarkFormat parse_format(string_view s)
+{
+    if (s == "text") {
+        return BenchmarkFormat::Text;
+    }
+    if (s == "json") {
+        return BenchmarkFormat::Json;
+    }
+    if (s == "csv") {
+        return BenchmarkFormat::Csv;
+    }
+    throw invalid_argument{"invalid format: "s + string{s}};
+}
+} // namespace
+
 int main(int argc, char* argv[])
 {
     int ret = 1;
@@ -94,6 +110,12 @@ int main(int argc, char* argv[])
         string regex;
         bool list{false};
         bool randomise{false};
+        int64_t warmup_ms{0};
+        int64_t duration_ms{3000};
+        string format{"text"};
+
+        BenchmarkConfig config;
+        config.value_scale = 1000.0;
 
         Options opts{"benchmark options [options]"};
         // clang-format off
@@ -101,17 +123,32 @@ int main(int argc, char* argv[])
             ('l', "list", Switch{list}, "list available benchmarks")
             ('h', "help", Help{})
             ('r', "random", Switch{randomise}, "run benchmarks in random order")
+            ('w', "warmup", Value{warmup_ms}, "warmup period in milliseconds (default 0)")
+            ('d', "duration", Value{duration_ms}, "duration of each repetition in milliseconds"
+             " (default 3000)")
+            ('n', "iterations", Value{config.iterations}, "run each repetition for a number of"
+             " iterations instead of a duration")
+            ('R', "repetitions", Value{config.repetitions}, "number of repetitions (default 1)")
+            ('c', "cpu", Value{config.thread.affinity}, "pin to isolcpus-style set of CPUs")
+            ('o', "format", Value{format}, "output format: text, json or csv (default text)")
+            ('p', "perf", Switch{config.counters}, "report hardware performance counters")
             ;
         // clang-format on
 
         opts.parse(argc, argv);
+        if (config.repetitions < 1) {
+            throw invalid_argument{"invalid repetitions"};
+        }
+        config.warmup = Millis{warmup_ms};
+        config.duration = Millis{duration_ms};
+        config.format = parse_format(format);
 
         auto& store = BenchmarkStore::instance();
         if (list) {
             store.list(cout);
             return 0;
         }
-        store.run(cout, regex, randomise);
+        store.run(cout, config, regex, randomise);
         ret = 0;
     } catch (const exception& e) {
         cerr << "error: " << e.what();
@@ -0,0 +1,160 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Counters.hpp"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#include <cstring>
+
+namespace toolbox::bm {
+using namespace std;
+namespace {
+
+#if defined(__linux__)
+struct EventType {
+    uint32_t type;
+    uint64_t config;
+};
+
+constexpr EventType EventTypes[NumPerfEvents] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+};
+
+int perf_event_open(const EventType& et) noexcept
+{
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = et.type;
+    attr.config = et.config;
+    attr.disabled = 1;
+    // Hardware events in user space only, which is permitted at the default perf_event_paranoid
+    // level. Context switches always occur in the kernel.
+    attr.exclude_kernel = et.type == PERF_TYPE_HARDWARE;
+    attr.exclude_hv = 1;
+    // Include threads subsequently created by the calling thread, such as benchmark workers.
+    attr.inherit = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // Calling thread on any CPU.
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
+#endif
+
+} // namespace
+
+const char* enum_string(PerfEvent event) noexcept
+{
+    switch (event) {
+    case PerfEvent::Cycles:
+        return "cycles";
+    case PerfEvent::Instructions:
+        return "instructions";
+    case PerfEvent::CacheMisses:
+        return "cache_misses";
+    case PerfEvent::BranchMisses:
+        return "branch_misses";
+    case PerfEvent::ContextSwitches:
+        return "context_switches";
+    }
+    return "unknown";
+}
+
+PerfCounters::PerfCounters() noexcept
+{
+#if defined(__linux__)
+    for (size_t i{0}; i < NumPerfEvents; ++i) {
+        // A failure leaves the handle invalid, and the event unavailable.
+        if (const auto fd = perf_event_open(EventTypes[i]); fd >= 0) {
+            fds_[i] = FileHandle{fd};
+        }
+    }
+#endif
+}
+
+PerfCounters::~PerfCounters() = default;
+
+bool PerfCounters::available() const noexcept
+{
+    for (const auto& fd : fds_) {
+        if (fd.get() != FileHandle::invalid()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PerfCounters::start() noexcept
+{
+#if defined(__linux__)
+    for (const auto& fd : fds_) {
+        if (fd.get() != FileHandle::invalid()) {
+            ::ioctl(fd.get(), PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(fd.get(), PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+void PerfCounters::stop() noexcept
+{
+#if defined(__linux__)
+    for (const auto& fd : fds_) {
+        if (fd.get() != FileHandle::invalid()) {
+            ::ioctl(fd.get(), PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+#endif
+}
+
+PerfCounters::Counts PerfCounters::read() const noexcept
+{
+    Counts counts;
+    counts.fill(-1);
+#if defined(__linux__)
+    for (size_t i{0}; i < NumPerfEvents; ++i) {
+        const auto fd = fds_[i].get();
+        if (fd == FileHandle::invalid()) {
+            continue;
+        }
+        // Value, time enabled and time running.
+        uint64_t buf[3];
+        if (::read(fd, buf, sizeof(buf)) != sizeof(buf)) {
+            continue;
+        }
+        if (buf[2] == 0) {
+            // The event was never scheduled, so the count is unknown.
+            continue;
+        }
+        if (buf[2] < buf[1]) {
+            // Extrapolate multiplexed counts over the time enabled.
+            counts[i] = static_cast<int64_t>(static_cast<double>(buf[0]) * buf[1] / buf[2]);
+        } else {
+            counts[i] = buf[0];
+        }
+    }
+#endif
+    return counts;
+}
+
+} // namespace toolbox::bm
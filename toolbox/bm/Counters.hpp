@@ -0,0 +1,84 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOOLBOX_BM_COUNTERS_HPP
+#define TOOLBOX_BM_COUNTERS_HPP
+
+#include <toolbox/io/Handle.hpp>
+
+#include <array>
+#include <cstdint>
+
+namespace toolbox::bm {
+
+enum class PerfEvent : int {
+    Cycles,
+    Instructions,
+    CacheMisses,
+    BranchMisses,
+    ContextSwitches
+};
+
+constexpr std::size_t NumPerfEvents{5};
+
+/// Returns the name of the event, as used in benchmark reports.
+TOOLBOX_API const char* enum_string(PerfEvent event) noexcept;
+
+/// Hardware and software performance counters for the calling thread, and any threads that it
+/// subsequently creates, based on perf_event_open.
+///
+/// Each event is opened independently, so that events that are not supported or not permitted,
+/// for example hardware events inside a virtual machine, or all events when perf_event_paranoid
+/// is too restrictive, are simply unavailable rather than causing an error. Counts are scaled to
+/// compensate for multiplexing when there are more events than hardware counters.
+class TOOLBOX_API PerfCounters {
+  public:
+    using Counts = std::array<std::int64_t, NumPerfEvents>;
+
+    PerfCounters() noexcept;
+    ~PerfCounters();
+
+    // Copy.
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // Move.
+    PerfCounters(PerfCounters&&) = delete;
+    PerfCounters& operator=(PerfCounters&&) = delete;
+
+    /// Returns true if any event is available.
+    bool available() const noexcept;
+    /// Returns true if the event is available.
+    bool available(PerfEvent event) const noexcept
+    {
+        return fds_[static_cast<int>(event)].get() != FileHandle::invalid();
+    }
+
+    /// Reset and start the counters.
+    void start() noexcept;
+    /// Stop the counters.
+    void stop() noexcept;
+
+    /// Returns the counts accumulated between start() and stop(). The count for an unavailable
+    /// event is -1.
+    Counts read() const noexcept;
+
+  private:
+    std::array<FileHandle, NumPerfEvents> fds_;
+};
+
+} // namespace toolbox::bm
+
+#endif // TOOLBOX_BM_COUNTERS_HPP
@@ -17,16 +17,27 @@
 #define TOOLBOX_BM_CTX
 
 #include <toolbox/bm/Range.hpp>
+#include <toolbox/hdr/Histogram.hpp>
 #include <toolbox/util/Alarm.hpp>
 
+#include <algorithm>
 #include <atomic>
+#include <limits>
 
 namespace toolbox::bm {
 
 class TOOLBOX_API BenchmarkCtx {
   public:
-    explicit BenchmarkCtx(HdrHistogram& hist)
+    /// \param hist The histogram that operations are recorded to.
+    /// \param max_count The context stops once this many operations have been recorded.
+    /// \param total If set, the operation count shared by concurrent contexts, which all stop once
+    /// they have recorded max_count operations between them.
+    explicit BenchmarkCtx(HdrHistogram& hist,
+                          std::int64_t max_count = std::numeric_limits<std::int64_t>::max(),
+                          std::atomic<std::int64_t>* total = nullptr)
     : hist_{hist}
+    , max_count_{max_count}
+    , total_{total}
     {
     }
     ~BenchmarkCtx();
@@ -39,14 +50,41 @@ class TOOLBOX_API BenchmarkCtx {
     BenchmarkCtx(BenchmarkCtx&&) = delete;
     BenchmarkCtx& operator=(BenchmarkCtx&&) = delete;
 
-    explicit operator bool() const noexcept { return !stop_; }
-    BenchmarkRange range(int first, int last) const noexcept { return {hist_, first, last}; }
-    BenchmarkRange range(int count) const noexcept { return {hist_, 0, count}; }
+    explicit operator bool() const noexcept
+    {
+        return !stop_.load(std::memory_order_relaxed) && count() < max_count_;
+    }
+    HdrHistogram& hist() const noexcept { return hist_; }
+    std::int64_t max_count() const noexcept { return max_count_; }
+    /// Returns the number of operations recorded, including those of concurrent contexts that share
+    /// the total.
+    std::int64_t count() const noexcept
+    {
+        return total_ ? total_->load(std::memory_order_relaxed) : hist_.total_count();
+    }
 
+    BenchmarkRange range(int first, int last) noexcept { return {*this, first, last}; }
+    BenchmarkRange range(int count) noexcept { return {*this, 0, count}; }
+
+    /// Records a value, such as a latency in nanoseconds, for operations timed by the caller.
+    void record(std::int64_t value, std::int64_t count = 1) noexcept
+    {
+        if (total_) {
+            // Claim the operations from the shared total, and drop any beyond max_count.
+            const auto prev = total_->fetch_add(count, std::memory_order_relaxed);
+            count = std::min(count, max_count_ - prev);
+            if (count <= 0) {
+                return;
+            }
+        }
+        hist_.record_values(value, count);
+    }
     void stop() noexcept { stop_ = true; }
 
   private:
     HdrHistogram& hist_;
+    const std::int64_t max_count_;
+    std::atomic<std::int64_t>* const total_;
     std::atomic_bool stop_{false};
 };
 
@@ -15,15 +15,15 @@
 
 #include "Range.hpp"
 
-#include <toolbox/hdr/Histogram.hpp>
+#include "Ctx.hpp"
 
 #include <cassert>
 
 namespace toolbox::bm {
 using namespace std;
 
-BenchmarkRange::BenchmarkRange(HdrHistogram& hist, int first, int last) noexcept
-: hist_{hist}
+BenchmarkRange::BenchmarkRange(BenchmarkCtx& ctx, int first, int last) noexcept
+: ctx_{ctx}
 , first_{first}
 , last_{last}
 , start_{chrono::high_resolution_clock::now()}
@@ -37,7 +37,7 @@ BenchmarkRange::~BenchmarkRange()
     const auto elapsed = chrono::duration_cast<chrono::nanoseconds>(end - start_);
     const auto count = last_ - first_;
     // Record average.
-    hist_.record_values(elapsed.count() / count, count);
+    ctx_.record(elapsed.count() / count, count);
 }
 
 } // namespace toolbox::bm
@@ -20,17 +20,12 @@
 
 #include <chrono>
 
-namespace toolbox {
-inline namespace hdr {
-class HdrHistogram;
-} // namespace hdr
-} // namespace toolbox
-
 namespace toolbox::bm {
+class BenchmarkCtx;
 
 /// The BenchmarkRange class records the time elapsed during object lifetime,
 /// i.e., between construction and destruction.
-/// The elapsed time is recorded in the HdrHistogram object during destruction.
+/// The elapsed time is recorded in the BenchmarkCtx object during destruction.
 class TOOLBOX_API BenchmarkRange {
     class Iterator {
         friend constexpr bool operator==(Iterator lhs, Iterator rhs) noexcept
@@ -59,7 +54,7 @@ class TOOLBOX_API BenchmarkRange {
     };
 
   public:
-    BenchmarkRange(HdrHistogram& hist, int first, int last) noexcept;
+    BenchmarkRange(BenchmarkCtx& ctx, int first, int last) noexcept;
     ~BenchmarkRange();
 
     // Copy.
@@ -74,7 +69,7 @@ class TOOLBOX_API BenchmarkRange {
     auto end() const noexcept { return Iterator{last_}; }
 
   private:
-    HdrHistogram& hist_;
+    BenchmarkCtx& ctx_;
     const int first_;
     const int last_;
     std::chrono::time_point<std::chrono::high_resolution_clock> start_;
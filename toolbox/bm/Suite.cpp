@@ -15,39 +15,243 @@
 
 #include "Suite.hpp"
 
-#include <sstream>
-#include <iomanip>
-#include <boost/io/ios_state.hpp>
 #include <toolbox/hdr/Utility.hpp>
+#include <toolbox/sys/Log.hpp>
+#include <toolbox/util/Math.hpp>
+
+#include <boost/io/ios_state.hpp>
+
+#include <iomanip>
+#include <sstream>
 
 namespace toolbox::bm {
 using namespace std;
+namespace {
+
+constexpr double Percentiles[] = {50, 95, 99, 99.9, 99.99};
+constexpr size_t NumPercentiles{size(Percentiles)};
+
+void put_json_string(ostream& os, string_view s)
+{
+    os << '"';
+    for (const char c : s) {
+        if (c == '"' || c == '\\') {
+            os << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            os << "\\u" << hex << setw(4) << setfill('0') << static_cast<int>(c) << dec
+               << setfill(' ');
+        } else {
+            os << c;
+        }
+    }
+    os << '"';
+}
+
+} // namespace
+
+struct BenchmarkSuite::Result {
+    explicit Result(const char* name)
+    : name{name}
+    {
+    }
+    const char* name;
+    HdrHistogram hist{1, 1'000'000'000, 5};
+    /// Operations per second for each repetition.
+    VarAccum ops_per_sec;
+    /// Counter totals over all repetitions, or -1 if unavailable.
+    PerfCounters::Counts counts{};
+};
 
-BenchmarkSuite::BenchmarkSuite(std::ostream& os, double value_scale)
+BenchmarkSuite::BenchmarkSuite(ostream& os, const BenchmarkConfig& config)
 : os_{os}
-, value_scale_{value_scale}
+, config_{config}
 {
+    set_thread_attrs(config_.thread);
+    if (config_.counters) {
+        counters_ = make_unique<PerfCounters>();
+        if (!counters_->available()) {
+            TOOLBOX_WARNING << "performance counters unavailable; check perf_event_paranoid";
+        }
+    }
+
     boost::io::ios_all_saver all_saver{os};
+    switch (config_.format) {
+    case BenchmarkFormat::Text:
+        // clang-format off
+        os << left << setw(45) << "NAME"
+           << right << setw(15) << "COUNT"
+           << right << setw(10) << "MIN"
+           << right << setw(10) << "%50"
+           << right << setw(10) << "%95"
+           << right << setw(10) << "%99"
+           << right << setw(10) << "%99.9"
+           << right << setw(10) << "%99.99"
+           << right << setw(15) << "OPS/S"
+           << right << setw(10) << "RSD%"
+           << endl;
+        // clang-format on
+
+        // Separator.
+        os << setw(145) << setfill('-') << '-' << setfill(' ') << endl;
+        break;
+    case BenchmarkFormat::Json:
+        os << "{\"benchmarks\":[";
+        break;
+    case BenchmarkFormat::Csv:
+        os << "name,repetitions,count,min,p50,p95,p99,p99.9,p99.99,max,ops_per_sec,ops_per_sec_sd";
+        if (config_.counters) {
+            for (size_t i{0}; i < NumPerfEvents; ++i) {
+                os << ',' << enum_string(static_cast<PerfEvent>(i));
+            }
+        }
+        os << endl;
+        break;
+    }
+}
 
-    // clang-format off
-    os << left << setw(45) << "NAME"
-       << right << setw(15) << "COUNT"
-       << right << setw(10) << "MIN"
-       << right << setw(10) << "%50"
-       << right << setw(10) << "%95"
-       << right << setw(10) << "%99"
-       << right << setw(10) << "%99.9"
-       << right << setw(10) << "%99.99"
-       << endl;
-    // clang-format on
-
-    // Separator.
-    os << setw(120) << setfill('-') << '-' << setfill(' ') << endl;
+BenchmarkSuite::BenchmarkSuite(ostream& os, double value_scale)
+: BenchmarkSuite{os, [value_scale]() {
+                     BenchmarkConfig config;
+                     config.value_scale = value_scale;
+                     return config;
+                 }()}
+{
+}
+
+BenchmarkSuite::~BenchmarkSuite()
+{
+    if (config_.format == BenchmarkFormat::Json) {
+        os_ << "\n]}" << endl;
+    }
 }
 
-void BenchmarkSuite::report(const char* name, HdrHistogram& h)
+void BenchmarkSuite::run(const char* name, const function<void(BenchmarkCtx&)>& fn)
 {
-    os_ << h.report(false, name, value_scale_);
+    if (config_.warmup > Duration::zero()) {
+        HdrHistogram hist{1, 1'000'000'000, 5};
+        BenchmarkCtx ctx{hist};
+        Alarm alarm{config_.warmup, [&ctx]() { ctx.stop(); }};
+        fn(ctx);
+    }
+    Result result{name};
+    for (int i{0}; i < config_.repetitions; ++i) {
+        HdrHistogram hist{1, 1'000'000'000, 5};
+        if (counters_) {
+            counters_->start();
+        }
+        const auto start = MonoClock::now();
+        if (config_.iterations > 0) {
+            BenchmarkCtx ctx{hist, config_.iterations};
+            fn(ctx);
+        } else {
+            BenchmarkCtx ctx{hist};
+            Alarm alarm{config_.duration, [&ctx]() { ctx.stop(); }};
+            fn(ctx);
+        }
+        const chrono::duration<double> elapsed{MonoClock::now() - start};
+        if (counters_) {
+            counters_->stop();
+            const auto counts = counters_->read();
+            for (size_t j{0}; j < NumPerfEvents; ++j) {
+                auto& total = result.counts[j];
+                total = counts[j] < 0 || total < 0 ? -1 : total + counts[j];
+            }
+        }
+        if (elapsed.count() > 0) {
+            result.ops_per_sec.append(hist.total_count() / elapsed.count());
+        }
+        result.hist.add(hist);
+    }
+    report(result);
+}
+
+void BenchmarkSuite::report(const Result& result)
+{
+    const auto& h = result.hist;
+    int64_t values[NumPercentiles];
+    values_at_percentiles(h, Percentiles, values, NumPercentiles);
+
+    const auto ops = result.ops_per_sec.mean();
+    // The sample standard deviation is undefined for a single repetition.
+    const auto sd = result.ops_per_sec.size() > 1 ? stdev(result.ops_per_sec) : 0.0;
+
+    // Counts per operation, or negative if unavailable.
+    double per_op[NumPerfEvents];
+    for (size_t i{0}; i < NumPerfEvents; ++i) {
+        const auto n = result.counts[i];
+        per_op[i] = n < 0 || h.total_count() == 0 ? -1.0 : double(n) / h.total_count();
+    }
+    const bool counters{counters_ && counters_->available()};
+
+    boost::io::ios_all_saver all_saver{os_};
+    switch (config_.format) {
+    case BenchmarkFormat::Text:
+        os_ << left << setw(45) << result.name << right << setw(15) << h.total_count()
+            << setw(10) << h.min() / config_.value_scale;
+        for (const auto v : values) {
+            os_ << setw(10) << v / config_.value_scale;
+        }
+        os_ << fixed << setprecision(0) << setw(15) << ops << setprecision(2) << setw(10)
+            << (ops > 0 ? 100.0 * sd / ops : 0.0) << endl;
+        if (counters) {
+            // Counters per operation on a separate line.
+            os_ << defaultfloat << setprecision(6) << "   ";
+            for (size_t i{0}; i < NumPerfEvents; ++i) {
+                if (per_op[i] >= 0) {
+                    os_ << ' ' << enum_string(static_cast<PerfEvent>(i)) << '=' << per_op[i];
+                }
+            }
+            os_ << endl;
+        }
+        break;
+    case BenchmarkFormat::Json:
+        // Latencies are reported in nanoseconds, regardless of the value scale.
+        os_ << (first_ ? "\n" : ",\n") << "{\"name\":";
+        put_json_string(os_, result.name);
+        os_ << ",\"repetitions\":" << config_.repetitions //
+            << ",\"count\":" << h.total_count()            //
+            << ",\"min\":" << h.min()                      //
+            << ",\"percentiles\":{";
+        for (size_t i{0}; i < NumPercentiles; ++i) {
+            os_ << (i > 0 ? ",\"" : "\"") << Percentiles[i] << "\":" << values[i];
+        }
+        os_ << "},\"max\":" << h.max() << fixed << setprecision(3) //
+            << ",\"ops_per_sec\":" << ops                          //
+            << ",\"ops_per_sec_sd\":" << sd;
+        if (counters) {
+            os_ << defaultfloat << setprecision(6) << ",\"counters\":{";
+            const char* sep{"\""};
+            for (size_t i{0}; i < NumPerfEvents; ++i) {
+                if (per_op[i] >= 0) {
+                    os_ << sep << enum_string(static_cast<PerfEvent>(i)) << "\":" << per_op[i];
+                    sep = ",\"";
+                }
+            }
+            os_ << '}';
+        }
+        os_ << '}';
+        break;
+    case BenchmarkFormat::Csv:
+        os_ << result.name << ',' << config_.repetitions << ',' << h.total_count() << ','
+            << h.min();
+        for (const auto v : values) {
+            os_ << ',' << v;
+        }
+        os_ << ',' << h.max() << fixed << setprecision(3) << ',' << ops << ',' << sd;
+        if (config_.counters) {
+            os_ << defaultfloat << setprecision(6);
+            // Empty fields for unavailable counters keep the columns aligned with the header.
+            for (const auto v : per_op) {
+                os_ << ',';
+                if (v >= 0) {
+                    os_ << v;
+                }
+            }
+        }
+        os_ << endl;
+        break;
+    }
+    first_ = false;
 }
 
 } // namespace toolbox::bm
@@ -16,33 +16,66 @@
 #ifndef TOOLBOX_BM_SUITE_HPP
 #define TOOLBOX_BM_SUITE_HPP
 
+#include <toolbox/bm/Counters.hpp>
 #include <toolbox/bm/Ctx.hpp>
 
 #include <toolbox/hdr/Histogram.hpp>
+#include <toolbox/sys/Thread.hpp>
+#include <toolbox/sys/Time.hpp>
+
+#include <functional>
+#include <iosfwd>
+#include <memory>
 
 namespace toolbox::bm {
 
+enum class BenchmarkFormat : int { Text, Json, Csv };
+
+/// BenchmarkConfig controls how each benchmark in a suite is run and reported.
+struct BenchmarkConfig {
+    /// Time spent running each benchmark before measurement. Warmup results are discarded.
+    Duration warmup{};
+    /// Length of each repetition in duration mode.
+    Duration duration{Seconds{3}};
+    /// If non-zero, each repetition runs until at least this many operations have been recorded,
+    /// instead of for a fixed duration.
+    std::int64_t iterations{0};
+    /// Number of measured repetitions per benchmark.
+    int repetitions{1};
+    /// Attributes, such as CPU affinity, applied to the thread running the suite.
+    ThreadConfig thread;
+    BenchmarkFormat format{BenchmarkFormat::Text};
+    /// Report hardware performance counters per operation, where permitted.
+    bool counters{false};
+    /// Divisor applied to nanosecond values in the text format.
+    double value_scale{1.0};
+};
+
 class TOOLBOX_API BenchmarkSuite {
   public:
+    BenchmarkSuite(std::ostream& os, const BenchmarkConfig& config);
     explicit BenchmarkSuite(std::ostream& os, double value_scale = 1.0);
+    ~BenchmarkSuite();
+
+    // Copy.
+    BenchmarkSuite(const BenchmarkSuite&) = delete;
+    BenchmarkSuite& operator=(const BenchmarkSuite&) = delete;
 
-    template <typename FnT>
-    void run(const char* name, FnT fn)
-    {
-        using namespace std::literals::chrono_literals;
-        constexpr auto duration = 3s;
+    // Move.
+    BenchmarkSuite(BenchmarkSuite&&) = delete;
+    BenchmarkSuite& operator=(BenchmarkSuite&&) = delete;
 
-        HdrHistogram hist{1, 1'000'000'000, 5};
-        BenchmarkCtx ctx{hist};
-        Alarm alarm{duration, [&ctx]() { ctx.stop(); }};
-        fn(ctx);
-        report(name, hist);
-    }
-    void report(const char* name, HdrHistogram& hist);
+    void run(const char* name, const std::function<void(BenchmarkCtx&)>& fn);
 
   private:
+    /// Merged results over all repetitions of a benchmark.
+    struct Result;
+    void report(const Result& result);
+
     std::ostream& os_;
-    double value_scale_;
+    const BenchmarkConfig config_;
+    std::unique_ptr<PerfCounters> counters_;
+    bool first_{true};
 };
 
 } // namespace toolbox::bm
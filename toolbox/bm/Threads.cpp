@@ -0,0 +1,148 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Threads.hpp"
+
+#include <toolbox/hdr/Histogram.hpp>
+#include <toolbox/sys/Time.hpp>
+
+#include <atomic>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+
+#include <pthread.h>
+
+namespace toolbox::bm {
+using namespace std;
+namespace {
+
+/// Returns the CPUs that the calling thread may run on, or an empty list if it may run on all.
+vector<int> restricted_cpus()
+{
+    vector<int> cpus;
+    cpu_set_t cs;
+    CPU_ZERO(&cs);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(cs), &cs) != 0) {
+        return cpus;
+    }
+    const auto n = static_cast<int>(thread::hardware_concurrency());
+    for (int i{0}; i < CPU_SETSIZE; ++i) {
+        if (CPU_ISSET(i, &cs)) {
+            cpus.push_back(i);
+        }
+    }
+    if (static_cast<int>(cpus.size()) >= n) {
+        cpus.clear();
+    }
+    return cpus;
+}
+
+} // namespace
+
+struct BenchmarkThreads::Worker {
+    Worker(string name, Fn fn)
+    : name{move(name)}
+    , fn{move(fn)}
+    {
+    }
+    string name;
+    Fn fn;
+    HdrHistogram hist{1, 1'000'000'000, 5};
+    // Constructed by run(), so that each run starts with a new context.
+    optional<BenchmarkCtx> ctx;
+    exception_ptr error;
+};
+
+BenchmarkThreads::BenchmarkThreads(BenchmarkCtx& ctx)
+: ctx_{ctx}
+{
+}
+
+BenchmarkThreads::~BenchmarkThreads() = default;
+
+void BenchmarkThreads::add(string name, Fn fn)
+{
+    workers_.push_back(make_unique<Worker>(move(name), move(fn)));
+}
+
+void BenchmarkThreads::add(string name, int count, const Fn& fn)
+{
+    for (int i{0}; i < count; ++i) {
+        add(name + '-' + to_string(i), fn);
+    }
+}
+
+void BenchmarkThreads::run()
+{
+    const auto cpus = restricted_cpus();
+    const auto n = static_cast<int>(workers_.size());
+    if (!cpus.empty() && static_cast<int>(cpus.size()) < n) {
+        throw invalid_argument{"fewer cpus than benchmark threads: " + to_string(cpus.size())
+                               + " < " + to_string(n)};
+    }
+    // The workers count their operations against one shared total, because typically only some of
+    // them record operations.
+    total_.store(0, memory_order_relaxed);
+    for (auto& w : workers_) {
+        w->ctx.emplace(w->hist, ctx_.max_count(), &total_);
+    }
+
+    atomic<int> ready{0};
+    atomic<bool> done{false};
+    vector<thread> threads;
+    threads.reserve(n);
+    for (int i{0}; i < n; ++i) {
+        ThreadConfig config{workers_[i]->name};
+        if (!cpus.empty()) {
+            config.affinity = to_string(cpus[i]);
+        }
+        threads.emplace_back([this, i, config, &ready, &done]() {
+            auto& w = *workers_[i];
+            try {
+                set_thread_attrs(config);
+                // Start barrier.
+                ready.fetch_add(1, memory_order_acq_rel);
+                while (ready.load(memory_order_acquire) < static_cast<int>(workers_.size())) {
+                    this_thread::yield();
+                }
+                w.fn(*w.ctx);
+            } catch (...) {
+                w.error = current_exception();
+                // Release the other threads from the barrier.
+                ready.store(workers_.size(), memory_order_release);
+            }
+            done.store(true, memory_order_release);
+        });
+    }
+    // Wait for the enclosing context to stop, or any thread to finish.
+    while (ctx_ && !done.load(memory_order_acquire)) {
+        this_thread::sleep_for(Millis{1});
+    }
+    for (auto& w : workers_) {
+        w->ctx->stop();
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    for (auto& w : workers_) {
+        if (w->error) {
+            rethrow_exception(w->error);
+        }
+        ctx_.hist().add(w->hist);
+    }
+}
+
+} // namespace toolbox::bm
@@ -0,0 +1,77 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOOLBOX_BM_THREADS_HPP
+#define TOOLBOX_BM_THREADS_HPP
+
+#include <toolbox/bm/Ctx.hpp>
+
+#include <toolbox/sys/Thread.hpp>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace toolbox::bm {
+
+/// Runs a benchmark on multiple threads, such as producers and consumers of a queue.
+///
+/// Each thread is given its own BenchmarkCtx and histogram. The threads wait at a start barrier
+/// so that they begin together, and when any thread returns, or the enclosing context is stopped,
+/// all threads are stopped. Thread functions must therefore poll their context rather than block
+/// indefinitely. The per-thread histograms are merged into the enclosing context's histogram, so
+/// typically only one side, for example the consumer, records operations. The threads share the
+/// enclosing context's maximum operation count, so that together they record exactly that many
+/// operations, however they are divided between the threads.
+///
+/// If the benchmark thread's affinity has been restricted, for example with the --cpu option,
+/// then each thread is pinned to a separate CPU from that set, in order.
+class TOOLBOX_API BenchmarkThreads {
+  public:
+    using Fn = std::function<void(BenchmarkCtx&)>;
+
+    explicit BenchmarkThreads(BenchmarkCtx& ctx);
+    ~BenchmarkThreads();
+
+    // Copy.
+    BenchmarkThreads(const BenchmarkThreads&) = delete;
+    BenchmarkThreads& operator=(const BenchmarkThreads&) = delete;
+
+    // Move.
+    BenchmarkThreads(BenchmarkThreads&&) = delete;
+    BenchmarkThreads& operator=(BenchmarkThreads&&) = delete;
+
+    /// Add a thread with the given name.
+    void add(std::string name, Fn fn);
+
+    /// Add count threads that run the same function.
+    void add(std::string name, int count, const Fn& fn);
+
+    /// Run all threads until stopped, and merge their histograms.
+    /// \throw std::invalid_argument if the affinity set has fewer CPUs than there are threads.
+    void run();
+
+  private:
+    struct Worker;
+    BenchmarkCtx& ctx_;
+    /// The number of operations recorded by all threads.
+    std::atomic<std::int64_t> total_{0};
+    std::vector<std::unique_ptr<Worker>> workers_;
+};
+
+} // namespace toolbox::bm
+
+#endif // TOOLBOX_BM_THREADS_HPP
@@ -0,0 +1,74 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Threads.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+using namespace toolbox;
+
+namespace {
+
+void produce(bm::BenchmarkCtx& ctx)
+{
+    while (ctx) {
+    }
+}
+
+void consume(bm::BenchmarkCtx& ctx)
+{
+    while (ctx) {
+        ctx.record(1);
+    }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(ThreadsSuite)
+
+BOOST_AUTO_TEST_CASE(ThreadsMaxCountCase)
+{
+    constexpr int64_t N{100000};
+    for (const int n : {1, 2}) {
+        HdrHistogram hist{1, 1'000'000'000, 5};
+        bm::BenchmarkCtx ctx{hist, N};
+        bm::BenchmarkThreads threads{ctx};
+        // Only the consumers record operations.
+        threads.add("producer", n, produce);
+        threads.add("consumer", n, consume);
+        threads.run();
+        BOOST_TEST(hist.total_count() == N);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ThreadsRangeCase)
+{
+    constexpr int64_t N{1000};
+    HdrHistogram hist{1, 1'000'000'000, 5};
+    bm::BenchmarkCtx ctx{hist, N};
+    bm::BenchmarkThreads threads{ctx};
+    threads.add("worker", 2, [](auto& ctx) {
+        while (ctx) {
+            for (auto _ : ctx.range(3)) {
+            }
+        }
+    });
+    threads.run();
+    BOOST_TEST(hist.total_count() == N);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
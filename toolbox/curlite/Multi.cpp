@@ -0,0 +1,171 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Multi.hpp"
+
+#include <toolbox/sys/Log.hpp>
+
+namespace toolbox {
+inline namespace curl {
+using namespace std;
+
+CurlMulti::CurlMulti(Reactor& r)
+: reactor_{r}
+, multi_{curl_multi_init()}
+{
+    if (!multi_) {
+        throw curlite::Exception{"curl_multi_init failed"};
+    }
+    curl_multi_setopt(multi_, CURLMOPT_SOCKETFUNCTION, &CurlMulti::on_socket);
+    curl_multi_setopt(multi_, CURLMOPT_SOCKETDATA, this);
+    curl_multi_setopt(multi_, CURLMOPT_TIMERFUNCTION, &CurlMulti::on_timer);
+    curl_multi_setopt(multi_, CURLMOPT_TIMERDATA, this);
+}
+
+CurlMulti::~CurlMulti()
+{
+    for (const auto& [handle, transfer] : transfers_) {
+        curl_multi_remove_handle(multi_, handle);
+    }
+    transfers_.clear();
+    // The socket callback may be called while cached connections are closed.
+    curl_multi_cleanup(multi_);
+    socks_.clear();
+}
+
+void CurlMulti::set(CURLMoption opt, long value)
+{
+    if (const auto rc = curl_multi_setopt(multi_, opt, value); rc != CURLM_OK) {
+        throw curlite::Exception{curl_multi_strerror(rc)};
+    }
+}
+
+void CurlMulti::add(curlite::Easy& easy, CurlSlot slot)
+{
+    auto* const handle = easy.get();
+    transfers_[handle] = {&easy, slot};
+    // The timer callback is called with a zero timeout to start the transfer.
+    if (const auto rc = curl_multi_add_handle(multi_, handle); rc != CURLM_OK) {
+        transfers_.erase(handle);
+        throw curlite::Exception{curl_multi_strerror(rc)};
+    }
+}
+
+void CurlMulti::remove(curlite::Easy& easy) noexcept
+{
+    auto* const handle = easy.get();
+    if (transfers_.erase(handle) > 0) {
+        curl_multi_remove_handle(multi_, handle);
+    }
+}
+
+int CurlMulti::on_socket(CURL* handle, curl_socket_t fd, int what, void* userp,
+                         void* socketp) noexcept
+{
+    auto* const self = static_cast<CurlMulti*>(userp);
+    try {
+        if (what == CURL_POLL_REMOVE) {
+            // Unsubscribe before curl closes the socket.
+            self->socks_.erase(fd);
+            return 0;
+        }
+        auto events = PollEvents::None;
+        if (what & CURL_POLL_IN) {
+            events = events + PollEvents::Read;
+        }
+        if (what & CURL_POLL_OUT) {
+            events = events + PollEvents::Write;
+        }
+        auto it = self->socks_.find(fd);
+        if (it == self->socks_.end()) {
+            it = self->socks_.emplace(fd, self->reactor_.handle(fd)).first;
+            it->second.add(events, bind<&CurlMulti::on_io_event>(self));
+        } else if (it->second.events() != events) {
+            it->second.events(events);
+            it->second.commit();
+        }
+    } catch (const std::exception& e) {
+        TOOLBOX_ERROR << "failed to watch curl socket: " << e.what();
+        return -1;
+    }
+    return 0;
+}
+
+int CurlMulti::on_timer(CURLM* multi, long timeout_ms, void* userp) noexcept
+{
+    auto* const self = static_cast<CurlMulti*>(userp);
+    if (timeout_ms < 0) {
+        self->tmr_.reset();
+        return 0;
+    }
+    // A zero timeout expires on the next reactor cycle, because curl functions must not be called
+    // from within curl callbacks.
+    self->tmr_ = self->reactor_.timer(CyclTime::current().mono_time() + Millis{timeout_ms},
+                                      Priority::High, bind<&CurlMulti::on_timeout>(self));
+    return 0;
+}
+
+void CurlMulti::on_io_event(CyclTime now, int fd, PollEvents events)
+{
+    int mask{0};
+    if (events & PollEvents::Read) {
+        mask |= CURL_CSELECT_IN;
+    }
+    if (events & PollEvents::Write) {
+        mask |= CURL_CSELECT_OUT;
+    }
+    if (events & PollEvents::Error) {
+        mask |= CURL_CSELECT_ERR;
+    }
+    socket_action(now, fd, mask);
+}
+
+void CurlMulti::on_timeout(CyclTime now, Timer& tmr)
+{
+    socket_action(now, CURL_SOCKET_TIMEOUT, 0);
+}
+
+void CurlMulti::socket_action(CyclTime now, curl_socket_t fd, int mask)
+{
+    int running;
+    if (const auto rc = curl_multi_socket_action(multi_, fd, mask, &running); rc != CURLM_OK) {
+        TOOLBOX_ERROR << "curl_multi_socket_action: " << curl_multi_strerror(rc);
+    }
+    int pending;
+    while (const auto* const msg = curl_multi_info_read(multi_, &pending)) {
+        if (msg->msg != CURLMSG_DONE) {
+            continue;
+        }
+        // The message is invalidated when the handle is removed.
+        auto* const handle = msg->easy_handle;
+        const auto result = msg->data.result;
+        curl_multi_remove_handle(multi_, handle);
+        const auto it = transfers_.find(handle);
+        if (it == transfers_.end()) {
+            continue;
+        }
+        const auto transfer = it->second;
+        transfers_.erase(it);
+        try {
+            // The slot may start new transfers, or destroy the easy handle.
+            transfer.slot(now, *transfer.easy, result);
+        } catch (const std::exception& e) {
+            TOOLBOX_ERROR << "error handling curl transfer: " << e.what();
+        }
+    }
+}
+
+} // namespace curl
+} // namespace toolbox
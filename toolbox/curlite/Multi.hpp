@@ -0,0 +1,95 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOOLBOX_CURLITE_MULTI_HPP
+#define TOOLBOX_CURLITE_MULTI_HPP
+
+#include <toolbox/curlite/curlite.hpp>
+#include <toolbox/io/Reactor.hpp>
+#include <toolbox/util/Slot.hpp>
+
+#include <unordered_map>
+
+namespace toolbox {
+inline namespace curl {
+
+/// Called from the reactor thread when a transfer completes, with the transfer's result code.
+using CurlSlot = Slot<CyclTime, curlite::Easy&, CURLcode>;
+
+/// Runs curl transfers on a reactor using the curl multi interface.
+///
+/// The sockets that curl asks to be watched are registered with the reactor's poller, and curl's
+/// timeouts are mapped onto a reactor timer, so that many concurrent transfers, including TLS
+/// transfers, run on the reactor thread without blocking it. Connections are cached by the multi
+/// handle, and reused by later transfers to the same host.
+class TOOLBOX_API CurlMulti {
+  public:
+    explicit CurlMulti(Reactor& r);
+    /// Transfers in progress are aborted without calling their slots.
+    ~CurlMulti();
+
+    // Copy.
+    CurlMulti(const CurlMulti&) = delete;
+    CurlMulti& operator=(const CurlMulti&) = delete;
+
+    // Move.
+    CurlMulti(CurlMulti&&) = delete;
+    CurlMulti& operator=(CurlMulti&&) = delete;
+
+    /// Returns the managed multi handle.
+    CURLM* get() const noexcept { return multi_; }
+    /// Returns the number of transfers in progress.
+    std::size_t size() const noexcept { return transfers_.size(); }
+
+    /// Set an option of the multi handle, such as CURLMOPT_MAX_HOST_CONNECTIONS.
+    /// See curl_multi_setopt() for details.
+    ///
+    /// \throw curlite::Exception on error.
+    void set(CURLMoption opt, long value);
+
+    /// Start a transfer. The easy handle must remain valid until the slot has been called, or the
+    /// transfer has been removed.
+    ///
+    /// \throw curlite::Exception on error.
+    void add(curlite::Easy& easy, CurlSlot slot);
+
+    /// Abort a transfer without calling its slot.
+    void remove(curlite::Easy& easy) noexcept;
+
+  private:
+    struct Transfer {
+        curlite::Easy* easy;
+        CurlSlot slot;
+    };
+
+    static int on_socket(CURL* handle, curl_socket_t fd, int what, void* userp,
+                         void* socketp) noexcept;
+    static int on_timer(CURLM* multi, long timeout_ms, void* userp) noexcept;
+    void on_io_event(CyclTime now, int fd, PollEvents events);
+    void on_timeout(CyclTime now, Timer& tmr);
+    /// Notify curl of socket activity or timeout, and call the slots of completed transfers.
+    void socket_action(CyclTime now, curl_socket_t fd, int mask);
+
+    Reactor& reactor_;
+    CURLM* const multi_;
+    Timer tmr_;
+    std::unordered_map<curl_socket_t, PollHandle> socks_;
+    std::unordered_map<CURL*, Transfer> transfers_;
+};
+
+} // namespace curl
+} // namespace toolbox
+
+#endif // TOOLBOX_CURLITE_MULTI_HPP
@@ -0,0 +1,99 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Multi.hpp"
+
+#include <toolbox/http/TestServ.ut.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+using namespace toolbox;
+using namespace toolbox::http::test;
+
+namespace {
+
+struct Transfer {
+    explicit Transfer(const string& url)
+    {
+        easy.set(CURLOPT_URL, url);
+        easy.onWrite_([this](char* data, size_t size) {
+            body.append(data, size);
+            return true;
+        });
+    }
+    curlite::Easy easy;
+    string body;
+};
+
+struct Results {
+    void on_done(CyclTime now, curlite::Easy& easy, CURLcode result)
+    {
+        if (result == CURLE_OK && easy.getInfo<long>(CURLINFO_RESPONSE_CODE) == 200) {
+            ++ok;
+        }
+        ++done;
+    }
+    int done{0}, ok{0};
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(MultiSuite)
+
+BOOST_AUTO_TEST_CASE(CurlMultiCase)
+{
+    TestServ serv{CyclTime::now(), {boost::asio::ip::address_v4::loopback(), 0}, 1,
+                  [](CyclTime now, HttpServ& serv) { return make_unique<TestApp>(serv); }};
+    StreamEndpoint ep;
+    serv[0].serv().get_sock_name(ep);
+    const auto url = "http://127.0.0.1:" + to_string(ep.port()) + "/";
+
+    os::Reactor reactor;
+    CurlMulti multi{reactor};
+    multi.set(CURLMOPT_MAX_HOST_CONNECTIONS, 4);
+
+    constexpr int Transfers{32};
+    Results results;
+    vector<unique_ptr<Transfer>> transfers;
+    for (int i{0}; i < Transfers; ++i) {
+        transfers.push_back(make_unique<Transfer>(url));
+        multi.add(transfers.back()->easy, bind<&Results::on_done>(&results));
+    }
+    BOOST_TEST(multi.size() == size_t(Transfers));
+    BOOST_TEST(poll_until(reactor, [&results]() { return results.done == Transfers; }));
+    BOOST_TEST(results.ok == Transfers);
+    BOOST_TEST(multi.size() == 0U);
+    for (const auto& transfer : transfers) {
+        BOOST_TEST(transfer->body == "Hello /");
+    }
+    const auto accepted = serv[0].stats().accepted.load();
+    BOOST_TEST(accepted <= 4);
+
+    // Cached connections are reused by later transfers.
+    multi.add(transfers.front()->easy, bind<&Results::on_done>(&results));
+    BOOST_TEST(poll_until(reactor, [&results]() { return results.done == Transfers + 1; }));
+    BOOST_TEST(results.ok == Transfers + 1);
+    BOOST_TEST(serv[0].stats().accepted.load() == accepted);
+
+    // Aborted transfers are not reported.
+    multi.add(transfers.back()->easy, bind<&Results::on_done>(&results));
+    multi.remove(transfers.back()->easy);
+    BOOST_TEST(multi.size() == 0U);
+    reactor.poll(CyclTime::now(), 10ms);
+    BOOST_TEST(results.done == Transfers + 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
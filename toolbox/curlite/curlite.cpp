@@ -854,7 +854,7 @@ namespace curlite
 
         c >> ostr;
 
-        return std::move( c );
+        return c;
     }
 
     Easy upload( std::istream &istr,
@@ -886,7 +886,7 @@ namespace curlite
         // reset the option to avoid access violation (if a client reuses the Easy object)
         c.set( CURLOPT_HTTPHEADER, nullptr );
 
-        return std::move( c );
+        return c;
     }
 
 } // end of namespace <curlite>
\ No newline at end of file
@@ -42,6 +42,9 @@
     #error "This version of curlite is incompatible with your cURL version" 
 #endif
 
+// Export the API from shared libraries built with hidden visibility.
+#pragma GCC visibility push(default)
+
 namespace curlite
 {
     template <class FunctionPtr>
@@ -511,4 +514,6 @@ namespace curlite
 
 } // end of namespace
 
+#pragma GCC visibility pop
+
 #endif
\ No newline at end of file
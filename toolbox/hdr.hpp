@@ -17,7 +17,9 @@
 #define TOOLBOX_HDR_HPP
 
 #include "hdr/Histogram.hpp"
+#include "hdr/IntervalLog.hpp"
 #include "hdr/Iterator.hpp"
+#include "hdr/Recorder.hpp"
 #include "hdr/Utility.hpp"
 
 #endif // TOOLBOX_HDR_HPP
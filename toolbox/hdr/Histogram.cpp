@@ -228,6 +228,18 @@ bool HdrHistogram::record_values(int64_t value, int64_t count) noexcept
     return true;
 }
 
+int64_t HdrHistogram::add(const HdrHistogram& from) noexcept
+{
+    int64_t dropped{0};
+    for (int32_t i{0}; i < from.counts_len(); ++i) {
+        const auto count = from.count_at_index(i);
+        if (count > 0 && !record_values(from.value_at_index(i), count)) {
+            dropped += count;
+        }
+    }
+    return dropped;
+}
+
 int32_t HdrHistogram::normalize_index(int32_t index) const noexcept
 {
     if (normalizing_index_offset_ == 0) {
@@ -294,20 +306,24 @@ void HdrHistogram::update_min_max(int64_t value) noexcept
     max_value_ = std::max(max_value_, value);
 }
 
-std::string HdrHistogram::report(bool with_columns, const char* name,  double value_scale)
+std::string HdrHistogram::report(bool with_columns, const char* name, double value_scale) const
 {
     std::stringstream os;
     boost::io::ios_all_saver all_saver{os};
 
+    constexpr double Percentiles[] = {50, 95, 99, 99.9, 99.99};
+    int64_t values[size(Percentiles)];
+    values_at_percentiles(*this, Percentiles, values, size(Percentiles));
+
     // clang-format off
     os  << left  << setw(45) << name
         << right << setw(15) << (with_columns ? "COUNT:":"") << total_count()
         << right << setw(10) << (with_columns ? "MIN:":"") << min() / value_scale
-        << right << setw(10) << (with_columns ? "%50:":"") << value_at_percentile(*this, 50) / value_scale
-        << right << setw(10) << (with_columns ? "%95:":"") << value_at_percentile(*this, 95) / value_scale
-        << right << setw(10) << (with_columns ? "%99:":"") << value_at_percentile(*this, 99) / value_scale
-        << right << setw(10) << (with_columns ? "%99.9:":"") << value_at_percentile(*this, 99.9) / value_scale
-        << right << setw(10) << (with_columns ? "%99.99:":"") << value_at_percentile(*this, 99.99) / value_scale
+        << right << setw(10) << (with_columns ? "%50:":"") << values[0] / value_scale
+        << right << setw(10) << (with_columns ? "%95:":"") << values[1] / value_scale
+        << right << setw(10) << (with_columns ? "%99:":"") << values[2] / value_scale
+        << right << setw(10) << (with_columns ? "%99.9:":"") << values[3] / value_scale
+        << right << setw(10) << (with_columns ? "%99.99:":"") << values[4] / value_scale
         << endl;
     // clang-format on
     return os.str();
@@ -83,6 +83,9 @@ class TOOLBOX_API HdrHistogram {
     std::int32_t bucket_count() const noexcept { return bucket_count_; }
     std::int64_t total_count() const noexcept { return total_count_; }
     std::int32_t counts_len() const noexcept { return static_cast<std::int32_t>(counts_.size()); }
+    /// Returns the counts_len() counts. The normalising index offset is always zero, so element i
+    /// is the count at index i.
+    const std::int64_t* counts() const noexcept { return counts_.data(); }
 
     /// Get minimum value from the histogram. Will return 2^63-1 if the histogram is empty.
     std::int64_t min() const noexcept;
@@ -145,12 +148,20 @@ class TOOLBOX_API HdrHistogram {
     /// true otherwise.
     bool record_values(std::int64_t value, std::int64_t count) noexcept;
 
+    /// Adds all of the values from one histogram to this one. The histograms may have different
+    /// ranges and precision; values are re-recorded at this histogram's resolution.
+    ///
+    /// \param from Histogram to copy values from.
+    /// \return the number of values dropped because they were out of range.
+    std::int64_t add(const HdrHistogram& from) noexcept;
+
     /// Print report
     ///
     /// \param name Name of the report
     /// \param value_scale Value divisor
     /// \return Report string
-    std::string report(bool with_columns = false, const char* name = "", double value_scale = 1.0);
+    std::string report(bool with_columns = false, const char* name = "",
+                       double value_scale = 1.0) const;
   private:
     std::int32_t normalize_index(std::int32_t index) const noexcept;
     std::int32_t get_bucket_index(std::int64_t value) const noexcept;
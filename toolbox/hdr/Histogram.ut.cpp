@@ -109,4 +109,24 @@ BOOST_AUTO_TEST_CASE(HistogramRecordEquivalentValueCase)
     BOOST_TEST(10015 * 1024 + 1023 == h.highest_equivalent_value(10008 * 1024));
 }
 
+BOOST_AUTO_TEST_CASE(HistogramAddCase)
+{
+    HdrHistogram h1{1, 1000, 3};
+    HdrHistogram h2{1, 100000, 3};
+    h1.record_values(10, 2);
+    h2.record_value(10);
+    h2.record_value(500);
+    h2.record_value(50000);
+
+    // Values beyond the destination's range are dropped.
+    BOOST_TEST(h1.add(h2) == 1);
+    BOOST_TEST(h1.total_count() == 4);
+    BOOST_TEST(h1.count_at_value(10) == 3);
+    BOOST_TEST(h1.count_at_value(500) == 1);
+
+    BOOST_TEST(h2.add(h1) == 0);
+    BOOST_TEST(h2.total_count() == 7);
+    BOOST_TEST(h2.count_at_value(10) == 4);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
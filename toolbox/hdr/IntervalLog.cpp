@@ -0,0 +1,425 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "IntervalLog.hpp"
+
+#include <toolbox/util/Finally.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+#include <zlib.h>
+
+namespace toolbox {
+inline namespace hdr {
+using namespace std;
+namespace {
+
+// Cookies of the V2 format for 64-bit word sizes.
+constexpr uint32_t EncodingCookie{0x1c849303 | 0x10};
+constexpr uint32_t CompressionCookie{0x1c849304 | 0x10};
+constexpr size_t EncodingHeaderSize{40};
+constexpr size_t CompressionHeaderSize{8};
+/// The most bytes that a single count can occupy.
+constexpr uint64_t MaxVarintSize{9};
+
+constexpr string_view Base64Chars{
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"};
+
+/// A year in seconds, used to distinguish relative from absolute timestamps.
+constexpr double YearSecs{365.25 * 24 * 60 * 60};
+
+void put_be(string& out, uint64_t val, int size)
+{
+    for (int i{size - 1}; i >= 0; --i) {
+        out += static_cast<char>(val >> (i * 8));
+    }
+}
+
+uint64_t get_be(string_view& buf, int size)
+{
+    if (buf.size() < static_cast<size_t>(size)) {
+        throw runtime_error{"truncated histogram"};
+    }
+    uint64_t val{0};
+    for (int i{0}; i < size; ++i) {
+        val = (val << 8) | static_cast<uint8_t>(buf[i]);
+    }
+    buf.remove_prefix(size);
+    return val;
+}
+
+/// Zig-zag LEB128 encoding, where the ninth byte, if any, holds eight bits.
+void put_varint(string& out, int64_t val)
+{
+    auto u = (static_cast<uint64_t>(val) << 1) ^ static_cast<uint64_t>(val >> 63);
+    for (int i{0}; i < 8; ++i) {
+        if (u < 0x80) {
+            out += static_cast<char>(u);
+            return;
+        }
+        out += static_cast<char>((u & 0x7f) | 0x80);
+        u >>= 7;
+    }
+    out += static_cast<char>(u);
+}
+
+int64_t get_varint(string_view& buf)
+{
+    uint64_t u{0};
+    for (int i{0};; ++i) {
+        if (buf.empty()) {
+            throw runtime_error{"truncated histogram counts"};
+        }
+        const auto b = static_cast<uint8_t>(buf.front());
+        buf.remove_prefix(1);
+        if (i == 8) {
+            u |= uint64_t{b} << 56;
+            break;
+        }
+        u |= uint64_t{b & 0x7fU} << (i * 7);
+        if ((b & 0x80) == 0) {
+            break;
+        }
+    }
+    return static_cast<int64_t>(u >> 1) ^ -static_cast<int64_t>(u & 1);
+}
+
+string base64_encode(string_view in)
+{
+    string out;
+    out.reserve((in.size() + 2) / 3 * 4);
+    size_t i{0};
+    for (; i + 2 < in.size(); i += 3) {
+        const uint32_t n{static_cast<uint32_t>(static_cast<uint8_t>(in[i])) << 16
+                         | static_cast<uint32_t>(static_cast<uint8_t>(in[i + 1])) << 8
+                         | static_cast<uint8_t>(in[i + 2])};
+        out += Base64Chars[n >> 18 & 0x3f];
+        out += Base64Chars[n >> 12 & 0x3f];
+        out += Base64Chars[n >> 6 & 0x3f];
+        out += Base64Chars[n & 0x3f];
+    }
+    if (i < in.size()) {
+        uint32_t n{static_cast<uint32_t>(static_cast<uint8_t>(in[i])) << 16};
+        if (i + 1 < in.size()) {
+            n |= static_cast<uint32_t>(static_cast<uint8_t>(in[i + 1])) << 8;
+        }
+        out += Base64Chars[n >> 18 & 0x3f];
+        out += Base64Chars[n >> 12 & 0x3f];
+        out += i + 1 < in.size() ? Base64Chars[n >> 6 & 0x3f] : '=';
+        out += '=';
+    }
+    return out;
+}
+
+string base64_decode(string_view in)
+{
+    string out;
+    out.reserve(in.size() / 4 * 3);
+    uint32_t n{0};
+    int bits{0};
+    for (const auto c : in) {
+        if (c == '=') {
+            break;
+        }
+        const auto pos = Base64Chars.find(c);
+        if (pos == string_view::npos) {
+            throw runtime_error{"invalid base64"};
+        }
+        n = (n << 6) | static_cast<uint32_t>(pos);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out += static_cast<char>(n >> bits);
+        }
+    }
+    return out;
+}
+
+double to_secs(WallTime t) noexcept
+{
+    return static_cast<double>(ns_since_epoch(t)) / 1e9;
+}
+
+WallTime from_secs(double secs) noexcept
+{
+    return WallTime{Nanos{llround(secs * 1e9)}};
+}
+
+double parse_double(string_view sv)
+{
+    const string s{sv};
+    char* end;
+    const auto val = strtod(s.c_str(), &end);
+    if (s.empty() || end != s.c_str() + s.size()) {
+        throw runtime_error{"invalid number in histogram log: " + s};
+    }
+    return val;
+}
+
+/// Returns the next comma-separated field.
+string_view next_field(string_view& line)
+{
+    const auto pos = line.find(',');
+    if (pos == string_view::npos) {
+        throw runtime_error{"invalid histogram log line"};
+    }
+    const auto field = line.substr(0, pos);
+    line.remove_prefix(pos + 1);
+    return field;
+}
+
+} // namespace
+
+string encode_compressed(const HdrHistogram& h)
+{
+    // Counts are only encoded up to the last non-zero count.
+    int32_t len{h.counts_len()};
+    while (len > 0 && h.count_at_index(len - 1) == 0) {
+        --len;
+    }
+    string counts;
+    int64_t zeros{0};
+    for (int32_t i{0}; i < len; ++i) {
+        const auto count = h.count_at_index(i);
+        if (count == 0) {
+            ++zeros;
+        } else {
+            if (zeros > 0) {
+                put_varint(counts, -zeros);
+                zeros = 0;
+            }
+            put_varint(counts, count);
+        }
+    }
+
+    string payload;
+    payload.reserve(EncodingHeaderSize + counts.size());
+    put_be(payload, EncodingCookie, 4);
+    put_be(payload, counts.size(), 4);
+    // Normalising index offset.
+    put_be(payload, 0, 4);
+    put_be(payload, h.significant_figures(), 4);
+    put_be(payload, h.lowest_trackable_value(), 8);
+    put_be(payload, h.highest_trackable_value(), 8);
+    // Integer to double conversion ratio.
+    const double ratio{1.0};
+    uint64_t ratio_bits;
+    memcpy(&ratio_bits, &ratio, sizeof(ratio_bits));
+    put_be(payload, ratio_bits, 8);
+    payload += counts;
+
+    auto dest_len = compressBound(payload.size());
+    string out(CompressionHeaderSize + dest_len, '\0');
+    if (compress(reinterpret_cast<Bytef*>(&out[CompressionHeaderSize]), &dest_len,
+                 reinterpret_cast<const Bytef*>(payload.data()), payload.size())
+        != Z_OK) {
+        throw runtime_error{"deflate failed"};
+    }
+    out.resize(CompressionHeaderSize + dest_len);
+    string head;
+    put_be(head, CompressionCookie, 4);
+    put_be(head, dest_len, 4);
+    out.replace(0, CompressionHeaderSize, head);
+    return out;
+}
+
+HdrHistogram decode_compressed(string_view buf)
+{
+    // Cookies are compared excluding the word size bits.
+    if ((get_be(buf, 4) & ~0xf0U) != (CompressionCookie & ~0xf0U)) {
+        throw runtime_error{"invalid histogram compression cookie"};
+    }
+    const auto len = get_be(buf, 4);
+    if (buf.size() < len) {
+        throw runtime_error{"truncated histogram"};
+    }
+
+    // The encoded header states the length of the counts, so inflate the header first.
+    z_stream zs{};
+    if (inflateInit(&zs) != Z_OK) {
+        throw runtime_error{"inflate failed"};
+    }
+    const auto finally = make_finally([&zs]() noexcept { inflateEnd(&zs); });
+    string payload(EncodingHeaderSize, '\0');
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(buf.data()));
+    zs.avail_in = static_cast<uInt>(len);
+    zs.next_out = reinterpret_cast<Bytef*>(payload.data());
+    zs.avail_out = static_cast<uInt>(payload.size());
+    auto ret = inflate(&zs, Z_SYNC_FLUSH);
+    if ((ret != Z_OK && ret != Z_STREAM_END) || zs.avail_out != 0) {
+        throw runtime_error{"truncated histogram header"};
+    }
+    string_view head{payload};
+    if ((get_be(head, 4) & ~0xf0U) != (EncodingCookie & ~0xf0U)) {
+        throw runtime_error{"invalid histogram encoding cookie"};
+    }
+    const auto counts_size = get_be(head, 4);
+    const auto normalizing_index_offset = static_cast<int32_t>(get_be(head, 4));
+    const auto significant_figures = static_cast<int32_t>(get_be(head, 4));
+    const auto lowest = static_cast<int64_t>(get_be(head, 8));
+    const auto highest = static_cast<int64_t>(get_be(head, 8));
+    if (normalizing_index_offset != 0) {
+        throw runtime_error{"unsupported histogram normalizing index offset"};
+    }
+    // Throws std::invalid_argument if the bucket configuration is invalid.
+    HdrHistogram h{lowest, highest, significant_figures};
+    // The length comes from the input, so bound the allocation by the most that the counts can
+    // occupy.
+    if (counts_size > MaxVarintSize * h.counts_len()) {
+        throw runtime_error{"histogram counts too long"};
+    }
+    payload.resize(EncodingHeaderSize + counts_size);
+    zs.next_out = reinterpret_cast<Bytef*>(&payload[EncodingHeaderSize]);
+    zs.avail_out = static_cast<uInt>(counts_size);
+    ret = counts_size > 0 ? inflate(&zs, Z_FINISH) : Z_STREAM_END;
+    if (ret != Z_STREAM_END || zs.avail_out != 0) {
+        throw runtime_error{"truncated histogram counts"};
+    }
+
+    string_view counts{payload};
+    counts.remove_prefix(EncodingHeaderSize);
+    // The index never exceeds counts_len, so skipping a run of empty buckets cannot overflow.
+    int64_t index{0};
+    while (!counts.empty()) {
+        const auto count = get_varint(counts);
+        if (count < 0) {
+            if (count < index - h.counts_len()) {
+                throw runtime_error{"histogram counts out of range"};
+            }
+            index -= count;
+            continue;
+        }
+        if (index >= h.counts_len()) {
+            throw runtime_error{"histogram counts out of range"};
+        }
+        // The reference encoders write a single empty bucket as a zero count, rather than as a
+        // run, and recording it would set the minimum and maximum.
+        if (count == 0) {
+            ++index;
+            continue;
+        }
+        h.record_values(h.value_at_index(static_cast<int32_t>(index++)), count);
+    }
+    return h;
+}
+
+string log_encode(const HdrHistogram& h)
+{
+    return base64_encode(encode_compressed(h));
+}
+
+HdrHistogram log_decode(string_view text)
+{
+    return decode_compressed(base64_decode(text));
+}
+
+HdrLogWriter::HdrLogWriter(ostream& os, double max_value_divisor) noexcept
+: os_{os}
+, max_value_divisor_{max_value_divisor}
+{
+}
+
+HdrLogWriter::~HdrLogWriter() = default;
+
+void HdrLogWriter::write_header(WallTime start_time, string_view comment)
+{
+    start_time_ = start_time;
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.3f", to_secs(start_time));
+    if (!comment.empty()) {
+        os_ << "#" << comment << '\n';
+    }
+    os_ << "#[Histogram log format version 1.3]\n"
+        << "#[StartTime: " << buf << " (seconds since epoch)]\n"
+        << "\"StartTimestamp\",\"Interval_Length\",\"Interval_Max\","
+           "\"Interval_Compressed_Histogram\"\n";
+}
+
+void HdrLogWriter::write(const HdrHistogram& h, WallTime start, WallTime end, string_view tag)
+{
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%.3f,%.3f,%.3f,", to_secs(start) - to_secs(start_time_),
+             to_secs(end) - to_secs(start),
+             static_cast<double>(h.max()) / max_value_divisor_);
+    if (!tag.empty()) {
+        os_ << "Tag=" << tag << ',';
+    }
+    os_ << buf << log_encode(h) << '\n';
+}
+
+HdrLogReader::HdrLogReader(istream& is) noexcept
+: is_{is}
+{
+}
+
+HdrLogReader::~HdrLogReader() = default;
+
+bool HdrLogReader::read(HdrLogEntry& entry)
+{
+    string line;
+    while (getline(is_, line)) {
+        string_view sv{line};
+        if (!sv.empty() && sv.back() == '\r') {
+            sv.remove_suffix(1);
+        }
+        if (sv.empty() || sv.front() == '"') {
+            continue;
+        }
+        if (sv.front() == '#') {
+            constexpr string_view StartTime{"#[StartTime: "};
+            constexpr string_view BaseTime{"#[BaseTime: "};
+            if (sv.substr(0, StartTime.size()) == StartTime) {
+                sv.remove_prefix(StartTime.size());
+                start_time_ = from_secs(parse_double(sv.substr(0, sv.find(' '))));
+                has_start_time_ = true;
+            } else if (sv.substr(0, BaseTime.size()) == BaseTime) {
+                sv.remove_prefix(BaseTime.size());
+                base_time_ = from_secs(parse_double(sv.substr(0, sv.find(' '))));
+                has_base_time_ = true;
+            }
+            continue;
+        }
+        entry.tag.clear();
+        if (sv.substr(0, 4) == "Tag=") {
+            const auto tag = next_field(sv);
+            entry.tag.assign(tag.substr(4));
+        }
+        const auto start = parse_double(next_field(sv));
+        const auto length = parse_double(next_field(sv));
+        // The interval max is redundant given the histogram.
+        next_field(sv);
+
+        // Timestamps are relative to the base time if given, otherwise to the start time if they
+        // are too small to be absolute.
+        if (has_base_time_) {
+            entry.start = base_time_ + from_secs(start).time_since_epoch();
+        } else if (has_start_time_ && start < YearSecs) {
+            entry.start = start_time_ + from_secs(start).time_since_epoch();
+        } else {
+            entry.start = from_secs(start);
+        }
+        entry.length = from_secs(length).time_since_epoch();
+        entry.histogram = log_decode(sv);
+        return true;
+    }
+    return false;
+}
+
+} // namespace hdr
+} // namespace toolbox
@@ -0,0 +1,131 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOOLBOX_HDR_INTERVALLOG
+#define TOOLBOX_HDR_INTERVALLOG
+
+#include <toolbox/hdr/Histogram.hpp>
+#include <toolbox/sys/Time.hpp>
+
+#include <iosfwd>
+#include <optional>
+#include <string_view>
+
+namespace toolbox {
+inline namespace hdr {
+
+/// Encode histogram in the standard compressed HdrHistogram V2 format: a big-endian header
+/// followed by the counts as zig-zag LEB128 varints, where runs of zeros are encoded as negative
+/// counts, and the whole compressed with deflate.
+///
+/// The output is compatible with the Java and C implementations of HdrHistogram.
+TOOLBOX_API std::string encode_compressed(const HdrHistogram& h);
+
+/// Decode histogram from the standard compressed HdrHistogram V2 format.
+///
+/// \throw std::runtime_error if the buffer is malformed.
+TOOLBOX_API HdrHistogram decode_compressed(std::string_view buf);
+
+/// Encode histogram in the compressed format as base64 text, as used in interval logs.
+TOOLBOX_API std::string log_encode(const HdrHistogram& h);
+
+/// Decode histogram from base64 text in the compressed format.
+///
+/// \throw std::runtime_error if the text is malformed.
+TOOLBOX_API HdrHistogram log_decode(std::string_view text);
+
+/// Writes histograms in the HdrHistogram interval log format (version 1.3), which can be read by
+/// HdrLogReader and the standard HdrHistogram tools, for example:
+///
+/// #[Histogram log format version 1.3]
+/// #[StartTime: 1584144000.000 (seconds since epoch)]
+/// "StartTimestamp","Interval_Length","Interval_Max","Interval_Compressed_Histogram"
+/// 0.000,1.000,2.769,HISTFAAAAEV42pJpYe...
+class TOOLBOX_API HdrLogWriter {
+  public:
+    /// \param os The output stream.
+    /// \param max_value_divisor Divisor applied to the interval max, for example 1e6 to report
+    /// nanosecond values in milliseconds.
+    explicit HdrLogWriter(std::ostream& os, double max_value_divisor = 1.0) noexcept;
+    ~HdrLogWriter();
+
+    // Copy.
+    HdrLogWriter(const HdrLogWriter&) = delete;
+    HdrLogWriter& operator=(const HdrLogWriter&) = delete;
+
+    // Move.
+    HdrLogWriter(HdrLogWriter&&) = delete;
+    HdrLogWriter& operator=(HdrLogWriter&&) = delete;
+
+    /// Write the log header. Interval timestamps are written relative to the start time.
+    void write_header(WallTime start_time, std::string_view comment = {});
+
+    /// Write an interval histogram.
+    ///
+    /// \param h The interval histogram.
+    /// \param start The start of the interval.
+    /// \param end The end of the interval.
+    /// \param tag Optional tag, which must not contain commas or whitespace.
+    void write(const HdrHistogram& h, WallTime start, WallTime end, std::string_view tag = {});
+
+  private:
+    std::ostream& os_;
+    const double max_value_divisor_;
+    WallTime start_time_{};
+};
+
+/// An interval read by HdrLogReader.
+struct TOOLBOX_API HdrLogEntry {
+    std::string tag;
+    /// The absolute start of the interval.
+    WallTime start;
+    /// The interval length.
+    Duration length;
+    std::optional<HdrHistogram> histogram;
+};
+
+/// Reads histograms in the HdrHistogram interval log format.
+class TOOLBOX_API HdrLogReader {
+  public:
+    explicit HdrLogReader(std::istream& is) noexcept;
+    ~HdrLogReader();
+
+    // Copy.
+    HdrLogReader(const HdrLogReader&) = delete;
+    HdrLogReader& operator=(const HdrLogReader&) = delete;
+
+    // Move.
+    HdrLogReader(HdrLogReader&&) = delete;
+    HdrLogReader& operator=(HdrLogReader&&) = delete;
+
+    /// The start time from the log header, if any has been read.
+    WallTime start_time() const noexcept { return start_time_; }
+
+    /// Read the next interval.
+    ///
+    /// \return false at end of file.
+    /// \throw std::runtime_error if the log is malformed.
+    bool read(HdrLogEntry& entry);
+
+  private:
+    std::istream& is_;
+    WallTime start_time_{}, base_time_{};
+    bool has_start_time_{false}, has_base_time_{false};
+};
+
+} // namespace hdr
+} // namespace toolbox
+
+#endif // TOOLBOX_HDR_INTERVALLOG
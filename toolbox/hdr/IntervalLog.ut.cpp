@@ -0,0 +1,205 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "IntervalLog.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+
+#include <zlib.h>
+
+using namespace std;
+using namespace toolbox;
+
+namespace {
+
+bool equal(const HdrHistogram& lhs, const HdrHistogram& rhs)
+{
+    if (lhs.counts_len() != rhs.counts_len() || lhs.total_count() != rhs.total_count()
+        || lhs.min() != rhs.min() || lhs.max() != rhs.max()) {
+        return false;
+    }
+    for (int32_t i{0}; i < lhs.counts_len(); ++i) {
+        if (lhs.count_at_index(i) != rhs.count_at_index(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void put_be(string& out, uint64_t val, int size)
+{
+    for (int i{size - 1}; i >= 0; --i) {
+        out += static_cast<char>(val >> (i * 8));
+    }
+}
+
+void put_varint(string& out, int64_t val)
+{
+    auto u = (static_cast<uint64_t>(val) << 1) ^ static_cast<uint64_t>(val >> 63);
+    for (int i{0}; i < 8 && u >= 0x80; ++i, u >>= 7) {
+        out += static_cast<char>((u & 0x7f) | 0x80);
+    }
+    out += static_cast<char>(u);
+}
+
+/// Returns a compressed histogram of 1 to 1000 at three significant figures, with the given counts
+/// and stated counts length.
+string make_compressed(string_view counts, uint32_t counts_size)
+{
+    string payload;
+    put_be(payload, 0x1c849313, 4);
+    put_be(payload, counts_size, 4);
+    put_be(payload, 0, 4);
+    put_be(payload, 3, 4);
+    put_be(payload, 1, 8);
+    put_be(payload, 1000, 8);
+    // Conversion ratio of 1.0.
+    put_be(payload, 0x3ff0000000000000, 8);
+    payload += counts;
+
+    auto len = compressBound(payload.size());
+    string out(8 + len, '\0');
+    BOOST_REQUIRE(compress(reinterpret_cast<Bytef*>(&out[8]), &len,
+                           reinterpret_cast<const Bytef*>(payload.data()), payload.size())
+                  == Z_OK);
+    out.resize(8 + len);
+    string head;
+    put_be(head, 0x1c849314, 4);
+    put_be(head, len, 4);
+    return out.replace(0, 8, head);
+}
+
+string make_compressed(string_view counts)
+{
+    return make_compressed(counts, counts.size());
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(IntervalLogSuite)
+
+BOOST_AUTO_TEST_CASE(EncodeCompressedCase)
+{
+    HdrHistogram h{1, 3600LL * 1000 * 1000 * 1000, 3};
+    BOOST_TEST(equal(decode_compressed(encode_compressed(h)), h));
+
+    h.record_value(1);
+    h.record_values(1000, 100);
+    // Counts that need all nine bytes of the varint encoding.
+    h.record_values(123456789, numeric_limits<int64_t>::max() / 2);
+    h.record_value(3600LL * 1000 * 1000 * 1000);
+    const auto buf = encode_compressed(h);
+    BOOST_TEST(equal(decode_compressed(buf), h));
+
+    // The standard encoding is recognisable by its base64 prefix.
+    BOOST_TEST(log_encode(h).compare(0, 5, "HISTF") == 0);
+    BOOST_TEST(equal(log_decode(log_encode(h)), h));
+
+    BOOST_CHECK_THROW(decode_compressed(string_view{buf}.substr(0, buf.size() - 1)), runtime_error);
+    auto bad = buf;
+    bad[0] = '\0';
+    BOOST_CHECK_THROW(decode_compressed(bad), runtime_error);
+    BOOST_CHECK_THROW(log_decode("HISTF!"), runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(DecodeReferenceCase)
+{
+    // Encoded as by the reference Java implementation (AbstractHistogram.fillBufferFromCountsArray
+    // and Deflater at its default level), which writes each isolated empty bucket, including the
+    // one for zero, as a zero count rather than as a run.
+    constexpr auto Text = "HISTFAAAACh4nJNpmSzMwMDAxQABzFCaEURcm7yEwf4DVIQJCFkO859gBACEzAY0"sv;
+    HdrHistogram expected{1, 3600LL * 1000 * 1000, 3};
+    expected.record_value(1);
+    expected.record_value(3);
+    expected.record_values(5, 2);
+    expected.record_values(1000, 100);
+
+    const auto h = log_decode(Text);
+    BOOST_TEST(h.total_count() == 104);
+    BOOST_TEST(h.min() == 1);
+    BOOST_TEST(h.max() == 1000);
+    BOOST_TEST(equal(h, expected));
+    BOOST_TEST(equal(log_decode(log_encode(h)), h));
+}
+
+BOOST_AUTO_TEST_CASE(DecodeCompressedBadCountsCase)
+{
+    string counts;
+    put_varint(counts, -2);
+    put_varint(counts, 5);
+    const auto h = decode_compressed(make_compressed(counts));
+    BOOST_TEST(h.total_count() == 5);
+    BOOST_TEST(h.count_at_value(2) == 5);
+
+    // The stated length of the counts is bounded before anything is allocated.
+    BOOST_CHECK_EXCEPTION(decode_compressed(make_compressed(counts, 0xffffffff)), runtime_error,
+                          [](const auto& e) {
+                              return string_view{e.what()} == "histogram counts too long";
+                          });
+
+    // Runs of empty buckets that skip beyond the end, or overflow the index.
+    for (const auto run : {-int64_t{h.counts_len()} - 1, numeric_limits<int64_t>::min()}) {
+        counts.clear();
+        put_varint(counts, -1);
+        put_varint(counts, run);
+        put_varint(counts, 1);
+        BOOST_CHECK_THROW(decode_compressed(make_compressed(counts)), runtime_error);
+    }
+    counts.clear();
+    put_varint(counts, -int64_t{h.counts_len()});
+    put_varint(counts, 1);
+    BOOST_CHECK_THROW(decode_compressed(make_compressed(counts)), runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(IntervalLogCase)
+{
+    const WallTime start{Seconds{1584144000}};
+    HdrHistogram h1{1, 1000000, 3};
+    HdrHistogram h2{1, 1000000, 3};
+    h1.record_values(100, 10);
+    h2.record_values(200000, 5);
+
+    stringstream ss;
+    {
+        HdrLogWriter writer{ss, 1000.0};
+        writer.write_header(start, "test log");
+        writer.write(h1, start, start + Seconds{1});
+        writer.write(h2, start + Seconds{1}, start + Millis{2500}, "foo");
+    }
+    BOOST_TEST(ss.str().find("#[StartTime: 1584144000.000") != string::npos);
+    BOOST_TEST(ss.str().find("\n0.000,1.000,0.100,HISTF") != string::npos);
+    BOOST_TEST(ss.str().find("\nTag=foo,1.000,1.500,200.") != string::npos);
+
+    HdrLogReader reader{ss};
+    HdrLogEntry entry;
+    BOOST_TEST(reader.read(entry));
+    BOOST_TEST(reader.start_time() == start);
+    BOOST_TEST(entry.tag.empty());
+    BOOST_TEST(entry.start == start);
+    BOOST_TEST((entry.length == Seconds{1}));
+    BOOST_TEST(equal(*entry.histogram, h1));
+
+    BOOST_TEST(reader.read(entry));
+    BOOST_TEST(entry.tag == "foo");
+    BOOST_TEST(entry.start == start + Seconds{1});
+    BOOST_TEST((entry.length == Millis{1500}));
+    BOOST_TEST(equal(*entry.histogram, h2));
+
+    BOOST_TEST(!reader.read(entry));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
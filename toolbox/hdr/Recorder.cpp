@@ -0,0 +1,140 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Recorder.hpp"
+
+#include <thread>
+
+namespace toolbox {
+inline namespace hdr {
+using namespace std;
+
+AtomicHdrHistogram::AtomicHdrHistogram(const HdrBucketConfig& config)
+: config_{config}
+, counts_{new atomic<int64_t>[config.counts_len]}
+{
+    reset();
+}
+
+AtomicHdrHistogram::AtomicHdrHistogram(int64_t lowest_trackable_value,
+                                       int64_t highest_trackable_value, int32_t significant_figures)
+: AtomicHdrHistogram{
+    HdrBucketConfig{lowest_trackable_value, highest_trackable_value, significant_figures}}
+{
+}
+
+AtomicHdrHistogram::~AtomicHdrHistogram() = default;
+
+bool AtomicHdrHistogram::record_values(int64_t value, int64_t count) noexcept
+{
+    if (value < 0) {
+        return false;
+    }
+    const int32_t counts_index{counts_index_for(value)};
+    if (counts_index < 0 || config_.counts_len <= counts_index) {
+        return false;
+    }
+    counts_[counts_index].fetch_add(count, memory_order_relaxed);
+    total_count_.fetch_add(count, memory_order_relaxed);
+    return true;
+}
+
+void AtomicHdrHistogram::reset() noexcept
+{
+    for (int32_t i{0}; i < config_.counts_len; ++i) {
+        counts_[i].store(0, memory_order_relaxed);
+    }
+    total_count_.store(0, memory_order_relaxed);
+}
+
+void AtomicHdrHistogram::add_to(HdrHistogram& hist) const noexcept
+{
+    for (int32_t i{0}; i < config_.counts_len; ++i) {
+        if (const auto count = counts_[i].load(memory_order_relaxed); count > 0) {
+            // The lowest value of each bucket maps back to the same bucket.
+            hist.record_values(hist.value_at_index(i), count);
+        }
+    }
+}
+
+int32_t AtomicHdrHistogram::counts_index_for(int64_t value) const noexcept
+{
+    // Same as HdrHistogram.
+    const int32_t pow2ceiling{64 - __builtin_clzll(value | config_.sub_bucket_mask)};
+    const int32_t bucket_index{pow2ceiling - config_.unit_magnitude
+                               - (config_.sub_bucket_half_count_magnitude + 1)};
+    const int32_t sub_bucket_index(value >> (bucket_index + config_.unit_magnitude));
+    return ((bucket_index + 1) << config_.sub_bucket_half_count_magnitude)
+        + (sub_bucket_index - config_.sub_bucket_half_count);
+}
+
+void HdrPhaser::flip_phase() noexcept
+{
+    // The sign of the start epoch identifies the current phase.
+    const bool next_phase_is_even{start_epoch_.load() < 0};
+    int64_t initial_start_value;
+    if (next_phase_is_even) {
+        initial_start_value = 0;
+        even_end_epoch_.store(initial_start_value);
+    } else {
+        initial_start_value = numeric_limits<int64_t>::min();
+        odd_end_epoch_.store(initial_start_value);
+    }
+    const auto start_value_at_flip = start_epoch_.exchange(initial_start_value);
+
+    // Wait for the writers that entered the previous phase to exit.
+    auto& end_epoch = next_phase_is_even ? odd_end_epoch_ : even_end_epoch_;
+    while (end_epoch.load() != start_value_at_flip) {
+        this_thread::yield();
+    }
+}
+
+HdrRecorder::HdrRecorder(const HdrBucketConfig& config)
+: a_{config}
+, b_{config}
+{
+}
+
+HdrRecorder::HdrRecorder(int64_t lowest_trackable_value, int64_t highest_trackable_value,
+                         int32_t significant_figures)
+: HdrRecorder{HdrBucketConfig{lowest_trackable_value, highest_trackable_value, significant_figures}}
+{
+}
+
+HdrRecorder::~HdrRecorder() = default;
+
+void HdrRecorder::interval_histogram(HdrHistogram& hist)
+{
+    lock_guard<mutex> lock{phaser_.reader_mutex()};
+    auto* const prev = active_.load(memory_order_relaxed);
+    auto* const next = prev == &a_ ? &b_ : &a_;
+    next->reset();
+    active_.store(next, memory_order_release);
+    phaser_.flip_phase();
+
+    // No writer can be recording to the previously active histogram.
+    hist.reset();
+    prev->add_to(hist);
+}
+
+HdrHistogram HdrRecorder::interval_histogram()
+{
+    HdrHistogram hist{config()};
+    interval_histogram(hist);
+    return hist;
+}
+
+} // namespace hdr
+} // namespace toolbox
@@ -0,0 +1,175 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOOLBOX_HDR_RECORDER
+#define TOOLBOX_HDR_RECORDER
+
+#include <toolbox/hdr/Histogram.hpp>
+
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <mutex>
+
+namespace toolbox {
+inline namespace hdr {
+
+/// A histogram that may be recorded to concurrently by multiple threads.
+///
+/// Counts are updated with relaxed atomic increments, so recording never blocks. The counts are not
+/// mutually consistent while writers are active; use HdrRecorder to obtain stable snapshots.
+class TOOLBOX_API AtomicHdrHistogram {
+  public:
+    explicit AtomicHdrHistogram(const HdrBucketConfig& config);
+    AtomicHdrHistogram(std::int64_t lowest_trackable_value, std::int64_t highest_trackable_value,
+                       std::int32_t significant_figures);
+    ~AtomicHdrHistogram();
+
+    // Copy.
+    AtomicHdrHistogram(const AtomicHdrHistogram&) = delete;
+    AtomicHdrHistogram& operator=(const AtomicHdrHistogram&) = delete;
+
+    // Move.
+    AtomicHdrHistogram(AtomicHdrHistogram&&) = delete;
+    AtomicHdrHistogram& operator=(AtomicHdrHistogram&&) = delete;
+
+    const HdrBucketConfig& config() const noexcept { return config_; }
+    std::int64_t total_count() const noexcept
+    {
+        return total_count_.load(std::memory_order_relaxed);
+    }
+
+    /// Records a value in the histogram. This function is thread-safe.
+    ///
+    /// \return false if the value is out of range and can't be recorded, true otherwise.
+    bool record_value(std::int64_t value) noexcept { return record_values(value, 1); }
+
+    /// Records count values in the histogram. This function is thread-safe.
+    ///
+    /// \return false if the value is out of range and can't be recorded, true otherwise.
+    bool record_values(std::int64_t value, std::int64_t count) noexcept;
+
+    /// Reset the histogram. This function must not be called concurrently with writers.
+    void reset() noexcept;
+
+    /// Add the recorded values to hist, which must have the same bucket configuration.
+    void add_to(HdrHistogram& hist) const noexcept;
+
+  private:
+    std::int32_t counts_index_for(std::int64_t value) const noexcept;
+
+    const HdrBucketConfig config_;
+    std::atomic<std::int64_t> total_count_{0};
+    std::unique_ptr<std::atomic<std::int64_t>[]> counts_;
+};
+
+/// A writer-reader phaser, as used by HdrHistogram's Recorder.
+///
+/// Writers enter and exit a critical section with wait-free atomic increments. A reader flips the
+/// phase and waits until all writers that entered the critical section in the previous phase have
+/// exited, so that data published by those writers may be safely read.
+class TOOLBOX_API HdrPhaser {
+  public:
+    HdrPhaser() = default;
+
+    // Copy.
+    HdrPhaser(const HdrPhaser&) = delete;
+    HdrPhaser& operator=(const HdrPhaser&) = delete;
+
+    // Move.
+    HdrPhaser(HdrPhaser&&) = delete;
+    HdrPhaser& operator=(HdrPhaser&&) = delete;
+
+    /// Enter a writer critical section.
+    ///
+    /// \return the value that must be passed to writer_exit().
+    std::int64_t writer_enter() noexcept { return start_epoch_.fetch_add(1); }
+
+    /// Exit a writer critical section.
+    void writer_exit(std::int64_t critical_value) noexcept
+    {
+        (critical_value < 0 ? odd_end_epoch_ : even_end_epoch_).fetch_add(1);
+    }
+
+    /// Serialises readers. The lock must be held while calling flip_phase().
+    std::mutex& reader_mutex() noexcept { return reader_mutex_; }
+
+    /// Flip the phase, and wait for all writers in the previous phase to exit.
+    void flip_phase() noexcept;
+
+  private:
+    std::atomic<std::int64_t> start_epoch_{0};
+    std::atomic<std::int64_t> even_end_epoch_{0};
+    std::atomic<std::int64_t> odd_end_epoch_{std::numeric_limits<std::int64_t>::min()};
+    std::mutex reader_mutex_;
+};
+
+/// Records values from multiple threads, and provides stable interval histograms without pausing
+/// the writers.
+///
+/// The recorder is double-buffered: writers record into the active histogram, while a reader swaps
+/// in the inactive histogram and waits, using a phaser, for in-flight writes to the previously
+/// active histogram to complete before reading it.
+class TOOLBOX_API HdrRecorder {
+  public:
+    explicit HdrRecorder(const HdrBucketConfig& config);
+    HdrRecorder(std::int64_t lowest_trackable_value, std::int64_t highest_trackable_value,
+                std::int32_t significant_figures);
+    ~HdrRecorder();
+
+    // Copy.
+    HdrRecorder(const HdrRecorder&) = delete;
+    HdrRecorder& operator=(const HdrRecorder&) = delete;
+
+    // Move.
+    HdrRecorder(HdrRecorder&&) = delete;
+    HdrRecorder& operator=(HdrRecorder&&) = delete;
+
+    const HdrBucketConfig& config() const noexcept { return a_.config(); }
+
+    /// Records a value. This function is thread-safe and wait-free.
+    ///
+    /// \return false if the value is out of range and can't be recorded, true otherwise.
+    bool record_value(std::int64_t value) noexcept { return record_values(value, 1); }
+
+    /// Records count values. This function is thread-safe and wait-free.
+    ///
+    /// \return false if the value is out of range and can't be recorded, true otherwise.
+    bool record_values(std::int64_t value, std::int64_t count) noexcept
+    {
+        const auto critical_value = phaser_.writer_enter();
+        const auto ret = active_.load(std::memory_order_acquire)->record_values(value, count);
+        phaser_.writer_exit(critical_value);
+        return ret;
+    }
+
+    /// Reset hist to the values recorded since the previous interval.
+    ///
+    /// \param hist The interval histogram, which must have the same bucket configuration.
+    void interval_histogram(HdrHistogram& hist);
+
+    /// Returns a new histogram holding the values recorded since the previous interval.
+    HdrHistogram interval_histogram();
+
+  private:
+    HdrPhaser phaser_;
+    AtomicHdrHistogram a_, b_;
+    std::atomic<AtomicHdrHistogram*> active_{&a_};
+};
+
+} // namespace hdr
+} // namespace toolbox
+
+#endif // TOOLBOX_HDR_RECORDER
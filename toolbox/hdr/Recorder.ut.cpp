@@ -0,0 +1,105 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Recorder.hpp"
+
+#include "Utility.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace toolbox;
+
+BOOST_AUTO_TEST_SUITE(RecorderSuite)
+
+BOOST_AUTO_TEST_CASE(AtomicHistogramCase)
+{
+    AtomicHdrHistogram ah{1, 1000, 4};
+    BOOST_TEST(ah.record_value(1));
+    BOOST_TEST(ah.record_values(100, 2));
+    BOOST_TEST(ah.record_value(1000));
+    BOOST_TEST(!ah.record_value(-1));
+    BOOST_TEST(!ah.record_value(32768));
+    BOOST_TEST(ah.total_count() == 4);
+
+    HdrHistogram h{ah.config()};
+    ah.add_to(h);
+    BOOST_TEST(h.total_count() == 4);
+    BOOST_TEST(h.count_at_value(100) == 2);
+    BOOST_TEST(h.min() == 1);
+    BOOST_TEST(h.max() == 1000);
+
+    ah.reset();
+    BOOST_TEST(ah.total_count() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(RecorderIntervalCase)
+{
+    HdrRecorder r{1, 3600 * 1000 * 1000LL, 3};
+    r.record_values(10, 5);
+    auto h = r.interval_histogram();
+    BOOST_TEST(h.total_count() == 5);
+    BOOST_TEST(h.count_at_value(10) == 5);
+
+    r.record_value(20);
+    r.interval_histogram(h);
+    BOOST_TEST(h.total_count() == 1);
+    BOOST_TEST(h.count_at_value(10) == 0);
+    BOOST_TEST(h.count_at_value(20) == 1);
+
+    r.interval_histogram(h);
+    BOOST_TEST(h.total_count() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(RecorderThreadCase)
+{
+    constexpr int Threads{4};
+    constexpr int N{100000};
+    HdrRecorder r{1, 3600 * 1000 * 1000LL, 3};
+
+    vector<thread> writers;
+    for (int i{0}; i < Threads; ++i) {
+        writers.emplace_back([&r, i]() {
+            for (int j{0}; j < N; ++j) {
+                r.record_value(1 + i);
+            }
+        });
+    }
+    // Take intervals while the writers are recording.
+    HdrHistogram h{r.config()};
+    int64_t total{0}, sum{0};
+    for (int i{0}; i < 100; ++i) {
+        r.interval_histogram(h);
+        total += h.total_count();
+        for (int j{0}; j < Threads; ++j) {
+            sum += h.count_at_value(1 + j) * (1 + j);
+        }
+    }
+    for (auto& t : writers) {
+        t.join();
+    }
+    r.interval_histogram(h);
+    total += h.total_count();
+    for (int j{0}; j < Threads; ++j) {
+        sum += h.count_at_value(1 + j) * (1 + j);
+    }
+    BOOST_TEST(total == Threads * N);
+    BOOST_TEST(sum == int64_t{N} * Threads * (Threads + 1) / 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
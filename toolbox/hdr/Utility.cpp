@@ -20,6 +20,7 @@
 
 #include <boost/io/ios_state.hpp>
 
+#include <algorithm>
 #include <cmath>
 #include <iomanip>
 #include <ostream>
@@ -36,6 +37,7 @@ int64_t get_count_at_percentile(const HdrHistogram& h, double percentile) noexce
     const int count_at_percentile = (percentile * h.total_count() / 100) + 0.5;
     return std::max<int64_t>(count_at_percentile, 1);
 }
+
 } // namespace
 
 int64_t min(const HdrHistogram& h) noexcept
@@ -50,17 +52,70 @@ int64_t max(const HdrHistogram& h) noexcept
 
 int64_t value_at_percentile(const HdrHistogram& h, double percentile) noexcept
 {
-    const int64_t count_at_percentile{get_count_at_percentile(h, percentile)};
+    int64_t value;
+    values_at_percentiles(h, &percentile, &value, 1);
+    return value;
+}
 
+void values_at_percentiles(const HdrHistogram& h, const double* percentiles, int64_t* values,
+                           size_t n) noexcept
+{
+    // Values are never negative, so the outputs hold the negated target counts until they are
+    // resolved.
+    int64_t next{0};
+    for (size_t i{0}; i < n; ++i) {
+        const int64_t count_at_percentile{get_count_at_percentile(h, percentiles[i])};
+        values[i] = -count_at_percentile;
+        if (next == 0 || count_at_percentile < next) {
+            next = count_at_percentile;
+        }
+    }
+    if (h.total_count() == 0) {
+        next = 0;
+    }
+    // Resolve the percentiles in order of their target counts, in a single pass over the counts
+    // with a running total. Whole blocks that do not reach the next target are skipped using a
+    // block sum, which the compiler vectorises.
+    constexpr int32_t Block{64};
+    const auto* const counts = h.counts();
+    const auto len = h.counts_len();
     int64_t total{0};
-    HdrIterator iter{h};
-    while (iter.next()) {
-        total += iter.count();
-        if (total >= count_at_percentile) {
-            return h.highest_equivalent_value(iter.value());
+    int32_t index{0};
+    while (next > 0) {
+        for (; index + Block <= len; index += Block) {
+            int64_t sum{0};
+            for (int32_t i{0}; i < Block; ++i) {
+                sum += counts[index + i];
+            }
+            if (total + sum >= next) {
+                break;
+            }
+            total += sum;
+        }
+        for (; index < len; ++index) {
+            total += counts[index];
+            if (total >= next) {
+                break;
+            }
         }
+        if (index == len) {
+            break;
+        }
+        const auto value = h.highest_equivalent_value(h.value_at_index(index++));
+        next = 0;
+        for (size_t i{0}; i < n; ++i) {
+            if (values[i] < 0) {
+                if (-values[i] <= total) {
+                    values[i] = value;
+                } else if (next == 0 || -values[i] < next) {
+                    next = -values[i];
+                }
+            }
+        }
+    }
+    for (size_t i{0}; i < n; ++i) {
+        values[i] = std::max<int64_t>(values[i], 0);
     }
-    return 0;
 }
 
 double mean(const HdrHistogram& h) noexcept
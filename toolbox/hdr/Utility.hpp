@@ -17,6 +17,7 @@
 
 #include <toolbox/Config.h>
 
+#include <cstddef>
 #include <cstdint>
 #include <iosfwd>
 
@@ -35,6 +36,16 @@ TOOLBOX_API std::int64_t max(const HdrHistogram& h) noexcept;
 /// \return the percentile value.
 TOOLBOX_API std::int64_t value_at_percentile(const HdrHistogram& h, double percentile) noexcept;
 
+/// Get the values at several percentiles from a single pass over the histogram's counts, without
+/// allocating memory. The scan stops once the highest percentile has been resolved.
+///
+/// \param h The histogram.
+/// \param percentiles The percentiles to get the values for, in any order.
+/// \param values The output values, one per percentile.
+/// \param n The number of percentiles.
+TOOLBOX_API void values_at_percentiles(const HdrHistogram& h, const double* percentiles,
+                                       std::int64_t* values, std::size_t n) noexcept;
+
 /// Gets the mean for the values in the histogram.
 ///
 /// \param h The histogram.
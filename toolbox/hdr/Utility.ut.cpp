@@ -22,6 +22,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include <cmath>
+#include <thread>
 
 using namespace std;
 using namespace toolbox;
@@ -54,6 +55,81 @@ BOOST_AUTO_TEST_CASE(HighSignificantFiguresCase)
     BOOST_TEST(value_at_percentile(h, 50) == 1048575);
 }
 
+BOOST_AUTO_TEST_CASE(ValuesAtPercentilesCase)
+{
+    HdrHistogram h{1, 3600LL * 1000 * 1000, 3};
+    const double percentiles[] = {99.99, 0, 50, 100, 99, 90, 50};
+    int64_t values[size(percentiles)];
+
+    values_at_percentiles(h, percentiles, values, size(percentiles));
+    for (const auto val : values) {
+        BOOST_TEST(val == 0);
+    }
+
+    uint64_t x{88172645463325252ULL};
+    for (int i{0}; i < 10000; ++i) {
+        // Xorshift.
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        h.record_value(1 + x % 10000000);
+    }
+    values_at_percentiles(h, percentiles, values, size(percentiles));
+    for (size_t i{0}; i < size(percentiles); ++i) {
+        // Compare with a scan over the histogram.
+        const int64_t target{max<int64_t>((percentiles[i] * h.total_count() / 100) + 0.5, 1)};
+        int64_t total{0}, expect{0};
+        HdrIterator iter{h};
+        while (iter.next()) {
+            total += iter.count();
+            if (total >= target) {
+                expect = h.highest_equivalent_value(iter.value());
+                break;
+            }
+        }
+        BOOST_TEST(values[i] == expect);
+        BOOST_TEST(value_at_percentile(h, percentiles[i]) == expect);
+    }
+    BOOST_TEST(values[3] == h.max());
+
+    // Values recorded after a query are reflected in the next.
+    h.record_value(3600LL * 1000 * 1000);
+    BOOST_TEST(value_at_percentile(h, 100) == h.max());
+    h.reset();
+    BOOST_TEST(value_at_percentile(h, 100) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentPercentilesCase)
+{
+    HdrHistogram h{1, 1000000, 3};
+    for (int64_t i{1}; i <= 100000; ++i) {
+        h.record_value(i);
+    }
+    const double percentiles[] = {50, 90, 99, 99.9};
+    int64_t expect[size(percentiles)];
+    values_at_percentiles(h, percentiles, expect, size(percentiles));
+
+    // Queries do not modify the histogram, so const readers may run concurrently.
+    const auto& ch = h;
+    vector<thread> threads;
+    vector<int> mismatches(4);
+    for (size_t t{0}; t < mismatches.size(); ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i{0}; i < 100; ++i) {
+                int64_t values[size(percentiles)];
+                values_at_percentiles(ch, percentiles, values, size(percentiles));
+                mismatches[t] += !equal(begin(values), end(values), begin(expect));
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    for (const auto n : mismatches) {
+        BOOST_TEST(n == 0);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(NaNCase)
 {
     HdrHistogram h{1, 100000, 3};
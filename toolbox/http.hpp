@@ -18,14 +18,18 @@
 #define TOOLBOX_HTTP_HPP
 
 #include "http/App.hpp"
+#include "http/Clnt.hpp"
 #include "http/Conn.hpp"
 #include "http/Error.cpp"
 #include "http/Exception.cpp"
+#include "http/MultiServ.hpp"
 #include "http/Parser.hpp"
 #include "http/Request.hpp"
+#include "http/Router.hpp"
 #include "http/Serv.hpp"
 #include "http/Stream.hpp"
 #include "http/Types.hpp"
 #include "http/Url.hpp"
+#include "http/WebSocket.hpp"
 
 #endif // TOOLBOX_HTTP_HPP
@@ -1,97 +1,879 @@
-#pragma once
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
 
-#include <toolbox/http/Conn.hpp>
-#include <toolbox/net/StreamConnector.hpp>
+#ifndef TOOLBOX_HTTP_CLNT_HPP
+#define TOOLBOX_HTTP_CLNT_HPP
+
+#include <toolbox/http/FastParser.hpp>
+#include <toolbox/http/Request.hpp>
+#include <toolbox/io/Disposer.hpp>
+#include <toolbox/io/EventFd.hpp>
+#include <toolbox/io/File.hpp>
+#include <toolbox/io/Hook.hpp>
+#include <toolbox/io/MultiReactor.hpp>
+#include <toolbox/net/IoSock.hpp>
 #include <toolbox/net/Resolver.hpp>
+#include <toolbox/net/StreamConnector.hpp>
+#include <toolbox/sys/Log.hpp>
+#include <toolbox/util/MemAlloc.hpp>
+#include <toolbox/util/Slot.hpp>
+
+#include <boost/intrusive/list.hpp>
+
+#include <charconv>
+#include <cstring>
+#include <deque>
+#include <memory>
 
 namespace toolbox {
 inline namespace http {
 
-class HttpClnt : public StreamConnector<HttpClnt> {
-    using Base = StreamConnector<HttpClnt>;
+/// Completion slot for client requests. The slot is called exactly once per request, either with a
+/// default error code and the response, or with an error code and an empty response. Requests fail
+/// with std::errc::timed_out if the deadline expires, or with std::errc::connection_aborted if the
+/// connection was closed before the response was received.
+using HttpClntSlot = Slot<CyclTime, std::error_code, const HttpResponse&>;
+
+struct HttpClntConfig {
+    /// Maximum number of connections per origin.
+    std::size_t max_conns{4};
+    /// Maximum number of requests in flight on each connection.
+    std::size_t max_pipeline{16};
+};
+
+class HttpClntOrigin;
+
+namespace detail {
+inline void notify(CyclTime now, HttpClntSlot slot, std::error_code ec,
+                   const HttpResponse& resp) noexcept
+{
+    try {
+        slot(now, ec, resp);
+    } catch (const std::exception& e) {
+        TOOLBOX_ERROR << "error handling http response: " << e.what();
+    }
+}
+
+/// Notifies the reactor's thread, through an eventfd, when a name has been resolved on the
+/// resolver's thread. The waker is shared with the resolver, so it outlives the origin if the
+/// origin is destroyed while the name is being resolved.
+class HttpClntWaker : public IWaker {
+  public:
+    HttpClntWaker()
+    : efd_{0, EFD_NONBLOCK}
+    {
+    }
+    int fd() const noexcept { return efd_.fd(); }
+    void clear()
+    {
+        std::error_code ec;
+        char buf[sizeof(std::int64_t)];
+        os::read(efd_.fd(), {buf, sizeof(buf)}, ec);
+    }
+    void wakeup() noexcept override
+    {
+        std::error_code ec;
+        efd_.write(1, ec);
+    }
+
+  private:
+    EventFd efd_;
+};
+} // namespace detail
+
+/// A keep-alive client connection. Requests are pipelined, and the responses are matched to them
+/// in order.
+class HttpClntConn
+: public MemAlloc
+, public BasicDisposer<HttpClntConn>
+, HttpParserEngine<HttpClntConn> {
+
+    using Parser = HttpParserEngine<HttpClntConn>;
+    friend class BasicDisposer<HttpClntConn>;
+    friend Parser;
+
+    // Automatically unlink when object is destroyed.
+    using AutoUnlinkOption = boost::intrusive::link_mode<boost::intrusive::auto_unlink>;
+
+    /// Size of each socket read.
+    static constexpr std::size_t ReadSize{16 * 1024};
+    /// Maximum number of socket reads per I/O event.
+    static constexpr int MaxReads{4};
+
+    using Parser::parse;
+    using Parser::should_keep_alive;
+    using Parser::status_code;
+
+  public:
+    using Protocol = StreamProtocol;
+    using Endpoint = StreamEndpoint;
+
+    HttpClntConn(CyclTime now, Reactor& r, IoSock&& sock, const Endpoint& ep,
+                 HttpClntOrigin& origin)
+    : Parser{HttpType::Response}
+    , reactor_(r)
+    , sock_{std::move(sock)}
+    , ep_{ep}
+    , sub_(sock_.get(), r.poller(sock_.get()))
+    , origin_{origin}
+    {
+        sub_.add(PollEvents::Read, bind<&HttpClntConn::on_io_event>(this));
+        TOOLBOX_DEBUG << "http_clnt_connect, ep:" << ep_;
+    }
+
+    // Copy.
+    HttpClntConn(const HttpClntConn&) = delete;
+    HttpClntConn& operator=(const HttpClntConn&) = delete;
+
+    // Move.
+    HttpClntConn(HttpClntConn&&) = delete;
+    HttpClntConn& operator=(HttpClntConn&&) = delete;
+
+    const Endpoint& endpoint() const noexcept { return ep_; }
+    boost::intrusive::list_member_hook<AutoUnlinkOption> list_hook;
+
+    /// Returns the number of requests awaiting a response.
+    std::size_t pending() const noexcept { return pending_.size(); }
+    /// Returns false once the connection is closing, and can no longer accept requests.
+    bool usable() const noexcept { return !closing_; }
+    /// The output buffer, to which the next request is written before it is sent.
+    Buffer& output() noexcept { return out_; }
+
+    /// Send the request written to the output buffer at the end of the current reactor cycle.
+    void send(CyclTime now, MonoTime deadline, HttpClntSlot slot)
+    {
+        pending_.push_back({deadline, slot});
+        if (!write_blocked_) {
+            schedule_flush();
+        }
+        if (!tmr_.pending() || deadline < tmr_.expiry()) {
+            schedule_timeout(deadline);
+        }
+    }
+    /// Close the connection without calling the slots of pending requests.
+    void abandon(CyclTime now) noexcept
+    {
+        closing_ = true;
+        pending_.clear();
+        this->dispose(now);
+    }
+
+  protected:
+    void dispose_now(CyclTime now) noexcept;
+
+  private:
+    struct Pending {
+        MonoTime deadline;
+        HttpClntSlot slot;
+        /// True if the slot has been called with std::errc::timed_out, and the response is to be
+        /// discarded.
+        bool expired{false};
+    };
+
+    ~HttpClntConn() = default;
+
+    bool on_message_begin(CyclTime now) noexcept
+    {
+        in_progress_ = true;
+        resp_.clear();
+        return true;
+    }
+    bool on_url(CyclTime now, std::string_view sv) noexcept
+    {
+        // Only supported for HTTP requests.
+        return false;
+    }
+    bool on_status(CyclTime now, std::string_view sv) noexcept
+    {
+        bool ret{false};
+        try {
+            resp_.append_status(sv);
+            ret = true;
+        } catch (const std::exception& e) {
+            TOOLBOX_ERROR << "http_clnt_error, ep:" << ep_ << ", e:" << e.what();
+        }
+        return ret;
+    }
+    bool on_header_field(CyclTime now, std::string_view sv, First first) noexcept
+    {
+        bool ret{false};
+        try {
+            resp_.append_header_field(sv, first);
+            ret = true;
+        } catch (const std::exception& e) {
+            TOOLBOX_ERROR << "http_clnt_error, ep:" << ep_ << ", e:" << e.what();
+        }
+        return ret;
+    }
+    bool on_header_value(CyclTime now, std::string_view sv, First first) noexcept
+    {
+        bool ret{false};
+        try {
+            resp_.append_header_value(sv, first);
+            ret = true;
+        } catch (const std::exception& e) {
+            TOOLBOX_ERROR << "http_clnt_error, ep:" << ep_ << ", e:" << e.what();
+        }
+        return ret;
+    }
+    bool on_headers_end(CyclTime now) noexcept
+    {
+        resp_.set_status_code(status_code());
+        return true;
+    }
+    bool on_body(CyclTime now, std::string_view sv) noexcept
+    {
+        bool ret{false};
+        try {
+            resp_.append_body(sv);
+            ret = true;
+        } catch (const std::exception& e) {
+            TOOLBOX_ERROR << "http_clnt_error, ep:" << ep_ << ", e:" << e.what();
+        }
+        return ret;
+    }
+    bool on_message_end(CyclTime now) noexcept
+    {
+        in_progress_ = false;
+        if (resp_.status_code() / 100 == 1) {
+            // Interim responses precede the final response to the same request.
+            return true;
+        }
+        if (pending_.empty()) {
+            // Unsolicited response.
+            return false;
+        }
+        const auto p = pending_.front();
+        pending_.pop_front();
+        if (!should_keep_alive()) {
+            // Remove the connection from the pool before the slot is called.
+            closing_ = true;
+            this->pause();
+            detach(now);
+        }
+        if (!p.expired) {
+            detail::notify(now, p.slot, {}, resp_);
+        }
+        if (closing_) {
+            close(now, std::make_error_code(std::errc::connection_aborted));
+        } else {
+            on_ready(now);
+        }
+        return true;
+    }
+    bool on_chunk_header(CyclTime now, std::size_t len) noexcept { return true; }
+    bool on_chunk_end(CyclTime now) noexcept { return true; }
+    /// Called when the connection can accept more requests.
+    void on_ready(CyclTime now);
+    /// Remove the connection from the origin's pool. The connection is linked into the pool for as
+    /// long as the origin exists, so the origin is only accessed while the connection is linked.
+    void detach(CyclTime now) noexcept;
+    /// Fail all pending requests, and dispose of the connection.
+    void close(CyclTime now, std::error_code ec) noexcept
+    {
+        closing_ = true;
+        this->pause();
+        // The slots may destroy the client, so the origin is notified first.
+        detach(now);
+        auto pending = std::move(pending_);
+        pending_.clear();
+        fail(now, pending, ec);
+        this->dispose(now);
+    }
+    /// Fail the requests whose slots have not been called. Requests whose deadline has expired fail
+    /// with std::errc::timed_out.
+    static void fail(CyclTime now, const std::deque<Pending>& pending, std::error_code ec) noexcept
+    {
+        const HttpResponse resp;
+        const auto timed_out = std::make_error_code(std::errc::timed_out);
+        for (const auto& p : pending) {
+            if (!p.expired) {
+                detail::notify(now, p.slot, p.deadline <= now.mono_time() ? timed_out : ec, resp);
+            }
+        }
+    }
+    void on_timeout_timer(CyclTime now, Timer& tmr)
+    {
+        auto lock = this->lock_this(now);
+        // Fail the expired requests. Their responses are discarded when they arrive, so that the
+        // other requests on the connection are unaffected. The slots may send more requests, or
+        // close the connection.
+        const HttpResponse resp;
+        const auto timed_out = std::make_error_code(std::errc::timed_out);
+        bool live{false};
+        auto next = MonoTime::max();
+        for (std::size_t i{0}; i < pending_.size(); ++i) {
+            auto& p = pending_[i];
+            if (p.expired) {
+                continue;
+            }
+            if (p.deadline > now.mono_time()) {
+                live = true;
+                next = std::min(next, p.deadline);
+                continue;
+            }
+            TOOLBOX_DEBUG << "http_clnt_timeout, ep:" << ep_;
+            p.expired = true;
+            const auto slot = p.slot;
+            detail::notify(now, slot, timed_out, resp);
+        }
+        if (closing_) {
+            return;
+        }
+        if (!live && !pending_.empty()) {
+            // Every request in flight has expired, so the server may be unresponsive.
+            close(now, std::make_error_code(std::errc::connection_aborted));
+        } else if (live) {
+            schedule_timeout(next);
+        }
+    }
+    void on_io_event(CyclTime now, int fd, PollEvents events)
+    {
+        assert(fd == sock_.get());
+        auto lock = this->lock_this(now);
+        try {
+            if (events & PollEvents::Read) {
+                if (!drain_input(now)) {
+                    close(now, std::make_error_code(std::errc::connection_reset));
+                    return;
+                }
+            }
+            if (closing_ || out_.empty() || (write_blocked_ && !(events & PollEvents::Write))) {
+                return;
+            }
+            if (write_blocked_) {
+                flush_output(now);
+            } else {
+                schedule_flush();
+            }
+        } catch (const std::system_error& e) {
+            TOOLBOX_DEBUG << "http_clnt_error, ep:" << ep_ << ", e:" << e.what();
+            close(now, e.code());
+        } catch (const std::exception& e) {
+            TOOLBOX_DEBUG << "http_clnt_error, ep:" << ep_ << ", e:" << e.what();
+            close(now, std::make_error_code(std::errc::protocol_error));
+        }
+    }
+    void on_flush_hook(CyclTime now)
+    {
+        flush_hook_.unlink();
+        auto lock = this->lock_this(now);
+        try {
+            if (!closing_ && !out_.empty() && !write_blocked_) {
+                flush_output(now);
+            }
+        } catch (const std::system_error& e) {
+            close(now, e.code());
+        }
+    }
+    /// Defer the write until the end of the current reactor cycle, so that pipelined requests are
+    /// written with one syscall per connection.
+    void schedule_flush() noexcept
+    {
+        if (!flush_hook_.is_linked()) {
+            reactor_.add_hook(flush_hook_);
+        }
+    }
+    bool drain_input(CyclTime now)
+    {
+        // Limit the number of reads to avoid starvation.
+        for (int i{0}; i < MaxReads; ++i) {
+            std::error_code ec;
+            const auto buf = in_.prepare(ReadSize);
+            const auto size = sock_.read(buf, ec);
+            if (ec) {
+                // No data available in socket buffer.
+                if (ec == std::errc::operation_would_block) {
+                    break;
+                }
+                throw std::system_error{ec, "read"};
+            }
+            if (size == 0) {
+                flush_input(now);
+                return false;
+            }
+            // Commit actual bytes read.
+            in_.commit(size);
+            // Assume that the TCP stream has been drained if we read less than the requested
+            // amount.
+            if (static_cast<size_t>(size) < buffer_size(buf)) {
+                break;
+            }
+        }
+        flush_input(now);
+        return true;
+    }
+    void flush_input(CyclTime now)
+    {
+        const auto n = parse(now, in_.buffer());
+        if (in_progress_) {
+            // The response refers to the input buffer, which is about to be consumed.
+            resp_.save();
+        }
+        in_.consume(n);
+    }
+    void flush_output(CyclTime now)
+    {
+        // Attempt to flush buffered data.
+        out_.consume(os::write(sock_.get(), out_.buffer()));
+        if (out_.empty()) {
+            if (write_blocked_) {
+                // Restore read-only state after the buffer has been drained.
+                sub_.del(PollEvents::Write);
+                write_blocked_ = false;
+            }
+        } else if (!write_blocked_) {
+            // Set the state to read-write if the entire buffer could not be written.
+            sub_.add(PollEvents::Write);
+            write_blocked_ = true;
+        }
+    }
+    void schedule_timeout(MonoTime deadline)
+    {
+        tmr_ = reactor_.timer(deadline, Priority::Low,
+                              bind<&HttpClntConn::on_timeout_timer>(this));
+    }
+
+    Reactor& reactor_;
+    IoSock sock_;
+    Endpoint ep_;
+    PollHandle sub_;
+    HttpClntOrigin& origin_;
+    Timer tmr_;
+    Hook flush_hook_{bind<&HttpClntConn::on_flush_hook>(this)};
+    Buffer in_, out_;
+    HttpResponse resp_;
+    /// Requests in the order that they were sent.
+    std::deque<Pending> pending_;
+    bool in_progress_{false}, write_blocked_{false}, closing_{false};
+};
+
+/// The pool of connections to a single origin server. Requests are sent on the open connection
+/// with the fewest requests in flight, and are queued while the origin's name is resolved, or
+/// while new connections are established.
+class HttpClntOrigin : public StreamConnector<HttpClntOrigin> {
+    using Base = StreamConnector<HttpClntOrigin>;
     friend Base;
-    using Conn = HttpConn;
+    friend class HttpClntConn;
+
     using ConstantTimeSizeOption = boost::intrusive::constant_time_size<false>;
-    using MemberHookOption = boost::intrusive::member_hook<Conn, decltype(Conn::list_hook),
-                                                           &Conn::list_hook>;
-    using ConnList = boost::intrusive::list<Conn, ConstantTimeSizeOption, MemberHookOption>;
+    using MemberHookOption = boost::intrusive::member_hook<HttpClntConn,
+                                                           decltype(HttpClntConn::list_hook),
+                                                           &HttpClntConn::list_hook>;
+    using ConnList
+        = boost::intrusive::list<HttpClntConn, ConstantTimeSizeOption, MemberHookOption>;
+
   public:
-    HttpClnt(CyclTime now, Reactor& reactor, Resolver& resolver, const std::string& uri)
-    : reactor_{reactor}
+    /// \param authority The host and optional port of the origin, which is sent in the Host
+    /// header.
+    HttpClntOrigin(Reactor& r, Resolver& resolver, const HttpClntConfig& config,
+                   std::string_view authority)
+    : reactor_{r}
     , resolver_{resolver}
-    , uri_{uri}
-    , ep_{parse_stream_endpoint(uri)}
+    , config_{config}
+    , authority_{authority}
+    , waker_{std::make_shared<detail::HttpClntWaker>()}
+    , waker_sub_{waker_->fd(), r.poller(waker_->fd())}
     {
-        // Immediate and then at 5s intervals.
-        tmr_ = reactor_.timer(now.mono_time(), 5s, Priority::Low, bind<&HttpClnt::on_timer>(this));
+        waker_sub_.add(PollEvents::Read, bind<&HttpClntOrigin::on_resolve>(this));
+        std::string_view host{authority}, port{"80"};
+        if (host.front() == '[') {
+            // IPv6 address literal.
+            const auto pos = host.find(']');
+            // The closing bracket must be followed by a port, or end the authority.
+            if (pos == std::string_view::npos
+                || (pos + 1 < host.size() && (host[pos + 1] != ':' || pos + 2 == host.size()))) {
+                throw std::invalid_argument{"invalid authority: " + authority_};
+            }
+            if (pos + 1 < host.size()) {
+                port = host.substr(pos + 2);
+            }
+            uri_ = "tcp6://";
+            uri_ += host.substr(0, pos + 1);
+        } else {
+            if (const auto pos = host.rfind(':'); pos != std::string_view::npos) {
+                port = host.substr(pos + 1);
+                host = host.substr(0, pos);
+            }
+            uri_ = "tcp4://";
+            uri_ += host;
+        }
+        uri_ += ':';
+        uri_ += port;
     }
-    ~HttpClnt()
+    ~HttpClntOrigin()
     {
+        closing_ = true;
         const auto now = CyclTime::current();
-        conn_list_.clear_and_dispose([now](auto* conn) { 
-            conn->dispose(now);
-        });
-        
+        conns_.clear_and_dispose([now](auto* conn) { conn->abandon(now); });
+    }
+
+    // Copy.
+    HttpClntOrigin(const HttpClntOrigin&) = delete;
+    HttpClntOrigin& operator=(const HttpClntOrigin&) = delete;
+
+    // Move.
+    HttpClntOrigin(HttpClntOrigin&&) = delete;
+    HttpClntOrigin& operator=(HttpClntOrigin&&) = delete;
+
+    const std::string& authority() const noexcept { return authority_; }
+    /// Returns the number of open connections.
+    std::size_t connections() const noexcept { return conns_.size(); }
+
+    void request(CyclTime now, HttpMethod method, std::string_view target,
+                 const HttpHeaderViews& headers, std::string_view body, Duration timeout,
+                 HttpClntSlot slot)
+    {
+        const auto deadline = now.mono_time() + timeout;
+        if (auto* const conn = select(); conn && waiting_.empty()) {
+            put_request(conn->output(), method, target, headers, body);
+            conn->send(now, deadline, slot);
+            return;
+        }
+        Waiting w{{}, deadline, slot};
+        put_request(w.data, method, target, headers, body);
+        waiting_.push_back(std::move(w));
+        connect_if_needed(now);
+        if (!waiting_.empty() && (!tmr_.pending() || deadline < tmr_.expiry())) {
+            schedule_expiry(deadline);
+        }
     }
 
   private:
-    void on_sock_prepare(CyclTime now, IoSock& sock)
+    struct Waiting {
+        std::string data;
+        MonoTime deadline;
+        HttpClntSlot slot;
+    };
+
+    static void put(Buffer& buf, std::string_view sv)
+    {
+        std::memcpy(buffer_cast<char*>(buf.prepare(sv.size())), sv.data(), sv.size());
+        buf.commit(sv.size());
+    }
+    static void put(std::string& buf, std::string_view sv) { buf.append(sv.data(), sv.size()); }
+    template <typename BufT>
+    void put_request(BufT& buf, HttpMethod method, std::string_view target,
+                     const HttpHeaderViews& headers, std::string_view body)
+    {
+        put(buf, enum_string(method));
+        put(buf, " ");
+        put(buf, target);
+        put(buf, " HTTP/1.1\r\nHost: ");
+        put(buf, authority_);
+        put(buf, "\r\n");
+        for (const auto& [field, value] : headers) {
+            put(buf, field);
+            put(buf, ": ");
+            put(buf, value);
+            put(buf, "\r\n");
+        }
+        if (!body.empty() || method == HttpMethod::Post || method == HttpMethod::Put
+            || method == HttpMethod::Patch) {
+            char len[24];
+            const auto [end, ec] = std::to_chars(len, len + sizeof(len), body.size());
+            put(buf, "Content-Length: ");
+            put(buf, {len, static_cast<std::size_t>(end - len)});
+            put(buf, "\r\n");
+        }
+        put(buf, "\r\n");
+        put(buf, body);
+    }
+    /// Returns the usable connection with the fewest requests in flight, or null if all
+    /// connections are busy.
+    HttpClntConn* select() noexcept
     {
-        if (sock.is_ip_family()) {
-            // Set the number of SYN retransmits that TCP should send before aborting the attempt to
-            // connect.
-            set_tcp_syn_nt(sock.get(), 1);
+        HttpClntConn* best{nullptr};
+        for (auto& conn : conns_) {
+            if (conn.usable() && conn.pending() < config_.max_pipeline
+                && (!best || conn.pending() < best->pending())) {
+                best = &conn;
+            }
         }
+        return best;
     }
+    void connect_if_needed(CyclTime now)
+    {
+        if (waiting_.empty() || connecting_ || conns_.size() >= config_.max_conns) {
+            return;
+        }
+        if (!resolved_) {
+            if (!future_.valid()) {
+                // The waker notifies on_resolve() when the result is ready.
+                future_ = resolver_.resolve(uri_, SOCK_STREAM, waker_);
+            }
+            return;
+        }
+        connecting_ = true;
+        try {
+            connect(now, reactor_, endpoint_);
+        } catch (const std::system_error& e) {
+            on_connect_error(now, e.code());
+        }
+    }
+    void on_sock_prepare(CyclTime now, IoSock& sock) {}
     void on_sock_connect(CyclTime now, IoSock&& sock, const Endpoint& ep)
     {
-        TOOLBOX_INFO << "connection opened: " << ep;
-        inprogress_ = false;
-
-        // High performance TCP servers could use a custom allocator.
-        auto* const conn = new Conn{now, reactor_, std::move(sock), ep};
-        conn_list_.push_back(*conn);
+        connecting_ = false;
+        // High performance TCP clients could use a custom allocator.
+        auto* const conn = new HttpClntConn{now, reactor_, std::move(sock), ep, *this};
+        conns_.push_back(*conn);
+        on_conn_ready(now, *conn);
+        connect_if_needed(now);
     }
     void on_sock_connect_error(CyclTime now, const std::exception& e)
     {
-        TOOLBOX_ERROR << "failed to connect: " << e.what();
-        aifuture_ = resolver_.resolve(uri_, SOCK_STREAM);
-        inprogress_ = false;
+        auto ec = std::make_error_code(std::errc::connection_refused);
+        // This function is called from the connector's exception handler, so the exception can be
+        // rethrown to recover the error code.
+        try {
+            throw;
+        } catch (const std::system_error& se) {
+            ec = se.code();
+        } catch (...) {
+        }
+        on_connect_error(now, ec);
     }
-    void on_timer(CyclTime now, Timer& tmr)
+    void on_connect_error(CyclTime now, std::error_code ec)
     {
-        if (!conn_list_.empty() || inprogress_) {
+        TOOLBOX_WARNING << "failed to connect to " << authority_ << ": " << ec.message();
+        connecting_ = false;
+        // Resolve the name again for the next attempt.
+        resolved_ = false;
+        if (conns_.empty()) {
+            // Otherwise the queued requests are sent when the open connections become ready.
+            fail_waiting(now, ec);
+        }
+    }
+    void on_conn_ready(CyclTime now, HttpClntConn& conn)
+    {
+        while (!waiting_.empty() && conn.usable() && conn.pending() < config_.max_pipeline) {
+            auto w = std::move(waiting_.front());
+            waiting_.pop_front();
+            put(conn.output(), w.data);
+            conn.send(now, w.deadline, w.slot);
+        }
+    }
+    void on_conn_closed(CyclTime now) noexcept
+    {
+        if (closing_) {
             return;
         }
-        if (aifuture_.valid()) {
-            if (!is_ready(aifuture_)) {
-                TOOLBOX_INFO << "address pending";
-                return;
-            }
-            try {
-                ep_ = ip_endpoint<Endpoint>(aifuture_);
-            } catch (const std::exception& e) {
-                TOOLBOX_ERROR << "failed to resolve address: " << e.what();
-                aifuture_ = resolver_.resolve(uri_, SOCK_STREAM);
-                return;
+        try {
+            connect_if_needed(now);
+        } catch (const std::exception& e) {
+            TOOLBOX_WARNING << "failed to connect to " << authority_ << ": " << e.what();
+        }
+    }
+    void fail_waiting(CyclTime now, std::error_code ec) noexcept
+    {
+        const auto waiting = std::move(waiting_);
+        waiting_.clear();
+        const HttpResponse resp;
+        for (const auto& w : waiting) {
+            detail::notify(now, w.slot, ec, resp);
+        }
+    }
+    void on_resolve(CyclTime now, int fd, PollEvents events)
+    {
+        waker_->clear();
+        if (!future_.valid() || !is_ready(future_)) {
+            return;
+        }
+        try {
+            endpoint_ = ip_endpoint<Endpoint>(future_);
+            resolved_ = true;
+            TOOLBOX_DEBUG << "address resolved: " << endpoint_;
+        } catch (const std::system_error& e) {
+            TOOLBOX_WARNING << "failed to resolve " << authority_ << ": " << e.what();
+            fail_waiting(now, e.code());
+        } catch (const std::exception& e) {
+            TOOLBOX_WARNING << "failed to resolve " << authority_ << ": " << e.what();
+            fail_waiting(now, std::make_error_code(std::errc::host_unreachable));
+        }
+        connect_if_needed(now);
+    }
+    /// Expire queued requests at the earliest deadline.
+    void schedule_expiry(MonoTime deadline)
+    {
+        tmr_ = reactor_.timer(deadline, Priority::Low,
+                              bind<&HttpClntOrigin::on_expiry_timer>(this));
+    }
+    void on_expiry_timer(CyclTime now, Timer& tmr)
+    {
+        // The slots may queue more requests.
+        const HttpResponse resp;
+        for (std::size_t i{0}; i < waiting_.size();) {
+            if (waiting_[i].deadline <= now.mono_time()) {
+                const auto slot = waiting_[i].slot;
+                waiting_.erase(waiting_.begin() + i);
+                detail::notify(now, slot, std::make_error_code(std::errc::timed_out), resp);
+            } else {
+                ++i;
             }
-            TOOLBOX_INFO << "address resolved: " << ep_;
         }
-        TOOLBOX_INFO << "reconnecting";
-        if (!connect(now, reactor_, ep_)) {
-            inprogress_ = true;
+        if (!waiting_.empty()) {
+            const auto it = std::min_element(
+                waiting_.begin(), waiting_.end(),
+                [](const auto& lhs, const auto& rhs) { return lhs.deadline < rhs.deadline; });
+            schedule_expiry(it->deadline);
         }
     }
+
     Reactor& reactor_;
     Resolver& resolver_;
-    const std::string uri_;
+    const HttpClntConfig& config_;
+    const std::string authority_;
+    /// Resolver URI.
+    std::string uri_;
+    AddrInfoFuture future_;
+    std::shared_ptr<detail::HttpClntWaker> waker_;
+    PollHandle waker_sub_;
+    Endpoint endpoint_;
+    /// Expires queued requests.
     Timer tmr_;
-    AddrInfoFuture aifuture_;
-    Endpoint ep_;
-    bool inprogress_{false};
-    // List of active connections.
-    ConnList conn_list_;
+    bool resolved_{false}, connecting_{false}, closing_{false};
+    /// Requests waiting for a connection.
+    std::deque<Waiting> waiting_;
+    ConnList conns_;
 };
 
+inline void HttpClntConn::detach(CyclTime now) noexcept
+{
+    if (list_hook.is_linked()) {
+        list_hook.unlink();
+        origin_.on_conn_closed(now);
+    }
 }
+
+inline void HttpClntConn::dispose_now(CyclTime now) noexcept
+{
+    TOOLBOX_DEBUG << "http_clnt_disconnect, ep:" << ep_;
+    closing_ = true;
+    detach(now);
+    const auto pending = std::move(pending_);
+    delete this;
+    // Neither the connection nor the origin is accessed once the slots are called, because a slot
+    // may destroy the client.
+    fail(now, pending, std::make_error_code(std::errc::connection_aborted));
+}
+
+inline void HttpClntConn::on_ready(CyclTime now)
+{
+    if (list_hook.is_linked()) {
+        origin_.on_conn_ready(now, *this);
+    }
 }
+
+/// A non-blocking HTTP/1.1 client that runs on the reactor. Keep-alive connections are pooled per
+/// origin, and requests are pipelined on them. Names are resolved asynchronously by the Resolver,
+/// which must be run on another thread.
+///
+/// Responses whose body is delimited by the end of the connection are not supported, and fail
+/// with std::errc::connection_reset.
+class HttpClnt {
+  public:
+    HttpClnt(Reactor& r, Resolver& resolver, HttpClntConfig config = {})
+    : reactor_{r}
+    , resolver_{resolver}
+    , config_{config}
+    {
+    }
+    /// Connections are closed without calling the slots of pending requests.
+    ~HttpClnt() = default;
+
+    // Copy.
+    HttpClnt(const HttpClnt&) = delete;
+    HttpClnt& operator=(const HttpClnt&) = delete;
+
+    // Move.
+    HttpClnt(HttpClnt&&) = delete;
+    HttpClnt& operator=(HttpClnt&&) = delete;
+
+    /// Returns the number of open connections.
+    std::size_t connections() const noexcept
+    {
+        std::size_t n{0};
+        for (const auto& origin : origins_) {
+            n += origin->connections();
+        }
+        return n;
+    }
+
+    /// Send a request. The url must have the form "http://host[:port][/path][?query]". The Host
+    /// header, and the Content-Length header where required, are added to the headers.
+    ///
+    /// HEAD requests are not supported: the response parser would wait for the body advertised by
+    /// the Content-Length header, and stall the requests pipelined behind it.
+    ///
+    /// \throw std::invalid_argument if the url is invalid, or the method is HEAD.
+    void request(CyclTime now, HttpMethod method, std::string_view url,
+                 const HttpHeaderViews& headers, std::string_view body, Duration timeout,
+                 HttpClntSlot slot)
+    {
+        if (method == HttpMethod::Head) {
+            throw std::invalid_argument{"unsupported method: HEAD"};
+        }
+        constexpr std::string_view Scheme{"http://"};
+        if (url.compare(0, Scheme.size(), Scheme) != 0) {
+            throw std::invalid_argument{"invalid url: " + std::string{url}};
+        }
+        url.remove_prefix(Scheme.size());
+        const auto pos = std::min(url.find('/'), url.find('?'));
+        const auto authority = url.substr(0, pos);
+        if (authority.empty()) {
+            throw std::invalid_argument{"invalid url: " + std::string{Scheme} + std::string{url}};
+        }
+        std::string_view target{"/"};
+        std::string buf;
+        if (pos != std::string_view::npos) {
+            target = url.substr(pos);
+            if (target.front() == '?') {
+                buf = '/';
+                buf += target;
+                target = buf;
+            }
+        }
+        origin(authority).request(now, method, target, headers, body, timeout, slot);
+    }
+    void get(CyclTime now, std::string_view url, Duration timeout, HttpClntSlot slot)
+    {
+        request(now, HttpMethod::Get, url, {}, {}, timeout, slot);
+    }
+
+  private:
+    HttpClntOrigin& origin(std::string_view authority)
+    {
+        for (auto& origin : origins_) {
+            if (origin->authority() == authority) {
+                return *origin;
+            }
+        }
+        origins_.push_back(
+            std::make_unique<HttpClntOrigin>(reactor_, resolver_, config_, authority));
+        return *origins_.back();
+    }
+
+    Reactor& reactor_;
+    Resolver& resolver_;
+    const HttpClntConfig config_;
+    std::vector<std::unique_ptr<HttpClntOrigin>> origins_;
+};
+
+} // namespace http
+} // namespace toolbox
+
+#endif // TOOLBOX_HTTP_CLNT_HPP
@@ -0,0 +1,260 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "Clnt.hpp"
+#include "TestServ.ut.hpp"
+
+#include <toolbox/net/StreamSock.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <deque>
+#include <thread>
+
+using namespace std;
+using namespace toolbox;
+using namespace toolbox::http::test;
+
+namespace {
+
+/// Responds to each request, in order, after a delay.
+class DelayApp {
+  public:
+    static constexpr auto Delay = 200ms;
+
+    explicit DelayApp(HttpServ& serv)
+    : reactor_{serv.reactor()}
+    {
+        serv.accept(bind<&DelayApp::on_accept>(this));
+    }
+
+  private:
+    void on_accept(CyclTime now, HttpServerConn& conn)
+    {
+        conn_ = &conn;
+        conn.http_message(bind<&DelayApp::on_http_message>(this));
+    }
+    void on_http_message(CyclTime now, const StreamEndpoint& ep, const HttpRequest& req,
+                         HttpStream& os)
+    {
+        tmrs_.push_back(reactor_.timer(now.mono_time() + Delay, Priority::Low,
+                                       bind<&DelayApp::on_timer>(this)));
+    }
+    void on_timer(CyclTime now, Timer& tmr)
+    {
+        auto& os = conn_->output();
+        os.http_status(HttpStatus::Ok, TextPlain);
+        os << "Hello /foo";
+        os.commit();
+        conn_->flush(now);
+    }
+
+    Reactor& reactor_;
+    HttpServerConn* conn_{nullptr};
+    deque<Timer> tmrs_;
+};
+
+/// Runs the resolver on a background thread.
+struct ResolverThread {
+    ResolverThread()
+    : thread{[this]() {
+        while (resolver.run(10ms) >= 0) {
+        }
+    }}
+    {
+    }
+    ~ResolverThread()
+    {
+        resolver.stop();
+        thread.join();
+    }
+    Resolver resolver;
+    std::thread thread;
+};
+
+struct Results {
+    void on_response(CyclTime now, error_code ec, const HttpResponse& resp)
+    {
+        if (ec) {
+            ++errors;
+            last_error = ec;
+        } else {
+            ++responses;
+            BOOST_TEST(resp.status_code() == 200);
+            BOOST_TEST(resp.status() == "OK");
+            if (resp.body() == "Hello /foo") {
+                ++hello;
+            }
+        }
+    }
+    int responses{0}, hello{0}, errors{0};
+    error_code last_error;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(HttpClntSuite)
+
+BOOST_AUTO_TEST_CASE(HttpClntPipelineCase)
+{
+    TestServ serv{CyclTime::now(), {boost::asio::ip::address_v4::loopback(), 0}, 1,
+                  [](CyclTime now, HttpServ& serv) { return make_unique<TestApp>(serv); }};
+    StreamEndpoint ep;
+    serv[0].serv().get_sock_name(ep);
+    const auto url = "http://127.0.0.1:" + to_string(ep.port()) + "/foo?bar=1";
+
+    ResolverThread rt;
+    os::Reactor reactor;
+    HttpClnt clnt{reactor, rt.resolver, {2, 8}};
+    Results results;
+    constexpr int Requests{64};
+    for (int i{0}; i < Requests; ++i) {
+        clnt.get(CyclTime::now(), url, 5s, bind<&Results::on_response>(&results));
+    }
+    BOOST_TEST(poll_until(reactor, [&results]() { return results.responses == Requests; }));
+    BOOST_TEST(results.hello == Requests);
+    BOOST_TEST(results.errors == 0);
+    // The requests are pipelined on a bounded number of keep-alive connections.
+    BOOST_TEST(clnt.connections() <= 2U);
+    BOOST_TEST(serv.connections() <= 2);
+    BOOST_TEST(serv.requests() == Requests);
+
+    // Open connections are reused.
+    const auto accepted = serv[0].stats().accepted.load();
+    clnt.request(CyclTime::now(), HttpMethod::Post, url, {{"Accept", "text/plain"}}, "body", 5s,
+                 bind<&Results::on_response>(&results));
+    BOOST_TEST(poll_until(reactor, [&results]() { return results.responses == Requests + 1; }));
+    BOOST_TEST(serv[0].stats().accepted.load() == accepted);
+
+    BOOST_CHECK_THROW(clnt.get(CyclTime::now(), "https://127.0.0.1/", 5s, {}), invalid_argument);
+    BOOST_CHECK_THROW(clnt.get(CyclTime::now(), "http:///foo", 5s, {}), invalid_argument);
+    BOOST_CHECK_THROW(clnt.request(CyclTime::now(), HttpMethod::Head, url, {}, {}, 5s, {}),
+                      invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(HttpClntIpv6Case)
+{
+    TestServ serv{CyclTime::now(), {boost::asio::ip::address_v6::loopback(), 0}, 1,
+                  [](CyclTime now, HttpServ& serv) { return make_unique<TestApp>(serv); }};
+    StreamEndpoint ep;
+    serv[0].serv().get_sock_name(ep);
+
+    ResolverThread rt;
+    os::Reactor reactor;
+    HttpClnt clnt{reactor, rt.resolver, {2, 8}};
+    Results results;
+    clnt.get(CyclTime::now(), "http://[::1]:" + to_string(ep.port()) + "/foo", 5s,
+             bind<&Results::on_response>(&results));
+    BOOST_TEST(poll_until(reactor, [&results]() { return results.responses == 1; }));
+    BOOST_TEST(results.hello == 1);
+
+    // Without a port, the default port is used.
+    clnt.get(CyclTime::now(), "http://[::1]/foo", 1s, bind<&Results::on_response>(&results));
+    BOOST_TEST(poll_until(reactor, [&results]() { return results.errors == 1; }));
+
+    // The closing bracket must be followed by a port, or end the authority.
+    BOOST_CHECK_THROW(clnt.get(CyclTime::now(), "http://[::1]x80/", 5s, {}), invalid_argument);
+    BOOST_CHECK_THROW(clnt.get(CyclTime::now(), "http://[::1]:/", 5s, {}), invalid_argument);
+    BOOST_CHECK_THROW(clnt.get(CyclTime::now(), "http://[::1/", 5s, {}), invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(HttpClntTimeoutCase)
+{
+    BasicHttpMultiServ<DelayApp> serv{
+        CyclTime::now(), {boost::asio::ip::address_v4::loopback(), 0}, 1,
+        [](CyclTime now, HttpServ& serv) { return make_unique<DelayApp>(serv); }};
+    StreamEndpoint ep;
+    serv[0].serv().get_sock_name(ep);
+    const auto url = "http://127.0.0.1:" + to_string(ep.port()) + "/foo";
+
+    ResolverThread rt;
+    os::Reactor reactor;
+    // Both requests are pipelined on a single connection.
+    HttpClnt clnt{reactor, rt.resolver, {1, 8}};
+    Results results;
+    clnt.get(CyclTime::now(), url, 50ms, bind<&Results::on_response>(&results));
+    clnt.get(CyclTime::now(), url, 5s, bind<&Results::on_response>(&results));
+    BOOST_TEST(poll_until(reactor, [&results]() { return results.errors == 1; }));
+    BOOST_TEST((results.last_error == errc::timed_out));
+    BOOST_TEST(results.responses == 0);
+
+    // The expired request does not affect the other request on the connection, and its response is
+    // discarded.
+    BOOST_TEST(poll_until(reactor, [&results]() { return results.responses == 1; }));
+    BOOST_TEST(results.hello == 1);
+    BOOST_TEST(results.errors == 1);
+    BOOST_TEST(clnt.connections() == 1U);
+    BOOST_TEST(serv[0].stats().accepted.load() == 1U);
+}
+
+BOOST_AUTO_TEST_CASE(HttpClntUnresponsiveCase)
+{
+    // A server that never responds.
+    StreamEndpoint ep{boost::asio::ip::address_v4::loopback(), 0};
+    StreamSockServ serv{ep.protocol()};
+    serv.bind(ep);
+    serv.listen(SOMAXCONN);
+    serv.get_sock_name(ep);
+    const auto url = "http://127.0.0.1:" + to_string(ep.port()) + "/";
+
+    ResolverThread rt;
+    os::Reactor reactor;
+    HttpClnt clnt{reactor, rt.resolver, {1, 8}};
+    Results results;
+    clnt.get(CyclTime::now(), url, 50ms, bind<&Results::on_response>(&results));
+    clnt.get(CyclTime::now(), url, 100ms, bind<&Results::on_response>(&results));
+    BOOST_TEST(poll_until(reactor, [&results]() { return results.errors == 1; }));
+    // The connection is kept open while a request is in flight.
+    BOOST_TEST(clnt.connections() == 1U);
+    BOOST_TEST(poll_until(reactor, [&results]() { return results.errors == 2; }));
+    BOOST_TEST(results.responses == 0);
+    BOOST_TEST((results.last_error == errc::timed_out));
+    // The connection is closed once every request in flight has expired.
+    BOOST_TEST(poll_until(reactor, [&clnt]() { return clnt.connections() == 0U; }));
+}
+
+BOOST_AUTO_TEST_CASE(HttpClntDestroyCase)
+{
+    TestServ serv{CyclTime::now(), {boost::asio::ip::address_v4::loopback(), 0}, 1,
+                  [](CyclTime now, HttpServ& serv) { return make_unique<TestApp>(serv); }};
+    StreamEndpoint ep;
+    serv[0].serv().get_sock_name(ep);
+    const auto url = "http://127.0.0.1:" + to_string(ep.port()) + "/foo";
+
+    ResolverThread rt;
+    os::Reactor reactor;
+    // The first slot destroys the client.
+    struct Owner {
+        void on_response(CyclTime now, error_code ec, const HttpResponse& resp)
+        {
+            ++calls;
+            clnt.reset();
+        }
+        unique_ptr<HttpClnt> clnt;
+        int calls{0};
+    } owner{make_unique<HttpClnt>(reactor, rt.resolver, HttpClntConfig{1, 8})};
+    for (int i{0}; i < 4; ++i) {
+        owner.clnt->get(CyclTime::now(), url, 5s, bind<&Owner::on_response>(&owner));
+    }
+    BOOST_TEST(poll_until(reactor, [&owner]() { return !owner.clnt; }));
+    // The remaining slots are not called.
+    const auto end = MonoClock::now() + 50ms;
+    while (MonoClock::now() < end) {
+        reactor.poll(CyclTime::now(), 1ms);
+    }
+    BOOST_TEST(owner.calls == 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
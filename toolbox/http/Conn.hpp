@@ -20,14 +20,19 @@
 #include "toolbox/io/Handle.hpp"
 #include "toolbox/io/Reactor.hpp"
 #include <exception>
-#include <toolbox/http/Parser.hpp>
+#include <utility>
+#include <toolbox/http/FastParser.hpp>
 #include <toolbox/http/Request.hpp>
 #include <toolbox/http/Stream.hpp>
+#include <toolbox/http/WebSocket.hpp>
+#include <toolbox/http/Writer.hpp>
 #include <toolbox/io/Disposer.hpp>
 #include <toolbox/io/Event.hpp>
+#include <toolbox/io/Hook.hpp>
 #include <toolbox/io/MultiReactor.hpp>
 #include <toolbox/net/Endpoint.hpp>
 #include <toolbox/net/IoSock.hpp>
+#include <toolbox/sys/Limits.hpp>
 #include <toolbox/util/MemAlloc.hpp>
 #include <toolbox/util/Slot.hpp>
 #include <boost/intrusive/list.hpp>
@@ -36,38 +41,66 @@ namespace toolbox {
 inline namespace http {
 class HttpAppBase;
 
+/// Connection and request counters for a server. The counters are updated only by the reactor
+/// thread that owns the server, and may be read from any thread.
+struct alignas(CacheLineSize) HttpServStats {
+    /// Total number of accepted connections.
+    std::atomic<std::int64_t> accepted{0};
+    /// Number of open connections.
+    std::atomic<std::int64_t> connections{0};
+    /// Total number of requests received.
+    std::atomic<std::int64_t> requests{0};
+    /// Total number of write system calls. Responses to pipelined requests are coalesced into a
+    /// single write.
+    std::atomic<std::int64_t> writes{0};
+
+    /// Add n to a counter. A locked read-modify-write is not required, because there is a single
+    /// writer.
+    static void add(std::atomic<std::int64_t>& counter, std::int64_t n) noexcept
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+};
+
 template <typename RequestT, typename ResponseT, bool IsClient>
 class BasicHttpConn
 : public MemAlloc
 , public BasicDisposer<BasicHttpConn<RequestT, ResponseT, IsClient>>
-, BasicHttpParser<BasicHttpConn<RequestT, ResponseT, IsClient>> {
+, HttpParserEngine<BasicHttpConn<RequestT, ResponseT, IsClient>> {
 
     using This = BasicHttpConn<RequestT, ResponseT, IsClient>;
+    using Parser = HttpParserEngine<This>;
     friend class BasicDisposer<This>;
-    friend class BasicHttpParser<This>;
+    friend Parser;
     using Request = RequestT;
     using Response = ResponseT;
 
-    using Parser = BasicHttpParser<This>;
     // Automatically unlink when object is destroyed.
     using AutoUnlinkOption = boost::intrusive::link_mode<boost::intrusive::auto_unlink>;
 
     static constexpr auto IdleTimeout = 5s;
+    /// Size of each socket read.
+    static constexpr std::size_t ReadSize{16 * 1024};
+    /// Maximum number of socket reads per I/O event.
+    static constexpr int MaxReads{4};
+    /// Default interval between WebSocket pings.
+    static constexpr auto WsPingInterval = IdleTimeout;
 
     using Parser::method;
     using Parser::parse;
     using Parser::should_keep_alive;
+    using Parser::status_code;
 
   public:
     using Protocol = StreamProtocol;
     using Endpoint = StreamEndpoint;
 
     BasicHttpConn(CyclTime now, Reactor& r, IoSock&& sock, const Endpoint& ep)
-    : Parser{HttpType::Request}
+    : Parser{IsClient ? HttpType::Response : HttpType::Request}
     , reactor_(r)
     , sock_{std::move(sock)}
     , ep_{ep}
-    , sub_(sock_.get(), r.poller(sock.get()))
+    , sub_(sock_.get(), r.poller(sock_.get()))
     {
         sub_.add(PollEvents::Read, bind<&BasicHttpConn::on_io_event>(this));
         schedule_timeout(now);
@@ -84,6 +117,8 @@ class BasicHttpConn
 
     const Endpoint& endpoint() const noexcept { return ep_; }
     void clear() noexcept { req_.clear(); }
+    /// Set the server counters that are updated by this connection.
+    void set_stats(HttpServStats* stats) noexcept { stats_ = stats; }
     boost::intrusive::list_member_hook<AutoUnlinkOption> list_hook;
 
     void http_connect(Slot<CyclTime, const Endpoint&> slot) {
@@ -101,23 +136,160 @@ class BasicHttpConn
     void http_message(Slot<CyclTime, const Endpoint&, const HttpRequest&, HttpStream&> slot) {
         http_message_ = slot;
     }
+    /// Called with each response received by a client connection.
     void http_response(Slot<CyclTime, const HttpResponse&, HttpStream&> slot) {
         http_response_ = slot;
     }
+    /// Deliver request bodies incrementally, as they are read from the socket, instead of
+    /// buffering them in the request. The body is then empty when http_message is called at the
+    /// end of the request. The view is only valid for the duration of the call.
+    void http_body(Slot<CyclTime, const Endpoint&, const HttpRequest&, std::string_view> slot) {
+        http_body_ = slot;
+    }
+
+    /// Output stream for responses that are written outside of the connection's callbacks.
+    HttpStream& output() noexcept { return outs_; }
+    /// Write the output committed outside of the connection's callbacks, such as chunks of a
+    /// streaming response, at the end of the current reactor cycle. Output counts as activity for
+    /// the purposes of the idle timeout.
+    void flush(CyclTime now)
+    {
+        if (!out_.empty() && !write_blocked_) {
+            schedule_flush();
+        }
+        schedule_timeout(now);
+    }
+    /// Stop reading from the socket, so that TCP flow control applies back-pressure to the peer.
+    /// Input that has already been read is still parsed and delivered. A paused connection is not
+    /// timed out.
+    void pause_input() noexcept
+    {
+        if (!input_paused_) {
+            sub_.del(PollEvents::Read);
+            input_paused_ = true;
+        }
+    }
+    /// Resume reading from the socket.
+    void resume_input(CyclTime now)
+    {
+        if (input_paused_) {
+            sub_.add(PollEvents::Read);
+            input_paused_ = false;
+            schedule_timeout(now);
+        }
+    }
+    bool input_paused() const noexcept { return input_paused_; }
 
-    void http_request(HttpRequest&& req) {
-        req_ = std::move(req);
-        ins_.http_request(req.method(), req.url(), req.headers());
+    /// Accept WebSocket upgrade requests, and deliver complete messages, after fragments have been
+    /// reassembled, to the slot. Upgrade requests are passed to http_message if this slot is not
+    /// set.
+    void ws_message(Slot<CyclTime, const Endpoint&, WsOpcode, std::string_view> slot) {
+        ws_message_ = slot;
     }
+    /// Called after the upgrade response has been written, with the upgrade request. On client
+    /// connections, called once the upgrade response has been validated, with an empty request.
+    void ws_open(Slot<CyclTime, const Endpoint&, const HttpRequest&> slot) {
+        ws_open_ = slot;
+    }
+    /// Set the ping interval. The connection is closed if nothing is received from the peer within
+    /// one interval of a ping.
+    void ws_ping_interval(Duration interval) noexcept { ws_ping_interval_ = interval; }
+    /// Returns true if the connection has been upgraded to WebSocket.
+    bool is_ws() const noexcept { return ws_; }
+    /// Send a WebSocket upgrade request for the target. The connection switches to framing once
+    /// the server's Sec-WebSocket-Accept header has been validated. If the upgrade is refused, then
+    /// http_error is called and the connection is closed.
+    void ws_connect(CyclTime now, std::string_view host, std::string_view target)
+    {
+        static_assert(IsClient, "upgrade requests are sent by clients");
+        ws_key_ = ws_client_key();
+        outs_.reset();
+        outs_ << "GET " << target << " HTTP/1.1\r\nHost: " << host
+              << "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Version: 13"
+                 "\r\nSec-WebSocket-Key: "
+              << ws_key_ << "\r\n\r\n";
+        outs_.commit();
+        outs_.reset();
+        flush(now);
+    }
+
+    /// Send a message. The frame is written at the end of the current reactor cycle.
+    void ws_send(WsOpcode opcode, std::string_view payload)
+    {
+        if (!ws_ || ws_closing_) {
+            return;
+        }
+        if constexpr (IsClient) {
+            const auto mask = ws_random_mask();
+            ws_put_frame(out_, opcode, payload, true, &mask);
+        } else {
+            ws_put_frame(out_, opcode, payload);
+        }
+        if (!write_blocked_) {
+            schedule_flush();
+        }
+    }
+    /// Send a frame that has been encoded once for many connections. Pending output and the frame
+    /// are written with a single gather write, and only the part of the frame that could not be
+    /// written is copied into the output buffer.
+    void ws_send_frame(CyclTime now, ConstBuffer frame)
+    {
+        if (!ws_ || ws_closing_) {
+            return;
+        }
+        if (write_blocked_) {
+            append_output(frame);
+            return;
+        }
+        iovec iov[2];
+        int iovcnt{0};
+        if (!out_.empty()) {
+            iov[iovcnt++] = {const_cast<char*>(out_.str().data()), out_.size()};
+        }
+        iov[iovcnt++] = {const_cast<void*>(buffer_cast<const void*>(frame)), buffer_size(frame)};
+        std::error_code ec;
+        auto n = os::writev(sock_.get(), iov, iovcnt, ec);
+        if (stats_) {
+            HttpServStats::add(stats_->writes, 1);
+        }
+        if (ec) {
+            if (ec != std::errc::operation_would_block) {
+                const std::system_error e{ec, "writev"};
+                on_http_error(now, ep_, e, outs_);
+                this->dispose(now);
+                return;
+            }
+            n = 0;
+        }
+        const auto m = std::min<std::size_t>(n, out_.size());
+        out_.consume(m);
+        append_output(advance(frame, n - m));
+        if (!out_.empty()) {
+            sub_.add(PollEvents::Write);
+            write_blocked_ = true;
+        }
+    }
+    /// Send a Close frame, and close the connection once it has been written.
+    void ws_close(WsCloseCode code)
+    {
+        if (!ws_ || ws_closing_) {
+            return;
+        }
+        const char payload[2]{static_cast<char>(static_cast<std::uint16_t>(code) >> 8),
+                              static_cast<char>(code)};
+        ws_send(WsOpcode::Close, {payload, sizeof(payload)});
+        ws_closing_ = true;
+    }
+
 protected:
     void on_http_connect(CyclTime now, const Endpoint& ep) {
-        TOOLBOX_INFO << "http_connect, ep:"<<ep;
+        TOOLBOX_DEBUG << "http_connect, ep:"<<ep;
         if(http_connect_)
             http_connect_(now, ep);
     }
     
     void on_http_disconnect(CyclTime now, const Endpoint& ep) {
-        TOOLBOX_INFO << "http_disconnect, ep:"<<ep;
+        TOOLBOX_DEBUG << "http_disconnect, ep:"<<ep;
         if(http_disconnect_)
             http_disconnect_(now, ep);        
     }
@@ -132,14 +304,22 @@ protected:
             http_timeout_(now, ep);
     }
     void on_http_message(CyclTime now, const Endpoint& ep, const HttpRequest& req, HttpStream& os) {
-        TOOLBOX_INFO << "http_message, ep:"<<ep<<", req:"<<req;
+        TOOLBOX_DEBUG << "http_message, ep:"<<ep<<", req:"<<req;
         if(http_message_)
             http_message_(now, ep, req, os);
     }
+    void on_ws_message(CyclTime now, const Endpoint& ep, WsOpcode opcode, std::string_view msg) {
+        TOOLBOX_DEBUG << "ws_message, ep:"<<ep<<", size:"<<msg.size();
+        if(ws_message_)
+            ws_message_(now, ep, opcode, msg);
+    }
   protected:
     void dispose_now(CyclTime now) noexcept
     {
         on_http_disconnect(now, ep_); // noexcept
+        if (stats_) {
+            HttpServStats::add(stats_->connections, -1);
+        }
         // Best effort to drain any data still pending in the write buffer before the socket is
         // closed.
         if (!out_.empty()) {
@@ -154,7 +334,11 @@ protected:
     bool on_message_begin(CyclTime now) noexcept
     {
         in_progress_ = true;
-        req_.clear();
+        if constexpr (IsClient) {
+            resp_.clear();
+        } else {
+            req_.clear();
+        }
         return true;
     }
     bool on_url(CyclTime now, std::string_view sv) noexcept
@@ -171,11 +355,16 @@ protected:
     }
     bool on_status(CyclTime now, std::string_view sv) noexcept
     {
-         // Only supported for HTTP responses.
-        resp_.reset();
-        resp_.status(sv);
-        http_response_(now, resp_, ins_);
-        return false;
+        // Only supported for HTTP responses.
+        bool ret{false};
+        try {
+            resp_.append_status(sv);
+            ret = true;
+        } catch (const std::exception& e) {
+            on_http_error(now, ep_, e, outs_);
+            this->dispose(now);
+        }
+        return ret;
     }
     bool on_header_field(CyclTime now, std::string_view sv, First first) noexcept
     {
@@ -198,7 +387,7 @@ protected:
         bool ret{false};
         try {
             if constexpr(IsClient) {
-                req_.append_header_value(sv, first);
+                resp_.append_header_value(sv, first);
             } else {
                 req_.append_header_value(sv, first);
             }
@@ -212,7 +401,7 @@ protected:
     bool on_headers_end(CyclTime now) noexcept
     {
         if constexpr(IsClient) {
-            
+            resp_.set_status_code(status_code());
         } else {
             req_.set_method(method());
         }
@@ -222,7 +411,13 @@ protected:
     {
         bool ret{false};
         try {
-            req_.append_body(sv);
+            if constexpr (IsClient) {
+                resp_.append_body(sv);
+            } else if (http_body_) {
+                http_body_(now, ep_, req_, sv);
+            } else {
+                req_.append_body(sv);
+            }
             ret = true;
         } catch (const std::exception& e) {
             on_http_error(now, ep_, e, outs_);
@@ -235,8 +430,23 @@ protected:
         bool ret{false};
         try {
             in_progress_ = false;
-            req_.flush(); // May throw.
-            on_http_message(now, ep_, req_, outs_);
+            if (stats_) {
+                HttpServStats::add(stats_->requests, 1);
+            }
+            if constexpr (IsClient) {
+                if (!ws_key_.empty()) {
+                    ws_handshake(now);
+                } else if (http_response_) {
+                    http_response_(now, resp_, outs_);
+                }
+            } else {
+                req_.flush(); // May throw.
+                if (const auto key = ws_upgrade_key(req_); ws_message_ && !key.empty()) {
+                    ws_accept(now, key);
+                } else {
+                    on_http_message(now, ep_, req_, outs_);
+                }
+            }
             ret = true;
         } catch (const std::exception& e) {
             on_http_error(now, ep_, e, outs_);
@@ -246,8 +456,144 @@ protected:
     }
     bool on_chunk_header(CyclTime now, std::size_t len) noexcept { return true; }
     bool on_chunk_end(CyclTime now) noexcept { return true; }
+    void ws_accept(CyclTime now, std::string_view key)
+    {
+        outs_.reset();
+        outs_ << http_status_line(HttpStatus::SwitchingProtocols)
+              << "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Accept: "
+              << ws_accept_key(key) << "\r\n\r\n";
+        outs_.commit();
+        outs_.reset();
+        ws_start(now);
+    }
+    void ws_handshake(CyclTime now)
+    {
+        const auto key = std::exchange(ws_key_, {});
+        if (!ws_upgrade_accepted(resp_, key)) {
+            throw std::runtime_error{"websocket upgrade refused"};
+        }
+        ws_start(now);
+    }
+    void ws_start(CyclTime now)
+    {
+        ws_ = true;
+        // Stop the HTTP parser at the end of the upgrade message. Any remaining input is framed.
+        this->pause();
+        tmr_ = reactor_.timer(now.mono_time() + ws_ping_interval_, ws_ping_interval_,
+                              Priority::Low, bind<&BasicHttpConn::on_ping_timer>(this));
+        if (ws_open_) {
+            ws_open_(now, ep_, req_);
+        }
+    }
+    std::size_t ws_parse(CyclTime now)
+    {
+        const auto buf = in_.mutable_buffer();
+        auto* const data = buffer_cast<char*>(buf);
+        const auto size = buffer_size(buf);
+        std::size_t pos{0};
+        while (pos < size && !ws_closing_) {
+            WsFrameHeader hdr;
+            const auto n = ws_parse_header(data + pos, size - pos, hdr);
+            if (n == 0) {
+                break;
+            }
+            if (hdr.masked == IsClient) {
+                throw WsException{WsCloseCode::ProtocolError, "invalid frame masking"};
+            }
+            if (hdr.len > MaxWsMessage) {
+                throw WsException{WsCloseCode::MessageTooBig, "frame too big"};
+            }
+            if (size - pos - n < hdr.len) {
+                // More input is required.
+                break;
+            }
+            auto* const payload = data + pos + n;
+            if (hdr.masked) {
+                ws_mask(payload, hdr.len, hdr.mask);
+            }
+            pos += n + hdr.len;
+            on_ws_frame(now, hdr, {payload, hdr.len});
+        }
+        return pos;
+    }
+    void on_ws_frame(CyclTime now, const WsFrameHeader& hdr, std::string_view payload)
+    {
+        // Any frame shows that the peer is alive.
+        ws_pong_pending_ = false;
+        switch (hdr.opcode) {
+        case WsOpcode::Ping:
+            ws_send(WsOpcode::Pong, payload);
+            return;
+        case WsOpcode::Pong:
+            return;
+        case WsOpcode::Close:
+            if (payload.size() == 1) {
+                // The body of a Close frame must begin with a two-byte status code (RFC 6455
+                // section 5.5.1).
+                throw WsException{WsCloseCode::ProtocolError, "invalid close frame"};
+            }
+            // Echo the status code.
+            ws_close(payload.size() >= 2 ? static_cast<WsCloseCode>(
+                         static_cast<std::uint8_t>(payload[0]) << 8
+                         | static_cast<std::uint8_t>(payload[1]))
+                                         : WsCloseCode::Normal);
+            return;
+        case WsOpcode::Continuation:
+            if (!ws_msg_) {
+                throw WsException{WsCloseCode::ProtocolError, "unexpected continuation frame"};
+            }
+            break;
+        default:
+            if (ws_msg_) {
+                throw WsException{WsCloseCode::ProtocolError, "expected continuation frame"};
+            }
+            if (hdr.fin) {
+                // Unfragmented messages are delivered from the input buffer.
+                on_ws_message(now, ep_, hdr.opcode, payload);
+                return;
+            }
+            ws_msg_ = WsBufferPool::local().acquire();
+            ws_opcode_ = hdr.opcode;
+            break;
+        }
+        if (ws_msg_->size() + payload.size() > MaxWsMessage) {
+            throw WsException{WsCloseCode::MessageTooBig, "message too big"};
+        }
+        auto buf = ws_msg_->prepare(payload.size());
+        std::memcpy(buffer_cast<char*>(buf), payload.data(), payload.size());
+        ws_msg_->commit(payload.size());
+        if (hdr.fin) {
+            auto msg = std::move(ws_msg_);
+            on_ws_message(now, ep_, ws_opcode_, msg->str());
+            WsBufferPool::local().release(std::move(msg));
+        }
+    }
+    void on_ping_timer(CyclTime now, Timer& tmr)
+    {
+        auto lock = this->lock_this(now);
+        if (ws_pong_pending_) {
+            on_http_timeout(now, ep_);
+            this->dispose(now);
+            return;
+        }
+        ws_send(WsOpcode::Ping, {});
+        ws_pong_pending_ = true;
+    }
+    void append_output(ConstBuffer buf)
+    {
+        const auto size = buffer_size(buf);
+        if (size > 0) {
+            std::memcpy(buffer_cast<char*>(out_.prepare(size)), buffer_cast<const char*>(buf),
+                        size);
+            out_.commit(size);
+        }
+    }
     void on_timeout_timer(CyclTime now, Timer& tmr)
     {
+        if (input_paused_) {
+            schedule_timeout(now);
+            return;
+        }
         auto lock = this->lock_this(now);
         on_http_timeout(now, ep_);
         this->dispose(now);
@@ -268,7 +614,11 @@ protected:
             if (out_.empty() || (write_blocked_ && !(events & PollEvents::Write))) {
                 return;
             }
-            flush_output(now);
+            if (write_blocked_) {
+                flush_output(now);
+            } else {
+                schedule_flush();
+            }
         } catch (const HttpException&) {
             // Do not call on_http_error() here, because it will have already been called in one of
             // the noexcept parser callback functions.
@@ -277,12 +627,33 @@ protected:
             this->dispose(now);
         }
     }
+    void on_flush_hook(CyclTime now)
+    {
+        flush_hook_.unlink();
+        auto lock = this->lock_this(now);
+        try {
+            if (!out_.empty() && !write_blocked_) {
+                flush_output(now);
+            }
+        } catch (const std::exception& e) {
+            on_http_error(now, ep_, e, outs_);
+            this->dispose(now);
+        }
+    }
+    /// Defer the write until the end of the current reactor cycle, so that responses to pipelined
+    /// requests, and to requests on other connections, are written with one syscall per connection.
+    void schedule_flush() noexcept
+    {
+        if (!flush_hook_.is_linked()) {
+            reactor_.add_hook(flush_hook_);
+        }
+    }
     bool drain_input(CyclTime now, IoSock& sock)
     {
         // Limit the number of reads to avoid starvation.
-        for (int i{0}; i < 4; ++i) {
+        for (int i{0}; i < MaxReads; ++i) {
             std::error_code ec;
-            const auto buf = in_.prepare(2944);
+            const auto buf = in_.prepare(ReadSize);
             const auto size = sock.read(buf, ec);
             if (ec) {
                 // No data available in socket buffer.
@@ -310,31 +681,64 @@ protected:
         schedule_timeout(now);
         return true;
     }
-    void flush_input(CyclTime now) { 
-        in_.consume(parse(now, in_.buffer())); 
+    void flush_input(CyclTime now)
+    {
+        if (!ws_) {
+            const auto n = parse(now, in_.buffer());
+            if (in_progress_) {
+                // The message refers to the input buffer, which is about to be consumed.
+                if constexpr (IsClient) {
+                    resp_.save();
+                } else {
+                    req_.save();
+                }
+            }
+            in_.consume(n);
+            if (!ws_) {
+                return;
+            }
+        }
+        try {
+            in_.consume(ws_parse(now));
+        } catch (const WsException& e) {
+            on_http_error(now, ep_, e, outs_);
+            ws_close(e.code());
+            in_.consume(in_.size());
+            this->dispose(now);
+        }
     }
     void flush_output(CyclTime now)
     {
         // Attempt to flush buffered data.
+        if (stats_) {
+            HttpServStats::add(stats_->writes, 1);
+        }
         out_.consume(os::write(sock_.get(), out_.buffer()));
         if (out_.empty()) {
-            if (!in_progress_ && !should_keep_alive()) {
+            // A non-persistent connection is closed once the response is complete, which for a
+            // chunked response is after the last-chunk has been committed.
+            if (ws_ ? ws_closing_
+                    : (!IsClient && !in_progress_ && !outs_.chunked() && !should_keep_alive())) {
                 this->dispose(now);
                 return;
             }
             if (write_blocked_) {
                 // Restore read-only state after the buffer has been drained.
-                sub_.events(PollEvents::Read);
+                sub_.del(PollEvents::Write);
                 write_blocked_ = false;
             }
         } else if (!write_blocked_) {
             // Set the state to read-write if the entire buffer could not be written.
-            sub_.events(PollEvents::Read + PollEvents::Write);
+            sub_.add(PollEvents::Write);
             write_blocked_ = true;
         }
     }
     void schedule_timeout(CyclTime now)
     {
+        if (ws_) {
+            // The liveness of WebSocket connections is checked by the ping timer.
+            return;
+        }
         const auto timeout = std::chrono::ceil<Seconds>(now.mono_time() + IdleTimeout);
         tmr_ = reactor_.timer(timeout, Priority::Low, bind<&BasicHttpConn::on_timeout_timer>(this));
     }
@@ -344,12 +748,22 @@ protected:
     Endpoint ep_;
     PollHandle sub_;
     Timer tmr_;
+    Hook flush_hook_{bind<&BasicHttpConn::on_flush_hook>(this)};
     Buffer in_, out_;
     Request req_;
     Response resp_;
     HttpStream ins_{in_};
     HttpStream outs_{out_};
-    bool in_progress_{false}, write_blocked_{false};
+    bool in_progress_{false}, write_blocked_{false}, input_paused_{false};
+    bool ws_{false}, ws_closing_{false}, ws_pong_pending_{false};
+    /// Opcode of the fragmented message in progress.
+    WsOpcode ws_opcode_{WsOpcode::Continuation};
+    /// Fragmented message in progress.
+    std::unique_ptr<Buffer> ws_msg_;
+    /// Sec-WebSocket-Key of the client's upgrade request that is awaiting a response.
+    std::string ws_key_;
+    Duration ws_ping_interval_{WsPingInterval};
+    HttpServStats* stats_{nullptr};
 
     Slot<CyclTime, const Endpoint&> http_connect_;
     Slot<CyclTime, const Endpoint&> http_disconnect_;
@@ -357,6 +771,9 @@ protected:
     Slot<CyclTime, const Endpoint&> http_timeout_;
     Slot<CyclTime, const Endpoint&, const HttpRequest&, HttpStream&> http_message_;
     Slot<CyclTime, const HttpResponse&, HttpStream&> http_response_;
+    Slot<CyclTime, const Endpoint&, const HttpRequest&, std::string_view> http_body_;
+    Slot<CyclTime, const Endpoint&, const HttpRequest&> ws_open_;
+    Slot<CyclTime, const Endpoint&, WsOpcode, std::string_view> ws_message_;
 };
 
 using HttpServerConn = BasicHttpConn<HttpRequest, HttpResponse, false>;
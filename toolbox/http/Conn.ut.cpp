@@ -0,0 +1,222 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "Conn.hpp"
+#include "TestServ.ut.hpp"
+
+#include <toolbox/net/StreamSock.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+using namespace toolbox;
+using namespace toolbox::http::test;
+
+namespace {
+
+/// Streams request bodies with back-pressure, and responds with a chunked event stream.
+class StreamApp {
+  public:
+    explicit StreamApp(HttpServ& serv)
+    : reactor_{serv.reactor()}
+    {
+        serv.accept(bind<&StreamApp::on_accept>(this));
+    }
+
+  private:
+    void on_accept(CyclTime now, HttpServerConn& conn)
+    {
+        conn_ = &conn;
+        conn.http_body(bind<&StreamApp::on_http_body>(this));
+        conn.http_message(bind<&StreamApp::on_http_message>(this));
+    }
+    void on_http_body(CyclTime now, const StreamEndpoint& ep, const HttpRequest& req,
+                      string_view sv)
+    {
+        bytes_ += sv.size();
+        ++chunks_;
+        // Stop reading until the next cycle.
+        conn_->pause_input();
+        tmr_ = reactor_.timer(now.mono_time(), Priority::High, bind<&StreamApp::on_resume>(this));
+    }
+    void on_resume(CyclTime now, Timer& tmr) { conn_->resume_input(now); }
+    void on_http_message(CyclTime now, const StreamEndpoint& ep, const HttpRequest& req,
+                         HttpStream& os)
+    {
+        os.http_status_chunked(HttpStatus::Ok, "text/event-stream");
+        for (int i{0}; i < 3; ++i) {
+            os.begin_chunk();
+            os << "data: " << i << "\n\n";
+            os.commit();
+        }
+        os.begin_chunk();
+        os << "data: " << bytes_ << ' ' << req.body().size() << ' ' << (chunks_ > 1) << "\n\n";
+        os.commit();
+        os.end_chunks();
+    }
+
+    Reactor& reactor_;
+    HttpServerConn* conn_{nullptr};
+    Timer tmr_;
+    size_t bytes_{0}, chunks_{0};
+};
+
+/// Completes a chunked response in a later reactor cycle.
+class DeferredStreamApp {
+  public:
+    explicit DeferredStreamApp(HttpServ& serv)
+    : reactor_{serv.reactor()}
+    {
+        serv.accept(bind<&DeferredStreamApp::on_accept>(this));
+    }
+
+  private:
+    void on_accept(CyclTime now, HttpServerConn& conn)
+    {
+        conn_ = &conn;
+        conn.http_message(bind<&DeferredStreamApp::on_http_message>(this));
+    }
+    void on_http_message(CyclTime now, const StreamEndpoint& ep, const HttpRequest& req,
+                         HttpStream& os)
+    {
+        os.http_status_chunked(HttpStatus::Ok, "text/event-stream");
+        os.begin_chunk();
+        os << "data: 0\n\n";
+        os.commit();
+        tmr_ = reactor_.timer(now.mono_time() + 10ms, Priority::High,
+                              bind<&DeferredStreamApp::on_timer>(this));
+    }
+    void on_timer(CyclTime now, Timer& tmr)
+    {
+        auto& os = conn_->output();
+        os.begin_chunk();
+        os << "data: 1\n\n";
+        os.commit();
+        os.end_chunks();
+        conn_->flush(now);
+    }
+
+    Reactor& reactor_;
+    HttpServerConn* conn_{nullptr};
+    Timer tmr_;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(HttpConnSuite)
+
+BOOST_AUTO_TEST_CASE(HttpPipelineCase)
+{
+    const auto now = CyclTime::now();
+    TestServ serv{now, {boost::asio::ip::address_v4::loopback(), 0}, 1,
+                  [](CyclTime now, HttpServ& serv) { return make_unique<TestApp>(serv); }};
+    StreamEndpoint ep;
+    serv[0].serv().get_sock_name(ep);
+
+    // Pipeline a batch of requests in a single write.
+    constexpr int Depth{16};
+    string reqs;
+    for (int i{0}; i < Depth; ++i) {
+        reqs += "GET / HTTP/1.1\r\n\r\n";
+    }
+    StreamSockClnt clnt{ep.protocol()};
+    clnt.connect(ep);
+    os::write(clnt.get(), {reqs.data(), reqs.size()});
+
+    // Each request is answered in order on the same connection.
+    string resp;
+    char buf[1024];
+    auto count = [&resp]() {
+        int n{0};
+        for (auto pos = resp.find("Hello"); pos != string::npos;
+             pos = resp.find("Hello", pos + 1)) {
+            ++n;
+        }
+        return n;
+    };
+    while (count() < Depth) {
+        const auto n = os::read(clnt.get(), {buf, sizeof(buf)});
+        BOOST_REQUIRE(n > 0);
+        resp.append(buf, n);
+    }
+    BOOST_TEST(count() == Depth);
+    BOOST_TEST(resp.compare(resp.size() - 7, 7, "Hello /") == 0);
+    BOOST_TEST(serv.requests() == Depth);
+    BOOST_TEST(serv.connections() == 1);
+    // The responses are written together at the end of the reactor cycle.
+    BOOST_TEST(serv[0].stats().writes.load() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(HttpStreamCase)
+{
+    const auto now = CyclTime::now();
+    BasicHttpMultiServ<StreamApp> serv{
+        now, {boost::asio::ip::address_v4::loopback(), 0}, 1,
+        [](CyclTime now, HttpServ& serv) { return make_unique<StreamApp>(serv); }};
+    StreamEndpoint ep;
+    serv[0].serv().get_sock_name(ep);
+
+    StreamSockClnt clnt{ep.protocol()};
+    clnt.connect(ep);
+    constexpr size_t BodySize{1 << 20};
+    const string req{"POST / HTTP/1.1\r\nContent-Length: " + to_string(BodySize) + "\r\n\r\n"};
+    os::write(clnt.get(), {req.data(), req.size()});
+    const string body(BodySize, 'x');
+    for (size_t n{0}; n < body.size();) {
+        n += os::write(clnt.get(), {body.data() + n, body.size() - n});
+    }
+
+    string resp;
+    char buf[1024];
+    while (resp.size() < 5 || resp.compare(resp.size() - 5, 5, "0\r\n\r\n") != 0) {
+        const auto n = os::read(clnt.get(), {buf, sizeof(buf)});
+        BOOST_REQUIRE(n > 0);
+        resp.append(buf, n);
+    }
+    BOOST_TEST(resp.find("\r\nTransfer-Encoding: chunked\r\n\r\n") != string::npos);
+    BOOST_TEST(resp.find("\r\n00000009\r\ndata: 2\n\n\r\n") != string::npos);
+    // The body was delivered in several pieces, and was not buffered in the request.
+    BOOST_TEST(resp.find("data: 1048576 0 1\n\n") != string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(HttpStreamCloseCase)
+{
+    const auto now = CyclTime::now();
+    BasicHttpMultiServ<DeferredStreamApp> serv{
+        now, {boost::asio::ip::address_v4::loopback(), 0}, 1,
+        [](CyclTime now, HttpServ& serv) { return make_unique<DeferredStreamApp>(serv); }};
+    StreamEndpoint ep;
+    serv[0].serv().get_sock_name(ep);
+
+    StreamSockClnt clnt{ep.protocol()};
+    clnt.connect(ep);
+    constexpr auto Request = "GET / HTTP/1.1\r\nConnection: close\r\n\r\n"sv;
+    os::write(clnt.get(), {Request.data(), Request.size()});
+
+    // The connection is not closed until the response is complete.
+    string resp;
+    char buf[1024];
+    for (;;) {
+        const auto n = os::read(clnt.get(), {buf, sizeof(buf)});
+        if (n == 0) {
+            break;
+        }
+        resp.append(buf, n);
+    }
+    BOOST_TEST(resp.find("data: 1\n\n") != string::npos);
+    BOOST_TEST(resp.compare(resp.size() - 5, 5, "0\r\n\r\n") == 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,270 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "FastParser.hpp"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace toolbox {
+inline namespace http {
+using namespace std;
+namespace detail {
+namespace {
+
+constexpr bool is_ctl(char c) noexcept
+{
+    const auto u = static_cast<unsigned char>(c);
+    return (u < 0x20 && u != '\t') || u == 0x7f;
+}
+
+// Token characters as defined by RFC 7230.
+constexpr bool is_tchar(char c) noexcept
+{
+    if ((c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z')) {
+        return true;
+    }
+    switch (c) {
+    case '!':
+    case '#':
+    case '$':
+    case '%':
+    case '&':
+    case '\'':
+    case '*':
+    case '+':
+    case '-':
+    case '.':
+    case '^':
+    case '_':
+    case '`':
+    case '|':
+    case '~':
+        return true;
+    }
+    return false;
+}
+
+constexpr char to_lower(char c) noexcept
+{
+    return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+const char* find_ctl_scalar(const char* first, const char* last) noexcept
+{
+    for (; first != last; ++first) {
+        if (is_ctl(*first)) {
+            break;
+        }
+    }
+    return first;
+}
+
+#if defined(__x86_64__)
+// The SIMD variants are compiled for their instruction sets regardless of the build's target
+// architecture, so that they are available to the run-time dispatch below.
+
+__attribute__((target("avx2"))) const char* find_ctl_avx2(const char* first,
+                                                         const char* last) noexcept
+{
+    const auto ctl_max = _mm256_set1_epi8(0x1f);
+    const auto tab = _mm256_set1_epi8('\t');
+    const auto del = _mm256_set1_epi8(0x7f);
+    while (last - first >= 32) {
+        const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+        // Bytes less than or equal to 0x1f are unchanged by the unsigned maximum.
+        const auto lt = _mm256_cmpeq_epi8(_mm256_max_epu8(v, ctl_max), ctl_max);
+        const auto ctl = _mm256_or_si256(_mm256_andnot_si256(_mm256_cmpeq_epi8(v, tab), lt),
+                                         _mm256_cmpeq_epi8(v, del));
+        if (const auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(ctl)); mask != 0) {
+            return first + __builtin_ctz(mask);
+        }
+        first += 32;
+    }
+    return find_ctl_scalar(first, last);
+}
+
+#if !defined(__AVX2__)
+__attribute__((target("sse4.2"))) const char* find_ctl_sse42(const char* first,
+                                                            const char* last) noexcept
+{
+    // Pairs of inclusive ranges, as used by picohttpparser.
+    alignas(16) static const char ranges[16] = "\000\010\012\037\177\177";
+    const auto r = _mm_load_si128(reinterpret_cast<const __m128i*>(ranges));
+    while (last - first >= 16) {
+        const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+        const int i{_mm_cmpestri(r, 6, v, 16,
+                                 _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_LEAST_SIGNIFICANT)};
+        if (i != 16) {
+            return first + i;
+        }
+        first += 16;
+    }
+    return find_ctl_scalar(first, last);
+}
+
+using FindCtl = const char* (*)(const char*, const char*) noexcept;
+
+FindCtl select_find_ctl() noexcept
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return find_ctl_avx2;
+    }
+    if (__builtin_cpu_supports("sse4.2")) {
+        return find_ctl_sse42;
+    }
+    return find_ctl_scalar;
+}
+#endif // !__AVX2__
+#endif // __x86_64__
+
+} // namespace
+
+const char* find_ctl(const char* first, const char* last) noexcept
+{
+#if defined(__AVX2__)
+    return find_ctl_avx2(first, last);
+#elif defined(__x86_64__)
+    // The implementation is selected once, on first use, for the CPU that the process runs on.
+    static const auto impl = select_find_ctl();
+    return impl(first, last);
+#else
+    return find_ctl_scalar(first, last);
+#endif
+}
+
+size_t find_header_end(const char* data, size_t size, size_t from) noexcept
+{
+    // The terminator may straddle the previous search limit.
+    size_t i{from > 3 ? from - 3 : 0};
+    while (i < size) {
+        const auto* const nl = static_cast<const char*>(memchr(data + i, '\n', size - i));
+        if (!nl) {
+            break;
+        }
+        i = nl - data + 1;
+        if (i < size && data[i] == '\n') {
+            return i + 1;
+        }
+        if (i + 1 < size && data[i] == '\r' && data[i + 1] == '\n') {
+            return i + 2;
+        }
+    }
+    return 0;
+}
+
+bool is_token(string_view sv) noexcept
+{
+    if (sv.empty()) {
+        return false;
+    }
+    for (const auto c : sv) {
+        if (!is_tchar(c)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parse_method(string_view sv, HttpMethod& method) noexcept
+{
+    // Fast path for the most common methods.
+    switch (sv.size()) {
+    case 3:
+        if (sv == "GET") {
+            method = HttpMethod::Get;
+            return true;
+        }
+        if (sv == "PUT") {
+            method = HttpMethod::Put;
+            return true;
+        }
+        break;
+    case 4:
+        if (sv == "POST") {
+            method = HttpMethod::Post;
+            return true;
+        }
+        if (sv == "HEAD") {
+            method = HttpMethod::Head;
+            return true;
+        }
+        break;
+    }
+    for (int i{0}; i <= HTTP_SOURCE; ++i) {
+        if (sv == http_method_str(static_cast<http_method>(i))) {
+            method = static_cast<HttpMethod>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool iequals(string_view sv, string_view lower) noexcept
+{
+    if (sv.size() != lower.size()) {
+        return false;
+    }
+    for (size_t i{0}; i < sv.size(); ++i) {
+        if (to_lower(sv[i]) != lower[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool has_token(string_view list, string_view lower) noexcept
+{
+    while (!list.empty()) {
+        const auto pos = list.find(',');
+        auto tok = list.substr(0, pos);
+        list = pos == string_view::npos ? string_view{} : list.substr(pos + 1);
+        while (!tok.empty() && (tok.front() == ' ' || tok.front() == '\t')) {
+            tok.remove_prefix(1);
+        }
+        while (!tok.empty() && (tok.back() == ' ' || tok.back() == '\t')) {
+            tok.remove_suffix(1);
+        }
+        if (iequals(tok, lower)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+string_view last_token(string_view list) noexcept
+{
+    while (!list.empty()) {
+        const auto pos = list.rfind(',');
+        auto tok = pos == string_view::npos ? list : list.substr(pos + 1);
+        list = list.substr(0, pos == string_view::npos ? 0 : pos);
+        while (!tok.empty() && (tok.front() == ' ' || tok.front() == '\t')) {
+            tok.remove_prefix(1);
+        }
+        while (!tok.empty() && (tok.back() == ' ' || tok.back() == '\t')) {
+            tok.remove_suffix(1);
+        }
+        if (!tok.empty()) {
+            return tok;
+        }
+    }
+    return {};
+}
+
+} // namespace detail
+} // namespace http
+} // namespace toolbox
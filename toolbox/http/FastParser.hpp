@@ -0,0 +1,470 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef TOOLBOX_HTTP_FASTPARSER_HPP
+#define TOOLBOX_HTTP_FASTPARSER_HPP
+
+#include <toolbox/Config.h>
+#include <toolbox/http/Exception.hpp>
+#include <toolbox/http/Parser.hpp>
+#include <toolbox/http/Types.hpp>
+#include <toolbox/io/Buffer.hpp>
+#include <toolbox/sys/Time.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+namespace toolbox {
+inline namespace http {
+namespace detail {
+
+/// Returns a pointer to the first control character in [first, last), other than horizontal tab,
+/// or last if there is none. On x86-64, the scan uses AVX2 or SSE4.2 if the CPU supports them,
+/// which is detected at run time unless the build already targets AVX2.
+TOOLBOX_API const char* find_ctl(const char* first, const char* last) noexcept;
+
+/// Returns the size of the header block, including the terminating empty line, or zero if the
+/// block is incomplete.
+///
+/// \param from Offset from which to resume a previous search of the same data.
+TOOLBOX_API std::size_t find_header_end(const char* data, std::size_t size,
+                                        std::size_t from) noexcept;
+
+/// Returns true if sv is a non-empty token, as defined by RFC 7230.
+TOOLBOX_API bool is_token(std::string_view sv) noexcept;
+
+/// Parse a request method.
+///
+/// \return false if the method is unknown.
+TOOLBOX_API bool parse_method(std::string_view sv, HttpMethod& method) noexcept;
+
+/// Returns true if sv is equal to the lower-case string, ignoring case.
+TOOLBOX_API bool iequals(std::string_view sv, std::string_view lower) noexcept;
+
+/// Returns true if the comma-separated list contains the lower-case token, ignoring case.
+TOOLBOX_API bool has_token(std::string_view list, std::string_view lower) noexcept;
+
+/// Returns the last non-empty token in the comma-separated list, or an empty view if there is none.
+TOOLBOX_API std::string_view last_token(std::string_view list) noexcept;
+
+} // namespace detail
+
+/// A picohttpparser-style HTTP/1.x parser, which is a drop-in replacement for BasicHttpParser.
+///
+/// Rather than running a byte-at-a-time state machine, the parser waits until the complete header
+/// block is available, and then parses it in a single pass, using SIMD instructions to scan for the
+/// end of each line. Until the block is complete, no input is consumed, so that tokens are always
+/// contiguous in the caller's buffer, and the search for the end of the block resumes where it
+/// left off. Bodies, including chunked bodies, are parsed incrementally.
+///
+/// Each header field and value is delivered in a single callback. Responses without a length are
+/// delimited by the end of the connection, so their messages are never completed by the parser.
+template <typename DerivedT>
+class BasicHttpFastParser {
+  public:
+    /// The maximum size of a header block.
+    static constexpr std::size_t MaxHeaderSize{80 * 1024};
+
+    explicit BasicHttpFastParser(HttpType type) noexcept
+    : type_{type}
+    {
+    }
+
+    // Copy.
+    BasicHttpFastParser(const BasicHttpFastParser&) noexcept = default;
+    BasicHttpFastParser& operator=(const BasicHttpFastParser&) noexcept = default;
+
+    // Move.
+    BasicHttpFastParser(BasicHttpFastParser&&) noexcept = default;
+    BasicHttpFastParser& operator=(BasicHttpFastParser&&) noexcept = default;
+
+    int http_major() const noexcept { return http_major_; }
+    int http_minor() const noexcept { return http_minor_; }
+    int status_code() const noexcept { return status_code_; }
+    HttpMethod method() const noexcept { return method_; }
+    bool should_keep_alive() const noexcept { return keep_alive_; }
+    bool body_is_final() const noexcept { return body_final_; }
+
+    /// Stop parsing after the current callback returns.
+    void pause() noexcept { paused_ = true; }
+
+  protected:
+    ~BasicHttpFastParser() = default;
+
+    void reset() noexcept
+    {
+        state_ = State::Head;
+        scanned_ = 0;
+        paused_ = false;
+    }
+    /// Returns the number of bytes consumed, which may be less than the buffer size if the input
+    /// ends part way through a header block or chunk header.
+    std::size_t parse(CyclTime now, ConstBuffer buf)
+    {
+        const auto* const data = buffer_cast<const char*>(buf);
+        const auto size = buffer_size(buf);
+        std::size_t pos{0};
+        while (pos < size && !paused_) {
+            const auto* const p = data + pos;
+            const auto len = size - pos;
+            std::size_t n;
+            switch (state_) {
+            case State::Head:
+                n = parse_head(now, p, len);
+                break;
+            case State::Body:
+                n = parse_body(now, p, len);
+                break;
+            case State::BodyEof:
+                n = body(now, p, len, false);
+                break;
+            case State::ChunkSize:
+                n = parse_chunk_size(now, p, len);
+                break;
+            case State::ChunkData:
+                n = parse_chunk_data(now, p, len);
+                break;
+            case State::ChunkEnd:
+                n = parse_chunk_end(now, p, len);
+                break;
+            case State::Trailer:
+            default:
+                n = parse_trailer(now, p, len);
+                break;
+            }
+            if (n == 0) {
+                // More input is required.
+                break;
+            }
+            pos += n;
+        }
+        paused_ = false;
+        return pos;
+    }
+
+  private:
+    enum class State { Head, Body, BodyEof, ChunkSize, ChunkData, ChunkEnd, Trailer };
+
+    DerivedT* derived() noexcept { return static_cast<DerivedT*>(this); }
+
+    [[noreturn]] static void throw_error(const char* what)
+    {
+        throw HttpException{HttpStatus::BadRequest, what};
+    }
+    static void check(bool ok, const char* what)
+    {
+        if (!ok) {
+            throw_error(what);
+        }
+    }
+    /// Returns a pointer to the end of the line, which must end with CRLF or LF.
+    static const char* find_eol(const char* first, const char* last)
+    {
+        const auto* const eol = detail::find_ctl(first, last);
+        check(eol != last, "unterminated line");
+        if (*eol == '\r') {
+            check(eol + 1 != last && eol[1] == '\n', "invalid line ending");
+        } else {
+            check(*eol == '\n', "invalid character");
+        }
+        return eol;
+    }
+    static const char* next_line(const char* eol) noexcept { return eol + (*eol == '\r' ? 2 : 1); }
+
+    std::size_t parse_head(CyclTime now, const char* p, std::size_t len)
+    {
+        // Ignore empty lines between messages.
+        if (*p == '\r' || *p == '\n') {
+            return 1;
+        }
+        const auto end = detail::find_header_end(p, len, scanned_);
+        if (end == 0) {
+            check(len <= MaxHeaderSize, "header overflow");
+            scanned_ = len;
+            return 0;
+        }
+        scanned_ = 0;
+        const auto* const last = p + end;
+
+        content_length_ = 0;
+        has_length_ = has_coding_ = chunked_ = close_ = keep_alive_hdr_ = body_final_ = false;
+        check(derived()->on_message_begin(now), "on_message_begin callback failed");
+
+        auto* eol = find_eol(p, last);
+        if (type_ == HttpType::Request) {
+            parse_request_line(now, p, eol);
+        } else {
+            parse_status_line(now, p, eol);
+        }
+        for (p = next_line(eol); *p != '\r' && *p != '\n'; p = next_line(eol)) {
+            eol = find_eol(p, last);
+            parse_header_line(now, p, eol, true);
+        }
+        keep_alive_ = http_major_ > 1 || (http_major_ == 1 && http_minor_ >= 1) ? !close_
+                                                                                 : keep_alive_hdr_;
+        if (has_coding_) {
+            if (type_ == HttpType::Request) {
+                // RFC 7230 section 3.3.3. Ambiguous framing is rejected to prevent request
+                // smuggling.
+                check(chunked_, "chunked must be the final transfer coding");
+                check(!has_length_, "content length with transfer encoding");
+            } else {
+                // Transfer-Encoding overrides Content-Length.
+                has_length_ = false;
+            }
+        }
+        check(derived()->on_headers_end(now), "on_headers_complete callback failed");
+
+        if (chunked_) {
+            state_ = State::ChunkSize;
+        } else if (has_length_ && content_length_ > 0) {
+            remaining_ = content_length_;
+            state_ = State::Body;
+        } else if (type_ == HttpType::Response && !has_length_ && status_code_ >= 200
+                   && status_code_ != 204 && status_code_ != 304) {
+            // The body is delimited by the end of the connection.
+            keep_alive_ = false;
+            state_ = State::BodyEof;
+        } else {
+            message_end(now);
+        }
+        return end;
+    }
+    void parse_request_line(CyclTime now, const char* p, const char* eol)
+    {
+        const auto* const sp1 = static_cast<const char*>(std::memchr(p, ' ', eol - p));
+        check(sp1, "invalid request line");
+        check(detail::parse_method({p, static_cast<std::size_t>(sp1 - p)}, method_),
+              "invalid method");
+        const auto* const url = sp1 + 1;
+        const auto* const sp2 = static_cast<const char*>(std::memchr(url, ' ', eol - url));
+        check(sp2 && sp2 > url, "invalid url");
+        parse_version(sp2 + 1, eol);
+        check(derived()->on_url(now, {url, static_cast<std::size_t>(sp2 - url)}),
+              "on_url callback failed");
+    }
+    void parse_status_line(CyclTime now, const char* p, const char* eol)
+    {
+        check(eol - p >= 12 && p[8] == ' ', "invalid status line");
+        parse_version(p, p + 8);
+        const auto* const s = p + 9;
+        check(is_digit(s[0]) && is_digit(s[1]) && is_digit(s[2]), "invalid status");
+        status_code_ = (s[0] - '0') * 100 + (s[1] - '0') * 10 + (s[2] - '0');
+        const auto* reason = s + 3;
+        if (reason != eol) {
+            check(*reason == ' ', "invalid status line");
+            ++reason;
+        }
+        check(derived()->on_status(now, {reason, static_cast<std::size_t>(eol - reason)}),
+              "on_status callback failed");
+    }
+    void parse_version(const char* p, const char* last)
+    {
+        check(last - p == 8 && std::memcmp(p, "HTTP/", 5) == 0 && is_digit(p[5]) && p[6] == '.'
+                  && is_digit(p[7]),
+              "invalid version");
+        http_major_ = p[5] - '0';
+        http_minor_ = p[7] - '0';
+    }
+    void parse_header_line(CyclTime now, const char* p, const char* eol, bool interpret)
+    {
+        check(*p != ' ' && *p != '\t', "obsolete line folding");
+        const auto* const colon = static_cast<const char*>(std::memchr(p, ':', eol - p));
+        check(colon, "invalid header");
+        const std::string_view name{p, static_cast<std::size_t>(colon - p)};
+        check(detail::is_token(name), "invalid header field");
+
+        const auto* first = colon + 1;
+        const auto* last = eol;
+        while (first != last && (*first == ' ' || *first == '\t')) {
+            ++first;
+        }
+        while (last != first && (last[-1] == ' ' || last[-1] == '\t')) {
+            --last;
+        }
+        const std::string_view value{first, static_cast<std::size_t>(last - first)};
+        if (interpret) {
+            interpret_header(name, value);
+        }
+        check(derived()->on_header_field(now, name, First::Yes), "on_header_field callback failed");
+        check(derived()->on_header_value(now, value, First::Yes),
+              "on_header_value callback failed");
+    }
+    void interpret_header(std::string_view name, std::string_view value)
+    {
+        switch (name.size()) {
+        case 10:
+            if (detail::iequals(name, "connection")) {
+                close_ = detail::has_token(value, "close");
+                keep_alive_hdr_ = detail::has_token(value, "keep-alive");
+            }
+            break;
+        case 14:
+            if (detail::iequals(name, "content-length")) {
+                check(!value.empty() && value.size() <= 18, "invalid content length");
+                std::size_t n{0};
+                for (const auto c : value) {
+                    check(is_digit(c), "invalid content length");
+                    n = n * 10 + (c - '0');
+                }
+                check(!has_length_ || n == content_length_, "unexpected content length");
+                content_length_ = n;
+                has_length_ = true;
+            }
+            break;
+        case 17:
+            if (detail::iequals(name, "transfer-encoding")) {
+                // Codings accumulate across headers, so the final coding is the last token of the
+                // last non-empty header.
+                if (const auto last = detail::last_token(value); !last.empty()) {
+                    has_coding_ = true;
+                    chunked_ = detail::iequals(last, "chunked");
+                }
+            }
+            break;
+        }
+    }
+    std::size_t body(CyclTime now, const char* p, std::size_t len, bool final)
+    {
+        body_final_ = final;
+        check(derived()->on_body(now, {p, len}), "on_body callback failed");
+        return len;
+    }
+    std::size_t parse_body(CyclTime now, const char* p, std::size_t len)
+    {
+        const auto n = std::min(len, remaining_);
+        remaining_ -= n;
+        body(now, p, n, remaining_ == 0);
+        if (remaining_ == 0) {
+            message_end(now);
+        }
+        return n;
+    }
+    std::size_t parse_chunk_size(CyclTime now, const char* p, std::size_t len)
+    {
+        const auto* const nl = static_cast<const char*>(std::memchr(p, '\n', len));
+        if (!nl) {
+            check(len <= MaxChunkLine, "chunk header overflow");
+            return 0;
+        }
+        std::size_t n{0}, digits{0};
+        for (auto* q = p; q != nl; ++q, ++digits) {
+            const int x{hex_value(*q)};
+            if (x < 0) {
+                // Chunk extensions are ignored.
+                check(digits > 0 && (*q == ';' || *q == ' ' || *q == '\t' || *q == '\r'),
+                      "invalid chunk size");
+                break;
+            }
+            check(digits < 15, "chunk size overflow");
+            n = n * 16 + x;
+        }
+        check(derived()->on_chunk_header(now, n), "on_chunk_header callback failed");
+        if (n == 0) {
+            state_ = State::Trailer;
+        } else {
+            remaining_ = n;
+            state_ = State::ChunkData;
+        }
+        return nl - p + 1;
+    }
+    std::size_t parse_chunk_data(CyclTime now, const char* p, std::size_t len)
+    {
+        const auto n = std::min(len, remaining_);
+        remaining_ -= n;
+        body(now, p, n, false);
+        if (remaining_ == 0) {
+            state_ = State::ChunkEnd;
+        }
+        return n;
+    }
+    std::size_t parse_chunk_end(CyclTime now, const char* p, std::size_t len)
+    {
+        std::size_t n;
+        if (*p == '\n') {
+            n = 1;
+        } else if (len < 2) {
+            return 0;
+        } else {
+            check(p[0] == '\r' && p[1] == '\n', "invalid chunk");
+            n = 2;
+        }
+        check(derived()->on_chunk_end(now), "on_chunk_complete callback failed");
+        state_ = State::ChunkSize;
+        return n;
+    }
+    std::size_t parse_trailer(CyclTime now, const char* p, std::size_t len)
+    {
+        const auto* const nl = static_cast<const char*>(std::memchr(p, '\n', len));
+        if (!nl) {
+            check(len <= MaxHeaderSize, "header overflow");
+            return 0;
+        }
+        const auto* const eol = nl > p && nl[-1] == '\r' ? nl - 1 : nl;
+        if (eol == p) {
+            // The empty line that ends the trailer.
+            check(derived()->on_chunk_end(now), "on_chunk_complete callback failed");
+            message_end(now);
+        } else {
+            check(detail::find_ctl(p, eol) == eol, "invalid character");
+            parse_header_line(now, p, eol, false);
+        }
+        return nl - p + 1;
+    }
+    void message_end(CyclTime now)
+    {
+        state_ = State::Head;
+        check(derived()->on_message_end(now), "on_message_complete callback failed");
+    }
+    static constexpr bool is_digit(char c) noexcept { return c >= '0' && c <= '9'; }
+    static constexpr int hex_value(char c) noexcept
+    {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        }
+        c |= 0x20;
+        return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+    }
+    static constexpr std::size_t MaxChunkLine{1024};
+
+    HttpType type_;
+    State state_{State::Head};
+    bool paused_{false};
+    /// Bytes of an incomplete header block that have already been searched.
+    std::size_t scanned_{0};
+    /// Bytes remaining in the body or current chunk.
+    std::size_t remaining_{0};
+    std::size_t content_length_{0};
+    HttpMethod method_{HttpMethod::Get};
+    int http_major_{0}, http_minor_{0}, status_code_{0};
+    bool has_length_{false}, has_coding_{false}, chunked_{false}, close_{false};
+    bool keep_alive_hdr_{false};
+    bool keep_alive_{false}, body_final_{false};
+};
+
+/// The parser used by HTTP connections, which is selected at build time.
+#if TOOLBOX_HAVE_FAST_HTTP_PARSER
+template <typename DerivedT>
+using HttpParserEngine = BasicHttpFastParser<DerivedT>;
+#else
+template <typename DerivedT>
+using HttpParserEngine = BasicHttpParser<DerivedT>;
+#endif
+
+} // namespace http
+} // namespace toolbox
+
+#endif // TOOLBOX_HTTP_FASTPARSER_HPP
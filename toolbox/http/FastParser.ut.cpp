@@ -0,0 +1,338 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "FastParser.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace toolbox;
+
+namespace {
+
+struct Message {
+    HttpMethod method{};
+    int status{0};
+    string url, reason, body;
+    vector<pair<string, string>> headers;
+    size_t chunks{0};
+    bool keep_alive{false};
+};
+
+bool operator==(const Message& lhs, const Message& rhs) noexcept
+{
+    return lhs.method == rhs.method && lhs.status == rhs.status && lhs.url == rhs.url
+        && lhs.reason == rhs.reason && lhs.body == rhs.body && lhs.headers == rhs.headers
+        && lhs.chunks == rhs.chunks && lhs.keep_alive == rhs.keep_alive;
+}
+
+template <template <typename> class EngineT>
+class TestParser : public EngineT<TestParser<EngineT>> {
+    using Parser = EngineT<TestParser<EngineT>>;
+    friend Parser;
+
+  public:
+    using Parser::Parser;
+
+    const auto& messages() const noexcept { return messages_; }
+
+    /// Parse the input in fragments of at most n bytes, keeping unconsumed bytes in the buffer.
+    void feed(string_view in, size_t n = string_view::npos)
+    {
+        string buf;
+        while (!in.empty()) {
+            const auto frag = in.substr(0, n);
+            in.remove_prefix(frag.size());
+            buf.append(frag.data(), frag.size());
+            buf.erase(0, Parser::parse(CyclTime::current(), {buf.data(), buf.size()}));
+        }
+        BOOST_TEST(buf.empty());
+    }
+
+  private:
+    bool on_message_begin(CyclTime now) noexcept
+    {
+        msg_ = {};
+        return true;
+    }
+    bool on_url(CyclTime now, string_view sv) noexcept
+    {
+        msg_.url.append(sv.data(), sv.size());
+        return true;
+    }
+    bool on_status(CyclTime now, string_view sv) noexcept
+    {
+        msg_.reason.append(sv.data(), sv.size());
+        return true;
+    }
+    bool on_header_field(CyclTime now, string_view sv, First first) noexcept
+    {
+        if (first == First::Yes) {
+            msg_.headers.emplace_back();
+        }
+        msg_.headers.back().first.append(sv.data(), sv.size());
+        return true;
+    }
+    bool on_header_value(CyclTime now, string_view sv, First first) noexcept
+    {
+        msg_.headers.back().second.append(sv.data(), sv.size());
+        return true;
+    }
+    bool on_headers_end(CyclTime now) noexcept
+    {
+        msg_.method = this->method();
+        msg_.status = this->status_code();
+        msg_.keep_alive = this->should_keep_alive();
+        return true;
+    }
+    bool on_body(CyclTime now, string_view sv) noexcept
+    {
+        msg_.body.append(sv.data(), sv.size());
+        return true;
+    }
+    bool on_message_end(CyclTime now) noexcept
+    {
+        messages_.push_back(msg_);
+        return true;
+    }
+    bool on_chunk_header(CyclTime now, size_t len) noexcept
+    {
+        if (len > 0) {
+            ++msg_.chunks;
+        }
+        return true;
+    }
+    bool on_chunk_end(CyclTime now) noexcept { return true; }
+
+    Message msg_;
+    vector<Message> messages_;
+};
+
+using FastParser = TestParser<BasicHttpFastParser>;
+using SlowParser = TestParser<BasicHttpParser>;
+
+constexpr auto Requests =                          //
+    "GET /path/file.html?foo=bar HTTP/1.1\r\n"     //
+    "Host: www.reactivemarkets.com\r\n"            //
+    "User-Agent:  HTTPTool/1.0\r\n"                //
+    "Accept: */*\r\n"                              //
+    "\r\n"                                         //
+    "POST /api/order HTTP/1.1\r\n"                 //
+    "Content-Type: application/json\r\n"           //
+    "content-length: 13\r\n"                       //
+    "\r\n"                                         //
+    "{\"qty\":10000}"                              //
+    "PUT /api/upload HTTP/1.1\r\n"                 //
+    "Transfer-Encoding: chunked\r\n"               //
+    "\r\n"                                         //
+    "5;ext=1\r\nHello\r\n"                         //
+    "8\r\n, World!\r\n"                            //
+    "0\r\n"                                        //
+    "Checksum: abc\r\n"                            //
+    "\r\n"                                         //
+    "DELETE /api/order/1 HTTP/1.0\r\n"             //
+    "Connection: keep-alive\r\n"                   //
+    "\r\n"                                         //
+    "OPTIONS * HTTP/1.1\n"                         //
+    "Connection: Upgrade, close\n"                 //
+    "\n"sv;
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(FastParserSuite)
+
+BOOST_AUTO_TEST_CASE(FastParserFindCtlCase)
+{
+    string s(100, 'x');
+    s[50] = '\t';
+    s[70] = static_cast<char>(0x80);
+    BOOST_TEST(detail::find_ctl(s.data(), s.data() + s.size()) == s.data() + s.size());
+    for (size_t i{0}; i < s.size(); ++i) {
+        for (const char c : {'\r', '\n', '\0', '\x1f', '\x7f'}) {
+            auto t = s;
+            t[i] = c;
+            BOOST_TEST(detail::find_ctl(t.data(), t.data() + t.size()) == t.data() + i);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(FastParserFindHeaderEndCase)
+{
+    constexpr auto Head = "GET / HTTP/1.1\r\nHost: x\r\n\r\nbody"sv;
+    BOOST_TEST(detail::find_header_end(Head.data(), Head.size(), 0) == Head.size() - 4);
+    BOOST_TEST(detail::find_header_end(Head.data(), Head.size() - 5, 0) == 0U);
+    // Resume a search where the terminator straddles the previous limit.
+    for (size_t i{0}; i < Head.size() - 4; ++i) {
+        BOOST_TEST(detail::find_header_end(Head.data(), Head.size(), i) == Head.size() - 4);
+    }
+    BOOST_TEST(detail::find_header_end("GET / HTTP/1.0\n\n", 16, 0) == 16U);
+}
+
+BOOST_AUTO_TEST_CASE(FastParserHelpersCase)
+{
+    HttpMethod method{};
+    BOOST_TEST(detail::parse_method("MKCALENDAR", method));
+    BOOST_TEST(method == HttpMethod::MkCalendar);
+    BOOST_TEST(!detail::parse_method("get", method));
+    BOOST_TEST(!detail::parse_method("", method));
+
+    BOOST_TEST(detail::is_token("X-Custom_Header"));
+    BOOST_TEST(!detail::is_token("Bad Header"));
+    BOOST_TEST(!detail::is_token(""));
+
+    BOOST_TEST(detail::iequals("Content-Length", "content-length"));
+    BOOST_TEST(!detail::iequals("Content-Length", "content-type"));
+    BOOST_TEST(detail::has_token("gzip, Chunked", "chunked"));
+    BOOST_TEST(!detail::has_token("chunkedx", "chunked"));
+    BOOST_TEST(detail::last_token("gzip, chunked ,") == "chunked");
+    BOOST_TEST(detail::last_token("gzip") == "gzip");
+    BOOST_TEST(detail::last_token(" , ").empty());
+}
+
+BOOST_AUTO_TEST_CASE(FastParserRequestsCase)
+{
+    FastParser h{HttpType::Request};
+    h.feed(Requests);
+
+    const auto& msgs = h.messages();
+    BOOST_TEST(msgs.size() == 5U);
+
+    BOOST_TEST(msgs[0].method == HttpMethod::Get);
+    BOOST_TEST(msgs[0].url == "/path/file.html?foo=bar");
+    BOOST_TEST(msgs[0].headers.size() == 3U);
+    BOOST_TEST(msgs[0].headers[1].first == "User-Agent");
+    BOOST_TEST(msgs[0].headers[1].second == "HTTPTool/1.0");
+    BOOST_TEST(msgs[0].keep_alive);
+
+    BOOST_TEST(msgs[1].method == HttpMethod::Post);
+    BOOST_TEST(msgs[1].body == "{\"qty\":10000}");
+
+    BOOST_TEST(msgs[2].method == HttpMethod::Put);
+    BOOST_TEST(msgs[2].body == "Hello, World!");
+    BOOST_TEST(msgs[2].chunks == 2U);
+    BOOST_TEST(msgs[2].headers.size() == 2U);
+    BOOST_TEST(msgs[2].headers[1].first == "Checksum");
+
+    BOOST_TEST(msgs[3].method == HttpMethod::Delete);
+    BOOST_TEST(msgs[3].keep_alive);
+
+    BOOST_TEST(msgs[4].method == HttpMethod::Options);
+    BOOST_TEST(msgs[4].url == "*");
+    BOOST_TEST(!msgs[4].keep_alive);
+}
+
+BOOST_AUTO_TEST_CASE(FastParserCompatCase)
+{
+    // Both engines must produce the same messages.
+    SlowParser slow{HttpType::Request};
+    slow.feed(Requests);
+
+    FastParser fast{HttpType::Request};
+    fast.feed(Requests);
+    BOOST_TEST((fast.messages() == slow.messages()));
+}
+
+BOOST_AUTO_TEST_CASE(FastParserIncrementalCase)
+{
+    FastParser whole{HttpType::Request};
+    whole.feed(Requests);
+    for (size_t n{1}; n < Requests.size(); ++n) {
+        FastParser h{HttpType::Request};
+        h.feed(Requests, n);
+        BOOST_TEST((h.messages() == whole.messages()));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(FastParserResponseCase)
+{
+    constexpr auto Responses =         //
+        "HTTP/1.1 200 OK\r\n"          //
+        "Content-Length: 5 \r\n"       //
+        "\r\n"                         //
+        "Hello"                        //
+        "HTTP/1.1 204 No Content\r\n"  //
+        "\r\n"                         //
+        "HTTP/1.0 404 Not Found\r\n"   //
+        "Content-Type: text/plain\r\n" //
+        "\r\n"                         //
+        "Not"sv;
+
+    FastParser h{HttpType::Response};
+    h.feed(Responses);
+
+    // The last response is delimited by the end of the connection.
+    const auto& msgs = h.messages();
+    BOOST_TEST(msgs.size() == 2U);
+    BOOST_TEST(msgs[0].status == 200);
+    BOOST_TEST(msgs[0].reason == "OK");
+    // Trailing whitespace is not part of the value.
+    BOOST_TEST(msgs[0].headers[0].second == "5");
+    BOOST_TEST(msgs[0].body == "Hello");
+    BOOST_TEST(msgs[1].status == 204);
+    BOOST_TEST(!h.should_keep_alive());
+}
+
+BOOST_AUTO_TEST_CASE(FastParserErrorCase)
+{
+    const auto fails = [](string_view msg) {
+        FastParser h{HttpType::Request};
+        try {
+            h.feed(msg);
+        } catch (const HttpException& e) {
+            return toolbox::http_status(e.code()) == HttpStatus::BadRequest;
+        }
+        return false;
+    };
+    BOOST_TEST(fails("FOO / HTTP/1.1\r\n\r\n"));
+    BOOST_TEST(fails("GET / HTTP/1.x\r\n\r\n"));
+    BOOST_TEST(fails("GET  HTTP/1.1\r\n\r\n"));
+    BOOST_TEST(fails("GET / HTTP/1.1\r\nHost: x\r\n folded\r\n\r\n"));
+    BOOST_TEST(fails("GET / HTTP/1.1\r\nBad Name: x\r\n\r\n"));
+    BOOST_TEST(fails("GET / HTTP/1.1\r\nHost: a\rb\r\n\r\n"));
+    BOOST_TEST(fails("POST / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n"));
+    BOOST_TEST(fails("POST / HTTP/1.1\r\nContent-Length: 1\r\nContent-Length: 2\r\n\r\n"));
+    BOOST_TEST(fails("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nxyz\r\n"));
+    BOOST_TEST(fails("GET / HTTP/1.1\r\nHost: " + string(FastParser::MaxHeaderSize, 'x')));
+
+    // Request smuggling.
+    BOOST_TEST(fails("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\nContent-Length: 3\r\n\r\n"
+                     "0\r\n\r\n"));
+    BOOST_TEST(fails("POST / HTTP/1.1\r\nTransfer-Encoding: chunked, gzip\r\n\r\n0\r\n\r\n"));
+    BOOST_TEST(fails("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\nTransfer-Encoding: gzip\r\n"
+                     "\r\n0\r\n\r\n"));
+    BOOST_TEST(fails("POST / HTTP/1.1\r\nTransfer-Encoding: identity\r\n\r\n"));
+}
+
+BOOST_AUTO_TEST_CASE(FastParserTransferEncodingCase)
+{
+    // Codings accumulate across headers, and chunked is the final coding.
+    FastParser h{HttpType::Request};
+    h.feed("POST / HTTP/1.1\r\nTransfer-Encoding: gzip\r\nTransfer-Encoding: chunked\r\n"
+           "Transfer-Encoding:\r\n\r\n3\r\nabc\r\n0\r\n\r\n"sv);
+    BOOST_TEST(h.messages().size() == 1U);
+    BOOST_TEST(h.messages()[0].body == "abc");
+
+    // Transfer-Encoding overrides Content-Length in responses.
+    FastParser r{HttpType::Response};
+    r.feed("HTTP/1.1 200 OK\r\nContent-Length: 10\r\nTransfer-Encoding: chunked\r\n\r\n"
+           "3\r\nabc\r\n0\r\n\r\n"sv);
+    BOOST_TEST(r.messages().size() == 1U);
+    BOOST_TEST(r.messages()[0].body == "abc");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
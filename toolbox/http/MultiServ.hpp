@@ -0,0 +1,197 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef TOOLBOX_HTTP_MULTISERV_HPP
+#define TOOLBOX_HTTP_MULTISERV_HPP
+
+#include <toolbox/http/Serv.hpp>
+#include <toolbox/io/Runner.hpp>
+#include <toolbox/sys/Thread.hpp>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace toolbox {
+inline namespace http {
+
+/// BasicHttpMultiServ runs an HTTP server on each of a pool of worker threads.
+///
+/// Each worker has its own reactor, acceptor and application, so that no state is shared between
+/// workers. The acceptors are bound to the same endpoint with SO_REUSEPORT, and the kernel
+/// distributes incoming connections between them. Connection and request counters are kept per
+/// worker.
+///
+/// \tparam AppT The application type, which is instantiated once per worker.
+template <typename AppT, typename ConnT = HttpServerConn, typename ReactorT = os::Reactor>
+class BasicHttpMultiServ {
+  public:
+    using App = AppT;
+    using Conn = ConnT;
+    using Serv = BasicHttpServ<ConnT>;
+    using Endpoint = StreamEndpoint;
+
+    /// Creates the application for a worker's server. The factory is called from the thread that
+    /// constructs the BasicHttpMultiServ, before any worker threads are started.
+    using AppFactory = std::function<std::unique_ptr<AppT>(CyclTime, Serv&)>;
+
+    class Worker {
+        friend class BasicHttpMultiServ;
+
+      public:
+        Worker(CyclTime now, std::size_t id, const Endpoint& ep, const AppFactory& factory)
+        : id_{id}
+        , reactor_{1024}
+        , serv_{std::make_unique<Serv>(now, reactor_, ep, ReusePort::Yes)}
+        {
+            app_ = factory(now, *serv_);
+        }
+        ~Worker()
+        {
+            // Connections hold slots bound to the application, so they are disposed first.
+            serv_.reset();
+        }
+
+        // Copy.
+        Worker(const Worker&) = delete;
+        Worker& operator=(const Worker&) = delete;
+
+        // Move.
+        Worker(Worker&&) = delete;
+        Worker& operator=(Worker&&) = delete;
+
+        std::size_t id() const noexcept { return id_; }
+        ReactorT& reactor() noexcept { return reactor_; }
+        Serv& serv() noexcept { return *serv_; }
+        AppT& app() noexcept { return *app_; }
+        /// The counters may be read from any thread.
+        const HttpServStats& stats() const noexcept { return serv_->stats(); }
+
+      private:
+        const std::size_t id_;
+        ReactorT reactor_;
+        std::unique_ptr<AppT> app_;
+        std::unique_ptr<Serv> serv_;
+        std::thread thread_;
+        std::atomic<bool> exited_{false};
+    };
+
+    /// \param ep The endpoint. If the port is zero, then the port assigned to the first worker is
+    /// used by the others.
+    /// \param workers The number of workers.
+    /// \param factory Creates the application for each worker.
+    /// \param name The thread name prefix; each thread's name is suffixed with its worker id.
+    /// \param cpus An optional isolcpus-style set of CPUs, which are assigned to the workers in
+    /// order, so that each worker is pinned to its own CPU.
+    BasicHttpMultiServ(CyclTime now, const Endpoint& ep, std::size_t workers, AppFactory factory,
+                       const std::string& name = "http", std::string_view cpus = {})
+    {
+        workers_.reserve(workers);
+        auto bind_ep = ep;
+        for (std::size_t i{0}; i < workers; ++i) {
+            workers_.push_back(std::make_unique<Worker>(now, i, bind_ep, factory));
+            if (i == 0) {
+                workers_.front()->serv().get_sock_name(bind_ep);
+            }
+        }
+        const auto cpu_list = make_cpu_list(cpus);
+        for (auto& w : workers_) {
+            ThreadConfig config{name + std::to_string(w->id())};
+            if (!cpu_list.empty()) {
+                config.affinity = std::to_string(cpu_list[w->id() % cpu_list.size()]);
+            }
+            w->thread_ = std::thread{[&r = w->reactor_, &exited = w->exited_, config]() {
+                auto fn = [&r]() { r.run(); };
+                run_thread(fn, config);
+                exited.store(true, std::memory_order_release);
+            }};
+        }
+        // Reactor::stop() is ignored until the reactor is open, so the destructor could otherwise
+        // miss a worker that has not yet entered run() and block forever on join().
+        for (auto& w : workers_) {
+            while (w->reactor_.state() != State::Open
+                   && !w->exited_.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+    ~BasicHttpMultiServ()
+    {
+        for (auto& w : workers_) {
+            w->reactor_.stop();
+            w->reactor_.wakeup();
+        }
+        for (auto& w : workers_) {
+            w->thread_.join();
+        }
+        // The servers are destroyed on this thread, once the reactors have stopped.
+        workers_.clear();
+    }
+
+    // Copy.
+    BasicHttpMultiServ(const BasicHttpMultiServ&) = delete;
+    BasicHttpMultiServ& operator=(const BasicHttpMultiServ&) = delete;
+
+    // Move.
+    BasicHttpMultiServ(BasicHttpMultiServ&&) = delete;
+    BasicHttpMultiServ& operator=(BasicHttpMultiServ&&) = delete;
+
+    std::size_t size() const noexcept { return workers_.size(); }
+    Worker& operator[](std::size_t i) noexcept { return *workers_[i]; }
+    const Worker& operator[](std::size_t i) const noexcept { return *workers_[i]; }
+
+    /// Returns the total number of requests received by all workers.
+    std::int64_t requests() const noexcept
+    {
+        std::int64_t n{0};
+        for (const auto& w : workers_) {
+            n += w->stats().requests.load(std::memory_order_relaxed);
+        }
+        return n;
+    }
+    /// Returns the number of open connections across all workers.
+    std::int64_t connections() const noexcept
+    {
+        std::int64_t n{0};
+        for (const auto& w : workers_) {
+            n += w->stats().connections.load(std::memory_order_relaxed);
+        }
+        return n;
+    }
+
+  private:
+    static std::vector<int> make_cpu_list(std::string_view cpus)
+    {
+        std::vector<int> cpu_list;
+        if (!cpus.empty()) {
+            const auto set = parse_cpu_set(cpus);
+            for (int cpu{0}; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &set)) {
+                    cpu_list.push_back(cpu);
+                }
+            }
+        }
+        return cpu_list;
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+};
+
+} // namespace http
+} // namespace toolbox
+
+#endif // TOOLBOX_HTTP_MULTISERV_HPP
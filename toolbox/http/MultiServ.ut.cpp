@@ -0,0 +1,88 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "MultiServ.hpp"
+#include "TestServ.ut.hpp"
+
+#include <toolbox/net/StreamSock.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+using namespace toolbox;
+using namespace toolbox::http::test;
+
+BOOST_AUTO_TEST_SUITE(MultiServSuite)
+
+BOOST_AUTO_TEST_CASE(HttpMultiServCase)
+{
+    const auto now = CyclTime::now();
+    TestServ serv{now, {boost::asio::ip::address_v4::loopback(), 0}, 4,
+                  [](CyclTime now, HttpServ& serv) { return make_unique<TestApp>(serv); }};
+    BOOST_TEST(serv.size() == 4U);
+
+    // All workers are bound to the same port.
+    StreamEndpoint ep;
+    serv[0].serv().get_sock_name(ep);
+    BOOST_TEST(ep.port() != 0);
+    for (size_t i{1}; i < serv.size(); ++i) {
+        StreamEndpoint other;
+        serv[i].serv().get_sock_name(other);
+        BOOST_TEST(other.port() == ep.port());
+    }
+
+    constexpr int Clients{16};
+    vector<StreamSockClnt> clients;
+    for (int i{0}; i < Clients; ++i) {
+        clients.emplace_back(ep.protocol());
+        clients.back().connect(ep);
+        constexpr auto Request = "GET / HTTP/1.1\r\n\r\n"sv;
+        os::write(clients.back().get(), {Request.data(), Request.size()});
+    }
+    for (auto& clnt : clients) {
+        string resp;
+        char buf[256];
+        while (resp.find("Hello") == string::npos) {
+            const auto n = os::read(clnt.get(), {buf, sizeof(buf)});
+            BOOST_REQUIRE(n > 0);
+            resp.append(buf, n);
+        }
+        BOOST_TEST(resp.compare(0, 15, "HTTP/1.1 200 OK") == 0);
+    }
+    BOOST_TEST(serv.requests() == Clients);
+    BOOST_TEST(serv.connections() == Clients);
+
+    int64_t accepted{0};
+    for (size_t i{0}; i < serv.size(); ++i) {
+        accepted += serv[i].stats().accepted.load();
+    }
+    BOOST_TEST(accepted == Clients);
+
+    clients.clear();
+    BOOST_TEST(wait_for([&serv]() { return serv.connections() == 0; }));
+}
+
+BOOST_AUTO_TEST_CASE(HttpMultiServStopCase)
+{
+    // Destroying the server immediately must not wait on workers that have not started running.
+    const auto now = CyclTime::now();
+    for (int i{0}; i < 32; ++i) {
+        TestServ serv{now, {boost::asio::ip::address_v4::loopback(), 0}, 4,
+                      [](CyclTime now, HttpServ& serv) { return make_unique<TestApp>(serv); }};
+        BOOST_TEST(serv.size() == 4U);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -16,10 +16,88 @@
 
 #include "Request.hpp"
 
+#include <cstring>
+
 namespace toolbox {
 inline namespace http {
+using namespace std;
+namespace {
+constexpr size_t MinBlockSize{4096};
+} // namespace
+
+HttpArena::~HttpArena() = default;
+
+bool HttpArena::contains(const char* ptr) const noexcept
+{
+    for (const auto& block : blocks_) {
+        if (ptr >= block.data.get() && ptr < block.data.get() + block.size) {
+            return true;
+        }
+    }
+    return false;
+}
+
+string_view HttpArena::append(string_view lhs, string_view rhs)
+{
+    if (!lhs.empty() && !blocks_.empty()) {
+        auto& block = blocks_[block_];
+        if (lhs.data() + lhs.size() == block.data.get() + used_
+            && used_ + rhs.size() <= block.size) {
+            memcpy(block.data.get() + used_, rhs.data(), rhs.size());
+            used_ += rhs.size();
+            return {lhs.data(), lhs.size() + rhs.size()};
+        }
+    }
+    auto* const ptr = allocate(lhs.size() + rhs.size());
+    memcpy(ptr, lhs.data(), lhs.size());
+    memcpy(ptr + lhs.size(), rhs.data(), rhs.size());
+    return {ptr, lhs.size() + rhs.size()};
+}
+
+char* HttpArena::allocate(size_t size)
+{
+    if (!blocks_.empty() && used_ + size <= blocks_[block_].size) {
+        auto* const ptr = blocks_[block_].data.get() + used_;
+        used_ += size;
+        return ptr;
+    }
+    if (block_ + 1 < blocks_.size() && size <= blocks_[block_ + 1].size) {
+        // Reuse the next block.
+        ++block_;
+    } else {
+        // Blocks grow geometrically so that tokens that are repeatedly extended, such as large
+        // bodies, are copied a bounded number of times.
+        const auto block_size = max(MinBlockSize, 2 * size);
+        blocks_.push_back({make_unique<char[]>(block_size), block_size});
+        block_ = blocks_.size() - 1;
+    }
+    used_ = size;
+    return blocks_[block_].data.get();
+}
 
 HttpRequest::~HttpRequest() = default;
 
+void HttpRequest::save()
+{
+    arena_.save(url_);
+    for (auto& [field, value] : headers_) {
+        arena_.save(field);
+        arena_.save(value);
+    }
+    arena_.save(body_);
+}
+
+HttpResponse::~HttpResponse() = default;
+
+void HttpResponse::save()
+{
+    arena_.save(status_);
+    for (auto& [field, value] : headers_) {
+        arena_.save(field);
+        arena_.save(value);
+    }
+    arena_.save(body_);
+}
+
 } // namespace http
 } // namespace toolbox
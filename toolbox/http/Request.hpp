@@ -21,12 +21,85 @@
 #include <toolbox/http/Types.hpp>
 #include <toolbox/http/Url.hpp>
 
+#include <memory>
+#include <string_view>
 #include <vector>
 
 namespace toolbox {
 inline namespace http {
 
 
+/// Storage for request tokens that cannot be referenced in place.
+///
+/// Memory is allocated in blocks that never move, so that views into the arena remain valid
+/// until it is cleared. The blocks are retained when the arena is cleared, so that steady-state
+/// parsing does not allocate.
+class TOOLBOX_API HttpArena {
+  public:
+    HttpArena() = default;
+    ~HttpArena();
+
+    // Copy.
+    HttpArena(const HttpArena&) = delete;
+    HttpArena& operator=(const HttpArena&) = delete;
+
+    // Move.
+    HttpArena(HttpArena&&) = delete;
+    HttpArena& operator=(HttpArena&&) = delete;
+
+    /// Returns true if the pointer refers to memory owned by the arena.
+    bool contains(const char* ptr) const noexcept;
+
+    /// Release all allocations, but retain the memory.
+    void clear() noexcept
+    {
+        block_ = 0;
+        used_ = 0;
+    }
+    /// Returns a copy of lhs followed by rhs. The copy is made in place if lhs was the most recent
+    /// allocation, and there is sufficient space remaining in the block.
+    std::string_view append(std::string_view lhs, std::string_view rhs);
+    /// Returns a copy of sv.
+    std::string_view copy(std::string_view sv) { return append({}, sv); }
+
+    /// Extend token with sv. Tokens that are contiguous in the input buffer are joined in place.
+    void join(std::string_view& token, std::string_view sv)
+    {
+        if (token.empty()) {
+            token = sv;
+        } else if (token.data() + token.size() == sv.data() && !contains(token.data())) {
+            token = {token.data(), token.size() + sv.size()};
+        } else {
+            token = append(token, sv);
+        }
+    }
+    /// Copy token into the arena if it refers to the input buffer.
+    void save(std::string_view& token)
+    {
+        if (!token.empty() && !contains(token.data())) {
+            token = copy(token);
+        }
+    }
+
+  private:
+    char* allocate(std::size_t size);
+
+    struct Block {
+        std::unique_ptr<char[]> data;
+        std::size_t size;
+    };
+    std::vector<Block> blocks_;
+    /// Index of the current block.
+    std::size_t block_{0};
+    /// Bytes used in the current block.
+    std::size_t used_{0};
+};
+
+/// A request whose url, headers and body are views.
+///
+/// Tokens refer directly to the connection's input buffer when they are contiguous. Tokens that
+/// http_parser delivers in pieces, such as those split across reads, are joined in a per-request
+/// arena. The views are valid until the request is cleared, or save() is called.
 class TOOLBOX_API HttpRequest : public BasicUrl<HttpRequest> {
   public:
     HttpRequest() = default;
@@ -41,39 +114,45 @@ class TOOLBOX_API HttpRequest : public BasicUrl<HttpRequest> {
     HttpRequest& operator=(HttpRequest&&) = delete;
 
     HttpMethod method() const noexcept { return method_; }
-    const std::string& url() const noexcept { return url_; }
-    const HttpHeaders& headers() const noexcept { return headers_; }
-    const std::string& body() const noexcept { return body_; }
+    std::string_view url() const noexcept { return url_; }
+    const HttpHeaderViews& headers() const noexcept { return headers_; }
+    std::string_view body() const noexcept { return body_; }
 
     void clear() noexcept
     {
         method_ = HttpMethod::Get;
-        url_.clear();
+        url_ = {};
         headers_.clear();
-        body_.clear();
+        body_ = {};
+        arena_.clear();
     }
     void flush() { parse(); }
     void set_method(HttpMethod method) noexcept { method_ = method; }
-    void append_url(std::string_view sv) { url_.append(sv.data(), sv.size()); }
+    void append_url(std::string_view sv) { arena_.join(url_, sv); }
     void append_header_field(std::string_view sv, First first)
     {
         if (first == First::Yes) {
-            headers_.emplace_back(std::string{sv.data(), sv.size()}, "");
+            headers_.emplace_back(sv, std::string_view{});
         } else {
-            headers_.back().first.append(sv.data(), sv.size());
+            arena_.join(headers_.back().first, sv);
         }
     }
     void append_header_value(std::string_view sv, First first)
     {
-        headers_.back().second.append(sv.data(), sv.size());
+        arena_.join(headers_.back().second, sv);
     }
-    void append_body(std::string_view sv) { body_.append(sv.data(), sv.size()); }
+    void append_body(std::string_view sv) { arena_.join(body_, sv); }
+
+    /// Copy tokens that refer to the input buffer into the arena. This function must be called
+    /// before the input buffer is consumed, if the message is incomplete.
+    void save();
 
   private:
     HttpMethod method_{HttpMethod::Get};
-    std::string url_;
-    HttpHeaders headers_;
-    std::string body_;
+    std::string_view url_;
+    HttpHeaderViews headers_;
+    std::string_view body_;
+    HttpArena arena_;
 };
 
 inline std::ostream& operator<<(std::ostream& os, const HttpRequest& req) {
@@ -84,10 +163,12 @@ inline std::ostream& operator<<(std::ostream& os, const HttpRequest& req) {
     return os;
 }
 
+/// A response whose reason phrase, headers and body are views, with the same lifetime rules as
+/// HttpRequest.
 class TOOLBOX_API HttpResponse {
   public:
     HttpResponse() = default;
-    ~HttpResponse() = default;
+    ~HttpResponse();
 
     // Copy.
     HttpResponse(const HttpResponse&) = delete;
@@ -96,17 +177,47 @@ class TOOLBOX_API HttpResponse {
     // Move.
     HttpResponse(HttpResponse&&) = delete;
     HttpResponse& operator=(HttpResponse&&) = delete;
-  public:
-    void reset() {
-        headers_.clear();
+
+    int status_code() const noexcept { return status_code_; }
+    /// Returns the reason phrase.
+    std::string_view status() const noexcept { return status_; }
+    const HttpHeaderViews& headers() const noexcept { return headers_; }
+    std::string_view body() const noexcept { return body_; }
+
+    void clear() noexcept
+    {
+        status_code_ = 0;
         status_ = {};
+        headers_.clear();
+        body_ = {};
+        arena_.clear();
+    }
+    void set_status_code(int status_code) noexcept { status_code_ = status_code; }
+    void append_status(std::string_view sv) { arena_.join(status_, sv); }
+    void append_header_field(std::string_view sv, First first)
+    {
+        if (first == First::Yes) {
+            headers_.emplace_back(sv, std::string_view{});
+        } else {
+            arena_.join(headers_.back().first, sv);
+        }
     }
-    const HttpHeaders& headers() const noexcept { return headers_; }
-    const std::string& status() const noexcept { return status_; }
-    void status(std::string_view val) { status_ = val; }
+    void append_header_value(std::string_view sv, First first)
+    {
+        arena_.join(headers_.back().second, sv);
+    }
+    void append_body(std::string_view sv) { arena_.join(body_, sv); }
+
+    /// Copy tokens that refer to the input buffer into the arena. This function must be called
+    /// before the input buffer is consumed, if the message is incomplete.
+    void save();
+
   private:
-    HttpHeaders headers_;
-    std::string status_;
+    int status_code_{0};
+    std::string_view status_;
+    HttpHeaderViews headers_;
+    std::string_view body_;
+    HttpArena arena_;
 };
 
 } // namespace http
@@ -0,0 +1,191 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "Request.hpp"
+
+#include <toolbox/http/Parser.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstring>
+
+using namespace std;
+using namespace toolbox;
+
+namespace {
+
+class RequestParser : public BasicHttpParser<RequestParser> {
+    friend class BasicHttpParser<RequestParser>;
+
+  public:
+    RequestParser()
+    : BasicHttpParser<RequestParser>{HttpType::Request}
+    {
+    }
+    const HttpRequest& req() const noexcept { return req_; }
+    int messages() const noexcept { return messages_; }
+
+    /// Parse data through a scratch buffer that is overwritten by each call, as the connection's
+    /// input buffer would be.
+    void parse(string_view data)
+    {
+        memset(buf_, '!', sizeof(buf_));
+        memcpy(buf_, data.data(), data.size());
+        BasicHttpParser<RequestParser>::parse(CyclTime::now(), {buf_, data.size()});
+        if (in_progress_) {
+            req_.save();
+        }
+    }
+    /// Parse data in place.
+    void parse_in_place(string_view data)
+    {
+        BasicHttpParser<RequestParser>::parse(CyclTime::now(), {data.data(), data.size()});
+    }
+
+  private:
+    bool on_message_begin(CyclTime now) noexcept
+    {
+        in_progress_ = true;
+        req_.clear();
+        return true;
+    }
+    bool on_url(CyclTime now, string_view sv) noexcept
+    {
+        req_.append_url(sv);
+        return true;
+    }
+    bool on_status(CyclTime now, string_view sv) noexcept { return false; }
+    bool on_header_field(CyclTime now, string_view sv, First first) noexcept
+    {
+        req_.append_header_field(sv, first);
+        return true;
+    }
+    bool on_header_value(CyclTime now, string_view sv, First first) noexcept
+    {
+        req_.append_header_value(sv, first);
+        return true;
+    }
+    bool on_headers_end(CyclTime now) noexcept
+    {
+        req_.set_method(method());
+        return true;
+    }
+    bool on_body(CyclTime now, string_view sv) noexcept
+    {
+        req_.append_body(sv);
+        return true;
+    }
+    bool on_message_end(CyclTime now) noexcept
+    {
+        in_progress_ = false;
+        req_.flush();
+        ++messages_;
+        return true;
+    }
+    bool on_chunk_header(CyclTime now, size_t len) noexcept { return true; }
+    bool on_chunk_end(CyclTime now) noexcept { return true; }
+
+    HttpRequest req_;
+    char buf_[256];
+    bool in_progress_{false};
+    int messages_{0};
+};
+
+constexpr auto Message =                                      //
+    "POST /path/script.cgi?foo=bar HTTP/1.1\r\n"              //
+    "Content-Type: application/x-www-form-urlencoded\r\n"     //
+    "Content-Length: 32\r\n"                                  //
+    "\r\n"                                                    //
+    "home=Cosby&favorite+flavor=flies"sv;
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(RequestSuite)
+
+BOOST_AUTO_TEST_CASE(RequestInPlaceCase)
+{
+    RequestParser p;
+    p.parse_in_place(Message);
+    BOOST_TEST(p.messages() == 1);
+
+    const auto& req = p.req();
+    BOOST_TEST(req.method() == HttpMethod::Post);
+    BOOST_TEST(req.url() == "/path/script.cgi?foo=bar"sv);
+    BOOST_TEST(req.path() == "/path/script.cgi"sv);
+    BOOST_TEST(req.query() == "foo=bar"sv);
+    BOOST_TEST(req.headers().size() == 2U);
+    BOOST_TEST(req.headers()[0].first == "Content-Type"sv);
+    BOOST_TEST(req.headers()[0].second == "application/x-www-form-urlencoded"sv);
+    BOOST_TEST(req.body() == "home=Cosby&favorite+flavor=flies"sv);
+
+    // Contiguous tokens refer directly to the input.
+    BOOST_TEST(req.url().data() == Message.data() + 5);
+    BOOST_TEST(req.body().data() == Message.data() + Message.size() - 32);
+}
+
+BOOST_AUTO_TEST_CASE(RequestSplitCase)
+{
+    // Split the message at every possible offset, and also into single bytes.
+    for (size_t n{1}; n < Message.size(); ++n) {
+        RequestParser p;
+        p.parse(Message.substr(0, n));
+        p.parse(Message.substr(n));
+        BOOST_TEST(p.messages() == 1);
+        const auto& req = p.req();
+        BOOST_TEST(req.url() == "/path/script.cgi?foo=bar"sv);
+        BOOST_TEST(req.headers().size() == 2U);
+        BOOST_TEST(req.headers()[1].first == "Content-Length"sv);
+        BOOST_TEST(req.headers()[1].second == "32"sv);
+        BOOST_TEST(req.body() == "home=Cosby&favorite+flavor=flies"sv);
+    }
+    RequestParser p;
+    for (const auto c : Message) {
+        p.parse({&c, 1});
+    }
+    BOOST_TEST(p.messages() == 1);
+    BOOST_TEST(p.req().url() == "/path/script.cgi?foo=bar"sv);
+    BOOST_TEST(p.req().headers()[0].second == "application/x-www-form-urlencoded"sv);
+    BOOST_TEST(p.req().body() == "home=Cosby&favorite+flavor=flies"sv);
+}
+
+BOOST_AUTO_TEST_CASE(HttpArenaCase)
+{
+    HttpArena arena;
+    const auto a = arena.copy("foo"sv);
+    // The most recent allocation is extended in place.
+    const auto b = arena.append(a, "bar"sv);
+    BOOST_TEST(b == "foobar"sv);
+    BOOST_TEST(b.data() == a.data());
+    BOOST_TEST(arena.contains(b.data()));
+
+    const auto c = arena.copy("baz"sv);
+    const auto d = arena.append(b, "qux"sv);
+    BOOST_TEST(d == "foobarqux"sv);
+    BOOST_TEST(d.data() != b.data());
+    BOOST_TEST(c == "baz"sv);
+
+    // Large allocations are placed in their own blocks.
+    const string big(10000, 'x');
+    const auto e = arena.append(d, big);
+    BOOST_TEST(e.size() == 10009U);
+    BOOST_TEST(arena.contains(e.data()));
+    BOOST_TEST(!arena.contains(big.data()));
+
+    // Memory is reused after clear.
+    arena.clear();
+    BOOST_TEST(arena.copy("foo"sv).data() == a.data());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
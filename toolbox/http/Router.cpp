@@ -0,0 +1,210 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Router.hpp"
+
+#include <toolbox/http/Request.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace toolbox {
+inline namespace http {
+using namespace std;
+namespace {
+
+/// Remove the leading segment from path and return it.
+string_view pop_segment(string_view& path) noexcept
+{
+    const auto pos = path.find('/');
+    const auto seg = path.substr(0, pos);
+    path = pos == string_view::npos ? string_view{} : path.substr(pos + 1);
+    return seg;
+}
+
+bool less_segment(const pair<string, uint32_t>& lhs, string_view rhs) noexcept
+{
+    return string_view{lhs.first} < rhs;
+}
+
+} // namespace
+
+HttpRouter::HttpRouter()
+: nodes_(1)
+{
+}
+
+HttpRouter::~HttpRouter() = default;
+
+HttpRouter::HttpRouter(HttpRouter&&) noexcept = default;
+HttpRouter& HttpRouter::operator=(HttpRouter&&) noexcept = default;
+
+void HttpRouter::add(HttpMethod method, string_view pattern, HttpRouteSlot slot)
+{
+    if (pattern.empty() || pattern.front() != '/') {
+        throw invalid_argument{"invalid route: "s + string{pattern}};
+    }
+    const string_view orig{pattern};
+    pattern.remove_prefix(1);
+
+    uint32_t node{0};
+    size_t nparams{0};
+    // The root node represents "/", so an empty pattern has no segments.
+    while (!pattern.empty()) {
+        const auto seg = pop_segment(pattern);
+        if (seg.empty()) {
+            throw invalid_argument{"empty route segment: "s + string{orig}};
+        }
+        if (seg.front() == '*' && !pattern.empty()) {
+            throw invalid_argument{"wildcard must be last segment: "s + string{orig}};
+        }
+        if ((seg.front() == ':' || seg.front() == '*') && ++nparams > MaxHttpRouteParams) {
+            throw invalid_argument{"too many route parameters: "s + string{orig}};
+        }
+        node = add_child(node, seg);
+    }
+    auto& handlers = nodes_[node].handlers;
+    const auto it = find_if(handlers.begin(), handlers.end(),
+                            [method](const auto& h) { return h.first == method; });
+    if (it != handlers.end()) {
+        throw invalid_argument{"duplicate route: "s + enum_string(method) + ' ' + string{orig}};
+    }
+    handlers.emplace_back(method, slot);
+}
+
+const HttpRouteSlot* HttpRouter::match(HttpMethod method, string_view path,
+                                       HttpRouteParams& params, HttpStatus& status) const noexcept
+{
+    params.clear();
+    status = HttpStatus::NotFound;
+    if (path.empty() || path.front() != '/') {
+        return nullptr;
+    }
+    // Set if the path matched a route, regardless of method.
+    bool found{false};
+    const auto* const slot = match(0, method, path.substr(1), params, found);
+    if (slot) {
+        status = HttpStatus::Ok;
+    } else if (found) {
+        status = HttpStatus::MethodNotAllowed;
+    }
+    return slot;
+}
+
+HttpStatus HttpRouter::dispatch(CyclTime now, const StreamEndpoint& ep, const HttpRequest& req,
+                                HttpStream& os) const
+{
+    HttpRouteParams params;
+    HttpStatus status{HttpStatus::NotFound};
+    if (const auto* const slot = match(req.method(), req.path(), params, status); slot) {
+        (*slot)(now, ep, req, params, os);
+    }
+    return status;
+}
+
+uint32_t HttpRouter::find_child(const Node& node, string_view segment) const noexcept
+{
+    const auto& children = node.children;
+    const auto it = lower_bound(children.begin(), children.end(), segment, less_segment);
+    return it != children.end() && it->first == segment ? it->second : 0;
+}
+
+uint32_t HttpRouter::add_child(uint32_t parent, string_view segment)
+{
+    const bool param{segment.front() == ':'}, wildcard{segment.front() == '*'};
+    if (param || wildcard) {
+        const auto name = segment.substr(1);
+        if (name.empty()) {
+            throw invalid_argument{"unnamed route parameter"};
+        }
+        auto child = param ? nodes_[parent].param : nodes_[parent].wildcard;
+        if (child != 0) {
+            // Parameters at the same position must have the same name.
+            if (nodes_[child].name != name) {
+                throw invalid_argument{"conflicting route parameter: "s + string{name}};
+            }
+            return child;
+        }
+        child = static_cast<uint32_t>(nodes_.size());
+        nodes_.emplace_back().name = name;
+        (param ? nodes_[parent].param : nodes_[parent].wildcard) = child;
+        return child;
+    }
+    if (auto child = find_child(nodes_[parent], segment); child != 0) {
+        return child;
+    }
+    const auto child = static_cast<uint32_t>(nodes_.size());
+    nodes_.emplace_back();
+    auto& children = nodes_[parent].children;
+    const auto it = lower_bound(children.begin(), children.end(), segment, less_segment);
+    children.emplace(it, string{segment}, child);
+    return child;
+}
+
+const HttpRouteSlot* HttpRouter::find_handler(const Node& node, HttpMethod method) noexcept
+{
+    for (const auto& [m, slot] : node.handlers) {
+        if (m == method) {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+const HttpRouteSlot* HttpRouter::match(uint32_t index, HttpMethod method, string_view path,
+                                       HttpRouteParams& params, bool& found) const noexcept
+{
+    const auto& node = nodes_[index];
+    if (path.empty()) {
+        if (!node.handlers.empty()) {
+            found = true;
+            if (const auto* const slot = find_handler(node, method); slot) {
+                return slot;
+            }
+        }
+        // An empty remainder may still match a wildcard.
+    } else {
+        auto rest = path;
+        const auto seg = pop_segment(rest);
+        // Static segments take precedence.
+        if (const auto child = find_child(node, seg); child != 0) {
+            if (const auto* const slot = match(child, method, rest, params, found); slot) {
+                return slot;
+            }
+        }
+        // Parameters do not match empty segments.
+        if (node.param != 0 && !seg.empty()) {
+            const auto& child = nodes_[node.param];
+            params.push_back(child.name, seg);
+            if (const auto* const slot = match(node.param, method, rest, params, found); slot) {
+                return slot;
+            }
+            params.pop_back();
+        }
+    }
+    if (node.wildcard != 0) {
+        const auto& child = nodes_[node.wildcard];
+        found = true;
+        if (const auto* const slot = find_handler(child, method); slot) {
+            params.push_back(child.name, path);
+            return slot;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace http
+} // namespace toolbox
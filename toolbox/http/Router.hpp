@@ -0,0 +1,143 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOOLBOX_HTTP_ROUTER_HPP
+#define TOOLBOX_HTTP_ROUTER_HPP
+
+#include <toolbox/http/Types.hpp>
+#include <toolbox/net/Endpoint.hpp>
+#include <toolbox/sys/Time.hpp>
+#include <toolbox/util/Slot.hpp>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace toolbox {
+inline namespace http {
+class HttpRequest;
+class HttpStream;
+
+/// Maximum number of parameters in a route.
+constexpr std::size_t MaxHttpRouteParams{8};
+
+/// The parameters extracted from a request path. The names refer to the router, and the values
+/// refer to the path.
+class HttpRouteParams {
+  public:
+    using value_type = std::pair<std::string_view, std::string_view>;
+    using const_iterator = const value_type*;
+
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    const_iterator begin() const noexcept { return params_.data(); }
+    const_iterator end() const noexcept { return params_.data() + size_; }
+
+    /// Returns the value of the named parameter, or an empty view if there is no such parameter.
+    std::string_view operator[](std::string_view name) const noexcept
+    {
+        for (const auto& [key, value] : *this) {
+            if (key == name) {
+                return value;
+            }
+        }
+        return {};
+    }
+
+    void clear() noexcept { size_ = 0; }
+    void push_back(std::string_view name, std::string_view value) noexcept
+    {
+        params_[size_++] = {name, value};
+    }
+    void pop_back() noexcept { --size_; }
+
+  private:
+    std::array<value_type, MaxHttpRouteParams> params_;
+    std::size_t size_{0};
+};
+
+using HttpRouteSlot = Slot<CyclTime, const StreamEndpoint&, const HttpRequest&,
+                           const HttpRouteParams&, HttpStream&>;
+
+/// HttpRouter dispatches requests to handlers by method and path.
+///
+/// Routes are registered at startup with patterns of the form "/orders/:id/fills", where a ":name"
+/// segment matches any non-empty segment, and a trailing "*name" segment matches the remainder of
+/// the path. Paths are matched segment by segment against a trie, so the cost of matching depends
+/// on the depth of the path rather than the number of routes. Static segments take precedence over
+/// parameters, and parameters over wildcards. Matching does not allocate.
+class TOOLBOX_API HttpRouter {
+  public:
+    HttpRouter();
+    ~HttpRouter();
+
+    // Copy.
+    HttpRouter(const HttpRouter&) = delete;
+    HttpRouter& operator=(const HttpRouter&) = delete;
+
+    // Move.
+    HttpRouter(HttpRouter&&) noexcept;
+    HttpRouter& operator=(HttpRouter&&) noexcept;
+
+    /// Register a handler for method and pattern.
+    ///
+    /// \throw std::invalid_argument if the pattern is invalid, if it conflicts with the parameter
+    /// names of an existing route, or if the route is already registered.
+    void add(HttpMethod method, std::string_view pattern, HttpRouteSlot slot);
+
+    /// Returns the handler that matches the method and path, and sets the route parameters.
+    ///
+    /// \param status Set to HttpStatus::Ok if a handler was found, HttpStatus::MethodNotAllowed if
+    /// the path matched but the method did not, or HttpStatus::NotFound otherwise.
+    const HttpRouteSlot* match(HttpMethod method, std::string_view path, HttpRouteParams& params,
+                               HttpStatus& status) const noexcept;
+
+    /// Call the handler that matches the request's method and path.
+    ///
+    /// \return HttpStatus::Ok if a handler was called, or the error status to be sent otherwise.
+    HttpStatus dispatch(CyclTime now, const StreamEndpoint& ep, const HttpRequest& req,
+                        HttpStream& os) const;
+
+  private:
+    struct Node {
+        /// Static children, sorted by segment.
+        std::vector<std::pair<std::string, std::uint32_t>> children;
+        /// Parameter and wildcard children, or zero if none.
+        std::uint32_t param{0}, wildcard{0};
+        /// Parameter name, for parameter and wildcard nodes.
+        std::string name;
+        std::vector<std::pair<HttpMethod, HttpRouteSlot>> handlers;
+    };
+
+    std::uint32_t find_child(const Node& node, std::string_view segment) const noexcept;
+    std::uint32_t add_child(std::uint32_t parent, std::string_view segment);
+    static const HttpRouteSlot* find_handler(const Node& node, HttpMethod method) noexcept;
+    /// Backtracks until a route matches both the path and the method. The found flag is set if any
+    /// route matched the path.
+    const HttpRouteSlot* match(std::uint32_t node, HttpMethod method, std::string_view path,
+                               HttpRouteParams& params, bool& found) const noexcept;
+
+    /// The root node is at index zero.
+    std::vector<Node> nodes_;
+};
+
+} // namespace http
+} // namespace toolbox
+
+#endif // TOOLBOX_HTTP_ROUTER_HPP
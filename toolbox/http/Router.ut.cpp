@@ -0,0 +1,174 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Router.hpp"
+
+#include <toolbox/http/Request.hpp>
+#include <toolbox/http/Stream.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+using namespace toolbox;
+
+namespace {
+
+struct Handler {
+    void on_route(CyclTime /*now*/, const StreamEndpoint& /*ep*/, const HttpRequest& /*req*/,
+                  const HttpRouteParams& params, HttpStream& /*os*/)
+    {
+        ++calls;
+        id = params["id"];
+    }
+    int calls{0};
+    string id;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(RouterSuite)
+
+BOOST_AUTO_TEST_CASE(RouterMatchCase)
+{
+    Handler h;
+    const auto slot = bind<&Handler::on_route>(&h);
+
+    HttpRouter router;
+    router.add(HttpMethod::Get, "/", slot);
+    router.add(HttpMethod::Get, "/orders", slot);
+    router.add(HttpMethod::Post, "/orders", slot);
+    router.add(HttpMethod::Get, "/orders/:id", slot);
+    router.add(HttpMethod::Get, "/orders/open", slot);
+    router.add(HttpMethod::Get, "/orders/:id/fills/:fill", slot);
+    router.add(HttpMethod::Get, "/static/*path", slot);
+
+    HttpRouteParams params;
+    HttpStatus status;
+    BOOST_TEST(router.match(HttpMethod::Get, "/", params, status));
+    BOOST_TEST(params.empty());
+    BOOST_TEST(router.match(HttpMethod::Post, "/orders", params, status));
+    BOOST_TEST((status == HttpStatus::Ok));
+
+    // Static segments take precedence over parameters.
+    BOOST_TEST(router.match(HttpMethod::Get, "/orders/open", params, status));
+    BOOST_TEST(params.empty());
+    BOOST_TEST(router.match(HttpMethod::Get, "/orders/42", params, status));
+    BOOST_TEST(params.size() == 1U);
+    BOOST_TEST(params["id"] == "42");
+    BOOST_TEST(params["fill"].empty());
+
+    BOOST_TEST(router.match(HttpMethod::Get, "/orders/42/fills/7", params, status));
+    BOOST_TEST(params.size() == 2U);
+    BOOST_TEST(params["id"] == "42");
+    BOOST_TEST(params["fill"] == "7");
+
+    BOOST_TEST(router.match(HttpMethod::Get, "/static/css/main.css", params, status));
+    BOOST_TEST(params["path"] == "css/main.css");
+    BOOST_TEST(router.match(HttpMethod::Get, "/static/", params, status));
+    BOOST_TEST(params["path"].empty());
+
+    BOOST_TEST(!router.match(HttpMethod::Delete, "/orders/42", params, status));
+    BOOST_TEST((status == HttpStatus::MethodNotAllowed));
+    BOOST_TEST(!router.match(HttpMethod::Get, "/orders/42/fills", params, status));
+    BOOST_TEST((status == HttpStatus::NotFound));
+    BOOST_TEST(params.empty());
+    BOOST_TEST(!router.match(HttpMethod::Get, "/foo", params, status));
+    BOOST_TEST((status == HttpStatus::NotFound));
+    BOOST_TEST(!router.match(HttpMethod::Get, "", params, status));
+    BOOST_TEST((status == HttpStatus::NotFound));
+}
+
+BOOST_AUTO_TEST_CASE(RouterBacktrackCase)
+{
+    Handler h;
+    const auto slot = bind<&Handler::on_route>(&h);
+
+    HttpRouter router;
+    router.add(HttpMethod::Get, "/orders/open/summary", slot);
+    router.add(HttpMethod::Get, "/orders/:id/fills", slot);
+
+    // The static branch is tried first, and abandoned in favour of the parameter.
+    HttpRouteParams params;
+    HttpStatus status;
+    BOOST_TEST(router.match(HttpMethod::Get, "/orders/open/fills", params, status));
+    BOOST_TEST(params["id"] == "open");
+    BOOST_TEST(router.match(HttpMethod::Get, "/orders/open/summary", params, status));
+    BOOST_TEST(params.empty());
+    // Parameters do not match empty segments.
+    BOOST_TEST(!router.match(HttpMethod::Get, "/orders//fills", params, status));
+
+    // The method is considered before abandoning a branch.
+    router.add(HttpMethod::Get, "/orders/open", slot);
+    router.add(HttpMethod::Post, "/orders/:id", slot);
+    router.add(HttpMethod::Get, "/files/readme", slot);
+    router.add(HttpMethod::Put, "/files/*path", slot);
+    BOOST_TEST(router.match(HttpMethod::Post, "/orders/open", params, status));
+    BOOST_TEST((status == HttpStatus::Ok));
+    BOOST_TEST(params["id"] == "open");
+    BOOST_TEST(router.match(HttpMethod::Get, "/orders/open", params, status));
+    BOOST_TEST(params.empty());
+    BOOST_TEST(router.match(HttpMethod::Put, "/files/readme", params, status));
+    BOOST_TEST(params["path"] == "readme");
+    BOOST_TEST(!router.match(HttpMethod::Delete, "/orders/open", params, status));
+    BOOST_TEST((status == HttpStatus::MethodNotAllowed));
+    BOOST_TEST(params.empty());
+}
+
+BOOST_AUTO_TEST_CASE(RouterAddCase)
+{
+    Handler h;
+    const auto slot = bind<&Handler::on_route>(&h);
+
+    HttpRouter router;
+    router.add(HttpMethod::Get, "/orders/:id", slot);
+    BOOST_CHECK_THROW(router.add(HttpMethod::Get, "/orders/:id", slot), invalid_argument);
+    BOOST_CHECK_THROW(router.add(HttpMethod::Put, "/orders/:oid", slot), invalid_argument);
+    BOOST_CHECK_THROW(router.add(HttpMethod::Get, "orders", slot), invalid_argument);
+    BOOST_CHECK_THROW(router.add(HttpMethod::Get, "/orders//fills", slot), invalid_argument);
+    BOOST_CHECK_THROW(router.add(HttpMethod::Get, "/orders/:", slot), invalid_argument);
+    BOOST_CHECK_THROW(router.add(HttpMethod::Get, "/static/*path/foo", slot), invalid_argument);
+    BOOST_CHECK_THROW(router.add(HttpMethod::Get, "/:a/:b/:c/:d/:e/:f/:g/:h/:i", slot),
+                      invalid_argument);
+    router.add(HttpMethod::Put, "/orders/:id", slot);
+}
+
+BOOST_AUTO_TEST_CASE(RouterDispatchCase)
+{
+    Handler h;
+    HttpRouter router;
+    router.add(HttpMethod::Get, "/orders/:id", bind<&Handler::on_route>(&h));
+
+    HttpRequest req;
+    req.set_method(HttpMethod::Get);
+    req.append_url("/orders/42?verbose=1");
+    req.flush();
+
+    Buffer buf;
+    HttpStream os{buf};
+    BOOST_TEST((router.dispatch(CyclTime::now(), StreamEndpoint{}, req, os) == HttpStatus::Ok));
+    BOOST_TEST(h.calls == 1);
+    BOOST_TEST(h.id == "42");
+
+    req.clear();
+    req.set_method(HttpMethod::Post);
+    req.append_url("/orders/42");
+    req.flush();
+    BOOST_TEST((router.dispatch(CyclTime::now(), StreamEndpoint{}, req, os)
+                == HttpStatus::MethodNotAllowed));
+    BOOST_TEST(h.calls == 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
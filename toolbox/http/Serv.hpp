@@ -38,8 +38,9 @@ class BasicHttpServ : public StreamAcceptor<BasicHttpServ<ConnT>> {
   public:
     using Conn = ConnT;
   public:
-    BasicHttpServ(CyclTime now, Reactor& r, const Endpoint& ep)
-    : Base {r, ep}
+    BasicHttpServ(CyclTime now, Reactor& r, const Endpoint& ep,
+                  ReusePort reuse_port = ReusePort::No)
+    : Base {r, ep, reuse_port}
     , reactor_{r}
     {}
     ~BasicHttpServ()
@@ -59,12 +60,31 @@ class BasicHttpServ : public StreamAcceptor<BasicHttpServ<ConnT>> {
     void accept(Slot<CyclTime, Conn&> slot) {
       accept_ = slot;
     }
+    Reactor& reactor() noexcept { return reactor_; }
+    /// Send a message to all WebSocket connections. The frame is encoded once, and written to each
+    /// connection with a gather write.
+    void ws_broadcast(CyclTime now, WsOpcode opcode, std::string_view payload)
+    {
+        frame_.clear();
+        ws_put_frame(frame_, opcode, payload);
+        for (auto it = conn_list_.begin(); it != conn_list_.end();) {
+            // The connection may be disposed.
+            auto& conn = *it++;
+            if (conn.is_ws()) {
+                conn.ws_send_frame(now, frame_.buffer());
+            }
+        }
+    }
+    const HttpServStats& stats() const noexcept { return stats_; }
   private:
     void on_sock_prepare(CyclTime now, IoSock& sock) {}
     void on_sock_accept(CyclTime now, IoSock&& sock, const Endpoint& ep)
     {
         Conn* conn = new Conn{now, reactor_, std::move(sock), ep};
         conn_list_.push_back(*conn);
+        conn->set_stats(&stats_);
+        HttpServStats::add(stats_.accepted, 1);
+        HttpServStats::add(stats_.connections, 1);
         if(accept_)
           accept_(now, *conn);
     }
@@ -73,6 +93,9 @@ class BasicHttpServ : public StreamAcceptor<BasicHttpServ<ConnT>> {
     // List of active connections.
     ConnList conn_list_;
     Slot<CyclTime, Conn&> accept_;
+    // Broadcast frame.
+    Buffer frame_;
+    HttpServStats stats_;
 };
 
 using HttpServ = BasicHttpServ<HttpServerConn>;
@@ -16,6 +16,10 @@
 
 #include "Stream.hpp"
 #include "toolbox/http/Request.hpp"
+#include "toolbox/http/Writer.hpp"
+
+#include <cassert>
+#include <stdexcept>
 
 namespace toolbox {
 inline namespace http {
@@ -31,6 +35,17 @@ void HttpBuf::set_content_length(std::streamsize pos, std::streamsize len) noexc
     } while (len > 0);
 }
 
+void HttpBuf::set_chunk_size(std::streamsize pos, std::streamsize len) noexcept
+{
+    assert(len <= MaxHttpChunk);
+    auto it = pbase_ + pos;
+    do {
+        --it;
+        *it = "0123456789abcdef"[len & 0xf];
+        len >>= 4;
+    } while (len > 0);
+}
+
 HttpBuf::~HttpBuf() = default;
 
 HttpBuf::int_type HttpBuf::overflow(int_type c) noexcept
@@ -54,9 +69,26 @@ streamsize HttpBuf::xsputn(const char_type* s, streamsize count) noexcept
 
 HttpStream::~HttpStream() = default;
 
-void HttpStream::commit() noexcept
+void HttpStream::commit()
 {
-    if (cloff_ > 0) {
+    if (chunk_) {
+        chunk_ = false;
+        const auto len = pcount() - hcount_;
+        if (len == 0) {
+            buf_.reset();
+            toolbox::reset(*this);
+            return;
+        }
+        if (len > MaxHttpChunk) {
+            // The chunk-size would not fit in the place-holder.
+            buf_.reset();
+            toolbox::reset(*this);
+            throw length_error{"chunk too large"};
+        }
+        // Chunk = chunk-size CRLF chunk-data CRLF.
+        buf_.set_chunk_size(hcount_ - 2, len);
+        *this << "\r\n";
+    } else if (cloff_ > 0) {
         buf_.set_content_length(cloff_, pcount() - hcount_);
     }
     buf_.commit();
@@ -64,13 +96,7 @@ void HttpStream::commit() noexcept
 
 void HttpStream::http_status(HttpStatus status, const char* content_type, NoCache no_cache)
 {
-    buf_.reset();
-    toolbox::reset(*this);
-
-    *this << "HTTP/1.1 " << status << ' ' << enum_string(status);
-    if (no_cache == NoCache::Yes) {
-        *this << "\r\nCache-Control: no-cache";
-    }
+    put_status(status, no_cache);
     if (content_type) {
         // Status-Line = HTTP-Version SP Status-Code SP Reason-Phrase CRLF. Use 10 space
         // place-holder for content length. RFC2616 states that field value MAY be preceded by any
@@ -85,16 +111,72 @@ void HttpStream::http_status(HttpStatus status, const char* content_type, NoCach
     hcount_ = pcount();
 }
 
-void HttpStream::http_request(HttpMethod method, const std::string& url) {
-    *this << enum_string(method) << ' ' << url << ' ' << " HTTP/1.1\r\n\r\n";
+void HttpStream::http_status_chunked(HttpStatus status, const char* content_type,
+                                     NoCache no_cache)
+{
+    put_status(status, no_cache);
+    if (content_type) {
+        *this << "\r\nContent-Type: " << content_type;
+    }
+    *this << "\r\nTransfer-Encoding: chunked\r\n\r\n";
+    buf_.commit();
+    reset();
+    chunked_ = true;
 }
 
-void HttpStream::http_request(HttpMethod method, const std::string& url, const HttpHeaders& headers) {
-    *this << enum_string(method) << ' ' << url << ' ' << " HTTP/1.1\r\n";
+void HttpStream::begin_chunk()
+{
+    reset();
+    // Use an 8 digit place-holder for the chunk size, which is sufficient for chunks of up to
+    // MaxHttpChunk. RFC7230 permits leading zeros in the chunk size.
+    *this << "00000000\r\n";
+    hcount_ = pcount();
+    chunk_ = true;
+}
+
+void HttpStream::end_chunks()
+{
+    reset();
+    *this << "0\r\n\r\n";
+    buf_.commit();
+    reset();
+    chunked_ = false;
+}
+
+void HttpStream::put_status(HttpStatus status, NoCache no_cache)
+{
+    reset();
+    *this << http_status_line(status);
+    if (no_cache == NoCache::Yes) {
+        *this << "\r\nCache-Control: no-cache";
+    }
+}
+
+namespace {
+template <typename HeadersT>
+void put_request(std::ostream& os, HttpMethod method, std::string_view url,
+                 const HeadersT& headers)
+{
+    os << enum_string(method) << ' ' << url << ' ' << " HTTP/1.1\r\n";
     for(auto&[k,v]:headers) {
-        *this << k << ':' << v << "\r\n";
+        os << k << ':' << v << "\r\n";
     }
-    *this << "\r\n";
+    os << "\r\n";
+}
+} // namespace
+
+void HttpStream::http_request(HttpMethod method, std::string_view url) {
+    *this << enum_string(method) << ' ' << url << ' ' << " HTTP/1.1\r\n\r\n";
+}
+
+void HttpStream::http_request(HttpMethod method, std::string_view url,
+                              const HttpHeaders& headers) {
+    put_request(*this, method, url, headers);
+}
+
+void HttpStream::http_request(HttpMethod method, std::string_view url,
+                              const HttpHeaderViews& headers) {
+    put_request(*this, method, url, headers);
 }
 
 } // namespace http
@@ -25,11 +25,15 @@ namespace toolbox {
 inline namespace http {
 
 using HttpHeaders = std::vector<std::pair<std::string, std::string>>;
+using HttpHeaderViews = std::vector<std::pair<std::string_view, std::string_view>>;
 
 constexpr char ApplicationJson[]{"application/json"};
 constexpr char TextHtml[]{"text/html"};
 constexpr char TextPlain[]{"text/plain"};
 
+/// Maximum size of a chunk, as limited by the 8 digit chunk-size place-holder.
+constexpr std::streamsize MaxHttpChunk{0xffffffff};
+
 class TOOLBOX_API HttpBuf : public std::streambuf {
   public:
     explicit HttpBuf(Buffer& buf) noexcept
@@ -46,6 +50,7 @@ class TOOLBOX_API HttpBuf : public std::streambuf {
     HttpBuf(HttpBuf&&) = delete;
     HttpBuf& operator=(HttpBuf&&) = delete;
 
+    Buffer& buffer() noexcept { return buf_; }
     std::streamsize pcount() const noexcept { return pcount_; }
     void commit() noexcept { buf_.commit(pcount_); }
     void reset() noexcept
@@ -54,6 +59,8 @@ class TOOLBOX_API HttpBuf : public std::streambuf {
         pcount_ = 0;
     }
     void set_content_length(std::streamsize pos, std::streamsize len) noexcept;
+    /// Write len in hex into the zero-filled place-holder ending at pos.
+    void set_chunk_size(std::streamsize pos, std::streamsize len) noexcept;
 
   protected:
     int_type overflow(int_type c) noexcept final;
@@ -65,6 +72,8 @@ class TOOLBOX_API HttpBuf : public std::streambuf {
     std::streamsize pcount_{0};
 };
 
+/// HttpStream formats HTTP messages with std::ostream. Prefer HttpResponseWriter, constructed on
+/// buffer(), for responses on latency sensitive paths.
 class TOOLBOX_API HttpStream : public std::ostream {
   public:
     explicit HttpStream(Buffer& buf) noexcept
@@ -83,23 +92,51 @@ class TOOLBOX_API HttpStream : public std::ostream {
     HttpStream(HttpStream&&) = delete;
     HttpStream& operator=(HttpStream&&) = delete;
 
+    /// Returns the output buffer, so that a connection's callbacks may write responses with
+    /// HttpResponseWriter instead. Output that has not been committed to the stream is overwritten
+    /// by the writer.
+    Buffer& buffer() noexcept { return buf_.buffer(); }
     std::streamsize pcount() const noexcept { return buf_.pcount(); }
-    void commit() noexcept;
+    /// Commit the response or chunk.
+    ///
+    /// \throw std::length_error if the chunk is larger than MaxHttpChunk. The chunk is discarded.
+    void commit();
     void reset() noexcept
     {
         buf_.reset();
         toolbox::reset(*this);
         cloff_ = hcount_ = 0;
+        chunk_ = false;
     }
     void http_status(HttpStatus status, const char* content_type, NoCache no_cache = NoCache::Yes);
-    void http_request(HttpMethod method, const std::string& url);
-    void http_request(HttpMethod method, const std::string& url, const HttpHeaders& headers);
+    /// Write and commit the status-line and headers of a response whose body is sent with the
+    /// chunked transfer-coding. Each chunk is then written by calling begin_chunk(), followed by
+    /// commit(), and the body is terminated by end_chunks().
+    void http_status_chunked(HttpStatus status, const char* content_type,
+                             NoCache no_cache = NoCache::Yes);
+    /// Begin a chunk. The chunk is discarded if it is empty when committed, because an empty chunk
+    /// would terminate the body.
+    void begin_chunk();
+    /// Write and commit the last-chunk.
+    void end_chunks();
+    /// Returns true if a chunked response has been started and not yet terminated by end_chunks().
+    bool chunked() const noexcept { return chunked_; }
+    void http_request(HttpMethod method, std::string_view url);
+    void http_request(HttpMethod method, std::string_view url, const HttpHeaders& headers);
+    void http_request(HttpMethod method, std::string_view url, const HttpHeaderViews& headers);
   private:
+    void put_status(HttpStatus status, NoCache no_cache);
+
     HttpBuf buf_;
     /// Content-Length offset.
     std::streamsize cloff_{0};
     /// Header size.
     std::streamsize hcount_{0};
+    /// True if a chunk is in progress.
+    bool chunk_{false};
+    /// True if the body of a chunked response is in progress. This is not cleared by reset(),
+    /// because the headers have already been committed.
+    bool chunked_{false};
 };
 
 } // namespace http
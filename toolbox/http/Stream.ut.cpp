@@ -0,0 +1,70 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "Stream.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+using namespace toolbox;
+
+BOOST_AUTO_TEST_SUITE(HttpStreamSuite)
+
+BOOST_AUTO_TEST_CASE(HttpStreamContentLengthCase)
+{
+    Buffer buf;
+    HttpStream os{buf};
+    os.http_status(HttpStatus::Ok, TextPlain);
+    os << "Hello";
+    os.commit();
+    BOOST_TEST(buf.str()
+               == "HTTP/1.1 200 OK\r\nCache-Control: no-cache\r\nContent-Type: text/plain"
+                  "\r\nContent-Length:          5\r\n\r\nHello");
+}
+
+BOOST_AUTO_TEST_CASE(HttpStreamChunkedCase)
+{
+    Buffer buf;
+    HttpStream os{buf};
+    os.http_status_chunked(HttpStatus::Ok, "text/event-stream", NoCache::No);
+    BOOST_TEST(buf.str()
+               == "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream"
+                  "\r\nTransfer-Encoding: chunked\r\n\r\n");
+    buf.clear();
+
+    os.begin_chunk();
+    os << "data: " << 101.25 << "\n\n";
+    BOOST_TEST(buf.empty());
+    os.commit();
+    BOOST_TEST(buf.str() == "0000000e\r\ndata: 101.25\n\n\r\n");
+    buf.clear();
+
+    // Empty chunks are discarded.
+    os.begin_chunk();
+    os.commit();
+    BOOST_TEST(buf.empty());
+
+    os.begin_chunk();
+    os << string(300, 'x');
+    os.commit();
+    BOOST_TEST(buf.str().substr(0, 10) == "0000012c\r\n");
+    BOOST_TEST(buf.size() == 312U);
+    buf.clear();
+
+    os.end_chunks();
+    BOOST_TEST(buf.str() == "0\r\n\r\n");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
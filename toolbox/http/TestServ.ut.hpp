@@ -0,0 +1,80 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef TOOLBOX_HTTP_TESTSERV_UT_HPP
+#define TOOLBOX_HTTP_TESTSERV_UT_HPP
+
+// Fixtures shared by the end-to-end HTTP tests.
+
+#include <toolbox/http/MultiServ.hpp>
+
+#include <thread>
+
+namespace toolbox {
+inline namespace http {
+namespace test {
+
+/// Responds to each request with "Hello " followed by the request path.
+class TestApp {
+  public:
+    explicit TestApp(HttpServ& serv) { serv.accept(bind<&TestApp::on_accept>(this)); }
+
+  private:
+    void on_accept(CyclTime now, HttpServerConn& conn)
+    {
+        conn.http_message(bind<&TestApp::on_http_message>(this));
+    }
+    void on_http_message(CyclTime now, const StreamEndpoint& ep, const HttpRequest& req,
+                         HttpStream& os)
+    {
+        os.http_status(HttpStatus::Ok, TextPlain);
+        os << "Hello " << req.path();
+        os.commit();
+    }
+};
+
+using TestServ = BasicHttpMultiServ<TestApp>;
+
+/// Poll the reactor until fn returns true, or for at most five seconds.
+template <typename FnT>
+bool poll_until(os::Reactor& reactor, FnT fn)
+{
+    using namespace std::literals::chrono_literals;
+    const auto end = MonoClock::now() + 5s;
+    while (!fn() && MonoClock::now() < end) {
+        reactor.poll(CyclTime::now(), 1ms);
+    }
+    return fn();
+}
+
+/// Wait until fn returns true, for at most one second. The servers run on their own threads.
+template <typename FnT>
+bool wait_for(FnT fn)
+{
+    using namespace std::literals::chrono_literals;
+    for (int i{0}; i < 1000; ++i) {
+        if (fn()) {
+            return true;
+        }
+        std::this_thread::sleep_for(1ms);
+    }
+    return false;
+}
+
+} // namespace test
+} // namespace http
+} // namespace toolbox
+
+#endif // TOOLBOX_HTTP_TESTSERV_UT_HPP
@@ -76,6 +76,7 @@ inline std::ostream& operator<<(std::ostream& os, HttpMethod method)
 }
 
 enum class HttpStatus : int {
+    SwitchingProtocols = HTTP_STATUS_SWITCHING_PROTOCOLS,
     Ok = HTTP_STATUS_OK,
     NoContent = HTTP_STATUS_NO_CONTENT,
     BadRequest = HTTP_STATUS_BAD_REQUEST,
@@ -0,0 +1,409 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "WebSocket.hpp"
+
+#include <toolbox/http/FastParser.hpp>
+#include <toolbox/sys/Error.hpp>
+
+#include <array>
+#include <cstring>
+
+#include <sys/random.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace toolbox {
+inline namespace http {
+using namespace std;
+namespace {
+
+// Appended to the client's key to form the accept key.
+constexpr auto WsGuid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"sv;
+
+constexpr char Base64Chars[]{"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"};
+
+inline uint32_t rol(uint32_t x, int n) noexcept
+{
+    return (x << n) | (x >> (32 - n));
+}
+
+/// SHA-1 is only used for the opening handshake, where its weakness is not a concern.
+class Sha1 {
+  public:
+    void update(string_view data) noexcept
+    {
+        for (const auto c : data) {
+            block_[used_++] = static_cast<uint8_t>(c);
+            if (used_ == block_.size()) {
+                transform();
+                used_ = 0;
+            }
+        }
+        len_ += data.size();
+    }
+    array<uint8_t, 20> finish() noexcept
+    {
+        const uint64_t bits{len_ * 8};
+        update("\x80"sv);
+        while (used_ != 56) {
+            update({"\0", 1});
+        }
+        for (int i{7}; i >= 0; --i) {
+            block_[used_++] = static_cast<uint8_t>(bits >> (i * 8));
+        }
+        transform();
+        array<uint8_t, 20> digest;
+        for (size_t i{0}; i < 20; ++i) {
+            digest[i] = static_cast<uint8_t>(h_[i / 4] >> (24 - (i % 4) * 8));
+        }
+        return digest;
+    }
+
+  private:
+    void transform() noexcept
+    {
+        uint32_t w[80];
+        for (int i{0}; i < 16; ++i) {
+            w[i] = uint32_t{block_[i * 4]} << 24 | uint32_t{block_[i * 4 + 1]} << 16
+                | uint32_t{block_[i * 4 + 2]} << 8 | uint32_t{block_[i * 4 + 3]};
+        }
+        for (int i{16}; i < 80; ++i) {
+            w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+        auto a = h_[0], b = h_[1], c = h_[2], d = h_[3], e = h_[4];
+        for (int i{0}; i < 80; ++i) {
+            uint32_t f, k;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5a827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ed9eba1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8f1bbcdc;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xca62c1d6;
+            }
+            const auto t = rol(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rol(b, 30);
+            b = a;
+            a = t;
+        }
+        h_[0] += a;
+        h_[1] += b;
+        h_[2] += c;
+        h_[3] += d;
+        h_[4] += e;
+    }
+
+    array<uint32_t, 5> h_{0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+    array<uint8_t, 64> block_{};
+    size_t used_{0};
+    uint64_t len_{0};
+};
+
+string base64_encode(const uint8_t* data, size_t size)
+{
+    string out;
+    out.reserve((size + 2) / 3 * 4);
+    size_t i{0};
+    for (; i + 3 <= size; i += 3) {
+        const uint32_t v{uint32_t{data[i]} << 16 | uint32_t{data[i + 1]} << 8 | data[i + 2]};
+        out += Base64Chars[v >> 18];
+        out += Base64Chars[(v >> 12) & 0x3f];
+        out += Base64Chars[(v >> 6) & 0x3f];
+        out += Base64Chars[v & 0x3f];
+    }
+    if (i < size) {
+        uint32_t v{uint32_t{data[i]} << 16};
+        if (i + 1 < size) {
+            v |= uint32_t{data[i + 1]} << 8;
+        }
+        out += Base64Chars[v >> 18];
+        out += Base64Chars[(v >> 12) & 0x3f];
+        out += i + 1 < size ? Base64Chars[(v >> 6) & 0x3f] : '=';
+        out += '=';
+    }
+    return out;
+}
+
+/// Fill the buffer from the kernel's cryptographically secure random number generator. RFC 6455
+/// requires that masking keys and nonces are unpredictable.
+void random_bytes(void* buf, size_t len)
+{
+    auto* ptr = static_cast<char*>(buf);
+    while (len > 0) {
+        const auto ret = getrandom(ptr, len, 0);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw system_error{make_sys_error(errno), "getrandom"};
+        }
+        ptr += ret;
+        len -= ret;
+    }
+}
+
+inline bool is_valid(WsOpcode opcode) noexcept
+{
+    switch (opcode) {
+    case WsOpcode::Continuation:
+    case WsOpcode::Text:
+    case WsOpcode::Binary:
+    case WsOpcode::Close:
+    case WsOpcode::Ping:
+    case WsOpcode::Pong:
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+WsException::~WsException() = default;
+
+string ws_accept_key(string_view key)
+{
+    Sha1 sha1;
+    sha1.update(key);
+    sha1.update(WsGuid);
+    const auto digest = sha1.finish();
+    return base64_encode(digest.data(), digest.size());
+}
+
+string ws_client_key()
+{
+    uint8_t nonce[16];
+    random_bytes(nonce, sizeof(nonce));
+    return base64_encode(nonce, sizeof(nonce));
+}
+
+uint32_t ws_random_mask()
+{
+    uint32_t mask;
+    random_bytes(&mask, sizeof(mask));
+    return mask;
+}
+
+string_view ws_upgrade_key(const HttpRequest& req) noexcept
+{
+    if (req.method() != HttpMethod::Get) {
+        return {};
+    }
+    bool upgrade{false}, connection{false}, version{false};
+    string_view key;
+    for (const auto& [name, value] : req.headers()) {
+        if (detail::iequals(name, "upgrade")) {
+            upgrade = detail::has_token(value, "websocket");
+        } else if (detail::iequals(name, "connection")) {
+            connection = detail::has_token(value, "upgrade");
+        } else if (detail::iequals(name, "sec-websocket-version")) {
+            version = value == "13";
+        } else if (detail::iequals(name, "sec-websocket-key")) {
+            key = value;
+        }
+    }
+    return upgrade && connection && version ? key : string_view{};
+}
+
+bool ws_upgrade_accepted(const HttpResponse& resp, string_view key)
+{
+    if (resp.status_code() != static_cast<int>(HttpStatus::SwitchingProtocols)) {
+        return false;
+    }
+    bool upgrade{false}, connection{false};
+    string_view accept;
+    for (const auto& [name, value] : resp.headers()) {
+        if (detail::iequals(name, "upgrade")) {
+            upgrade = detail::has_token(value, "websocket");
+        } else if (detail::iequals(name, "connection")) {
+            connection = detail::has_token(value, "upgrade");
+        } else if (detail::iequals(name, "sec-websocket-accept")) {
+            accept = value;
+        }
+    }
+    return upgrade && connection && accept == ws_accept_key(key);
+}
+
+size_t ws_parse_header(const char* data, size_t size, WsFrameHeader& hdr)
+{
+    if (size < 2) {
+        return 0;
+    }
+    const auto* const p = reinterpret_cast<const uint8_t*>(data);
+    if (p[0] & 0x70) {
+        throw WsException{WsCloseCode::ProtocolError, "reserved bits set in frame header"};
+    }
+    hdr.fin = (p[0] & 0x80) != 0;
+    hdr.opcode = static_cast<WsOpcode>(p[0] & 0x0f);
+    if (!is_valid(hdr.opcode)) {
+        throw WsException{WsCloseCode::ProtocolError, "invalid frame opcode"};
+    }
+    hdr.masked = (p[1] & 0x80) != 0;
+    uint64_t len{p[1] & 0x7fU};
+    size_t n{2};
+    if (len == 126) {
+        if (size < 4) {
+            return 0;
+        }
+        len = uint64_t{p[2]} << 8 | p[3];
+        n = 4;
+    } else if (len == 127) {
+        if (size < 10) {
+            return 0;
+        }
+        len = 0;
+        for (int i{2}; i < 10; ++i) {
+            len = len << 8 | p[i];
+        }
+        if (len >> 63) {
+            throw WsException{WsCloseCode::ProtocolError, "invalid frame length"};
+        }
+        n = 10;
+    }
+    if (is_control(hdr.opcode) && (!hdr.fin || len > 125)) {
+        throw WsException{WsCloseCode::ProtocolError, "invalid control frame"};
+    }
+    hdr.mask = 0;
+    if (hdr.masked) {
+        if (size < n + 4) {
+            return 0;
+        }
+        memcpy(&hdr.mask, p + n, 4);
+        n += 4;
+    }
+    hdr.len = len;
+    return n;
+}
+
+size_t ws_put_header(char* dst, WsOpcode opcode, uint64_t len, bool fin,
+                     const uint32_t* mask) noexcept
+{
+    auto* const p = reinterpret_cast<uint8_t*>(dst);
+    p[0] = (fin ? 0x80 : 0) | static_cast<uint8_t>(opcode);
+    const uint8_t mask_bit = mask ? 0x80 : 0;
+    size_t n;
+    if (len < 126) {
+        p[1] = mask_bit | static_cast<uint8_t>(len);
+        n = 2;
+    } else if (len <= 0xffff) {
+        p[1] = mask_bit | 126;
+        p[2] = static_cast<uint8_t>(len >> 8);
+        p[3] = static_cast<uint8_t>(len);
+        n = 4;
+    } else {
+        p[1] = mask_bit | 127;
+        for (int i{0}; i < 8; ++i) {
+            p[2 + i] = static_cast<uint8_t>(len >> (56 - i * 8));
+        }
+        n = 10;
+    }
+    if (mask) {
+        memcpy(p + n, mask, 4);
+        n += 4;
+    }
+    return n;
+}
+
+void ws_put_frame(Buffer& buf, WsOpcode opcode, string_view payload, bool fin,
+                  const uint32_t* mask)
+{
+    auto* const dst = buffer_cast<char*>(buf.prepare(MaxWsHeader + payload.size()));
+    const auto n = ws_put_header(dst, opcode, payload.size(), fin, mask);
+    if (!payload.empty()) {
+        memcpy(dst + n, payload.data(), payload.size());
+        if (mask) {
+            ws_mask(dst + n, payload.size(), *mask);
+        }
+    }
+    buf.commit(n + payload.size());
+}
+
+void ws_mask(char* data, size_t len, uint32_t mask, size_t offset) noexcept
+{
+    // Rotate the key, so that the first byte of data is masked with the correct key byte.
+    uint8_t key[4], rot[4];
+    memcpy(key, &mask, 4);
+    for (size_t i{0}; i < 4; ++i) {
+        rot[i] = key[(offset + i) & 3];
+    }
+    uint32_t word;
+    memcpy(&word, rot, 4);
+
+    // Each loop processes a multiple of four bytes, so the key remains aligned with the data.
+    size_t i{0};
+#if defined(__AVX2__)
+    const auto wide = _mm256_set1_epi32(static_cast<int>(word));
+    for (; i + 32 <= len; i += 32) {
+        auto* const p = reinterpret_cast<__m256i*>(data + i);
+        _mm256_storeu_si256(p, _mm256_xor_si256(_mm256_loadu_si256(p), wide));
+    }
+#endif
+#if defined(__SSE2__)
+    const auto vec = _mm_set1_epi32(static_cast<int>(word));
+    for (; i + 16 <= len; i += 16) {
+        auto* const p = reinterpret_cast<__m128i*>(data + i);
+        _mm_storeu_si128(p, _mm_xor_si128(_mm_loadu_si128(p), vec));
+    }
+#endif
+    const uint64_t dword{uint64_t{word} << 32 | word};
+    for (; i + 8 <= len; i += 8) {
+        uint64_t v;
+        memcpy(&v, data + i, 8);
+        v ^= dword;
+        memcpy(data + i, &v, 8);
+    }
+    for (; i < len; ++i) {
+        data[i] ^= rot[i & 3];
+    }
+}
+
+WsBufferPool::~WsBufferPool() = default;
+
+WsBufferPool& WsBufferPool::local() noexcept
+{
+    thread_local WsBufferPool pool;
+    return pool;
+}
+
+unique_ptr<Buffer> WsBufferPool::acquire()
+{
+    if (free_.empty()) {
+        return make_unique<Buffer>();
+    }
+    auto buf = move(free_.back());
+    free_.pop_back();
+    return buf;
+}
+
+void WsBufferPool::release(unique_ptr<Buffer> buf) noexcept
+{
+    if (free_.size() < MaxFree && buf->capacity() <= MaxCapacity) {
+        buf->clear();
+        // Storage for MaxFree buffers was reserved on construction.
+        free_.push_back(move(buf));
+    }
+}
+
+} // namespace http
+} // namespace toolbox
@@ -0,0 +1,160 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef TOOLBOX_HTTP_WEBSOCKET_HPP
+#define TOOLBOX_HTTP_WEBSOCKET_HPP
+
+#include <toolbox/http/Request.hpp>
+#include <toolbox/io/Buffer.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace toolbox {
+inline namespace http {
+
+enum class WsOpcode : std::uint8_t {
+    Continuation = 0x0,
+    Text = 0x1,
+    Binary = 0x2,
+    Close = 0x8,
+    Ping = 0x9,
+    Pong = 0xa
+};
+
+/// Status codes sent in Close frames, as defined by RFC 6455.
+enum class WsCloseCode : std::uint16_t {
+    Normal = 1000,
+    GoingAway = 1001,
+    ProtocolError = 1002,
+    UnsupportedData = 1003,
+    InvalidPayload = 1007,
+    PolicyViolation = 1008,
+    MessageTooBig = 1009,
+    InternalError = 1011
+};
+
+/// Maximum size of a frame header.
+constexpr std::size_t MaxWsHeader{14};
+/// Maximum size of a message, after fragments have been reassembled.
+constexpr std::size_t MaxWsMessage{16 * 1024 * 1024};
+
+/// Thrown when the peer violates the protocol. The code is sent to the peer in a Close frame.
+class TOOLBOX_API WsException : public std::runtime_error {
+  public:
+    WsException(WsCloseCode code, const char* what)
+    : std::runtime_error{what}
+    , code_{code}
+    {
+    }
+    ~WsException() override;
+
+    WsCloseCode code() const noexcept { return code_; }
+
+  private:
+    WsCloseCode code_;
+};
+
+struct WsFrameHeader {
+    bool fin;
+    WsOpcode opcode;
+    bool masked;
+    /// Masking key, in wire order.
+    std::uint32_t mask;
+    std::uint64_t len;
+};
+
+constexpr bool is_control(WsOpcode opcode) noexcept
+{
+    return (static_cast<std::uint8_t>(opcode) & 0x8) != 0;
+}
+
+/// Returns the value of the Sec-WebSocket-Accept header for the client's Sec-WebSocket-Key.
+TOOLBOX_API std::string ws_accept_key(std::string_view key);
+
+/// Returns a random Sec-WebSocket-Key for a client handshake.
+TOOLBOX_API std::string ws_client_key();
+
+/// Returns a random masking key for a client frame.
+/// \throw std::system_error if the kernel's random number generator fails.
+TOOLBOX_API std::uint32_t ws_random_mask();
+
+/// Returns the Sec-WebSocket-Key if req is a valid WebSocket upgrade request, otherwise an empty
+/// view.
+TOOLBOX_API std::string_view ws_upgrade_key(const HttpRequest& req) noexcept;
+
+/// Returns true if resp accepts the client's upgrade request, which was sent with key.
+TOOLBOX_API bool ws_upgrade_accepted(const HttpResponse& resp, std::string_view key);
+
+/// Parse a frame header.
+///
+/// \return the size of the header, or zero if more input is required.
+/// \throw WsException if the header is invalid.
+TOOLBOX_API std::size_t ws_parse_header(const char* data, std::size_t size, WsFrameHeader& hdr);
+
+/// Writes a frame header, which requires at most MaxWsHeader bytes, and returns its size. Frames
+/// sent by clients must be masked.
+TOOLBOX_API std::size_t ws_put_header(char* dst, WsOpcode opcode, std::uint64_t len,
+                                      bool fin = true,
+                                      const std::uint32_t* mask = nullptr) noexcept;
+
+/// Appends a frame to buf. The payload is masked in the buffer if mask is not null.
+TOOLBOX_API void ws_put_frame(Buffer& buf, WsOpcode opcode, std::string_view payload,
+                              bool fin = true, const std::uint32_t* mask = nullptr);
+
+/// Mask or unmask data in place. The offset is the position of data within the payload, so that a
+/// payload may be unmasked in pieces.
+TOOLBOX_API void ws_mask(char* data, std::size_t len, std::uint32_t mask,
+                         std::size_t offset = 0) noexcept;
+
+/// Free-list of buffers used to reassemble fragmented messages. Buffers are returned to the pool
+/// with their capacity intact, so that steady-state reassembly does not allocate.
+class TOOLBOX_API WsBufferPool {
+  public:
+    /// Maximum number of free buffers retained by the pool.
+    static constexpr std::size_t MaxFree{64};
+    /// Buffers with a larger capacity are released to the heap.
+    static constexpr std::size_t MaxCapacity{1024 * 1024};
+
+    WsBufferPool() { free_.reserve(MaxFree); }
+    ~WsBufferPool();
+
+    // Copy.
+    WsBufferPool(const WsBufferPool&) = delete;
+    WsBufferPool& operator=(const WsBufferPool&) = delete;
+
+    // Move.
+    WsBufferPool(WsBufferPool&&) = delete;
+    WsBufferPool& operator=(WsBufferPool&&) = delete;
+
+    /// Returns the pool for the calling thread.
+    static WsBufferPool& local() noexcept;
+
+    std::size_t size() const noexcept { return free_.size(); }
+
+    std::unique_ptr<Buffer> acquire();
+    void release(std::unique_ptr<Buffer> buf) noexcept;
+
+  private:
+    std::vector<std::unique_ptr<Buffer>> free_;
+};
+
+} // namespace http
+} // namespace toolbox
+
+#endif // TOOLBOX_HTTP_WEBSOCKET_HPP
@@ -0,0 +1,347 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "WebSocket.hpp"
+#include "TestServ.ut.hpp"
+
+#include <toolbox/net/StreamSock.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+using namespace toolbox;
+using namespace toolbox::http::test;
+
+namespace {
+
+/// Broadcasts each WebSocket message to all connections.
+class WsApp {
+  public:
+    explicit WsApp(HttpServ& serv)
+    : serv_{serv}
+    {
+        serv.accept(bind<&WsApp::on_accept>(this));
+    }
+
+  private:
+    void on_accept(CyclTime now, HttpServerConn& conn)
+    {
+        conn.ws_message(bind<&WsApp::on_ws_message>(this));
+    }
+    void on_ws_message(CyclTime now, const StreamEndpoint& ep, WsOpcode opcode, string_view msg)
+    {
+        serv_.ws_broadcast(now, opcode, msg);
+    }
+
+    HttpServ& serv_;
+};
+
+/// Client side of a WebSocket connection, which records the messages that it receives.
+struct WsClnt {
+    /// Connect to ep and send the upgrade request. The connection disposes of itself when closed.
+    HttpConn* connect(CyclTime now, os::Reactor& reactor, const StreamEndpoint& ep)
+    {
+        StreamSockClnt sock{ep.protocol()};
+        sock.connect(ep);
+        sock.set_non_block();
+        auto* const conn = new HttpConn{now, reactor, std::move(sock), ep};
+        conn->http_disconnect(bind<&WsClnt::on_http_disconnect>(this));
+        conn->ws_open(bind<&WsClnt::on_ws_open>(this));
+        conn->ws_message(bind<&WsClnt::on_ws_message>(this));
+        conn->ws_connect(now, "localhost", "/ws");
+        return conn;
+    }
+    void on_http_disconnect(CyclTime now, const StreamEndpoint& ep) { closed = true; }
+    void on_ws_open(CyclTime now, const StreamEndpoint& ep, const HttpRequest& req) { open = true; }
+    void on_ws_message(CyclTime now, const StreamEndpoint& ep, WsOpcode opcode, string_view msg)
+    {
+        msgs.emplace_back(msg);
+    }
+
+    bool open{false}, closed{false};
+    vector<string> msgs;
+};
+
+/// Read from the socket until a complete frame is available.
+pair<WsFrameHeader, string> read_frame(int fd, string& in)
+{
+    char buf[1024];
+    for (;;) {
+        WsFrameHeader hdr;
+        const auto n = ws_parse_header(in.data(), in.size(), hdr);
+        if (n > 0 && in.size() >= n + hdr.len) {
+            auto payload = in.substr(n, hdr.len);
+            in.erase(0, n + hdr.len);
+            return {hdr, payload};
+        }
+        const auto m = os::read(fd, {buf, sizeof(buf)});
+        BOOST_REQUIRE(m > 0);
+        in.append(buf, m);
+    }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(WebSocketSuite)
+
+BOOST_AUTO_TEST_CASE(WsAcceptKeyCase)
+{
+    // Example from RFC 6455.
+    BOOST_TEST(ws_accept_key("dGhlIHNhbXBsZSBub25jZQ==") == "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+    const auto key = ws_client_key();
+    BOOST_TEST(key.size() == 24U);
+    BOOST_TEST(key.compare(22, 2, "==") == 0);
+}
+
+BOOST_AUTO_TEST_CASE(WsUpgradeKeyCase)
+{
+    HttpRequest req;
+    req.append_url("/chat");
+    for (const auto& [name, value] : {pair{"Host"sv, "server.example.com"sv},
+                                      pair{"Upgrade"sv, "websocket"sv},
+                                      pair{"Connection"sv, "keep-alive, Upgrade"sv},
+                                      pair{"Sec-WebSocket-Key"sv, "dGhlIHNhbXBsZSBub25jZQ=="sv}}) {
+        req.append_header_field(name, First::Yes);
+        req.append_header_value(value, First::Yes);
+    }
+    // The version is required.
+    BOOST_TEST(ws_upgrade_key(req).empty());
+    req.append_header_field("Sec-WebSocket-Version", First::Yes);
+    req.append_header_value("13", First::Yes);
+    BOOST_TEST(ws_upgrade_key(req) == "dGhlIHNhbXBsZSBub25jZQ==");
+    req.set_method(HttpMethod::Post);
+    BOOST_TEST(ws_upgrade_key(req).empty());
+}
+
+BOOST_AUTO_TEST_CASE(WsHeaderCase)
+{
+    const uint32_t mask{0x37fa213d};
+    for (const uint64_t len : {0UL, 125UL, 126UL, 65535UL, 65536UL, 1UL << 40}) {
+        char buf[MaxWsHeader];
+        const auto n = ws_put_header(buf, WsOpcode::Binary, len, false, &mask);
+        BOOST_TEST(n == (len < 126 ? 6U : len <= 65535 ? 8U : 14U));
+        WsFrameHeader hdr;
+        // Incomplete headers require more input.
+        BOOST_TEST(ws_parse_header(buf, n - 1, hdr) == 0U);
+        BOOST_TEST(ws_parse_header(buf, n, hdr) == n);
+        BOOST_TEST(!hdr.fin);
+        BOOST_TEST((hdr.opcode == WsOpcode::Binary));
+        BOOST_TEST(hdr.masked);
+        BOOST_TEST(hdr.mask == mask);
+        BOOST_TEST(hdr.len == len);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(WsHeaderErrorCase)
+{
+    WsFrameHeader hdr;
+    // Reserved bits.
+    BOOST_CHECK_THROW(ws_parse_header("\xc1\x00", 2, hdr), WsException);
+    // Reserved opcode.
+    BOOST_CHECK_THROW(ws_parse_header("\x83\x00", 2, hdr), WsException);
+    // Fragmented control frame.
+    BOOST_CHECK_THROW(ws_parse_header("\x09\x00", 2, hdr), WsException);
+    // Control frame payload too long.
+    BOOST_CHECK_THROW(ws_parse_header("\x89\x7e\x00\x7e", 4, hdr), WsException);
+    try {
+        ws_parse_header("\x8b\x00", 2, hdr);
+    } catch (const WsException& e) {
+        BOOST_TEST((e.code() == WsCloseCode::ProtocolError));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(WsFrameCase)
+{
+    // Examples from RFC 6455.
+    Buffer buf;
+    ws_put_frame(buf, WsOpcode::Text, "Hello");
+    BOOST_TEST(buf.str() == "\x81\x05Hello"sv);
+
+    buf.clear();
+    const char key[]{'\x37', '\xfa', '\x21', '\x3d'};
+    uint32_t mask;
+    memcpy(&mask, key, 4);
+    ws_put_frame(buf, WsOpcode::Text, "Hello", true, &mask);
+    BOOST_TEST(buf.str() == "\x81\x85\x37\xfa\x21\x3d\x7f\x9f\x4d\x51\x58"sv);
+}
+
+BOOST_AUTO_TEST_CASE(WsMaskCase)
+{
+    const char key[]{'\x12', '\x34', '\x56', '\x78'};
+    uint32_t mask;
+    memcpy(&mask, key, 4);
+
+    string data(1000, '\0');
+    for (size_t i{0}; i < data.size(); ++i) {
+        data[i] = static_cast<char>(i * 7);
+    }
+    for (const size_t len : {0UL, 1UL, 7UL, 15UL, 31UL, 33UL, 100UL, 1000UL}) {
+        for (size_t offset{0}; offset < 4; ++offset) {
+            auto masked = data.substr(0, len);
+            ws_mask(masked.data(), len, mask, offset);
+            for (size_t i{0}; i < len; ++i) {
+                BOOST_TEST(masked[i] == static_cast<char>(data[i] ^ key[(offset + i) % 4]));
+            }
+            // Unmasking in pieces restores the data.
+            const auto half = len / 2;
+            ws_mask(masked.data(), half, mask, offset);
+            ws_mask(masked.data() + half, len - half, mask, offset + half);
+            BOOST_TEST(masked == data.substr(0, len));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(WsBufferPoolCase)
+{
+    WsBufferPool pool;
+    auto buf = pool.acquire();
+    buf->prepare(4096);
+    buf->commit(4096);
+    auto* const ptr = buf.get();
+    pool.release(move(buf));
+    BOOST_TEST(pool.size() == 1U);
+
+    // Buffers are reused empty, with their capacity.
+    buf = pool.acquire();
+    BOOST_TEST(buf.get() == ptr);
+    BOOST_TEST(buf->empty());
+    BOOST_TEST(buf->capacity() >= 4096U);
+    BOOST_TEST(pool.size() == 0U);
+
+    // Large buffers are not retained.
+    buf->prepare(WsBufferPool::MaxCapacity + 1);
+    pool.release(move(buf));
+    BOOST_TEST(pool.size() == 0U);
+}
+
+BOOST_AUTO_TEST_CASE(HttpWebSocketCase)
+{
+    const auto now = CyclTime::now();
+    BasicHttpMultiServ<WsApp> serv{
+        now, {boost::asio::ip::address_v4::loopback(), 0}, 1,
+        [](CyclTime now, HttpServ& serv) { return make_unique<WsApp>(serv); }};
+    StreamEndpoint ep;
+    serv[0].serv().get_sock_name(ep);
+
+    constexpr int Clients{2};
+    vector<StreamSockClnt> clients;
+    vector<string> ins(Clients);
+    for (int i{0}; i < Clients; ++i) {
+        clients.emplace_back(ep.protocol());
+        auto& clnt = clients.back();
+        clnt.connect(ep);
+        const auto key = ws_client_key();
+        const auto req = "GET /ws HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\n"
+                         "Connection: Upgrade\r\nSec-WebSocket-Version: 13\r\n"
+                         "Sec-WebSocket-Key: "
+            + key + "\r\n\r\n";
+        os::write(clnt.get(), {req.data(), req.size()});
+
+        auto& in = ins[i];
+        char buf[1024];
+        while (in.find("\r\n\r\n") == string::npos) {
+            const auto n = os::read(clnt.get(), {buf, sizeof(buf)});
+            BOOST_REQUIRE(n > 0);
+            in.append(buf, n);
+        }
+        BOOST_TEST(in.compare(0, 34, "HTTP/1.1 101 Switching Protocols\r\n") == 0);
+        BOOST_TEST(in.find("\r\nSec-WebSocket-Accept: " + ws_accept_key(key) + "\r\n")
+                   != string::npos);
+        in.erase(0, in.find("\r\n\r\n") + 4);
+    }
+
+    // A fragmented message, interleaved with a ping, from the first client.
+    const auto mask = ws_random_mask();
+    Buffer out;
+    ws_put_frame(out, WsOpcode::Text, "Hello, ", false, &mask);
+    ws_put_frame(out, WsOpcode::Ping, "ping", true, &mask);
+    ws_put_frame(out, WsOpcode::Continuation, "World!", true, &mask);
+    os::write(clients[0].get(), out.buffer());
+
+    auto [pong, data] = read_frame(clients[0].get(), ins[0]);
+    BOOST_TEST((pong.opcode == WsOpcode::Pong));
+    BOOST_TEST(!pong.masked);
+    BOOST_TEST(data == "ping");
+    // The reassembled message is broadcast to all clients.
+    for (int i{0}; i < Clients; ++i) {
+        auto [hdr, msg] = read_frame(clients[i].get(), ins[i]);
+        BOOST_TEST(hdr.fin);
+        BOOST_TEST((hdr.opcode == WsOpcode::Text));
+        BOOST_TEST(msg == "Hello, World!");
+    }
+
+    // An unmasked frame is a protocol error.
+    out.clear();
+    ws_put_frame(out, WsOpcode::Text, "Hello");
+    os::write(clients[1].get(), out.buffer());
+    auto [close, reason] = read_frame(clients[1].get(), ins[1]);
+    BOOST_TEST((close.opcode == WsOpcode::Close));
+    BOOST_TEST(reason == "\x03\xea"sv);
+    BOOST_TEST(wait_for([&serv]() { return serv.connections() == 1; }));
+
+    // A close frame with a one-byte body is a protocol error.
+    out.clear();
+    ws_put_frame(out, WsOpcode::Close, "\x03", true, &mask);
+    os::write(clients[0].get(), out.buffer());
+    auto [close2, reason2] = read_frame(clients[0].get(), ins[0]);
+    BOOST_TEST((close2.opcode == WsOpcode::Close));
+    BOOST_TEST(reason2 == "\x03\xea"sv);
+    BOOST_TEST(wait_for([&serv]() { return serv.connections() == 0; }));
+}
+
+BOOST_AUTO_TEST_CASE(HttpWebSocketClntCase)
+{
+    const auto now = CyclTime::now();
+    BasicHttpMultiServ<WsApp> serv{
+        now, {boost::asio::ip::address_v4::loopback(), 0}, 1,
+        [](CyclTime now, HttpServ& serv) { return make_unique<WsApp>(serv); }};
+    StreamEndpoint ep;
+    serv[0].serv().get_sock_name(ep);
+
+    os::Reactor reactor;
+    WsClnt clnt;
+    auto* const conn = clnt.connect(now, reactor, ep);
+    BOOST_TEST(poll_until(reactor, [&clnt]() { return clnt.open; }));
+    BOOST_TEST(conn->is_ws());
+
+    // The server closes the connection if a client frame is not masked, so the echo shows that
+    // the client masks its frames.
+    conn->ws_send(WsOpcode::Text, "Hello, World!");
+    BOOST_TEST(poll_until(reactor, [&clnt]() { return !clnt.msgs.empty(); }));
+    BOOST_TEST(clnt.msgs.size() == 1U);
+    BOOST_TEST(clnt.msgs.front() == "Hello, World!");
+
+    conn->ws_close(WsCloseCode::Normal);
+    BOOST_TEST(poll_until(reactor, [&clnt]() { return clnt.closed; }));
+    BOOST_TEST(wait_for([&serv]() { return serv.connections() == 0; }));
+}
+
+BOOST_AUTO_TEST_CASE(HttpWebSocketRefusedCase)
+{
+    // The test server responds to the upgrade request with a 200 response.
+    const auto now = CyclTime::now();
+    TestServ serv{now, {boost::asio::ip::address_v4::loopback(), 0}, 1,
+                  [](CyclTime now, HttpServ& serv) { return make_unique<TestApp>(serv); }};
+    StreamEndpoint ep;
+    serv[0].serv().get_sock_name(ep);
+
+    os::Reactor reactor;
+    WsClnt clnt;
+    clnt.connect(now, reactor, ep);
+    BOOST_TEST(poll_until(reactor, [&clnt]() { return clnt.closed; }));
+    BOOST_TEST(!clnt.open);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
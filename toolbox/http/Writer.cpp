@@ -0,0 +1,168 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "Writer.hpp"
+
+#include <toolbox/util/Ryu.hpp>
+
+namespace toolbox {
+inline namespace http {
+using namespace std;
+namespace {
+
+// Status-Line = HTTP-Version SP Status-Code SP Reason-Phrase CRLF. Use 10 space place-holder for
+// content length. RFC2616 states that field value MAY be preceded by any amount of LWS, though a
+// single SP is preferred.
+constexpr auto ContentLength = "\r\nContent-Length:          0"sv;
+
+constexpr char Days[][4]{"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+constexpr char Months[][4]{"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                           "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+inline char* put_2d(char* dst, int val) noexcept
+{
+    *dst++ = '0' + val / 10;
+    *dst++ = '0' + val % 10;
+    return dst;
+}
+
+} // namespace
+
+string_view http_status_line(HttpStatus status) noexcept
+{
+    switch (static_cast<int>(status)) {
+#define XX(num, name, string)                                                                      \
+    case num:                                                                                      \
+        return "HTTP/1.1 " #num " " #string ""sv;
+        HTTP_STATUS_MAP(XX)
+#undef XX
+    }
+    // Unknown status codes are formatted at run time with a generic reason phrase.
+    thread_local char buf[sizeof("HTTP/1.1 -2147483648 Unknown")];
+    constexpr auto Version = "HTTP/1.1 "sv;
+    constexpr auto Reason = " Unknown"sv;
+    auto* p = copy(Version.begin(), Version.end(), buf);
+    p = to_chars(p, buf + sizeof(buf), static_cast<int>(status)).ptr;
+    p = copy(Reason.begin(), Reason.end(), p);
+    return {buf, static_cast<size_t>(p - buf)};
+}
+
+size_t put_http_date(char* dst, WallTime t) noexcept
+{
+    thread_local time_t cached_time{-1};
+    thread_local char cached[MaxHttpDate];
+
+    const auto tt = WallClock::to_time_t(t);
+    if (tt != cached_time) {
+        struct tm gmt;
+        gmtime_r(&tt, &gmt);
+        auto* p = cached;
+        p = copy_n(Days[gmt.tm_wday], 3, p);
+        *p++ = ',';
+        *p++ = ' ';
+        p = put_2d(p, gmt.tm_mday);
+        *p++ = ' ';
+        p = copy_n(Months[gmt.tm_mon], 3, p);
+        *p++ = ' ';
+        const int year{gmt.tm_year + 1900};
+        p = put_2d(p, year / 100);
+        p = put_2d(p, year % 100);
+        *p++ = ' ';
+        p = put_2d(p, gmt.tm_hour);
+        *p++ = ':';
+        p = put_2d(p, gmt.tm_min);
+        *p++ = ':';
+        p = put_2d(p, gmt.tm_sec);
+        copy_n(" GMT", 4, p);
+        cached_time = tt;
+    }
+    memcpy(dst, cached, MaxHttpDate);
+    return MaxHttpDate;
+}
+
+HttpResponseWriter::~HttpResponseWriter() = default;
+
+void HttpResponseWriter::commit() noexcept
+{
+    if (in_headers_) {
+        end_headers();
+    }
+    if (cloff_ > 0) {
+        auto* it = base_ + cloff_;
+        auto len = pcount_ - hcount_;
+        do {
+            *--it = '0' + len % 10;
+            len /= 10;
+        } while (len > 0);
+    }
+    buf_.commit(pcount_);
+    reset();
+}
+
+void HttpResponseWriter::http_status(WallTime now, HttpStatus status, const char* content_type,
+                                     NoCache no_cache)
+{
+    reset();
+    const auto line = http_status_line(status);
+    const string_view type{content_type ? content_type : ""};
+    // Sufficient for the status line and all fixed headers.
+    auto* p = prepare(line.size() + type.size() + 128);
+    append(p, line);
+    if (no_cache == NoCache::Yes) {
+        append(base_ + pcount_, "\r\nCache-Control: no-cache"sv);
+    }
+    append(base_ + pcount_, "\r\nDate: "sv);
+    pcount_ += put_http_date(base_ + pcount_, now);
+    if (content_type) {
+        append(base_ + pcount_, "\r\nContent-Type: "sv);
+        append(base_ + pcount_, type);
+        append(base_ + pcount_, ContentLength);
+        cloff_ = pcount_;
+    }
+    in_headers_ = true;
+}
+
+void HttpResponseWriter::header(string_view name, string_view value)
+{
+    auto* p = prepare(name.size() + value.size() + 4);
+    append(p, "\r\n"sv);
+    append(base_ + pcount_, name);
+    append(base_ + pcount_, ": "sv);
+    append(base_ + pcount_, value);
+}
+
+HttpResponseWriter& HttpResponseWriter::put(double val)
+{
+    auto* const first = prepare_body(MaxRyuDtosBuf);
+    pcount_ += to_chars(first, first + MaxRyuDtosBuf, val).ptr - first;
+    return *this;
+}
+
+HttpResponseWriter& HttpResponseWriter::put_fixed(double val, int prec)
+{
+    auto* const first = prepare_body(max_ryu_fixed_buf(prec));
+    pcount_ += util::dtofixed(first, val, prec);
+    return *this;
+}
+
+void HttpResponseWriter::end_headers()
+{
+    in_headers_ = false;
+    append(prepare(4), "\r\n\r\n"sv);
+    hcount_ = pcount_;
+}
+
+} // namespace http
+} // namespace toolbox
@@ -0,0 +1,152 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef TOOLBOX_HTTP_WRITER_HPP
+#define TOOLBOX_HTTP_WRITER_HPP
+
+#include <toolbox/http/Types.hpp>
+#include <toolbox/io/Buffer.hpp>
+#include <toolbox/sys/Time.hpp>
+
+#include <charconv>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+namespace toolbox {
+inline namespace http {
+
+/// Returns the precomputed status line for status, without the trailing CRLF. Unknown status codes
+/// are formatted into a thread-local buffer with the reason phrase "Unknown", which is valid until
+/// the next such call on the same thread.
+TOOLBOX_API std::string_view http_status_line(HttpStatus status) noexcept;
+
+/// Maximum size of an IMF-fixdate, as used by the Date header.
+constexpr std::size_t MaxHttpDate{29};
+
+/// Writes an IMF-fixdate, for example "Sun, 06 Nov 1994 08:49:37 GMT", and returns its size.
+/// The result for the current second is cached per thread.
+TOOLBOX_API std::size_t put_http_date(char* dst, WallTime t) noexcept;
+
+/// HttpResponseWriter formats responses directly into an output buffer, without the overhead of
+/// std::ostream.
+///
+/// As with HttpStream, the bytes written are not visible in the buffer until they are committed,
+/// and the Content-Length header is back-patched on commit, once the size of the body is known.
+/// Connection callbacks construct the writer on the buffer of the HttpStream that they are passed.
+class TOOLBOX_API HttpResponseWriter {
+  public:
+    explicit HttpResponseWriter(Buffer& buf) noexcept
+    : buf_{buf}
+    {
+    }
+    ~HttpResponseWriter();
+
+    // Copy.
+    HttpResponseWriter(const HttpResponseWriter&) = delete;
+    HttpResponseWriter& operator=(const HttpResponseWriter&) = delete;
+
+    // Move.
+    HttpResponseWriter(HttpResponseWriter&&) = delete;
+    HttpResponseWriter& operator=(HttpResponseWriter&&) = delete;
+
+    std::size_t pcount() const noexcept { return pcount_; }
+    void commit() noexcept;
+    void reset() noexcept
+    {
+        base_ = nullptr;
+        pcount_ = avail_ = cloff_ = hcount_ = 0;
+        in_headers_ = false;
+    }
+
+    /// Begin a response, discarding any uncommitted output. Additional headers may be written with
+    /// header() until the first byte of the body.
+    void http_status(WallTime now, HttpStatus status, const char* content_type,
+                     NoCache no_cache = NoCache::Yes);
+    void header(std::string_view name, std::string_view value);
+
+    HttpResponseWriter& put(char c)
+    {
+        *prepare_body(1) = c;
+        ++pcount_;
+        return *this;
+    }
+    HttpResponseWriter& put(std::string_view sv)
+    {
+        append(prepare_body(sv.size()), sv);
+        return *this;
+    }
+    template <typename ValueT,
+              typename = std::enable_if_t<std::is_integral_v<ValueT>
+                                          && !std::is_same_v<ValueT, bool>
+                                          && !std::is_same_v<ValueT, char>>>
+    HttpResponseWriter& put(ValueT val)
+    {
+        // Maximum number of characters for a 64-bit integer, including sign.
+        auto* const first = prepare_body(20);
+        pcount_ += std::to_chars(first, first + 20, val).ptr - first;
+        return *this;
+    }
+    /// Write the shortest representation of the double that round-trips.
+    HttpResponseWriter& put(double val);
+    /// Write the double in fixed format with prec decimal places.
+    HttpResponseWriter& put_fixed(double val, int prec);
+
+    template <typename ValueT>
+    HttpResponseWriter& operator<<(const ValueT& val)
+    {
+        return put(val);
+    }
+    HttpResponseWriter& operator<<(const char* s) { return put(std::string_view{s}); }
+
+  private:
+    /// Returns a pointer to at least size bytes of space for writing.
+    char* prepare(std::size_t size)
+    {
+        if (size > avail_ - pcount_) {
+            const auto buf = buf_.prepare(pcount_ + size);
+            base_ = buffer_cast<char*>(buf);
+            avail_ = buffer_size(buf);
+        }
+        return base_ + pcount_;
+    }
+    char* prepare_body(std::size_t size)
+    {
+        if (in_headers_) {
+            end_headers();
+        }
+        return prepare(size);
+    }
+    void append(char* dst, std::string_view sv) noexcept
+    {
+        std::memcpy(dst, sv.data(), sv.size());
+        pcount_ += sv.size();
+    }
+    void end_headers();
+
+    Buffer& buf_;
+    char* base_{nullptr};
+    std::size_t pcount_{0}, avail_{0};
+    /// Content-Length offset.
+    std::size_t cloff_{0};
+    /// Header size.
+    std::size_t hcount_{0};
+    bool in_headers_{false};
+};
+
+} // namespace http
+} // namespace toolbox
+
+#endif // TOOLBOX_HTTP_WRITER_HPP
@@ -0,0 +1,138 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "Writer.hpp"
+
+#include <toolbox/http/Stream.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+using namespace toolbox;
+
+namespace {
+// Sun, 06 Nov 1994 08:49:37 GMT.
+const WallTime Now{Seconds{784111777}};
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(WriterSuite)
+
+BOOST_AUTO_TEST_CASE(HttpStatusLineCase)
+{
+    BOOST_TEST(http_status_line(HttpStatus::Ok) == "HTTP/1.1 200 OK");
+    BOOST_TEST(http_status_line(HttpStatus::NotFound) == "HTTP/1.1 404 Not Found");
+    BOOST_TEST(http_status_line(static_cast<HttpStatus>(299)) == "HTTP/1.1 299 Unknown");
+}
+
+BOOST_AUTO_TEST_CASE(HttpDateCase)
+{
+    char buf[MaxHttpDate];
+    BOOST_TEST(put_http_date(buf, Now) == MaxHttpDate);
+    BOOST_TEST(string_view(buf, MaxHttpDate) == "Sun, 06 Nov 1994 08:49:37 GMT");
+    // Cached within the same second.
+    BOOST_TEST(put_http_date(buf, Now + Millis{999}) == MaxHttpDate);
+    BOOST_TEST(string_view(buf, MaxHttpDate) == "Sun, 06 Nov 1994 08:49:37 GMT");
+    put_http_date(buf, Now + Seconds{86400 * 60 + 1});
+    BOOST_TEST(string_view(buf, MaxHttpDate) == "Thu, 05 Jan 1995 08:49:38 GMT");
+}
+
+BOOST_AUTO_TEST_CASE(HttpResponseWriterCase)
+{
+    Buffer buf;
+    HttpResponseWriter w{buf};
+    w.http_status(Now, HttpStatus::Ok, ApplicationJson);
+    w.header("X-Request-Id", "42");
+    w << "{\"id\":" << 12345 << ",\"px\":" << 1.25 << ",\"neg\":" << -7L << ",\"qty\":";
+    w.put_fixed(1.234, 2).put('}');
+    BOOST_TEST(buf.empty());
+    w.commit();
+    BOOST_TEST(w.pcount() == 0U);
+    BOOST_TEST(buf.str()
+               == "HTTP/1.1 200 OK\r\n"
+                  "Cache-Control: no-cache\r\n"
+                  "Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n"
+                  "Content-Type: application/json\r\n"
+                  "Content-Length:         42\r\n"
+                  "X-Request-Id: 42\r\n"
+                  "\r\n"
+                  "{\"id\":12345,\"px\":1.25,\"neg\":-7,\"qty\":1.23}"
+                  "");
+}
+
+BOOST_AUTO_TEST_CASE(HttpResponseWriterEmptyCase)
+{
+    Buffer buf;
+    HttpResponseWriter w{buf};
+    w.http_status(Now, HttpStatus::NoContent, nullptr, NoCache::No);
+    w.commit();
+    BOOST_TEST(buf.str()
+               == "HTTP/1.1 204 No Content\r\n"
+                  "Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n"
+                  "\r\n");
+
+    // Uncommitted output is discarded by the next response.
+    buf.clear();
+    w.http_status(Now, HttpStatus::InternalServerError, TextPlain);
+    w << "discarded";
+    w.http_status(Now, HttpStatus::NotFound, TextPlain, NoCache::No);
+    w.commit();
+    BOOST_TEST(buf.str()
+               == "HTTP/1.1 404 Not Found\r\n"
+                  "Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n"
+                  "Content-Type: text/plain\r\n"
+                  "Content-Length:          0\r\n"
+                  "\r\n");
+}
+
+BOOST_AUTO_TEST_CASE(HttpResponseWriterLargeCase)
+{
+    Buffer buf;
+    HttpResponseWriter w{buf};
+    w.http_status(Now, HttpStatus::Ok, TextPlain);
+    const string line(100, 'x');
+    for (int i{0}; i < 1000; ++i) {
+        w << line;
+    }
+    w.commit();
+    BOOST_TEST(buf.str().find("Content-Length:     100000\r\n") != string_view::npos);
+    BOOST_TEST(buf.str().substr(buf.size() - 100) == line);
+}
+
+BOOST_AUTO_TEST_CASE(HttpResponseWriterStreamCase)
+{
+    // As from a connection's http_message callback.
+    Buffer buf;
+    HttpStream os{buf};
+    HttpResponseWriter w{os.buffer()};
+    w.http_status(Now, HttpStatus::Ok, TextPlain, NoCache::No);
+    w << "Hello";
+    w.commit();
+    BOOST_TEST(buf.str()
+               == "HTTP/1.1 200 OK\r\n"
+                  "Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n"
+                  "Content-Type: text/plain\r\n"
+                  "Content-Length:          5\r\n"
+                  "\r\n"
+                  "Hello");
+
+    // The stream and the writer may be used in turn.
+    os.http_status(HttpStatus::Ok, TextPlain);
+    os << "World";
+    os.commit();
+    BOOST_TEST(buf.str().find("HelloHTTP/1.1 200 OK\r\n") != string_view::npos);
+    BOOST_TEST(buf.str().substr(buf.size() - 9) == "\r\n\r\nWorld");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
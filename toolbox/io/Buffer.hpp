@@ -57,6 +57,9 @@ class TOOLBOX_API Buffer {
     /// Returns available data as a string view.
     std::string_view str() const noexcept { return {rptr(), size()}; }
 
+    /// Returns available data as a mutable buffer, for transformations in place.
+    MutableBuffer mutable_buffer() noexcept { return {buf_.data() + rpos_, size()}; }
+
     /// Returns slice of available data as a string view.
     std::string_view str(std::size_t limit) const noexcept
     {
@@ -68,6 +71,9 @@ class TOOLBOX_API Buffer {
 
     /// Returns number of bytes available for read.
     std::size_t size() const noexcept { return wpos_ - rpos_; }
+
+    /// Returns the size of the underlying storage.
+    std::size_t capacity() const noexcept { return buf_.capacity(); }
     
     /// Returns raw data pointer available for read.
     const void* data() { return rptr(); }
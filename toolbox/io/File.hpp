@@ -25,6 +25,7 @@
 
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 
 namespace toolbox {
 namespace os {
@@ -125,6 +126,22 @@ inline void ftruncate(int fd, off_t length)
     }
 }
 
+/// Synchronize a file's in-core data with storage device.
+inline void fdatasync(int fd, std::error_code& ec) noexcept
+{
+    if (::fdatasync(fd) < 0) {
+        ec = make_sys_error(errno);
+    }
+}
+
+/// Synchronize a file's in-core data with storage device.
+inline void fdatasync(int fd)
+{
+    if (::fdatasync(fd) < 0) {
+        throw std::system_error{make_sys_error(errno), "fdatasync"};
+    }
+}
+
 /// Read from a file descriptor.
 inline ssize_t read(int fd, void* buf, std::size_t len, std::error_code& ec) noexcept
 {
@@ -189,6 +206,26 @@ inline std::size_t write(int fd, ConstBuffer buf)
     return write(fd, buffer_cast<const void*>(buf), buffer_size(buf));
 }
 
+/// Write data from multiple buffers to a file descriptor.
+inline ssize_t writev(int fd, const iovec* iov, int iovcnt, std::error_code& ec) noexcept
+{
+    const auto ret = ::writev(fd, iov, iovcnt);
+    if (ret < 0) {
+        ec = make_sys_error(errno);
+    }
+    return ret;
+}
+
+/// Write data from multiple buffers to a file descriptor.
+inline std::size_t writev(int fd, const iovec* iov, int iovcnt)
+{
+    const auto ret = ::writev(fd, iov, iovcnt);
+    if (ret < 0) {
+        throw std::system_error{make_sys_error(errno), "writev"};
+    }
+    return ret;
+}
+
 /// File control.
 inline int fcntl(int fd, int cmd, std::error_code& ec) noexcept
 {
@@ -156,10 +156,10 @@ public:
 
     /// wakeup, could be called from another thread
     void wakeup() noexcept override { 
-        if(state()==State::Open) {
-            // wakeup last reactor since others are always busy-polled
-            std::get<ImplsSize-1>(impls_).wakeup(); 
-        }
+        // wakeup last reactor since others are always busy-polled. The state is not checked,
+        // because stop() closes the reactor before the loop has observed the stop flag, and a
+        // notification to a reactor that is not running is harmless.
+        std::get<ImplsSize-1>(impls_).wakeup(); 
     }
 protected:
     std::tuple<ImplsT...> impls_;
@@ -19,6 +19,7 @@
 #include "MultiReactor.hpp"
 
 #include <toolbox/sys/Log.hpp>
+#include <toolbox/sys/LogFile.hpp>
 
 
 namespace toolbox {
@@ -32,6 +33,8 @@ void wait_termination_signal() {
         switch (const auto sig = sig_wait()) {
             case SIGHUP:
                 TOOLBOX_INFO << "received SIGHUP";
+                // Reopen the log file after an external rotation.
+                reopen_log_file();
                 continue;
             case SIGINT:
                 TOOLBOX_INFO << "received SIGINT";
@@ -81,6 +81,7 @@ class TOOLBOX_API BasicRunner {
     std::thread thread_;
 };
 
+/// Wait for SIGINT or SIGTERM. SIGHUP reopens the log file used by file_logger().
 void TOOLBOX_API wait_termination_signal();
 
 } // namespace io
@@ -18,9 +18,13 @@
 #define TOOLBOX_IPC_HPP
 
 #include "ipc/Futex.hpp"
+#include "ipc/Journal.hpp"
 #include "ipc/Mmap.hpp"
 #include "ipc/MpmcQueue.hpp"
 #include "ipc/Msg.hpp"
+#include "ipc/SeqlockTable.hpp"
 #include "ipc/Shm.hpp"
+#include "ipc/ShmPool.hpp"
+#include "ipc/ShmRegistry.hpp"
 
 #endif // TOOLBOX_IPC_HPP
@@ -0,0 +1,444 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Journal.hpp"
+
+#include <toolbox/io/Runner.hpp>
+#include <toolbox/net/Frame.hpp>
+#include <toolbox/util/Utility.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <cstring>
+
+#include <dirent.h>
+
+namespace toolbox {
+inline namespace ipc {
+using namespace std;
+namespace {
+
+constexpr auto make_crc_table() noexcept
+{
+    // CRC-32C (Castagnoli) polynomial in reversed bit order.
+    constexpr uint32_t Poly{0x82f63b78};
+    array<uint32_t, 256> table{};
+    for (uint32_t i{0}; i < 256; ++i) {
+        uint32_t crc{i};
+        for (int j{0}; j < 8; ++j) {
+            crc = (crc >> 1) ^ (Poly & (0 - (crc & 1)));
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+constexpr auto CrcTable = make_crc_table();
+
+uint32_t crc32c(uint32_t crc, const char* data, size_t len) noexcept
+{
+    crc = ~crc;
+    for (size_t i{0}; i < len; ++i) {
+        crc = CrcTable[(crc ^ static_cast<unsigned char>(data[i])) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+/// The checksum covers both the length prefix and the payload, so that a torn length is detected.
+inline uint32_t checksum(uint32_t len, const char* data) noexcept
+{
+    char buf[sizeof(uint32_t)];
+    put_length(buf, len);
+    return crc32c(crc32c(0, buf, sizeof(buf)), data, len - sizeof(uint32_t));
+}
+
+/// Returns the total size of a record, including the overhead and alignment padding.
+constexpr size_t record_size(size_t size) noexcept
+{
+    return (JournalRecordOverhead + size + JournalRecordAlign - 1) & ~(JournalRecordAlign - 1);
+}
+
+// The length prefix is stored last and with release semantics, so that a concurrent reader never
+// observes a length before the checksum and payload that it covers.
+
+inline void store_length(char* ptr, uint32_t len) noexcept
+{
+    char buf[sizeof(uint32_t)];
+    put_length(buf, len);
+    uint32_t word;
+    memcpy(&word, buf, sizeof(word));
+    __atomic_store_n(reinterpret_cast<uint32_t*>(ptr), word, __ATOMIC_RELEASE);
+}
+
+inline uint32_t load_length(const char* ptr) noexcept
+{
+    const auto word = __atomic_load_n(reinterpret_cast<const uint32_t*>(ptr), __ATOMIC_ACQUIRE);
+    char buf[sizeof(word)];
+    memcpy(buf, &word, sizeof(word));
+    return get_length(buf);
+}
+
+bool is_zero(const char* data, size_t len) noexcept
+{
+    return len == 0 || (data[0] == '\0' && memcmp(data, data + 1, len - 1) == 0);
+}
+
+const JournalHeader& validate_header(const Mmap& mem_map)
+{
+    if (mem_map.get().size() < JournalDataOffset) {
+        throw runtime_error{"invalid journal segment"};
+    }
+    const auto& hdr = *static_cast<const JournalHeader*>(mem_map.get().data());
+    if (hdr.magic != JournalMagic || hdr.version != JournalVersion) {
+        throw runtime_error{"invalid journal segment"};
+    }
+    return hdr;
+}
+
+} // namespace
+
+string journal_segment_path(const string& path, uint64_t seq)
+{
+    char buf[24];
+    const auto len = snprintf(buf, sizeof(buf), ".%010" PRIu64, seq);
+    return path + string{buf, static_cast<size_t>(len)};
+}
+
+vector<uint64_t> journal_segments(const string& path)
+{
+    const auto pos = path.find_last_of('/');
+    const string dir{pos == string::npos ? "." : pos == 0 ? "/" : path.substr(0, pos)};
+    const auto base = pos == string::npos ? string_view{path} : string_view{path}.substr(pos + 1);
+
+    vector<uint64_t> segs;
+    unique_ptr<DIR, int (*)(DIR*)> dp{opendir(dir.c_str()), closedir};
+    if (!dp) {
+        if (errno == ENOENT) {
+            return segs;
+        }
+        throw system_error{make_sys_error(errno), "opendir"};
+    }
+    while (const auto* const ent = readdir(dp.get())) {
+        const string_view name{ent->d_name};
+        if (name.size() <= base.size() + 1 || name.compare(0, base.size(), base) != 0
+            || name[base.size()] != '.') {
+            continue;
+        }
+        const auto suffix = name.substr(base.size() + 1);
+        if (!all_of(suffix.begin(), suffix.end(), [](char c) { return isdigit(c); })) {
+            // Ignore temporary files.
+            continue;
+        }
+        segs.push_back(ston<uint64_t>(suffix));
+    }
+    sort(segs.begin(), segs.end());
+    return segs;
+}
+
+Journal::Journal(string path, JournalConfig config)
+: path_{move(path)}
+, config_{move(config)}
+{
+    if (config_.segment_size % PageSize != 0
+        || config_.segment_size <= JournalDataOffset + 2 * JournalRecordOverhead
+        || config_.segment_size >= JournalRollMark) {
+        throw invalid_argument{"invalid journal segment size"};
+    }
+    size_t wpos{JournalDataOffset};
+    if (const auto segs = journal_segments(path_); segs.empty()) {
+        seg_ = create_segment(0);
+    } else {
+        seg_ = open_segment(segs.back());
+        wpos = recover(seg_);
+    }
+    base_ = static_cast<char*>(seg_.mem_map.get().data());
+    wpos_.store(wpos, memory_order_relaxed);
+    sync_seq_ = seg_.seq;
+    if (load_length(base_ + wpos) == JournalRollMark) {
+        // The previous process failed after marking the end of the segment.
+        roll();
+    }
+    if (config_.sync_interval.count() > 0) {
+        sync_thread_ = thread{[this]() {
+            auto fn = [this]() { run_sync(); };
+            run_thread(fn, config_.sync_thread);
+        }};
+    }
+}
+
+Journal::~Journal()
+{
+    if (sync_thread_.joinable()) {
+        Lock lock{mutex_};
+        stop_ = true;
+        // Unlock mutex before notifying to avoid contention.
+        lock.unlock();
+        cond_.notify_one();
+        sync_thread_.join();
+    }
+}
+
+MutableBuffer Journal::prepare(size_t size)
+{
+    if (size > max_record_size()) {
+        throw runtime_error{"journal record too large"};
+    }
+    // Always leave room for the roll mark.
+    if (wpos_.load(memory_order_relaxed) + record_size(size) + JournalRecordOverhead
+        > seg_.mem_map.get().size()) {
+        roll();
+    }
+    prepared_ = size;
+    return {base_ + wpos_.load(memory_order_relaxed) + JournalRecordOverhead, size};
+}
+
+void Journal::commit(size_t size) noexcept
+{
+    assert(size <= prepared_);
+    const auto wpos = wpos_.load(memory_order_relaxed);
+    char* const rec = base_ + wpos;
+    // The length includes the checksum, so that a zero length always marks the end of the journal.
+    const auto len = static_cast<uint32_t>(size + sizeof(uint32_t));
+    put_length(rec + sizeof(uint32_t), checksum(len, rec + JournalRecordOverhead));
+    store_length(rec, len);
+    prepared_ = 0;
+    wpos_.store(wpos + record_size(size), memory_order_release);
+}
+
+void Journal::write(ConstBuffer buf)
+{
+    const auto size = buffer_size(buf);
+    memcpy(buffer_cast<char*>(prepare(size)), buffer_cast<const char*>(buf), size);
+    commit(size);
+}
+
+void Journal::flush()
+{
+    lock_guard<mutex> sync_lock{sync_mutex_};
+
+    vector<Segment> retired;
+    uint64_t seq;
+    char* base;
+    size_t wpos;
+    {
+        Lock lock{mutex_};
+        retired.swap(retired_);
+        seq = seg_.seq;
+        base = base_;
+        wpos = wpos_.load(memory_order_acquire);
+    }
+    for (auto& seg : retired) {
+        os::msync(seg.mem_map.get().data(), seg.mem_map.get().size(), MS_SYNC);
+        os::fdatasync(seg.fh.get());
+    }
+    if (seq != sync_seq_) {
+        sync_seq_ = seq;
+        sync_pos_ = 0;
+    }
+    if (wpos > sync_pos_) {
+        // The msync() address must be page aligned.
+        const auto offset = sync_pos_ & ~(PageSize - 1);
+        os::msync(base + offset, wpos - offset, MS_SYNC);
+        sync_pos_ = wpos;
+    }
+}
+
+Journal::Segment Journal::open_segment(uint64_t seq)
+{
+    Segment seg{seq, os::open(journal_segment_path(path_, seq).c_str(), O_RDWR), nullptr};
+    seg.mem_map = os::mmap(nullptr, file_size(seg.fh.get()), PROT_READ | PROT_WRITE, MAP_SHARED,
+                           seg.fh.get(), 0);
+    validate_header(seg.mem_map);
+    return seg;
+}
+
+Journal::Segment Journal::create_segment(uint64_t seq)
+{
+    const auto path = journal_segment_path(path_, seq);
+    const auto tmp = path + ".tmp";
+
+    Segment seg{seq,
+                os::open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC,
+                         S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH),
+                nullptr};
+    if (const auto err = posix_fallocate(seg.fh.get(), 0, config_.segment_size); err != 0) {
+        throw system_error{make_sys_error(err), "posix_fallocate"};
+    }
+    seg.mem_map = os::mmap(nullptr, config_.segment_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                           seg.fh.get(), 0);
+    auto& hdr = *static_cast<JournalHeader*>(seg.mem_map.get().data());
+    hdr.magic = JournalMagic;
+    hdr.version = JournalVersion;
+    hdr.seq = seq;
+    hdr.size = config_.segment_size;
+
+    // Readers never observe a partially initialised segment.
+    if (::rename(tmp.c_str(), path.c_str()) < 0) {
+        throw system_error{make_sys_error(errno), "rename"};
+    }
+    return seg;
+}
+
+size_t Journal::recover(Segment& seg)
+{
+    auto* const base = static_cast<char*>(seg.mem_map.get().data());
+    const auto size = seg.mem_map.get().size();
+
+    size_t pos{JournalDataOffset};
+    while (pos + JournalRecordOverhead <= size) {
+        const auto len = load_length(base + pos);
+        if (len == JournalRollMark) {
+            return pos;
+        }
+        if (len < sizeof(uint32_t) || len - sizeof(uint32_t) > size - pos - JournalRecordOverhead
+            || get_length(base + pos + sizeof(uint32_t))
+                != checksum(len, base + pos + JournalRecordOverhead)) {
+            break;
+        }
+        pos += record_size(len - sizeof(uint32_t));
+    }
+    if (pos >= size) {
+        return pos;
+    }
+    // A cleanly written segment ends with a zero length and the zeroed remainder of its page, so
+    // there is nothing to repair.
+    const auto page = min(ceil_page(pos), size);
+    if (is_zero(base + pos, min(max(page, pos + JournalRecordOverhead), size) - pos)) {
+        return pos;
+    }
+    // Discard everything beyond the last valid record. Pages may have been written back out of
+    // order, so valid-looking records may follow a torn one.
+    memset(base + pos, 0, page - pos);
+    if (page < size) {
+        const auto fd = seg.fh.get();
+        if (fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, page, size - page) == 0) {
+            // Reserve the storage again.
+            if (const auto err = posix_fallocate(fd, page, size - page); err != 0) {
+                throw system_error{make_sys_error(err), "posix_fallocate"};
+            }
+        } else {
+            memset(base + page, 0, size - page);
+        }
+    }
+    os::msync(base, size, MS_SYNC);
+    TOOLBOX_NOTICE << "recovered journal segment " << seg.seq << " at position " << pos;
+    return pos;
+}
+
+void Journal::roll()
+{
+    auto seg = create_segment(seg_.seq + 1);
+    // The next segment exists before the roll mark is visible to readers.
+    store_length(base_ + wpos_.load(memory_order_relaxed), JournalRollMark);
+
+    Lock lock{mutex_};
+    // The rolled segment remains mapped until it has been synchronised by the next flush(), even if
+    // there is no background sync thread.
+    retired_.push_back(move(seg_));
+    seg_ = move(seg);
+    base_ = static_cast<char*>(seg_.mem_map.get().data());
+    wpos_.store(JournalDataOffset, memory_order_release);
+}
+
+void Journal::run_sync()
+{
+    for (;;) {
+        bool stop;
+        {
+            Lock lock{mutex_};
+            stop = cond_.wait_for(lock, config_.sync_interval, [this]() { return stop_; });
+        }
+        flush();
+        if (stop) {
+            break;
+        }
+    }
+}
+
+JournalReader::JournalReader(string path)
+: path_{move(path)}
+{
+    if (const auto segs = journal_segments(path_); !segs.empty()) {
+        seq_ = segs.front();
+    }
+}
+
+JournalReader::JournalReader(string path, uint64_t seq)
+: path_{move(path)}
+, seq_{seq}
+{
+}
+
+JournalReader::~JournalReader() = default;
+
+bool JournalReader::peek(ConstBuffer& buf)
+{
+    for (;;) {
+        // The segment is opened lazily, so that a reader can be started before the writer.
+        if (!mem_map_ && !open(seq_)) {
+            return false;
+        }
+        const auto* const base = static_cast<const char*>(mem_map_.get().data());
+        const auto size = mem_map_.get().size();
+        if (rpos_ + JournalRecordOverhead > size) {
+            return false;
+        }
+        const auto len = load_length(base + rpos_);
+        if (len == JournalRollMark) {
+            if (!open(seq_ + 1)) {
+                return false;
+            }
+            continue;
+        }
+        if (len < sizeof(uint32_t)
+            || len - sizeof(uint32_t) > size - rpos_ - JournalRecordOverhead) {
+            return false;
+        }
+        const auto n = len - sizeof(uint32_t);
+        if (get_length(base + rpos_ + sizeof(uint32_t))
+            != checksum(len, base + rpos_ + JournalRecordOverhead)) {
+            // Torn record left by a failed writer.
+            return false;
+        }
+        buf = {base + rpos_ + JournalRecordOverhead, n};
+        next_ = rpos_ + record_size(n);
+        return true;
+    }
+}
+
+void JournalReader::consume() noexcept
+{
+    rpos_ = next_;
+}
+
+bool JournalReader::open(uint64_t seq)
+{
+    error_code ec;
+    const auto fh = os::open(journal_segment_path(path_, seq).c_str(), O_RDONLY, ec);
+    if (ec) {
+        return false;
+    }
+    auto mem_map = os::mmap(nullptr, file_size(fh.get()), PROT_READ, MAP_SHARED, fh.get(), 0);
+    validate_header(mem_map);
+    mem_map_ = move(mem_map);
+    seq_ = seq;
+    rpos_ = next_ = JournalDataOffset;
+    return true;
+}
+
+} // namespace ipc
+} // namespace toolbox
@@ -0,0 +1,233 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOOLBOX_IPC_JOURNAL_HPP
+#define TOOLBOX_IPC_JOURNAL_HPP
+
+#include <toolbox/io/File.hpp>
+#include <toolbox/ipc/Mmap.hpp>
+#include <toolbox/sys/Limits.hpp>
+#include <toolbox/sys/Thread.hpp>
+#include <toolbox/sys/Time.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace toolbox {
+inline namespace ipc {
+
+/// Segment header at the start of each journal file.
+struct JournalHeader {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint64_t seq;
+    std::uint64_t size;
+};
+static_assert(sizeof(JournalHeader) <= CacheLineSize);
+
+enum : std::uint32_t {
+    /// Segment magic: "TBJ1" in little-endian.
+    JournalMagic = 0x314a4254,
+    JournalVersion = 1,
+    /// Length value marking the end of a segment; the journal continues in the next segment.
+    JournalRollMark = 0xffffffff
+};
+
+enum : std::size_t {
+    /// Records start on the first cache-line following the segment header.
+    JournalDataOffset = CacheLineSize,
+    /// Each record is prefixed with a 4 byte length and a 4 byte checksum.
+    JournalRecordOverhead = 2 * sizeof(std::uint32_t),
+    JournalRecordAlign = 8
+};
+
+/// Returns the path of the journal segment with sequence \p seq.
+TOOLBOX_API std::string journal_segment_path(const std::string& path, std::uint64_t seq);
+
+/// Returns the sequence numbers of all journal segments, in ascending order.
+TOOLBOX_API std::vector<std::uint64_t> journal_segments(const std::string& path);
+
+/// JournalConfig holds the journal attributes.
+struct JournalConfig {
+    /// The size of each segment file, including the segment header.
+    std::size_t segment_size{64 << 20};
+    /// The background sync interval. Zero disables the background sync thread, in which case
+    /// records, including those in segments that have since rolled, are synchronised by flush().
+    Duration sync_interval{Millis{10}};
+    /// The background sync thread's attributes.
+    ThreadConfig sync_thread{"journal"};
+};
+
+/// Journal is a persistent, segmented, append-only log of length-prefixed records.
+///
+/// Each segment is a memory-mapped file that is pre-allocated to the configured segment size.
+/// Records are written in place and published by storing the length prefix last, so that readers
+/// can tail the journal concurrently by mapping the same files. Dirty pages are flushed to storage
+/// asynchronously by a background thread, or synchronously by flush().
+///
+/// On open, the last segment is scanned up to the last record with a valid checksum. Any partial
+/// or corrupt records beyond that point are discarded.
+class TOOLBOX_API Journal {
+    using Lock = std::unique_lock<std::mutex>;
+
+    struct Segment {
+        std::uint64_t seq{};
+        FileHandle fh;
+        Mmap mem_map;
+    };
+
+  public:
+    /// Opens or creates the journal.
+    ///
+    /// \param path Path prefix of the segment files.
+    /// \param config The journal configuration.
+    explicit Journal(std::string path, JournalConfig config = {});
+    ~Journal();
+
+    // Copy.
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // Move.
+    Journal(Journal&&) = delete;
+    Journal& operator=(Journal&&) = delete;
+
+    /// Returns the sequence number of the current segment.
+    std::uint64_t seq() const noexcept { return seg_.seq; }
+    /// Returns the write position within the current segment.
+    std::size_t position() const noexcept { return wpos_.load(std::memory_order_relaxed); }
+    /// Returns the maximum record size.
+    std::size_t max_record_size() const noexcept
+    {
+        return config_.segment_size - JournalDataOffset - 2 * JournalRecordOverhead;
+    }
+
+    /// Returns write buffer of exactly size bytes, rolling to a new segment if necessary.
+    MutableBuffer prepare(std::size_t size);
+
+    /// Publish the record previously returned by prepare().
+    ///
+    /// \param size The record size, which must not exceed the size passed to prepare().
+    void commit(std::size_t size) noexcept;
+
+    /// Encode a record of at most size bytes in place. The function object returns the number of
+    /// bytes encoded.
+    template <typename FnT>
+    void write(std::size_t size, FnT fn)
+    {
+        const auto buf = prepare(size);
+        commit(fn(buffer_cast<char*>(buf), size));
+    }
+
+    /// Append a record.
+    void write(ConstBuffer buf);
+
+    /// Append a record.
+    void write(std::string_view sv) { write(ConstBuffer{sv.data(), sv.size()}); }
+
+    /// Synchronously flush all committed records to storage.
+    void flush();
+
+  private:
+    Segment open_segment(std::uint64_t seq);
+    Segment create_segment(std::uint64_t seq);
+    std::size_t recover(Segment& seg);
+    void roll();
+    void run_sync();
+
+    const std::string path_;
+    const JournalConfig config_;
+    Segment seg_;
+    char* base_{nullptr};
+    std::size_t prepared_{0};
+    std::atomic<std::size_t> wpos_{0};
+
+    mutable std::mutex mutex_;
+    std::condition_variable cond_;
+    /// Segments that have been rolled, but not yet synchronised.
+    std::vector<Segment> retired_;
+    bool stop_{false};
+
+    std::mutex sync_mutex_;
+    std::uint64_t sync_seq_{0};
+    std::size_t sync_pos_{0};
+    std::thread sync_thread_;
+};
+
+/// JournalReader reads records from a journal. The journal may be tailed while it is being written
+/// by another thread or process.
+class TOOLBOX_API JournalReader {
+  public:
+    /// Opens the journal for reading from the first available segment.
+    ///
+    /// \param path Path prefix of the segment files.
+    explicit JournalReader(std::string path);
+
+    /// Opens the journal for reading from segment \p seq.
+    ///
+    /// \param path Path prefix of the segment files.
+    /// \param seq The first segment.
+    JournalReader(std::string path, std::uint64_t seq);
+    ~JournalReader();
+
+    // Copy.
+    JournalReader(const JournalReader&) = delete;
+    JournalReader& operator=(const JournalReader&) = delete;
+
+    // Move.
+    JournalReader(JournalReader&&) noexcept = default;
+    JournalReader& operator=(JournalReader&&) noexcept = default;
+
+    /// Returns the sequence number of the current segment.
+    std::uint64_t seq() const noexcept { return seq_; }
+    /// Returns the read position within the current segment.
+    std::size_t position() const noexcept { return rpos_; }
+
+    /// Returns false if no complete record is available.
+    bool peek(ConstBuffer& buf);
+
+    /// Advance past the record returned by peek().
+    void consume() noexcept;
+
+    /// Returns false if no complete record is available.
+    template <typename FnT>
+    bool read(FnT fn)
+    {
+        ConstBuffer buf;
+        if (!peek(buf)) {
+            return false;
+        }
+        fn(buf);
+        consume();
+        return true;
+    }
+
+  private:
+    bool open(std::uint64_t seq);
+
+    std::string path_;
+    std::uint64_t seq_{0};
+    Mmap mem_map_;
+    std::size_t rpos_{0}, next_{0};
+};
+
+} // namespace ipc
+} // namespace toolbox
+
+#endif // TOOLBOX_IPC_JOURNAL_HPP
@@ -0,0 +1,207 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Journal.hpp"
+
+#include <toolbox/sys/Log.hpp>
+#include <toolbox/util/Finally.hpp>
+#include <toolbox/util/TempDir.ut.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace toolbox;
+
+namespace {
+
+using test::TempDir;
+
+int recovered{};
+
+void test_logger(int level, string_view msg)
+{
+    if (msg.find("recovered journal segment") != string_view::npos) {
+        ++recovered;
+    }
+}
+
+vector<string> read_all(JournalReader& r)
+{
+    vector<string> v;
+    while (r.read([&v](ConstBuffer buf) {
+        v.emplace_back(buffer_cast<const char*>(buf), buffer_size(buf));
+    })) {
+    }
+    return v;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(JournalSuite)
+
+BOOST_AUTO_TEST_CASE(JournalSegmentPathCase)
+{
+    BOOST_TEST(journal_segment_path("/tmp/foo", 0) == "/tmp/foo.0000000000");
+    BOOST_TEST(journal_segment_path("foo", 123) == "foo.0000000123");
+}
+
+BOOST_AUTO_TEST_CASE(JournalWriteReadCase)
+{
+    TempDir tmp;
+    JournalReader r{tmp.path("test")};
+    // Nothing to read before the journal is created.
+    BOOST_TEST(!r.read([](ConstBuffer) {}));
+
+    Journal j{tmp.path("test"), {PageSize * 4, Millis{1}}};
+    j.write("foo"sv);
+    j.write(""sv);
+    j.write(7, [](char* buf, size_t size) {
+        memcpy(buf, "bar", 3);
+        return 3;
+    });
+
+    const auto v = read_all(r);
+    BOOST_TEST(v.size() == 3U);
+    BOOST_TEST(v[0] == "foo");
+    BOOST_TEST(v[1] == "");
+    BOOST_TEST(v[2] == "bar");
+
+    // Tail.
+    j.write("baz"sv);
+    const auto w = read_all(r);
+    BOOST_TEST(w.size() == 1U);
+    BOOST_TEST(w[0] == "baz");
+}
+
+BOOST_AUTO_TEST_CASE(JournalRollCase)
+{
+    TempDir tmp;
+    constexpr int N = 1000;
+    {
+        Journal j{tmp.path("test"), {PageSize, Millis{1}}};
+        for (int i{0}; i < N; ++i) {
+            j.write(to_string(i));
+        }
+        BOOST_TEST(j.seq() > 0U);
+        BOOST_CHECK_THROW(j.write(string(PageSize, 'x')), runtime_error);
+    }
+    BOOST_TEST(journal_segments(tmp.path("test")).size() > 1U);
+
+    JournalReader r{tmp.path("test")};
+    const auto v = read_all(r);
+    BOOST_TEST(v.size() == size_t{N});
+    for (int i{0}; i < N; ++i) {
+        BOOST_TEST(v[i] == to_string(i));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(JournalFlushCase)
+{
+    TempDir tmp;
+    constexpr int N = 1000;
+    {
+        // Without a background sync thread, flush() synchronises the rolled segments.
+        Journal j{tmp.path("test"), {PageSize, Duration{}}};
+        for (int i{0}; i < N; ++i) {
+            j.write(to_string(i));
+        }
+        BOOST_TEST(j.seq() > 0U);
+        j.flush();
+        j.write("foo"sv);
+        j.flush();
+    }
+    JournalReader r{tmp.path("test")};
+    const auto v = read_all(r);
+    BOOST_TEST(v.size() == size_t{N + 1});
+    BOOST_TEST(v.back() == "foo");
+}
+
+BOOST_AUTO_TEST_CASE(JournalReopenCase)
+{
+    TempDir tmp;
+    size_t pos;
+    {
+        Journal j{tmp.path("test"), {PageSize * 4, Duration{}}};
+        j.write("foo"sv);
+        j.write("bar"sv);
+        pos = j.position();
+    }
+    const auto prev_level = set_log_level(Log::Info);
+    const auto prev_logger = set_logger(test_logger);
+    // clang-format off
+    const auto finally = make_finally([prev_level, prev_logger]() noexcept {
+        set_log_level(prev_level);
+        set_logger(prev_logger);
+    });
+    // clang-format on
+
+    // A cleanly written segment is not repaired.
+    recovered = 0;
+    {
+        Journal j{tmp.path("test"), {PageSize * 4, Duration{}}};
+        BOOST_TEST(j.position() == pos);
+    }
+    BOOST_TEST(recovered == 0);
+
+    {
+        // Garbage beyond the end of the last record.
+        auto fh = os::open(journal_segment_path(tmp.path("test"), 0).c_str(), O_RDWR);
+        BOOST_TEST(::pwrite(fh.get(), "X", 1, pos + JournalRecordOverhead) == 1);
+    }
+    Journal j{tmp.path("test"), {PageSize * 4, Duration{}}};
+    BOOST_TEST(j.position() == pos);
+    BOOST_TEST(recovered == 1);
+}
+
+BOOST_AUTO_TEST_CASE(JournalRecoverCase)
+{
+    TempDir tmp;
+    size_t pos;
+    {
+        Journal j{tmp.path("test"), {PageSize * 4, Duration{}}};
+        j.write("foo"sv);
+        pos = j.position();
+        j.write("bar"sv);
+        j.write("baz"sv);
+        j.flush();
+    }
+    {
+        // Corrupt the payload of the second record.
+        auto fh = os::open(journal_segment_path(tmp.path("test"), 0).c_str(), O_RDWR);
+        BOOST_TEST(::pwrite(fh.get(), "X", 1, pos + JournalRecordOverhead) == 1);
+    }
+    {
+        JournalReader r{tmp.path("test")};
+        const auto v = read_all(r);
+        BOOST_TEST(v.size() == 1U);
+        BOOST_TEST(v[0] == "foo");
+    }
+
+    Journal j{tmp.path("test"), {PageSize * 4, Duration{}}};
+    BOOST_TEST(j.position() == pos);
+    j.write("qux"sv);
+
+    JournalReader r{tmp.path("test")};
+    const auto v = read_all(r);
+    BOOST_TEST(v.size() == 2U);
+    BOOST_TEST(v[0] == "foo");
+    BOOST_TEST(v[1] == "qux");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
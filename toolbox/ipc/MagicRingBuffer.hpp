@@ -26,6 +26,7 @@
 #include <atomic>
 #include <cassert>
 #include <memory>
+#include <stdexcept>
 #include <unistd.h>
 
 #include <iostream>
@@ -76,7 +77,7 @@ class MagicRingBuffer {
     /// so the file can be safely closed once the mapping has been established.
     ///
     /// \param path Path to MpmcQueue file.
-    ///
+    /// \throw std::runtime_error if the file is too small or its capacity is not a power of two.
     explicit MagicRingBuffer(const char* path)
     : MagicRingBuffer{os::open(path, O_RDWR)}
     {
@@ -143,18 +144,50 @@ class MagicRingBuffer {
         std::swap(impl_, rhs.impl_);
         std::swap(allocator_, rhs.allocator_);
     }
+    /// Returns the readable region as a contiguous buffer.
+    ///
+    /// The region remains valid until consumed, because the double mapping makes the wrapped part
+    /// of the ring addressable beyond its end.
+    ConstBuffer peek() const noexcept
+    {
+        const auto rpos = impl_->rpos.load(std::memory_order_relaxed);
+        const auto wpos = impl_->wpos.load(std::memory_order_acquire);
+        return {impl_->buf + (rpos & mask_), static_cast<std::size_t>(wpos - rpos)};
+    }
+    /// Remove size bytes from the readable region returned by peek().
+    void consume(std::size_t size) noexcept
+    {
+        const auto rpos = impl_->rpos.load(std::memory_order_relaxed);
+        impl_->rpos.store(rpos + size, std::memory_order_release);
+    }
+    /// Returns the writable region as a contiguous buffer, or an empty buffer if fewer than size
+    /// bytes are available.
+    MutableBuffer reserve(std::size_t size) noexcept
+    {
+        const auto wpos = impl_->wpos.load(std::memory_order_relaxed);
+        const auto rpos = impl_->rpos.load(std::memory_order_acquire);
+        const std::size_t avail = capacity_ - (wpos - rpos);
+        if (avail < size) {
+            return {};
+        }
+        return {impl_->buf + (wpos & mask_), avail};
+    }
+    /// Publish size bytes written to the region returned by reserve().
+    void commit(std::size_t size) noexcept
+    {
+        const auto wpos = impl_->wpos.load(std::memory_order_relaxed);
+        impl_->wpos.store(wpos + size, std::memory_order_release);
+    }
     /// Read at least size bytes or return false
     template <typename FnT>
     bool read(std::size_t size, FnT fn) noexcept
     {
         static_assert(std::is_nothrow_invocable_v<FnT, const char*, std::size_t>);
-        auto rpos = impl_->rpos.load(std::memory_order_acquire);
-        auto wpos = impl_->wpos.load(std::memory_order_relaxed);
-        std::size_t ready = (std::size_t)(wpos-rpos);
+        const auto buf = peek();
+        const std::size_t ready = buffer_size(buf);
         if(ready==0 || ready<size)
             return false;
-        std::size_t consumed = fn(impl_->buf+(rpos&mask_), ready);  
-        impl_->rpos.store(rpos + consumed, std::memory_order_release);
+        consume(fn(buffer_cast<const char*>(buf), ready));
         return true;
     }
     /// Read available data up to size, return number of bytes read
@@ -176,12 +209,11 @@ class MagicRingBuffer {
     template <typename FnT>
     bool write(std::size_t size, FnT fn) noexcept
     {
-        auto wpos = impl_->wpos.load(std::memory_order_acquire);
-        auto rpos = impl_->rpos.load(std::memory_order_relaxed);
-        if(capacity_-(wpos-rpos)<size)
+        const auto buf = reserve(size);
+        if(buffer_size(buf)<size)
             return false;
-        fn(impl_->buf+(wpos&mask_), size);
-        impl_->wpos.store(wpos+size, std::memory_order_release);
+        fn(buffer_cast<char*>(buf), size);
+        commit(size);
         return true;
     }
     
@@ -205,8 +237,11 @@ class MagicRingBuffer {
     }
 
   private:
-    static constexpr std::size_t capacity(std::size_t size) noexcept
+    static constexpr std::size_t capacity(std::size_t size)
     {
+        if (size < sizeof(Impl)) {
+            throw std::runtime_error{"file too small for ring buffer"};
+        }
         return (size - sizeof(Impl));
     }
     static constexpr std::size_t size(std::size_t capacity) noexcept
@@ -1,11 +1,17 @@
 #include "MagicRingBuffer.hpp"
 
+#include <toolbox/util/TempDir.ut.hpp>
+
+
 #include <boost/test/tools/old/interface.hpp>
 #include <boost/test/unit_test.hpp>
 #include <cstdio>
 #include <sstream>
+#include <stdexcept>
 #include <thread>
 
+#include <unistd.h>
+
 #include <iostream>
 
 using namespace std;
@@ -113,4 +119,66 @@ BOOST_AUTO_TEST_CASE(MRBString)
     runner.join();
     std::cout << "nfull="<<nfull<<" nempty="<<nempty<<std::endl;        
 }
+
+BOOST_AUTO_TEST_CASE(MRBReserveCommit)
+{
+    MagicRingBuffer mrb(PageSize);
+    BOOST_TEST(buffer_size(mrb.peek()) == 0U);
+    BOOST_TEST(buffer_size(mrb.reserve(PageSize + 1)) == 0U);
+
+    // Advance close to the end of the ring, so that the next region wraps.
+    auto wbuf = mrb.reserve(PageSize - 2);
+    BOOST_TEST(buffer_size(wbuf) == PageSize);
+    mrb.commit(PageSize - 2);
+    mrb.consume(buffer_size(mrb.peek()));
+
+    wbuf = mrb.reserve(6);
+    BOOST_TEST(buffer_size(wbuf) == PageSize);
+    std::memcpy(buffer_cast<char*>(wbuf), "foobar", 6);
+    mrb.commit(6);
+
+    auto rbuf = mrb.peek();
+    BOOST_TEST(std::string_view(buffer_cast<const char*>(rbuf), buffer_size(rbuf)) == "foobar");
+    mrb.consume(3);
+    rbuf = mrb.peek();
+    BOOST_TEST(std::string_view(buffer_cast<const char*>(rbuf), buffer_size(rbuf)) == "bar");
+    mrb.consume(3);
+    BOOST_TEST(mrb.empty());
+}
+
+BOOST_AUTO_TEST_CASE(MRBReadWriteFd)
+{
+    MagicRingBuffer mrb(PageSize);
+    auto [in_r, in_w] = os::pipe2(0);
+    auto [out_r, out_w] = os::pipe2(0);
+
+    os::write(in_w.get(), ConstBuffer{"hello", 5});
+    mrb.commit(os::read(in_r.get(), mrb.reserve(1)));
+    mrb.consume(os::write(out_w.get(), mrb.peek()));
+    BOOST_TEST(mrb.empty());
+
+    char buf[5];
+    BOOST_TEST(os::read(out_r.get(), buf, sizeof(buf)) == 5U);
+    BOOST_TEST(std::string_view(buf, sizeof(buf)) == "hello");
+}
+
+BOOST_AUTO_TEST_CASE(MRBBadFileSize)
+{
+    test::TempFile tmp;
+    const auto* const path = tmp.path().c_str();
+
+    // Smaller than the header.
+    BOOST_REQUIRE(::truncate(path, 100) == 0);
+    BOOST_CHECK_EXCEPTION(MagicRingBuffer{path}, runtime_error, [](const auto& e) {
+        return string_view{e.what()} == "file too small for ring buffer";
+    });
+
+    // Header only.
+    BOOST_REQUIRE(::truncate(path, sizeof(MagicRingBuffer::Impl)) == 0);
+    BOOST_CHECK_THROW(MagicRingBuffer{path}, runtime_error);
+
+    // Capacity not a power of two.
+    BOOST_REQUIRE(::truncate(path, sizeof(MagicRingBuffer::Impl) + 3 * PageSize) == 0);
+    BOOST_CHECK_THROW(MagicRingBuffer{path}, runtime_error);
+}
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -76,7 +76,7 @@ struct MmapDeleter {
 
 using Mmap = std::unique_ptr<MmapPointer, MmapDeleter>;
 
-static constexpr std::size_t round_up_page_size(std::size_t n) { return (n+(toolbox::sys::PageSize>>1)) & ~(PageSize-1); };
+static constexpr std::size_t round_up_page_size(std::size_t n) { return (n+(toolbox::sys::PageSize-1)) & ~(PageSize-1); };
 
 enum MmapFlags : int {
     Magic    = 1,
@@ -124,11 +124,11 @@ public:
         }
 
         if(!(flags_ & unbox(MmapFlags::Magic))) {
-            int flg = MAP_ANON;
-            if(!(flags_ & unbox(MmapFlags::Shared)))
-                flg |= MAP_PRIVATE;
+            // Map the file when there is one, so that the memory is shared with other processes.
+            int flg = fd.empty() ? MAP_ANON : 0;
+            flg |= (flags_ & unbox(MmapFlags::Shared)) ? MAP_SHARED : MAP_PRIVATE;
             void* ptr = ::mmap(nullptr, len, prot, flg, fd.get(), 0);
-            if(ptr==nullptr)
+            if(ptr==MAP_FAILED)
                 throw std::system_error{make_sys_error(errno), "mmap"};
             return reinterpret_cast<value_type*>(ptr);
         } else {
@@ -190,6 +190,22 @@ inline Mmap mmap(void* addr, size_t len, int prot, int flags, int fd, off_t off)
     return Mmap{p};
 }
 
+/// Synchronize a file with a memory map.
+inline void msync(void* addr, size_t len, int flags, std::error_code& ec) noexcept
+{
+    if (::msync(addr, len, flags) < 0) {
+        ec = make_sys_error(errno);
+    }
+}
+
+/// Synchronize a file with a memory map.
+inline void msync(void* addr, size_t len, int flags)
+{
+    if (::msync(addr, len, flags) < 0) {
+        throw std::system_error{make_sys_error(errno), "msync"};
+    }
+}
+
 } // namespace os
 } // namespace toolbox
 
@@ -0,0 +1,260 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOOLBOX_IPC_SEQLOCKTABLE_HPP
+#define TOOLBOX_IPC_SEQLOCKTABLE_HPP
+
+#include <toolbox/io/File.hpp>
+#include <toolbox/ipc/Mmap.hpp>
+#include <toolbox/sys/Limits.hpp>
+#include <toolbox/util/Math.hpp>
+
+#include <cassert>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+
+namespace toolbox {
+inline namespace ipc {
+
+/// SeqlockTable is a fixed-capacity, open-addressed hash table of last values that may be shared
+/// between processes.
+///
+/// A single writer updates values, and any number of readers take consistent snapshots without
+/// locking. Each entry is guarded by a sequence number that is odd while the entry is being
+/// written; a reader retries if the sequence number changed while it was copying the value.
+/// Entries cannot be erased, so an entry's key never changes once it has been published.
+///
+/// The hash function must produce the same result in all processes sharing the table.
+template <typename KeyT, typename ValueT, typename HashT = std::hash<KeyT>>
+class SeqlockTable {
+    static_assert(std::is_trivially_copyable_v<KeyT>);
+    static_assert(std::is_trivially_copyable_v<ValueT>);
+
+  public:
+    struct alignas(CacheLineSize) Entry {
+        // Zero if the entry is unused, and odd while the entry is being written.
+        std::uint64_t seq;
+        KeyT key;
+        ValueT val;
+    };
+    static_assert(std::is_trivially_copyable_v<Entry>);
+    struct alignas(CacheLineSize) Impl {
+        std::uint64_t capacity;
+        // Number of used entries, which is only updated by the writer.
+        std::uint64_t size;
+        alignas(CacheLineSize) Entry entries[];
+    };
+    static_assert(std::is_trivially_copyable_v<Impl>);
+    static_assert(sizeof(Impl) == CacheLineSize);
+    static_assert(offsetof(Impl, entries) == CacheLineSize);
+
+    explicit SeqlockTable(std::size_t capacity)
+    : capacity_{next_pow2(capacity)}
+    , mask_{capacity_ - 1}
+    , allocator_{}
+    , impl_{reinterpret_cast<Impl*>(allocator_.allocate(size(capacity_)))}
+    {
+        init(impl_, capacity_);
+    }
+    /// Maps a file-backed SeqlockTable.
+    ///
+    /// \param fh File handle.
+    /// \param flags Mmap flags. Readers may add MmapFlags::Readonly.
+    /// \throw std::runtime_error if the file is too small or does not hold a valid table.
+    explicit SeqlockTable(FileHandle& fh, int flags = MmapFlags::Shared)
+    : capacity_{capacity(io::file_size(fh.get()))}
+    , mask_{capacity_ - 1}
+    , allocator_{flags}
+    , impl_{reinterpret_cast<Impl*>(allocator_.allocate(fh, size(capacity_)))}
+    {
+        if (!is_pow2(capacity_) || impl_->capacity != capacity_) {
+            allocator_.deallocate(reinterpret_cast<char*>(impl_), size(capacity_));
+            throw std::runtime_error{"invalid seqlock table"};
+        }
+    }
+    explicit SeqlockTable(FileHandle&& fh, int flags = MmapFlags::Shared)
+    : SeqlockTable{fh, flags}
+    {
+    }
+    /// Opens a file-backed SeqlockTable.
+    ///
+    /// \param path Path to SeqlockTable file.
+    /// \param flags Mmap flags. Readers may add MmapFlags::Readonly.
+    explicit SeqlockTable(const char* path, int flags = MmapFlags::Shared)
+    : SeqlockTable{os::open(path, (flags & MmapFlags::Readonly) ? O_RDONLY : O_RDWR), flags}
+    {
+    }
+    ~SeqlockTable()
+    {
+        if (impl_) {
+            allocator_.deallocate(reinterpret_cast<char*>(impl_), size(capacity_));
+        }
+    }
+
+    // Copy.
+    SeqlockTable(const SeqlockTable&) = delete;
+    SeqlockTable& operator=(const SeqlockTable&) = delete;
+
+    // Move.
+    SeqlockTable(SeqlockTable&& rhs) noexcept
+    : capacity_{rhs.capacity_}
+    , mask_{rhs.mask_}
+    , allocator_{std::move(rhs.allocator_)}
+    , impl_{rhs.impl_}
+    {
+        rhs.capacity_ = 0;
+        rhs.mask_ = 0;
+        rhs.impl_ = nullptr;
+    }
+    SeqlockTable& operator=(SeqlockTable&& rhs) = delete;
+
+    /// Returns the maximum number of entries the table can hold.
+    std::size_t capacity() const noexcept { return capacity_; }
+    /// Returns the number of entries in the table.
+    std::size_t size() const noexcept { return __atomic_load_n(&impl_->size, __ATOMIC_RELAXED); }
+
+    /// Copy the value associated with the key.
+    ///
+    /// \return false if there is no such key.
+    bool read(const KeyT& key, ValueT& val) const noexcept
+    {
+        const auto h = HashT{}(key);
+        for (std::size_t i{0}; i <= mask_; ++i) {
+            const auto& entry = impl_->entries[(h + i) & mask_];
+            auto seq = __atomic_load_n(&entry.seq, __ATOMIC_ACQUIRE);
+            // The key is only written when the entry is first used.
+            while (seq == 1) {
+                cpu_relax();
+                seq = __atomic_load_n(&entry.seq, __ATOMIC_ACQUIRE);
+            }
+            if (seq == 0) {
+                return false;
+            }
+            if (!(entry.key == key)) {
+                continue;
+            }
+            for (;;) {
+                if (!(seq & 1)) {
+                    std::memcpy(&val, &entry.val, sizeof(ValueT));
+                    // Prevent the copy from being reordered after the subsequent load.
+                    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+                    if (__atomic_load_n(&entry.seq, __ATOMIC_RELAXED) == seq) {
+                        return true;
+                    }
+                }
+                cpu_relax();
+                seq = __atomic_load_n(&entry.seq, __ATOMIC_ACQUIRE);
+            }
+        }
+        return false;
+    }
+
+    /// Update the value associated with the key, inserting the key if it does not exist. New
+    /// values are zero-initialised before the function object is called.
+    ///
+    /// Only a single thread may write to the table.
+    ///
+    /// \return false if the table is full.
+    template <typename FnT>
+    bool write(const KeyT& key, FnT fn) noexcept
+    {
+        static_assert(std::is_nothrow_invocable_v<FnT, ValueT&>);
+        const auto h = HashT{}(key);
+        for (std::size_t i{0}; i <= mask_; ++i) {
+            auto& entry = impl_->entries[(h + i) & mask_];
+            // Relaxed is sufficient, because this is the only writer.
+            const auto seq = __atomic_load_n(&entry.seq, __ATOMIC_RELAXED);
+            if (seq != 0 && !(entry.key == key)) {
+                continue;
+            }
+            __atomic_store_n(&entry.seq, seq + 1, __ATOMIC_RELAXED);
+            // Prevent the subsequent stores from being reordered before the odd sequence number.
+            __atomic_thread_fence(__ATOMIC_RELEASE);
+            if (seq == 0) {
+                std::memcpy(&entry.key, &key, sizeof(KeyT));
+                __atomic_store_n(&impl_->size, impl_->size + 1, __ATOMIC_RELAXED);
+            }
+            fn(entry.val);
+            __atomic_store_n(&entry.seq, seq + 2, __ATOMIC_RELEASE);
+            return true;
+        }
+        return false;
+    }
+    /// Set the value associated with the key, inserting the key if it does not exist.
+    ///
+    /// \return false if the table is full.
+    bool write(const KeyT& key, const ValueT& val) noexcept
+    {
+        return write(key, [&val](ValueT& ref) noexcept { std::memcpy(&ref, &val, sizeof(ValueT)); });
+    }
+
+    /// Initialise table.
+    static void init(Impl* impl, std::size_t capacity) noexcept
+    {
+        std::memset(impl, 0, size(capacity));
+        impl->capacity = capacity;
+    }
+    static constexpr std::size_t capacity(std::size_t size)
+    {
+        if (size < sizeof(Impl)) {
+            throw std::runtime_error{"file too small for seqlock table"};
+        }
+        return (size - sizeof(Impl)) / sizeof(Entry);
+    }
+    static constexpr std::size_t size(std::size_t capacity) noexcept
+    {
+        return sizeof(Impl) + capacity * sizeof(Entry);
+    }
+
+  private:
+    static void cpu_relax() noexcept
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+
+    std::size_t capacity_{}, mask_{};
+    MmapAllocator<char> allocator_;
+    Impl* impl_{nullptr};
+};
+
+/// Initialise file-based SeqlockTable.
+template <typename KeyT, typename ValueT, typename HashT = std::hash<KeyT>>
+void new_seqlock_table(FileHandle& fh, std::size_t capacity)
+{
+    using Table = SeqlockTable<KeyT, ValueT, HashT>;
+
+    capacity = next_pow2(capacity);
+    const auto size = Table::size(capacity);
+
+    os::ftruncate(fh.get(), size);
+    Mmap mem_map{os::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fh.get(), 0)};
+    Table::init(static_cast<typename Table::Impl*>(mem_map.get().data()), capacity);
+}
+
+/// Initialise file-based SeqlockTable.
+template <typename KeyT, typename ValueT, typename HashT = std::hash<KeyT>>
+void new_seqlock_table(FileHandle&& fh, std::size_t capacity)
+{
+    return new_seqlock_table<KeyT, ValueT, HashT>(fh, capacity);
+}
+
+} // namespace ipc
+} // namespace toolbox
+
+#endif // TOOLBOX_IPC_SEQLOCKTABLE_HPP
@@ -0,0 +1,122 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "SeqlockTable.hpp"
+
+#include <toolbox/util/TempDir.ut.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <thread>
+
+using namespace std;
+using namespace toolbox;
+
+namespace {
+
+struct Quote {
+    int64_t bid, offer;
+    int64_t bid_qty, offer_qty;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(SeqlockTableSuite)
+
+BOOST_AUTO_TEST_CASE(SeqlockTableReadWriteCase)
+{
+    SeqlockTable<int, Quote> t{3};
+    BOOST_TEST(t.capacity() == 4U);
+    BOOST_TEST(t.size() == 0U);
+
+    Quote q{};
+    BOOST_TEST(!t.read(1, q));
+    for (int i{0}; i < 4; ++i) {
+        BOOST_TEST(t.write(i, {i, i + 1, 10, 20}));
+    }
+    BOOST_TEST(t.size() == 4U);
+    BOOST_TEST(!t.write(4, {}));
+
+    BOOST_TEST(t.read(2, q));
+    BOOST_TEST(q.bid == 2);
+    BOOST_TEST(q.offer == 3);
+
+    BOOST_TEST(t.write(2, [](Quote& ref) noexcept { ref.bid_qty = 5; }));
+    BOOST_TEST(t.size() == 4U);
+    BOOST_TEST(t.read(2, q));
+    BOOST_TEST(q.bid == 2);
+    BOOST_TEST(q.bid_qty == 5);
+    BOOST_TEST(!t.read(4, q));
+}
+
+BOOST_AUTO_TEST_CASE(SeqlockTableSharedCase)
+{
+    test::TempDir tmp;
+    const auto path = tmp.path("table");
+
+    new_seqlock_table<int, Quote>(os::open(path.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR), 16);
+    SeqlockTable<int, Quote> writer{path.c_str()};
+    SeqlockTable<int, Quote> reader{path.c_str(), MmapFlags::Shared | MmapFlags::Readonly};
+    BOOST_TEST(reader.capacity() == 16U);
+
+    constexpr int64_t N = 100000;
+    atomic<bool> done{false};
+    thread t{[&]() {
+        for (int64_t i{1}; i <= N; ++i) {
+            // All fields must be consistent with each other.
+            writer.write(1, {i, i + 1, i * 2, i * 3});
+        }
+        done = true;
+    }};
+    int errors{0};
+    Quote q{};
+    while (!done) {
+        if (reader.read(1, q)) {
+            if (q.offer != q.bid + 1 || q.bid_qty != q.bid * 2 || q.offer_qty != q.bid * 3) {
+                ++errors;
+            }
+        }
+    }
+    t.join();
+    BOOST_TEST(errors == 0);
+    BOOST_TEST(reader.read(1, q));
+    BOOST_TEST(q.bid == N);
+}
+
+BOOST_AUTO_TEST_CASE(SeqlockTableBadFileCase)
+{
+    using Table = SeqlockTable<int, Quote>;
+
+    test::TempDir tmp;
+    const auto path = tmp.path("table");
+    auto fh = os::open(path.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+
+    // Smaller than the header.
+    os::ftruncate(fh.get(), 16);
+    BOOST_CHECK_EXCEPTION(Table{path.c_str()}, runtime_error, [](const auto& e) {
+        return string_view{e.what()} == "file too small for seqlock table";
+    });
+
+    // Large enough, but never initialised.
+    os::ftruncate(fh.get(), Table::size(16));
+    BOOST_CHECK_THROW(Table{path.c_str()}, runtime_error);
+
+    new_seqlock_table<int, Quote>(fh, 16);
+    BOOST_TEST(Table{path.c_str()}.capacity() == 16U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,256 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOOLBOX_IPC_SHMPOOL_HPP
+#define TOOLBOX_IPC_SHMPOOL_HPP
+
+#include <toolbox/io/File.hpp>
+#include <toolbox/ipc/Mmap.hpp>
+#include <toolbox/sys/Limits.hpp>
+
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace toolbox {
+inline namespace ipc {
+
+/// Null index returned when the pool is exhausted.
+constexpr std::uint32_t ShmPoolNil{std::numeric_limits<std::uint32_t>::max()};
+
+enum : std::uint32_t {
+    /// Pool magic: "TBP1" in little-endian.
+    ShmPoolMagic = 0x31504254,
+    ShmPoolVersion = 1
+};
+
+/// ShmPool is a fixed-capacity pool of objects in a memory-mapped segment that may be shared
+/// between processes.
+///
+/// Objects are referred to by index rather than by address, because each process may map the
+/// segment at a different address. This allows one process to allocate a large object, pass its
+/// index to another process through an MpmcQueue, and the other process to free it.
+///
+/// The free-list is a lock-free stack. The head is tagged with a counter that is incremented on
+/// each update to avoid the ABA problem.
+template <typename ValueT>
+class ShmPool {
+    static_assert(std::is_trivially_copyable_v<ValueT>);
+
+  public:
+    struct alignas(CacheLineSize) Node {
+        std::uint32_t next;
+        ValueT val;
+    };
+    static_assert(std::is_trivially_copyable_v<Node>);
+    struct alignas(CacheLineSize) Impl {
+        // The low 32 bits hold the index of the first free node, and the high 32 bits hold the tag.
+        std::uint64_t head;
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint64_t capacity;
+        alignas(CacheLineSize) Node nodes[];
+    };
+    static_assert(std::is_trivially_copyable_v<Impl>);
+    static_assert(sizeof(Impl) == CacheLineSize);
+    static_assert(offsetof(Impl, head) == 0 * CacheLineSize);
+    static_assert(offsetof(Impl, nodes) == 1 * CacheLineSize);
+
+    constexpr ShmPool(std::nullptr_t = nullptr) noexcept {}
+    explicit ShmPool(std::size_t capacity)
+    : capacity_{capacity}
+    , mem_map_{os::mmap(nullptr, size(capacity_), PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE,
+                        -1, 0)}
+    , impl_{static_cast<Impl*>(mem_map_.get().data())}
+    {
+        init(impl_, capacity_);
+    }
+    /// Maps a file-backed ShmPool.
+    ///
+    /// \throw std::runtime_error if the file is too small or was not initialised by new_shm_pool().
+    explicit ShmPool(FileHandle& fh)
+    : capacity_{capacity(io::file_size(fh.get()))}
+    , mem_map_{os::mmap(nullptr, size(capacity_), PROT_READ | PROT_WRITE, MAP_SHARED, fh.get(), 0)}
+    , impl_{static_cast<Impl*>(mem_map_.get().data())}
+    {
+        if (impl_->magic != ShmPoolMagic || impl_->version != ShmPoolVersion
+            || impl_->capacity != capacity_) {
+            throw std::runtime_error{"invalid shm pool"};
+        }
+    }
+    explicit ShmPool(FileHandle&& fh)
+    : ShmPool{fh}
+    {
+    }
+    /// Opens a file-backed ShmPool.
+    ///
+    /// \param path Path to ShmPool file.
+    /// \throw std::runtime_error if the file is too small or was not initialised by new_shm_pool().
+    explicit ShmPool(const char* path)
+    : ShmPool{os::open(path, O_RDWR)}
+    {
+    }
+    ~ShmPool() = default;
+
+    // Copy.
+    ShmPool(const ShmPool&) = delete;
+    ShmPool& operator=(const ShmPool&) = delete;
+
+    // Move.
+    ShmPool(ShmPool&& rhs) noexcept
+    : capacity_{rhs.capacity_}
+    , mem_map_{std::move(rhs.mem_map_)}
+    , impl_{rhs.impl_}
+    {
+        rhs.capacity_ = 0;
+        rhs.impl_ = nullptr;
+    }
+    ShmPool& operator=(ShmPool&& rhs) noexcept
+    {
+        reset();
+        swap(rhs);
+        return *this;
+    }
+
+    /// Returns the maximum number of objects the pool can hold.
+    std::size_t capacity() const noexcept { return capacity_; }
+
+    void reset(std::nullptr_t = nullptr) noexcept
+    {
+        // Reverse order.
+        impl_ = nullptr;
+        mem_map_.reset(nullptr);
+        capacity_ = 0;
+    }
+    void swap(ShmPool& rhs) noexcept
+    {
+        std::swap(capacity_, rhs.capacity_);
+        mem_map_.swap(rhs.mem_map_);
+        std::swap(impl_, rhs.impl_);
+    }
+
+    /// Returns the object at index \p i.
+    ValueT& operator[](std::uint32_t i) noexcept
+    {
+        assert(i < capacity_);
+        return impl_->nodes[i].val;
+    }
+    /// Returns the object at index \p i.
+    const ValueT& operator[](std::uint32_t i) const noexcept
+    {
+        assert(i < capacity_);
+        return impl_->nodes[i].val;
+    }
+
+    /// Allocate an object.
+    ///
+    /// \return the index of the object, or ShmPoolNil if the pool is exhausted.
+    std::uint32_t alloc() noexcept
+    {
+        auto head = __atomic_load_n(&impl_->head, __ATOMIC_ACQUIRE);
+        for (;;) {
+            const auto i = static_cast<std::uint32_t>(head);
+            if (i == ShmPoolNil) {
+                return ShmPoolNil;
+            }
+            // The node may be concurrently allocated by another thread, in which case the next
+            // index is stale, but the tag ensures that the exchange fails.
+            const auto next = __atomic_load_n(&impl_->nodes[i].next, __ATOMIC_RELAXED);
+            // The compare_exchange_weak function re-reads head on failure.
+            if (__atomic_compare_exchange_n(&impl_->head, &head, make_head(head, next), true,
+                                            __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+                return i;
+            }
+        }
+    }
+    /// Return the object at index \p i to the pool.
+    void free(std::uint32_t i) noexcept
+    {
+        assert(i < capacity_);
+        auto head = __atomic_load_n(&impl_->head, __ATOMIC_RELAXED);
+        for (;;) {
+            __atomic_store_n(&impl_->nodes[i].next, static_cast<std::uint32_t>(head),
+                             __ATOMIC_RELAXED);
+            // The compare_exchange_weak function re-reads head on failure.
+            if (__atomic_compare_exchange_n(&impl_->head, &head, make_head(head, i), true,
+                                            __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+                break;
+            }
+        }
+    }
+
+    /// Initialise the pool's free-list.
+    static void init(Impl* impl, std::size_t capacity) noexcept
+    {
+        std::memset(impl, 0, size(capacity));
+        for (std::size_t i{0}; i < capacity; ++i) {
+            impl->nodes[i].next = i + 1 < capacity ? i + 1 : ShmPoolNil;
+        }
+        impl->magic = ShmPoolMagic;
+        impl->version = ShmPoolVersion;
+        impl->capacity = capacity;
+        __atomic_store_n(&impl->head, capacity > 0 ? 0 : ShmPoolNil, __ATOMIC_RELEASE);
+    }
+    static constexpr std::size_t capacity(std::size_t size)
+    {
+        if (size < sizeof(Impl)) {
+            throw std::runtime_error{"file too small for shm pool"};
+        }
+        return (size - sizeof(Impl)) / sizeof(Node);
+    }
+    static constexpr std::size_t size(std::size_t capacity) noexcept
+    {
+        return sizeof(Impl) + capacity * sizeof(Node);
+    }
+
+  private:
+    static constexpr std::uint64_t make_head(std::uint64_t head, std::uint32_t i) noexcept
+    {
+        return (((head >> 32) + 1) << 32) | i;
+    }
+
+    std::size_t capacity_{};
+    Mmap mem_map_{nullptr};
+    Impl* impl_{nullptr};
+};
+
+/// Initialise file-based ShmPool.
+template <typename ValueT>
+void new_shm_pool(FileHandle& fh, std::size_t capacity)
+{
+    using Impl = typename ShmPool<ValueT>::Impl;
+
+    assert(capacity < ShmPoolNil);
+
+    const auto size = ShmPool<ValueT>::size(capacity);
+
+    os::ftruncate(fh.get(), size);
+    Mmap mem_map{os::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fh.get(), 0)};
+    ShmPool<ValueT>::init(static_cast<Impl*>(mem_map.get().data()), capacity);
+}
+
+/// Initialise file-based ShmPool.
+template <typename ValueT>
+void new_shm_pool(FileHandle&& fh, std::size_t capacity)
+{
+    return new_shm_pool<ValueT>(fh, capacity);
+}
+
+} // namespace ipc
+} // namespace toolbox
+
+#endif // TOOLBOX_IPC_SHMPOOL_HPP
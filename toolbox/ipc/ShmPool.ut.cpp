@@ -0,0 +1,148 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ShmPool.hpp"
+
+#include <toolbox/ipc/MpmcQueue.hpp>
+
+#include <toolbox/util/TempDir.ut.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace toolbox;
+
+namespace {
+
+struct Payload {
+    int id;
+    char data[4096];
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(ShmPoolSuite)
+
+BOOST_AUTO_TEST_CASE(ShmPoolAllocFreeCase)
+{
+    ShmPool<int> pool{4};
+    BOOST_TEST(pool.capacity() == 4U);
+
+    set<uint32_t> s;
+    for (int i{0}; i < 4; ++i) {
+        const auto j = pool.alloc();
+        BOOST_TEST(j < 4U);
+        pool[j] = i;
+        s.insert(j);
+    }
+    BOOST_TEST(s.size() == 4U);
+    BOOST_TEST(pool.alloc() == ShmPoolNil);
+
+    pool.free(2);
+    BOOST_TEST(pool.alloc() == 2U);
+    BOOST_TEST(pool.alloc() == ShmPoolNil);
+}
+
+BOOST_AUTO_TEST_CASE(ShmPoolThreadsCase)
+{
+    constexpr int Threads = 4, N = 100000;
+    ShmPool<int> pool{Threads};
+
+    vector<thread> ts;
+    atomic<int> errors{0};
+    for (int t{0}; t < Threads; ++t) {
+        ts.emplace_back([&pool, &errors, t]() {
+            for (int i{0}; i < N; ++i) {
+                const auto j = pool.alloc();
+                if (j == ShmPoolNil) {
+                    ++errors;
+                    continue;
+                }
+                pool[j] = t;
+                this_thread::yield();
+                // Fails if the same object was handed to two threads.
+                if (pool[j] != t) {
+                    ++errors;
+                }
+                pool.free(j);
+            }
+        });
+    }
+    for (auto& t : ts) {
+        t.join();
+    }
+    BOOST_TEST(errors == 0);
+}
+
+BOOST_AUTO_TEST_CASE(ShmPoolQueueCase)
+{
+    test::TempDir tmp;
+    const auto path = tmp.path("pool");
+
+    new_shm_pool<Payload>(os::open(path.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR), 8);
+    ShmPool<Payload> producer{path.c_str()}, consumer{path.c_str()};
+    BOOST_TEST(producer.capacity() == 8U);
+
+    // Pass payloads larger than MaxMsgSize by index.
+    MpmcQueue<uint32_t> q{8};
+    for (int i{0}; i < 8; ++i) {
+        const auto j = producer.alloc();
+        producer[j].id = i;
+        memset(producer[j].data, 'a' + i, sizeof(producer[j].data));
+        BOOST_TEST(q.push(j));
+    }
+    BOOST_TEST(producer.alloc() == ShmPoolNil);
+
+    uint32_t j{};
+    for (int i{0}; i < 8; ++i) {
+        BOOST_TEST(q.pop(j));
+        BOOST_TEST(consumer[j].id == i);
+        BOOST_TEST(consumer[j].data[sizeof(Payload::data) - 1] == 'a' + i);
+        consumer.free(j);
+    }
+    BOOST_TEST(producer.alloc() != ShmPoolNil);
+}
+
+BOOST_AUTO_TEST_CASE(ShmPoolBadFileCase)
+{
+    test::TempDir tmp;
+    const auto path = tmp.path("pool");
+    auto fh = os::open(path.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+
+    // Smaller than the header.
+    os::ftruncate(fh.get(), 16);
+    BOOST_CHECK_EXCEPTION(ShmPool<Payload>{path.c_str()}, runtime_error, [](const auto& e) {
+        return string_view{e.what()} == "file too small for shm pool";
+    });
+
+    // Large enough, but never initialised.
+    os::ftruncate(fh.get(), ShmPool<Payload>::size(8));
+    BOOST_CHECK_THROW(ShmPool<Payload>{path.c_str()}, runtime_error);
+
+    // Initialised with a different node size.
+    new_shm_pool<int>(fh, 8);
+    BOOST_CHECK_THROW(ShmPool<Payload>{path.c_str()}, runtime_error);
+
+    new_shm_pool<Payload>(fh, 8);
+    BOOST_TEST(ShmPool<Payload>{path.c_str()}.capacity() == 8U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
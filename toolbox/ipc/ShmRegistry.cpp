@@ -0,0 +1,271 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ShmRegistry.hpp"
+
+#include <csignal>
+
+#include <sched.h>
+
+namespace toolbox {
+inline namespace ipc {
+using namespace std;
+namespace {
+
+enum : uint32_t {
+    /// Registry magic: "TBR1" in little-endian.
+    RegistryMagic = 0x31524254,
+    RegistryVersion = 1
+};
+
+constexpr size_t registry_size(size_t capacity) noexcept
+{
+    return sizeof(ShmRegistry::Impl) + capacity * sizeof(ShmRegistryEntry);
+}
+
+/// FNV-1a is used instead of std::hash, because the hash must be stable across processes that
+/// may have been built with different toolchains.
+constexpr uint64_t hash_name(string_view name) noexcept
+{
+    uint64_t h{0xcbf29ce484222325};
+    for (const auto c : name) {
+        h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3;
+    }
+    return h;
+}
+
+inline bool is_alive(pid_t pid) noexcept
+{
+    return ::kill(pid, 0) == 0 || errno == EPERM;
+}
+
+FileHandle open_registry(const char* path, size_t capacity)
+{
+    error_code ec;
+    auto fh = os::open(path, O_RDWR, ec);
+    if (!ec) {
+        return fh;
+    }
+    if (ec != errc::no_such_file_or_directory) {
+        throw system_error{ec, "open"};
+    }
+    // Initialise under a temporary name and then link into place, so that concurrent creators agree
+    // on a single, fully initialised registry.
+    string tmp{path};
+    tmp += ".XXXXXX";
+    FileHandle tmp_fh{::mkstemp(tmp.data())};
+    if (tmp_fh.empty()) {
+        throw system_error{make_sys_error(errno), "mkstemp"};
+    }
+    try {
+        const auto size = registry_size(capacity);
+        os::ftruncate(tmp_fh.get(), size);
+        Mmap mem_map{
+            os::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, tmp_fh.get(), 0)};
+        auto* const impl = static_cast<ShmRegistry::Impl*>(mem_map.get().data());
+        impl->magic = RegistryMagic;
+        impl->version = RegistryVersion;
+        impl->capacity = capacity;
+        if (::link(tmp.c_str(), path) < 0 && errno != EEXIST) {
+            throw system_error{make_sys_error(errno), "link"};
+        }
+    } catch (...) {
+        ::unlink(tmp.c_str());
+        throw;
+    }
+    ::unlink(tmp.c_str());
+    return os::open(path, O_RDWR);
+}
+
+} // namespace
+
+ShmRegistry::ShmRegistry(const char* path, size_t capacity)
+{
+    capacity = next_pow2(capacity);
+    const auto fh = open_registry(path, capacity);
+    const auto size = file_size(fh.get());
+    if (size < sizeof(Impl)) {
+        throw runtime_error{"invalid registry"};
+    }
+    mem_map_ = os::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fh.get(), 0);
+    impl_ = static_cast<Impl*>(mem_map_.get().data());
+    if (impl_->magic != RegistryMagic || impl_->version != RegistryVersion
+        || !is_pow2(impl_->capacity) || size < registry_size(impl_->capacity)) {
+        throw runtime_error{"invalid registry"};
+    }
+    mask_ = impl_->capacity - 1;
+}
+
+ShmRegistry::~ShmRegistry() = default;
+
+const ShmRegistryEntry* ShmRegistry::find(string_view name) const
+{
+    const auto h = hash_name(name);
+    for (size_t i{0}; i <= mask_; ++i) {
+        auto& entry = impl_->entries[(h + i) & mask_];
+        for (;;) {
+            auto state = __atomic_load_n(&entry.state, __ATOMIC_ACQUIRE);
+            if (state == ShmSlotEmpty) {
+                return nullptr;
+            }
+            if (state == ShmSlotReady) {
+                if (entry.name() == name) {
+                    return &entry;
+                }
+                break;
+            }
+            if (state == ShmSlotErased) {
+                break;
+            }
+            // The slot is being initialised by another process. Only wait for entries that may
+            // have the same name; the name is written just after the slot is claimed.
+            if (!is_alive(state)) {
+                __atomic_compare_exchange_n(&entry.state, &state, ShmSlotErased, false,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+            } else if (entry.name() == name) {
+                sched_yield();
+            } else {
+                break;
+            }
+        }
+    }
+    return nullptr;
+}
+
+bool ShmRegistry::erase(string_view name)
+{
+    auto* const entry = const_cast<Entry*>(find(name));
+    if (!entry) {
+        return false;
+    }
+    std::int32_t state{ShmSlotReady};
+    return __atomic_compare_exchange_n(&entry->state, &state, ShmSlotErased, false,
+                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+
+size_t ShmRegistry::gc()
+{
+    size_t n{0};
+    for (size_t i{0}; i <= mask_; ++i) {
+        auto& entry = impl_->entries[i];
+        auto state = __atomic_load_n(&entry.state, __ATOMIC_ACQUIRE);
+        if (state == ShmSlotReady) {
+            const string path{entry.path()};
+            if (path.empty() || ::access(path.c_str(), F_OK) == 0) {
+                continue;
+            }
+        } else if (state <= ShmSlotEmpty || is_alive(state)) {
+            continue;
+        }
+        if (__atomic_compare_exchange_n(&entry.state, &state, ShmSlotErased, false,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            ++n;
+        }
+    }
+    return n;
+}
+
+pair<ShmRegistryEntry*, bool> ShmRegistry::claim(string_view name)
+{
+    if (name.empty() || name.size() > sizeof(Entry::name_buf)) {
+        throw invalid_argument{"invalid registry name"};
+    }
+    const auto h = hash_name(name);
+    const auto pid = ::getpid();
+    for (;;) {
+        // The first free slot in the probe sequence, which may be an erased slot. The sequence is
+        // searched to the first empty slot, to ensure that the name is not already present.
+        Entry* free{nullptr};
+        int32_t free_state{ShmSlotEmpty};
+        for (size_t i{0}; i <= mask_; ++i) {
+            auto& entry = impl_->entries[(h + i) & mask_];
+            auto state = __atomic_load_n(&entry.state, __ATOMIC_ACQUIRE);
+            while (state > 0) {
+                // The slot is being initialised by another process.
+                if (!is_alive(state)) {
+                    __atomic_compare_exchange_n(&entry.state, &state, ShmSlotErased, false,
+                                                __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+                } else {
+                    sched_yield();
+                }
+                state = __atomic_load_n(&entry.state, __ATOMIC_ACQUIRE);
+            }
+            if (state == ShmSlotReady) {
+                if (entry.name() == name) {
+                    return {&entry, false};
+                }
+                continue;
+            }
+            if (!free) {
+                free = &entry;
+                free_state = state;
+            }
+            if (state == ShmSlotEmpty) {
+                break;
+            }
+        }
+        if (!free) {
+            throw runtime_error{"registry full"};
+        }
+        if (!__atomic_compare_exchange_n(&free->state, &free_state, pid, false, __ATOMIC_SEQ_CST,
+                                         __ATOMIC_RELAXED)) {
+            // Another process claimed the slot first.
+            continue;
+        }
+        pstrcpy<'\0'>(free->name_buf, name);
+        // Concurrent inserts of the same name need not race for the same free slot: a slot that
+        // one passed over as ready may have been erased and then claimed by the other. So the
+        // probe sequence is searched again, now that the claim is visible. Both claims are
+        // sequentially consistent, so at least one of the inserts sees the other, and backs off.
+        if (!has_rival(name, h, free)) {
+            return {free, true};
+        }
+        abandon(*free);
+        sched_yield();
+    }
+}
+
+bool ShmRegistry::has_rival(string_view name, uint64_t h, const Entry* own) const noexcept
+{
+    for (size_t i{0}; i <= mask_; ++i) {
+        const auto& entry = impl_->entries[(h + i) & mask_];
+        if (&entry == own) {
+            continue;
+        }
+        const auto state = __atomic_load_n(&entry.state, __ATOMIC_SEQ_CST);
+        if (state == ShmSlotEmpty) {
+            break;
+        }
+        // The name of a slot that is being initialised may not have been written yet.
+        if (state > 0 || (state == ShmSlotReady && entry.name() == name)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ShmRegistry::publish(Entry& entry) noexcept
+{
+    __atomic_store_n(&entry.state, ShmSlotReady, __ATOMIC_RELEASE);
+}
+
+void ShmRegistry::abandon(Entry& entry) noexcept
+{
+    __atomic_store_n(&entry.state, ShmSlotErased, __ATOMIC_RELEASE);
+}
+
+} // namespace ipc
+} // namespace toolbox
@@ -0,0 +1,219 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOOLBOX_IPC_SHMREGISTRY_HPP
+#define TOOLBOX_IPC_SHMREGISTRY_HPP
+
+#include <toolbox/ipc/MpmcQueue.hpp>
+#include <toolbox/util/String.hpp>
+
+namespace toolbox {
+inline namespace ipc {
+
+enum : std::int32_t {
+    /// Slot has never been used.
+    ShmSlotEmpty = 0,
+    /// Slot holds a published entry.
+    ShmSlotReady = -1,
+    /// Slot held an entry that has since been erased. Erased slots are reused by later inserts.
+    ShmSlotErased = -2
+    // Positive values are the pid of the process initialising the entry.
+};
+
+/// ShmRegistryEntry describes a named shared-memory object.
+struct alignas(CacheLineSize) ShmRegistryEntry {
+    std::int32_t state;
+    /// Layout version of the object.
+    std::uint32_t version;
+    /// Capacity of the object.
+    std::uint64_t capacity;
+    char name_buf[48];
+    char type_buf[32];
+    char path_buf[160];
+
+    std::string_view name() const noexcept { return {name_buf, pstrlen<'\0'>(name_buf)}; }
+    std::string_view type() const noexcept { return {type_buf, pstrlen<'\0'>(type_buf)}; }
+    std::string_view path() const noexcept { return {path_buf, pstrlen<'\0'>(path_buf)}; }
+};
+static_assert(std::is_trivially_copyable_v<ShmRegistryEntry>);
+static_assert(sizeof(ShmRegistryEntry) == 4 * CacheLineSize);
+
+/// ShmRegistry is a directory of named shared-memory objects, stored in a small memory-mapped
+/// file, that allows processes to discover each other's queues without a broker.
+///
+/// The registry file is created atomically by the first process to open it. Entries are inserted
+/// into a fixed-capacity, open-addressed table, in the first empty or erased slot of the name's
+/// probe sequence. Each slot is claimed with a compare-and-swap, after which the probe sequence is
+/// searched again, so that concurrent inserts of the same name cannot both succeed. A slot is
+/// published only after its object has been initialised, so a reader never observes a partially
+/// initialised object. Slots
+/// claimed by a process that died before publishing are reclaimed by the next process that
+/// encounters them.
+class TOOLBOX_API ShmRegistry {
+  public:
+    using Entry = ShmRegistryEntry;
+
+    struct alignas(CacheLineSize) Impl {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint64_t capacity;
+        alignas(CacheLineSize) Entry entries[];
+    };
+    static_assert(std::is_trivially_copyable_v<Impl>);
+    static_assert(sizeof(Impl) == CacheLineSize);
+    static_assert(offsetof(Impl, entries) == CacheLineSize);
+
+    /// Opens the registry, creating it if it does not exist.
+    ///
+    /// \param path Path to registry file.
+    /// \param capacity Maximum number of entries, which is only used when creating the registry.
+    explicit ShmRegistry(const char* path, std::size_t capacity = 1024);
+    ~ShmRegistry();
+
+    // Copy.
+    ShmRegistry(const ShmRegistry&) = delete;
+    ShmRegistry& operator=(const ShmRegistry&) = delete;
+
+    // Move.
+    ShmRegistry(ShmRegistry&&) noexcept = default;
+    ShmRegistry& operator=(ShmRegistry&&) noexcept = default;
+
+    /// Returns the maximum number of entries the registry can hold.
+    std::size_t capacity() const noexcept { return mask_ + 1; }
+
+    /// Returns the published entry with the given name, or null if there is no such entry.
+    ///
+    /// If the entry is being initialised by another process, then this function waits until it is
+    /// published. Slots that are being initialised with other names are skipped.
+    const Entry* find(std::string_view name) const;
+
+    /// Insert a new entry, unless an entry with the same name already exists.
+    ///
+    /// The function object is called to initialise the object before the entry is published. If
+    /// the function object throws, then the entry is erased.
+    ///
+    /// \return the entry and a flag indicating whether the entry was inserted.
+    template <typename FnT>
+    std::pair<const Entry*, bool> insert(std::string_view name, std::string_view type,
+                                         std::string_view path, std::size_t capacity,
+                                         std::uint32_t version, FnT fn)
+    {
+        if (type.size() > sizeof(Entry::type_buf) || path.size() > sizeof(Entry::path_buf)) {
+            throw std::invalid_argument{"registry entry too long"};
+        }
+        auto [entry, claimed] = claim(name);
+        if (!claimed) {
+            return {entry, false};
+        }
+        try {
+            entry->version = version;
+            entry->capacity = capacity;
+            pstrcpy<'\0'>(entry->type_buf, type);
+            pstrcpy<'\0'>(entry->path_buf, path);
+            fn(*entry);
+        } catch (...) {
+            abandon(*entry);
+            throw;
+        }
+        publish(*entry);
+        return {entry, true};
+    }
+
+    /// Insert a new entry, unless an entry with the same name already exists.
+    ///
+    /// \return the entry and a flag indicating whether the entry was inserted.
+    std::pair<const Entry*, bool> insert(std::string_view name, std::string_view type,
+                                         std::string_view path, std::size_t capacity,
+                                         std::uint32_t version)
+    {
+        return insert(name, type, path, capacity, version, [](const Entry&) {});
+    }
+
+    /// Erase the entry with the given name.
+    ///
+    /// \return false if there is no such entry.
+    bool erase(std::string_view name);
+
+    /// Erase entries whose backing file no longer exists, and reclaim slots held by processes that
+    /// died before publishing their entry. This is typically called at startup.
+    ///
+    /// \return the number of entries erased.
+    std::size_t gc();
+
+    /// Call the function object for each published entry.
+    template <typename FnT>
+    void for_each(FnT fn) const
+    {
+        for (std::size_t i{0}; i <= mask_; ++i) {
+            const auto& entry = impl_->entries[i];
+            if (__atomic_load_n(&entry.state, __ATOMIC_ACQUIRE) == ShmSlotReady) {
+                fn(entry);
+            }
+        }
+    }
+
+  private:
+    std::pair<Entry*, bool> claim(std::string_view name);
+    /// Returns true if a slot other than own, in the probe sequence for the name, is being
+    /// initialised or holds a published entry with the same name.
+    bool has_rival(std::string_view name, std::uint64_t h, const Entry* own) const noexcept;
+    void publish(Entry& entry) noexcept;
+    void abandon(Entry& entry) noexcept;
+
+    Mmap mem_map_;
+    std::size_t mask_{};
+    Impl* impl_{nullptr};
+};
+
+/// Attach to the named MpmcQueue, creating and registering the queue if it does not exist.
+///
+/// The queue is only mapped when attached, so a process pays for the queues that it uses.
+///
+/// \throw std::runtime_error if the existing queue has a different layout or capacity.
+template <typename ValueT>
+MpmcQueue<ValueT> attach_mpmc_queue(ShmRegistry& reg, std::string_view name,
+                                    const std::string& path, std::size_t capacity)
+{
+    constexpr auto Type = "MpmcQueue";
+    // The queue layout is determined by the size of its values.
+    constexpr auto Version = static_cast<std::uint32_t>(sizeof(ValueT));
+    // The queue's capacity is rounded up to a power of two.
+    capacity = next_pow2(capacity);
+
+    const auto [entry, inserted] = reg.insert(name, Type, path, capacity, Version,
+                                              [&path, capacity](const ShmRegistryEntry&) {
+                                                  new_mpmc_queue<ValueT>(
+                                                      os::open(path.c_str(), O_RDWR | O_CREAT,
+                                                               S_IRUSR | S_IWUSR | S_IRGRP),
+                                                      capacity);
+                                              });
+    if (entry->type() != Type || entry->version != Version) {
+        throw std::runtime_error{"registry entry has incompatible layout"};
+    }
+    if (entry->capacity != capacity) {
+        throw std::runtime_error{"registry entry has different capacity"};
+    }
+    MpmcQueue<ValueT> q{std::string{entry->path()}.c_str()};
+    if (q.capacity() != capacity) {
+        throw std::runtime_error{"queue has different capacity"};
+    }
+    return q;
+}
+
+} // namespace ipc
+} // namespace toolbox
+
+#endif // TOOLBOX_IPC_SHMREGISTRY_HPP
@@ -0,0 +1,195 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ShmRegistry.hpp"
+
+#include <toolbox/util/TempDir.ut.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+
+#include <sys/wait.h>
+
+using namespace std;
+using namespace toolbox;
+
+using test::TempDir;
+
+BOOST_AUTO_TEST_SUITE(ShmRegistrySuite)
+
+BOOST_AUTO_TEST_CASE(ShmRegistryInsertCase)
+{
+    TempDir tmp;
+    ShmRegistry reg{tmp.path("registry").c_str(), 10};
+    BOOST_TEST(reg.capacity() == 16U);
+    BOOST_TEST(!reg.find("foo"));
+
+    auto [entry, inserted] = reg.insert("foo", "Foo", "/dev/null", 100, 1);
+    BOOST_TEST(inserted);
+    BOOST_TEST(entry->name() == "foo");
+    BOOST_TEST(entry->type() == "Foo");
+    BOOST_TEST(entry->path() == "/dev/null");
+    BOOST_TEST(entry->capacity == 100U);
+    BOOST_TEST(entry->version == 1U);
+
+    // Visible to other openers of the same registry.
+    ShmRegistry other{tmp.path("registry").c_str()};
+    const auto* found = other.find("foo");
+    BOOST_TEST(found);
+    BOOST_TEST(found->path() == "/dev/null");
+
+    tie(entry, inserted) = other.insert("foo", "Bar", "/dev/zero", 200, 2);
+    BOOST_TEST(!inserted);
+    BOOST_TEST(entry->type() == "Foo");
+
+    BOOST_CHECK_THROW(reg.insert("bar", "Bar", "", 0, 0, [](const auto&) { throw 1; }), int);
+    BOOST_TEST(!reg.find("bar"));
+
+    int n{0};
+    reg.for_each([&n](const auto&) { ++n; });
+    BOOST_TEST(n == 1);
+
+    BOOST_TEST(reg.erase("foo"));
+    BOOST_TEST(!reg.erase("foo"));
+    BOOST_TEST(!other.find("foo"));
+}
+
+BOOST_AUTO_TEST_CASE(ShmRegistryGcCase)
+{
+    TempDir tmp;
+    ShmRegistry reg{tmp.path("registry").c_str(), 16};
+    reg.insert("foo", "Foo", "/dev/null", 0, 0);
+    reg.insert("bar", "Bar", tmp.path("missing"), 0, 0);
+
+    // A child process dies while initialising its entry.
+    const auto pid = ::fork();
+    if (pid == 0) {
+        reg.insert("baz", "Baz", "", 0, 0, [](const auto&) { ::_exit(0); });
+    }
+    BOOST_TEST(::waitpid(pid, nullptr, 0) == pid);
+
+    BOOST_TEST(reg.gc() == 2U);
+    BOOST_TEST(reg.find("foo"));
+    BOOST_TEST(!reg.find("bar"));
+    BOOST_TEST(!reg.find("baz"));
+    BOOST_TEST(reg.insert("baz", "Baz", "", 0, 0).second);
+}
+
+BOOST_AUTO_TEST_CASE(ShmRegistryMpmcQueueCase)
+{
+    TempDir tmp;
+    ShmRegistry reg{tmp.path("registry").c_str(), 16};
+    auto q1 = attach_mpmc_queue<int>(reg, "queue", tmp.path("queue"), 8);
+    auto q2 = attach_mpmc_queue<int>(reg, "queue", tmp.path("queue"), 8);
+    BOOST_TEST(q1.capacity() == 8U);
+    BOOST_TEST(q1.push(101));
+    int val{};
+    BOOST_TEST(q2.pop(val));
+    BOOST_TEST(val == 101);
+
+    BOOST_CHECK_THROW(attach_mpmc_queue<long double>(reg, "queue", tmp.path("queue"), 8),
+                      runtime_error);
+    BOOST_CHECK_THROW(attach_mpmc_queue<int>(reg, "queue", tmp.path("queue"), 16), runtime_error);
+    // The same power of two.
+    BOOST_TEST(attach_mpmc_queue<int>(reg, "queue", tmp.path("queue"), 7).capacity() == 8U);
+}
+
+BOOST_AUTO_TEST_CASE(ShmRegistryReuseCase)
+{
+    TempDir tmp;
+    ShmRegistry reg{tmp.path("registry").c_str(), 4};
+
+    // Erased slots are reused, so the registry does not fill up.
+    for (int i{0}; i < 100; ++i) {
+        const auto name = "foo" + to_string(i);
+        BOOST_TEST(reg.insert(name, "Foo", "", 0, 0).second);
+        BOOST_TEST(reg.find(name));
+        BOOST_TEST(reg.erase(name));
+    }
+    for (int i{0}; i < 4; ++i) {
+        BOOST_TEST(reg.insert("bar" + to_string(i), "Bar", "", 0, 0).second);
+    }
+    BOOST_CHECK_THROW(reg.insert("baz", "Baz", "", 0, 0), runtime_error);
+
+    // An erased slot earlier in the probe sequence does not hide a later entry with the same name.
+    BOOST_TEST(reg.erase("bar0"));
+    BOOST_TEST(reg.erase("bar1"));
+    for (int i{2}; i < 4; ++i) {
+        BOOST_TEST(!reg.insert("bar" + to_string(i), "Bar", "", 0, 0).second);
+    }
+    int n{0};
+    reg.for_each([&n](const auto&) { ++n; });
+    BOOST_TEST(n == 2);
+}
+
+BOOST_AUTO_TEST_CASE(ShmRegistryEraseRaceCase)
+{
+    TempDir tmp;
+    const auto path = tmp.path("registry");
+    ShmRegistry reg{path.c_str(), 4};
+    BOOST_TEST(reg.insert("foo", "Foo", "", 0, 0).second);
+
+    // Map the registry, so that the slots in the probe sequence of "foo" can be set directly.
+    const auto fh = os::open(path.c_str(), O_RDWR);
+    Mmap mem_map{os::mmap(nullptr, file_size(fh.get()), PROT_READ | PROT_WRITE, MAP_SHARED,
+                          fh.get(), 0)};
+    auto* const impl = static_cast<ShmRegistry::Impl*>(mem_map.get().data());
+    size_t first{0};
+    while (impl->entries[first].name() != "foo") {
+        ++first;
+    }
+    auto slot = [impl, first](size_t i) -> ShmRegistryEntry& {
+        return impl->entries[(first + i) % 4];
+    };
+    auto set_state = [](ShmRegistryEntry& entry, int32_t state) {
+        __atomic_store_n(&entry.state, state, __ATOMIC_SEQ_CST);
+    };
+    // Another entry, an erased slot, and a slot that is being initialised by a live process.
+    pstrcpy<'\0'>(slot(0).name_buf, "bar"sv);
+    set_state(slot(0), ShmSlotReady);
+    set_state(slot(1), ShmSlotErased);
+    set_state(slot(2), ::getpid());
+    set_state(slot(3), ShmSlotEmpty);
+    // A slot that is being initialised with another name does not block the search.
+    BOOST_TEST(!reg.find("foo"));
+
+    auto insert = [&path](bool& inserted) {
+        ShmRegistry reg{path.c_str()};
+        inserted = reg.insert("foo", "Foo", "", 0, 0).second;
+    };
+    // The first insert passes over the entry in slot 0, and waits at slot 2, with slot 1 as its
+    // free slot.
+    bool inserted1{false}, inserted2{false};
+    thread t1{insert, ref(inserted1)};
+    this_thread::sleep_for(100ms);
+    // The entry in slot 0 is erased, so the second insert takes slot 0 as its free slot, passes
+    // over slot 1, and also waits at slot 2.
+    set_state(slot(0), ShmSlotErased);
+    thread t2{insert, ref(inserted2)};
+    this_thread::sleep_for(100ms);
+    // Both inserts find the end of the probe sequence at slot 3.
+    set_state(slot(2), ShmSlotErased);
+    t1.join();
+    t2.join();
+
+    BOOST_TEST(inserted1 != inserted2);
+    int n{0};
+    reg.for_each([&n](const auto& entry) { n += entry.name() == "foo" ? 1 : 0; });
+    BOOST_TEST(n == 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
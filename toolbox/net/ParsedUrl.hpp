@@ -49,7 +49,7 @@ public:
                 proto_ = {};
             } else {         
                 proto_ = u.substr(0, p);
-                u = u.substr(p);
+                u = u.substr(p + proto_sep.size());
             }
         }
         query_ = {};
@@ -69,6 +69,10 @@ public:
                 host_ = u.substr(0, p);
             }
         }
+        // IPv6 address literal.
+        if(host_.size()>=2 && host_.front()=='[' && host_.back()==']') {
+            host_ = host_.substr(1, host_.size()-2);
+        }
     }
     const UrlParams& params() const { return params_; }
     std::string_view url() const { return url_; }
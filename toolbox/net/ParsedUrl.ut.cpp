@@ -0,0 +1,99 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ParsedUrl.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+using namespace toolbox;
+
+BOOST_AUTO_TEST_SUITE(ParsedUrlSuite)
+
+BOOST_AUTO_TEST_CASE(ParsedUrlBasicCase)
+{
+    const string s{"tcp4://example.com:8080?foo=1|bar=2|baz="};
+    const ParsedUrl url{s};
+    BOOST_TEST(url.str() == s);
+    BOOST_TEST(url.url() == "tcp4://example.com:8080?foo=1");
+    BOOST_TEST(url.proto() == "tcp4");
+    BOOST_TEST(url.host() == "example.com");
+    BOOST_TEST(url.service() == "8080");
+    BOOST_TEST(url.query() == "?foo=1");
+    BOOST_TEST(url.params().size() == 2U);
+    BOOST_TEST(url.param("bar") == "2");
+    BOOST_TEST(url.param("baz").empty());
+    BOOST_TEST(url.param("qux", "dflt") == "dflt");
+
+    // The constructor and parse() take the separators in a different order, but parse the same.
+    ParsedUrl parsed;
+    parsed.parse(s);
+    BOOST_TEST(parsed.url() == url.url());
+    BOOST_TEST(parsed.proto() == url.proto());
+    BOOST_TEST(parsed.host() == url.host());
+    BOOST_TEST(parsed.service() == url.service());
+    BOOST_TEST(parsed.query() == url.query());
+    BOOST_TEST(parsed.params() == url.params());
+}
+
+BOOST_AUTO_TEST_CASE(ParsedUrlHostCase)
+{
+    // No scheme.
+    const string s1{"127.0.0.1:80"};
+    const ParsedUrl url1{s1};
+    BOOST_TEST(url1.proto().empty());
+    BOOST_TEST(url1.host() == "127.0.0.1");
+    BOOST_TEST(url1.service() == "80");
+
+    // No service.
+    const string s2{"unix:///tmp/foo.sock"};
+    const ParsedUrl url2{s2};
+    BOOST_TEST(url2.proto() == "unix");
+    BOOST_TEST(url2.host() == "/tmp/foo.sock");
+    BOOST_TEST(url2.service().empty());
+
+    // The brackets are removed from IPv6 address literals.
+    const string s3{"ip6://[::1]:80"};
+    const ParsedUrl url3{s3};
+    BOOST_TEST(url3.proto() == "ip6");
+    BOOST_TEST(url3.host() == "::1");
+    BOOST_TEST(url3.service() == "80");
+
+    const string s4{"tcp4://example.com:80|foo"};
+    BOOST_CHECK_THROW(ParsedUrl{s4}, logic_error);
+}
+
+BOOST_AUTO_TEST_CASE(ParsedUrlAeronCase)
+{
+    // AeronEndpoint parses its channel with the default separators, and reads the channel, endpoint
+    // and interface from the parameters.
+    const string s{"aeron:udp|channel=aeron:udp?endpoint=192.168.0.1:40456"
+                   "|endpoint=192.168.0.1:40456|interface=192.168.0.3"};
+    const ParsedUrl url{s};
+    BOOST_TEST(url.url() == "aeron:udp");
+    BOOST_TEST(url.param("channel") == "aeron:udp?endpoint=192.168.0.1:40456");
+    BOOST_TEST(url.param("endpoint") == "192.168.0.1:40456");
+    BOOST_TEST(url.param("interface") == "192.168.0.3");
+
+    // Without parameters, the channel is the whole URL.
+    const string ch{"aeron:udp?endpoint=localhost:20123"};
+    const ParsedUrl url2{ch};
+    BOOST_TEST(url2.url() == ch);
+    BOOST_TEST(url2.params().empty());
+    BOOST_TEST(url2.query() == "?endpoint=localhost:20123");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
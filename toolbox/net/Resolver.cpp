@@ -33,23 +33,29 @@ int Resolver::run(Duration timeout)
         return 0;
     } else if (stop_) {
         // This will unblock waiters by throwing a "broken promise" exception.
+        auto jobs = std::move(queue_);
         queue_.clear();
+        lock.unlock();
+        cancel(jobs);
         return -1;
     }
     // Copy batch of tasks to temporary buffer.
-    std::array<Task, BatchSize> tasks{};
+    std::array<Job, BatchSize> jobs{};
 
     const auto n = std::min(queue_.size(), BatchSize);
     for (std::size_t i{0}; i < n; ++i) {
-        // Copy is disabled for unique_ptr<>, so use swap() instead.
-        queue_[i].swap(tasks[i]);
+        jobs[i] = std::move(queue_[i]);
     }
     queue_.erase(queue_.begin(), queue_.begin() + n);
     lock.unlock();
 
     // Execute tasks after lock is released.
     for (std::size_t i{0}; i < n; ++i) {
-        tasks[i]();
+        jobs[i].task();
+        // The future is ready once the task has returned.
+        if (jobs[i].waker) {
+            jobs[i].waker->wakeup();
+        }
     }
     return n;
 }
@@ -66,11 +72,18 @@ void Resolver::stop()
 void Resolver::clear()
 {
     Lock lock{mutex_};
-    // This will unblock waiters by throwing a "broken promise" exception.
-    return queue_.clear();
+    auto jobs = std::move(queue_);
+    queue_.clear();
+    lock.unlock();
+    cancel(jobs);
 }
 
 AddrInfoFuture Resolver::resolve(const std::string& uri, int type)
+{
+    return resolve(uri, type, nullptr);
+}
+
+AddrInfoFuture Resolver::resolve(const std::string& uri, int type, std::shared_ptr<IWaker> waker)
 {
     Task task{[=]() -> AddrInfoPtr { return parse_endpoint(uri, type); }};
     auto future = task.get_future();
@@ -79,11 +92,22 @@ AddrInfoFuture Resolver::resolve(const std::string& uri, int type)
     if (stop_) {
         throw std::logic_error{"resolver stopped"};
     }
-    queue_.push_back(std::move(task));
+    queue_.push_back({std::move(task), std::move(waker)});
     lock.unlock();
     cond_.notify_one();
     return future;
 }
 
+void Resolver::cancel(std::deque<Job>& jobs) noexcept
+{
+    for (auto& job : jobs) {
+        // This will unblock waiters by throwing a "broken promise" exception.
+        job.task = Task{};
+        if (job.waker) {
+            job.waker->wakeup();
+        }
+    }
+}
+
 } // namespace net
 } // namespace toolbox
@@ -17,12 +17,14 @@
 #ifndef TOOLBOX_NET_RESOLVER_HPP
 #define TOOLBOX_NET_RESOLVER_HPP
 
+#include <toolbox/io/Waker.hpp>
 #include <toolbox/net/Sock.hpp>
 #include <toolbox/sys/Time.hpp>
 
 #include <cassert>
 #include <deque>
 #include <future>
+#include <memory>
 
 namespace toolbox {
 inline namespace net {
@@ -62,10 +64,21 @@ class TOOLBOX_API Resolver {
     /// Schedule a URI socket name resolution.
     AddrInfoFuture resolve(const std::string& uri, int type);
 
+    /// Schedule a URI socket name resolution. The waker is notified on the resolver's thread once
+    /// the future is ready, including when the task is cancelled.
+    AddrInfoFuture resolve(const std::string& uri, int type, std::shared_ptr<IWaker> waker);
+
   private:
+    struct Job {
+        Task task;
+        std::shared_ptr<IWaker> waker;
+    };
+    /// Cancel the jobs, resulting in a broken promise, and notify their wakers.
+    static void cancel(std::deque<Job>& jobs) noexcept;
+
     mutable std::mutex mutex_;
     std::condition_variable cond_;
-    std::deque<Task> queue_;
+    std::deque<Job> queue_;
     bool stop_{false};
 };
 
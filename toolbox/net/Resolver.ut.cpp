@@ -25,6 +25,13 @@
 using namespace std;
 using namespace toolbox;
 
+namespace {
+struct TestWaker : IWaker {
+    void wakeup() noexcept override { ++count; }
+    int count{0};
+};
+} // namespace
+
 BOOST_AUTO_TEST_SUITE(ResolverSuite)
 
 BOOST_AUTO_TEST_CASE(ResolverCase)
@@ -53,4 +60,22 @@ BOOST_AUTO_TEST_CASE(ResolverCase)
     BOOST_CHECK_THROW(future6.get(), future_error);
 }
 
+BOOST_AUTO_TEST_CASE(ResolverWakerCase)
+{
+    Resolver res;
+    auto waker = make_shared<TestWaker>();
+    auto future1 = res.resolve("tcp4://192.168.1.3:443", SOCK_STREAM, waker);
+    BOOST_TEST(waker->count == 0);
+    BOOST_TEST(res.run() == 1);
+    // The future is ready when the waker is notified.
+    BOOST_TEST(waker->count == 1);
+    BOOST_TEST(is_ready(future1));
+
+    // Cancelled tasks also notify.
+    auto future2 = res.resolve("tcp4://192.168.1.3:443", SOCK_STREAM, waker);
+    res.clear();
+    BOOST_TEST(waker->count == 2);
+    BOOST_CHECK_THROW(future2.get(), future_error);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -683,6 +683,18 @@ inline void set_so_reuse_addr(int sockfd, bool enabled)
     os::setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval));
 }
 
+inline void set_so_reuse_port(int sockfd, bool enabled, std::error_code& ec) noexcept
+{
+    int optval{enabled ? 1 : 0};
+    os::setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, &optval, sizeof(optval), ec);
+}
+
+inline void set_so_reuse_port(int sockfd, bool enabled)
+{
+    int optval{enabled ? 1 : 0};
+    os::setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, &optval, sizeof(optval));
+}
+
 inline void set_so_snd_buf(int sockfd, int size, std::error_code& ec) noexcept
 {
     os::setsockopt(sockfd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size), ec);
@@ -794,6 +806,12 @@ struct Sock : FileHandle {
     }
     void set_reuse_addr(bool enabled) { toolbox::set_so_reuse_addr(get(), enabled); }
 
+    void set_reuse_port(bool enabled, std::error_code& ec) noexcept
+    {
+        toolbox::set_so_reuse_port(get(), enabled, ec);
+    }
+    void set_reuse_port(bool enabled) { toolbox::set_so_reuse_port(get(), enabled); }
+
     void set_snd_buf(int size, std::error_code& ec) noexcept
     {
         toolbox::set_so_snd_buf(get(), size, ec);
@@ -25,17 +25,24 @@
 namespace toolbox {
 inline namespace net {
 
+/// Allow multiple sockets to bind to the same port, so that the kernel distributes incoming
+/// connections between them.
+enum class ReusePort : bool { No = false, Yes = true };
+
 template <typename DerivedT>
 class StreamAcceptor {
   public:
     using Protocol = StreamProtocol;
     using Endpoint = StreamEndpoint;
 
-    StreamAcceptor(Reactor& r, const Endpoint& ep)
+    StreamAcceptor(Reactor& r, const Endpoint& ep, ReusePort reuse_port = ReusePort::No)
     : serv_{ep.protocol()}
     , sub_{serv_.get(), r.poller(serv_.get())}
     {
         serv_.set_reuse_addr(true);
+        if (reuse_port == ReusePort::Yes) {
+            serv_.set_reuse_port(true);
+        }
         serv_.bind(ep);
         serv_.listen(SOMAXCONN);
         sub_.add(PollEvents::Read, bind<&StreamAcceptor::on_io_event>(this));
@@ -49,6 +56,9 @@ class StreamAcceptor {
     StreamAcceptor(StreamAcceptor&&) = delete;
     StreamAcceptor& operator=(StreamAcceptor&&) = delete;
 
+    /// Get the bound endpoint, which is useful if the port was assigned by the kernel.
+    void get_sock_name(Endpoint& ep) { serv_.get_sock_name(ep); }
+
   protected:
     ~StreamAcceptor() = default;
 
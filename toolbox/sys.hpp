@@ -17,11 +17,14 @@
 #ifndef TOOLBOX_SYS_HPP
 #define TOOLBOX_SYS_HPP
 
+#include "sys/AsyncLogger.hpp"
 #include "sys/Daemon.hpp"
 #include "sys/Date.hpp"
 #include "sys/Error.hpp"
 #include "sys/Limits.hpp"
 #include "sys/Log.hpp"
+#include "sys/LogFile.hpp"
+#include "sys/LogFormat.hpp"
 #include "sys/PidFile.hpp"
 #include "sys/Signal.hpp"
 #include "sys/System.hpp"
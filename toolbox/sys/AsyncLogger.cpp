@@ -0,0 +1,380 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "AsyncLogger.hpp"
+
+#include <toolbox/io/Runner.hpp>
+#include <toolbox/ipc/MagicRingBuffer.hpp>
+#include <toolbox/sys/LogFile.hpp>
+#include <toolbox/sys/LogFormat.hpp>
+
+#include <algorithm>
+#include <atomic>
+
+namespace toolbox {
+inline namespace sys {
+using namespace std;
+namespace {
+
+/// Messages are batched into writes of at least this size.
+constexpr size_t BatchSize{1 << 16};
+
+struct Record {
+    uint64_t tsc;
+    /// The format of the encoded arguments, or null if the payload is preformatted text.
+    const LogFormat* fmt;
+    int32_t level;
+    uint32_t size;
+};
+static_assert(sizeof(Record) == 24);
+
+constexpr size_t record_size(size_t size) noexcept
+{
+    // Align records to the record header.
+    return (sizeof(Record) + size + alignof(Record) - 1) & ~(alignof(Record) - 1);
+}
+
+atomic<uint64_t> next_epoch_{0};
+
+// Guards the current instance and the live epoch.
+mutex instance_mutex_;
+atomic<AsyncLogger*> instance_{nullptr};
+uint64_t live_epoch_{0};
+
+/// The calling thread's ring buffer, which is only valid if the epoch matches the epoch of the
+/// current instance.
+struct ThreadRing {
+    ~ThreadRing();
+    uint64_t epoch{0};
+    AsyncLogger::Ring* ring{nullptr};
+};
+
+thread_local ThreadRing thread_ring_;
+
+void write_all(int fd, const string& buf) noexcept
+{
+    const char* p{buf.data()};
+    size_t n{buf.size()};
+    while (n > 0) {
+        const auto ret = ::write(fd, p, n);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // Best effort given that this is the logger.
+            break;
+        }
+        p += ret;
+        n -= ret;
+    }
+}
+
+} // namespace
+
+struct AsyncLogger::Ring {
+    explicit Ring(size_t size)
+    : rb{size}
+    {
+    }
+    MagicRingBuffer rb;
+    const int tid{thread_id()};
+    atomic<size_t> dropped{0};
+    /// Set when the owning thread exits.
+    atomic<bool> closed{false};
+};
+
+ThreadRing::~ThreadRing()
+{
+    lock_guard<mutex> lock{instance_mutex_};
+    if (ring && epoch == live_epoch_) {
+        ring->closed.store(true, memory_order_release);
+    }
+}
+
+AsyncLogger::AsyncLogger(AsyncLoggerConfig config)
+: config_{move(config)}
+, epoch_{++next_epoch_}
+, base_tsc_{read_tsc()}
+, base_mono_{MonoClock::now()}
+{
+    // Initial estimate of the timestamp counter's frequency, which is refined as the logger runs.
+    this_thread::sleep_for(Millis{1});
+    ns_per_tick_ = static_cast<double>((MonoClock::now() - base_mono_).count())
+        / static_cast<double>(read_tsc() - base_tsc_);
+    batch_.reserve(BatchSize + MaxLogHeader + MaxMsgSize + 1);
+    if (config_.binary) {
+        put_log_header(batch_);
+        if (config_.file) {
+            file_header_ = batch_;
+            config_.file->set_header(file_header_);
+        } else {
+            write_all(config_.fd, batch_);
+        }
+        batch_.clear();
+    }
+    {
+        lock_guard<mutex> lock{instance_mutex_};
+        if (instance_.load(memory_order_relaxed)) {
+            throw runtime_error{"async logger already exists"};
+        }
+        live_epoch_ = epoch_;
+        instance_.store(this, memory_order_release);
+    }
+    prev_logger_ = set_logger(async_logger);
+    thread_ = thread{[this]() {
+        auto fn = [this]() { run(); };
+        run_thread(fn, config_.thread);
+    }};
+}
+
+AsyncLogger::~AsyncLogger()
+{
+    set_logger(prev_logger_);
+    {
+        lock_guard<mutex> lock{instance_mutex_};
+        instance_.store(nullptr, memory_order_release);
+        live_epoch_ = 0;
+    }
+    {
+        Lock lock{mutex_};
+        stop_ = true;
+    }
+    cond_.notify_one();
+    thread_.join();
+    drain();
+    if (config_.file) {
+        config_.file->flush();
+    }
+}
+
+size_t AsyncLogger::dropped() const noexcept
+{
+    lock_guard<mutex> drain_lock{drain_mutex_};
+    return dropped_;
+}
+
+void AsyncLogger::write(int level, string_view msg) noexcept
+{
+    if (auto* const buf = prepare(level, nullptr, msg.size()); buf) {
+        memcpy(buf, msg.data(), msg.size());
+        commit(msg.size());
+    }
+}
+
+void AsyncLogger::flush()
+{
+    drain();
+}
+
+char* AsyncLogger::prepare(int level, const LogFormat* fmt, size_t size) noexcept
+{
+    const auto tsc = read_tsc();
+    Ring* r;
+    try {
+        r = ring();
+    } catch (...) {
+        return nullptr;
+    }
+    const auto buf = r->rb.reserve(record_size(size));
+    if (buffer_size(buf) < record_size(size)) {
+        r->dropped.fetch_add(1, memory_order_relaxed);
+        return nullptr;
+    }
+    auto* const p = buffer_cast<char*>(buf);
+    const Record rec{tsc, fmt, level, static_cast<uint32_t>(size)};
+    memcpy(p, &rec, sizeof(rec));
+    return p + sizeof(rec);
+}
+
+void AsyncLogger::commit(size_t size) noexcept
+{
+    thread_ring_.ring->rb.commit(record_size(size));
+}
+
+AsyncLogger::Ring* AsyncLogger::ring()
+{
+    auto& tr = thread_ring_;
+    if (tr.epoch == epoch_) {
+        return tr.ring;
+    }
+    auto r = make_unique<Ring>(config_.ring_size);
+    tr.ring = r.get();
+    tr.epoch = epoch_;
+    Lock lock{mutex_};
+    rings_.push_back(move(r));
+    return tr.ring;
+}
+
+void AsyncLogger::drain()
+{
+    struct Entry {
+        uint64_t tsc;
+        const Record* rec;
+        int tid;
+    };
+
+    lock_guard<mutex> drain_lock{drain_mutex_};
+
+    // Refine the estimate of the timestamp counter's frequency over the logger's lifetime, and map
+    // the current timestamp counter to wall-clock time.
+    const auto now_tsc = read_tsc();
+    const auto now_mono = MonoClock::now();
+    const auto now_wall = WallClock::now();
+    if (now_mono - base_mono_ >= Seconds{1}) {
+        ns_per_tick_ = static_cast<double>((now_mono - base_mono_).count())
+            / static_cast<double>(now_tsc - base_tsc_);
+    }
+
+    vector<pair<Ring*, size_t>> rings;
+    {
+        Lock lock{mutex_};
+        rings.reserve(rings_.size());
+        for (auto& r : rings_) {
+            rings.emplace_back(r.get(), 0);
+        }
+    }
+    vector<Entry> entries;
+    size_t dropped{0};
+    for (auto& [r, consumed] : rings) {
+        dropped += r->dropped.exchange(0, memory_order_relaxed);
+        const auto buf = r->rb.peek();
+        const auto* const begin = buffer_cast<const char*>(buf);
+        const auto* const end = begin + buffer_size(buf);
+        for (const auto* p = begin; p < end;) {
+            const auto* const rec = reinterpret_cast<const Record*>(p);
+            entries.push_back({rec->tsc, rec, r->tid});
+            p += record_size(rec->size);
+            consumed = p - begin;
+        }
+    }
+    // Merge the threads' messages. Each thread's messages are already in order.
+    stable_sort(entries.begin(), entries.end(),
+                [](const auto& lhs, const auto& rhs) { return lhs.tsc < rhs.tsc; });
+
+    char head[MaxLogHeader + 1];
+    for (const auto& e : entries) {
+        const auto delta = static_cast<double>(static_cast<int64_t>(e.tsc - now_tsc)) * ns_per_tick_;
+        const auto t = now_wall + Nanos{static_cast<int64_t>(delta)};
+        const string_view payload{reinterpret_cast<const char*>(e.rec + 1), e.rec->size};
+        if (config_.binary) {
+            uint32_t id{0};
+            if (e.rec->fmt) {
+                auto [it, inserted] = format_ids_.emplace(e.rec->fmt, format_ids_.size() + 1);
+                if (inserted) {
+                    put_log_format(batch_, it->second, *e.rec->fmt);
+                    if (config_.file) {
+                        put_log_format(file_header_, it->second, *e.rec->fmt);
+                        new_formats_ = true;
+                    }
+                }
+                id = it->second;
+            }
+            put_log_msg(batch_, t, e.rec->level, e.tid, id, payload);
+        } else {
+            batch_.append(head, format_log_header(head, t, e.rec->level, e.tid));
+            if (e.rec->fmt) {
+                format_log_args(batch_, e.rec->fmt->fmt, e.rec->fmt->types, payload);
+            } else {
+                batch_.append(payload.data(), payload.size());
+            }
+            batch_ += '\n';
+        }
+        if (batch_.size() >= BatchSize) {
+            write_batch();
+        }
+    }
+    if (dropped > 0) {
+        dropped_ += dropped;
+        const auto msg = "dropped " + to_string(dropped) + " log messages";
+        if (config_.binary) {
+            put_log_msg(batch_, now_wall, Log::Warning, thread_id(), 0, msg);
+        } else {
+            batch_.append(head, format_log_header(head, now_wall, Log::Warning, thread_id()));
+            batch_ += msg;
+            batch_ += '\n';
+        }
+    }
+    if (!batch_.empty()) {
+        write_batch();
+    }
+    if (config_.file) {
+        config_.file->poll();
+    }
+    for (auto& [r, consumed] : rings) {
+        r->rb.consume(consumed);
+    }
+
+    // Release the rings of threads that have exited.
+    Lock lock{mutex_};
+    rings_.erase(remove_if(rings_.begin(), rings_.end(),
+                           [](const auto& r) {
+                               return r->closed.load(memory_order_acquire) && r->rb.empty();
+                           }),
+                 rings_.end());
+}
+
+void AsyncLogger::write_batch() noexcept
+{
+    if (config_.file) {
+        config_.file->write(batch_);
+        if (new_formats_) {
+            // The batch defines the new formats in the current file, and the header defines them
+            // in any file opened by a later rotation.
+            try {
+                config_.file->set_header(file_header_);
+                new_formats_ = false;
+            } catch (...) {
+                // Best effort given that this is the logger.
+            }
+        }
+    } else {
+        write_all(config_.fd, batch_);
+    }
+    batch_.clear();
+}
+
+void AsyncLogger::run()
+{
+    for (;;) {
+        bool stop;
+        {
+            Lock lock{mutex_};
+            stop = cond_.wait_for(lock, config_.poll_interval, [this]() { return stop_; });
+        }
+        drain();
+        if (stop) {
+            break;
+        }
+    }
+}
+
+AsyncLogger* get_async_logger() noexcept
+{
+    return get_logger() == async_logger ? instance_.load(memory_order_acquire) : nullptr;
+}
+
+void async_logger(int level, string_view msg) noexcept
+{
+    auto* const logger = instance_.load(memory_order_acquire);
+    if (logger) {
+        logger->write(level, msg);
+    } else {
+        std_logger(level, msg);
+    }
+}
+
+} // namespace sys
+} // namespace toolbox
@@ -0,0 +1,151 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOOLBOX_SYS_ASYNCLOGGER_HPP
+#define TOOLBOX_SYS_ASYNCLOGGER_HPP
+
+#include <toolbox/sys/Log.hpp>
+#include <toolbox/sys/Thread.hpp>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <unistd.h>
+
+namespace toolbox {
+inline namespace sys {
+class LogFile;
+struct LogFormat;
+
+/// AsyncLoggerConfig holds the asynchronous logger attributes.
+struct AsyncLoggerConfig {
+    /// The size of each thread's ring buffer, which must be a power of two and a multiple of the
+    /// page size.
+    std::size_t ring_size{1 << 20};
+    /// The interval at which the background thread drains the ring buffers.
+    Duration poll_interval{Millis{1}};
+    /// The file descriptor that formatted messages are written to.
+    int fd{STDERR_FILENO};
+    /// Write messages in binary, rather than text, leaving TOOLBOX_LOGF() messages unformatted. The
+    /// output can be converted to text with LogDecoder.
+    bool binary{false};
+    /// The background thread's attributes.
+    ThreadConfig thread{"logger"};
+    /// Optional file that messages are written to, rather than fd. The file must outlive the
+    /// logger. In binary mode, each new file starts with the formats defined so far, so that each
+    /// rotated file can be decoded on its own.
+    LogFile* file{nullptr};
+};
+
+/// AsyncLogger moves formatting and I/O off the logging thread.
+///
+/// Each logging thread copies the level, a timestamp counter and the message bytes into its own
+/// lock-free SPSC ring buffer. A background thread drains the rings, orders the messages by time,
+/// formats the header and writes the messages in batches. Messages are dropped, rather than
+/// blocking the logging thread, if its ring is full.
+///
+/// Messages written with TOOLBOX_LOGF() are enqueued as their encoded arguments and a reference to
+/// the call site's format, so formatting is also deferred to the background thread, or to an
+/// offline decoder if the logger is configured to write binary.
+///
+/// Only one AsyncLogger may exist at a time. It installs itself as the logger on construction and
+/// restores the previous logger on destruction. It must outlive any concurrent logging.
+class TOOLBOX_API AsyncLogger {
+    using Lock = std::unique_lock<std::mutex>;
+
+  public:
+    struct Ring;
+
+    explicit AsyncLogger(AsyncLoggerConfig config = {});
+    ~AsyncLogger();
+
+    // Copy.
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    // Move.
+    AsyncLogger(AsyncLogger&&) = delete;
+    AsyncLogger& operator=(AsyncLogger&&) = delete;
+
+    /// Returns the number of messages dropped because a ring buffer was full.
+    std::size_t dropped() const noexcept;
+
+    /// Enqueue message on the calling thread's ring buffer.
+    void write(int level, std::string_view msg) noexcept;
+
+    /// Enqueue message on the calling thread's ring buffer. The function object encodes size bytes
+    /// of arguments, which are formatted later using the format.
+    template <typename FnT>
+    void write(int level, const LogFormat* fmt, std::size_t size, FnT fn) noexcept
+    {
+        if (auto* const buf = prepare(level, fmt, size); buf) {
+            fn(buf);
+            commit(size);
+        }
+    }
+
+    /// Synchronously write all enqueued messages.
+    void flush();
+
+  private:
+    char* prepare(int level, const LogFormat* fmt, std::size_t size) noexcept;
+    void commit(std::size_t size) noexcept;
+    Ring* ring();
+    void drain();
+    void write_batch() noexcept;
+    void run();
+
+    const AsyncLoggerConfig config_;
+    const std::uint64_t epoch_;
+    Logger prev_logger_{nullptr};
+
+    // Clock calibration.
+    std::uint64_t base_tsc_;
+    MonoTime base_mono_;
+    double ns_per_tick_{1};
+
+    mutable std::mutex mutex_;
+    std::condition_variable cond_;
+    std::vector<std::unique_ptr<Ring>> rings_;
+    bool stop_{false};
+
+    mutable std::mutex drain_mutex_;
+    std::size_t dropped_{0};
+    std::string batch_;
+    /// Binary format ids.
+    std::unordered_map<const LogFormat*, std::uint32_t> format_ids_;
+    /// The header of each new file in binary mode, which defines the formats used so far.
+    std::string file_header_;
+    bool new_formats_{false};
+    std::thread thread_;
+};
+
+/// Asynchronous logger. This logger enqueues messages to the current AsyncLogger, or calls
+/// std_logger() if there is none.
+TOOLBOX_API void async_logger(int level, std::string_view msg) noexcept;
+
+/// Returns the current AsyncLogger if async_logger() is the current logger, otherwise null.
+TOOLBOX_API AsyncLogger* get_async_logger() noexcept;
+
+} // namespace sys
+} // namespace toolbox
+
+#endif // TOOLBOX_SYS_ASYNCLOGGER_HPP
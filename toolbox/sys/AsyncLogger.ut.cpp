@@ -0,0 +1,91 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "AsyncLogger.hpp"
+
+#include <toolbox/util/TempDir.ut.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace toolbox;
+
+using test::TempFile;
+
+BOOST_AUTO_TEST_SUITE(AsyncLoggerSuite)
+
+BOOST_AUTO_TEST_CASE(AsyncLoggerWriteCase)
+{
+    TempFile tmp;
+    const auto prev = get_logger();
+    {
+        AsyncLogger logger{{1 << 16, Seconds{60}, tmp.fd(), false, {"logger"}}};
+        BOOST_TEST(get_logger() == async_logger);
+        BOOST_CHECK_THROW(AsyncLogger{}, runtime_error);
+
+        write_log(Log::Warning, "foo");
+        thread t{[]() {
+            for (int i{0}; i < 100; ++i) {
+                write_log(Log::Info, "bar" + to_string(i));
+            }
+        }};
+        t.join();
+        write_log(Log::Info, "baz");
+        logger.flush();
+
+        const auto v = tmp.lines();
+        BOOST_TEST_REQUIRE(v.size() >= 102U);
+        // Messages are ordered by time across threads.
+        vector<string> msgs;
+        for (const auto& line : v) {
+            const auto pos = line.find("]: ");
+            BOOST_TEST_REQUIRE(pos != string::npos);
+            msgs.push_back(line.substr(pos + 3));
+        }
+        const size_t i = find(msgs.begin(), msgs.end(), "foo") - msgs.begin();
+        BOOST_TEST_REQUIRE(i + 101 < msgs.size());
+        BOOST_TEST(msgs[i + 1] == "bar0");
+        BOOST_TEST(msgs[i + 100] == "bar99");
+        BOOST_TEST(msgs[i + 101] == "baz");
+        BOOST_TEST(v[i].find(" W ") != string::npos);
+        BOOST_TEST(logger.dropped() == 0U);
+    }
+    BOOST_TEST(get_logger() == prev);
+}
+
+BOOST_AUTO_TEST_CASE(AsyncLoggerDroppedCase)
+{
+    TempFile tmp;
+    constexpr int N = 100;
+    AsyncLogger logger{{PageSize, Seconds{60}, tmp.fd(), false, {"logger"}}};
+    const string msg(100, 'x');
+    for (int i{0}; i < N; ++i) {
+        logger.write(Log::Info, msg);
+    }
+    logger.flush();
+    const auto v = tmp.lines();
+    const auto n = count_if(v.begin(), v.end(), [&msg](const auto& line) {
+        return line.size() > msg.size() && line.compare(line.size() - msg.size(), msg.size(), msg) == 0;
+    });
+    BOOST_TEST(logger.dropped() > 0U);
+    BOOST_TEST(n + logger.dropped() == size_t{N});
+    BOOST_TEST(v.back().find("dropped " + to_string(logger.dropped())) != string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
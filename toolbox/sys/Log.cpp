@@ -16,10 +16,14 @@
 
 #include "Log.hpp"
 
+#include <toolbox/sys/Thread.hpp>
 #include <toolbox/sys/Time.hpp>
 #include <toolbox/io/Handle.hpp>
+#include <toolbox/util/Config.hpp>
 #include <algorithm> // max()
 #include <atomic>
+#include <charconv>
+#include <cstring>
 #include <mutex>
 
 #include <syslog.h>
@@ -29,10 +33,6 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 
-#if defined(__linux__)
-#include <sys/syscall.h>
-#endif
-
 namespace toolbox {
 inline namespace sys {
 using namespace std;
@@ -49,6 +49,7 @@ atomic<int> level_{
 #endif
 };
 atomic<Logger> logger_{std_logger};
+atomic<LogTimeFormat> time_format_{LogTimeFormat::Local};
 mutex mutex_;
 
 inline int acquire_level() noexcept
@@ -63,18 +64,37 @@ inline Logger acquire_logger() noexcept
 
 thread_local LogMsg log_msg_;
 
-// The gettid() function is a Linux-specific function call.
-#if defined(__linux__)
-inline pid_t gettid()
+/// HeaderCache holds the parts of the log header that rarely change between consecutive messages
+/// on the same thread.
+struct HeaderCache {
+    /// The format and minute of the cached timestamp prefix.
+    LogTimeFormat format{LogTimeFormat::Local};
+    int64_t min{-1};
+    char prefix[32];
+    size_t prefix_len{0};
+    /// The cached thread id suffix, for example: "[0123456789]: ". The suffix is keyed on the thread
+    /// id, so it is refreshed when the id changes after fork().
+    int tid{0};
+    char tid_str[16];
+    size_t tid_len{0};
+};
+
+thread_local HeaderCache header_cache_;
+
+inline char* put_digits(char* p, int64_t val, int n) noexcept
 {
-    return syscall(SYS_gettid);
+    for (int i{n - 1}; i >= 0; --i) {
+        p[i] = '0' + val % 10;
+        val /= 10;
+    }
+    return p + n;
 }
-#else
-inline pid_t gettid()
+
+inline char* put_str(char* p, const char* s, size_t n) noexcept
 {
-    return getpid();
+    memcpy(p, s, n);
+    return p + n;
 }
-#endif
 
 } // namespace
 
@@ -113,25 +133,103 @@ void null_logger(int level, string_view msg) noexcept {}
 int stdout_fd = STDOUT_FILENO;
 int stderr_fd = STDERR_FILENO;
 
-void std_logger(int level, string_view msg) noexcept
+LogTimeFormat get_log_time_format() noexcept
 {
-    const auto now = WallClock::now();
-    const auto t = WallClock::to_time_t(now);
-    const auto ms = ms_since_epoch(now);
+    return time_format_.load(memory_order_relaxed);
+}
 
-    struct tm tm;
-    localtime_r(&t, &tm);
+LogTimeFormat set_log_time_format(LogTimeFormat format) noexcept
+{
+    return time_format_.exchange(format, memory_order_relaxed);
+}
 
-    // The following format has an upper-bound of 42 characters:
-    // "%b %d %H:%M:%S.%03d %-7s [%d]: "
+void set_log_config(const Config& config)
+{
+    if (const auto* const val = config.get("log_time_format", nullptr); val) {
+        const string_view sv{val};
+        if (sv == "local") {
+            set_log_time_format(LogTimeFormat::Local);
+        } else if (sv == "iso8601") {
+            set_log_time_format(LogTimeFormat::Iso8601);
+        } else if (sv == "epoch_ns") {
+            set_log_time_format(LogTimeFormat::EpochNs);
+        } else {
+            throw runtime_error{"invalid log_time_format: "s + val};
+        }
+    }
+}
+
+size_t format_log_header(char* buf, WallTime now, int level, int tid) noexcept
+{
+    // The following formats have an upper-bound of 48 characters:
     //
-    // Example:
-    // Mar 14 00:00:00.000 WARNING [0123456789]: msg...
-    // <---------------------------------------->
-    char head[42 + 1];
-    size_t hlen = strftime(head, sizeof(head), "%b %d %H:%M:%S", &tm);
-    hlen += sprintf(head + hlen, ".%03d %-2s [%d]: ", static_cast<int>(ms % 1000), log_label(level),
-                    static_cast<int>(gettid()));
+    // Local:   "Mar 14 00:00:00.000 V10 [-0123456789]: "
+    // Iso8601: "2020-03-14T00:00:00.000000Z V10 [-0123456789]: "
+    // EpochNs: "1584144000000000000 V10 [-0123456789]: "
+    // <---------------------------------------------->
+    auto& cache = header_cache_;
+    const auto format = get_log_time_format();
+    const auto ns = ns_since_epoch(now);
+    char* p{buf};
+    if (format == LogTimeFormat::EpochNs) {
+        p = to_chars(p, p + 20, ns).ptr;
+    } else {
+        // The calendar prefix only changes once per minute, assuming a whole-minute UTC offset.
+        const auto sec = ns / 1'000'000'000;
+        const auto min = sec / 60;
+        if (min != cache.min || format != cache.format) {
+            const time_t t{min * 60};
+            struct tm tm;
+            if (format == LogTimeFormat::Local) {
+                localtime_r(&t, &tm);
+                cache.prefix_len
+                    = strftime(cache.prefix, sizeof(cache.prefix), "%b %d %H:%M:", &tm);
+            } else {
+                gmtime_r(&t, &tm);
+                cache.prefix_len
+                    = strftime(cache.prefix, sizeof(cache.prefix), "%Y-%m-%dT%H:%M:", &tm);
+            }
+            cache.format = format;
+            cache.min = min;
+        }
+        p = put_str(p, cache.prefix, cache.prefix_len);
+        p = put_digits(p, sec % 60, 2);
+        *p++ = '.';
+        if (format == LogTimeFormat::Local) {
+            p = put_digits(p, ns / 1'000'000 % 1000, 3);
+        } else {
+            p = put_digits(p, ns / 1'000 % 1'000'000, 6);
+            *p++ = 'Z';
+        }
+    }
+    *p++ = ' ';
+
+    // Labels are padded to two characters.
+    const auto* const label = log_label(level);
+    const auto label_len = strlen(label);
+    p = put_str(p, label, label_len);
+    if (label_len < 2) {
+        *p++ = ' ';
+    }
+    *p++ = ' ';
+
+    if (tid != cache.tid || cache.tid_len == 0) {
+        char* q{cache.tid_str};
+        *q++ = '[';
+        q = to_chars(q, q + 11, tid).ptr;
+        q = put_str(q, "]: ", 3);
+        cache.tid = tid;
+        cache.tid_len = q - cache.tid_str;
+    }
+    p = put_str(p, cache.tid_str, cache.tid_len);
+    *p = '\0';
+    return p - buf;
+}
+
+void std_logger(int level, string_view msg) noexcept
+{
+    char head[MaxLogHeader + 1];
+    const auto hlen = format_log_header(head, WallClock::now(), level, thread_id());
     char tail{'\n'};
     iovec iov[] = {
         {head, hlen},                                //
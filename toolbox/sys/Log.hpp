@@ -18,9 +18,13 @@
 #define TOOLBOX_SYS_LOG_HPP
 
 #include <toolbox/sys/Limits.hpp>
+#include <toolbox/sys/Time.hpp>
 #include <toolbox/util/Stream.hpp>
 
 namespace toolbox {
+inline namespace util {
+class Config;
+} // namespace util
 inline namespace sys {
 
 /// Logger callback function.
@@ -62,6 +66,43 @@ TOOLBOX_API void std_logger(int level, std::string_view msg) noexcept;
 
 TOOLBOX_API void std_logger_set_file(std::string_view file) noexcept;
 
+/// Maximum length of the header written by format_log_header().
+constexpr std::size_t MaxLogHeader{48};
+
+/// Timestamp format of the log header.
+enum class LogTimeFormat : int {
+    /// Local time with millisecond precision, for example: "Mar 14 00:00:00.000".
+    Local,
+    /// ISO-8601 UTC time with microsecond precision, for example: "2020-03-14T00:00:00.000000Z".
+    Iso8601,
+    /// Nanoseconds since epoch, for example: "1584144000000000000".
+    EpochNs
+};
+
+/// Return current log header timestamp format.
+TOOLBOX_API LogTimeFormat get_log_time_format() noexcept;
+
+/// Set log header timestamp format globally for all threads.
+TOOLBOX_API LogTimeFormat set_log_time_format(LogTimeFormat format) noexcept;
+
+/// Apply the logging options in config. The following options are supported:
+///  - log_time_format: "local" (default), "iso8601" or "epoch_ns".
+///
+/// \throw std::runtime_error if an option is invalid.
+TOOLBOX_API void set_log_config(const Config& config);
+
+/// Format the header used by std_logger, for example: "Mar 14 00:00:00.000 W [0123456789]: ".
+///
+/// The calendar part of the timestamp is cached per thread and only recomputed when the minute
+/// changes, so that the cost of localtime_r() is not paid for every message.
+///
+/// \param buf Output buffer of at least MaxLogHeader + 1 bytes.
+/// \param now The time of the log message.
+/// \param level The log level.
+/// \param tid The thread id.
+/// \return the header length.
+TOOLBOX_API std::size_t format_log_header(char* buf, WallTime now, int level, int tid) noexcept;
+
 /// System logger. This logger calls syslog().
 TOOLBOX_API void sys_logger(int level, std::string_view msg) noexcept;
 
@@ -16,11 +16,17 @@
 
 #include "Log.hpp"
 
+#include <toolbox/util/Config.hpp>
 #include <toolbox/util/Finally.hpp>
 
 #include <boost/test/unit_test.hpp>
 
 #include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#include <sys/wait.h>
 
 using namespace std;
 using namespace toolbox;
@@ -47,6 +53,12 @@ void test_logger(int level, string_view msg)
     last_msg.assign(msg.data(), msg.size());
 }
 
+string header(WallTime now, int level, int tid)
+{
+    char buf[MaxLogHeader + 1];
+    return {buf, format_log_header(buf, now, level, tid)};
+}
+
 } // namespace
 
 BOOST_AUTO_TEST_SUITE(LogSuite)
@@ -104,4 +116,68 @@ BOOST_AUTO_TEST_CASE(LogMacroCase)
     BOOST_TEST(last_msg == "test6: (10,20)");
 }
 
+BOOST_AUTO_TEST_CASE(LogHeaderCase)
+{
+    const auto prev_format = get_log_time_format();
+    const auto finally
+        = make_finally([prev_format]() noexcept { set_log_time_format(prev_format); });
+
+    // 2020-03-14T00:00:00Z.
+    const WallTime t{Nanos{1584144000123456789}};
+
+    set_log_time_format(LogTimeFormat::Local);
+    char expect[64];
+    const auto tt = WallClock::to_time_t(t);
+    struct tm tm;
+    localtime_r(&tt, &tm);
+    strftime(expect, sizeof(expect), "%b %d %H:%M:%S.123 W  [123]: ", &tm);
+    BOOST_TEST(header(t, Log::Warning, 123) == expect);
+
+    set_log_time_format(LogTimeFormat::Iso8601);
+    BOOST_TEST(header(t, Log::Warning, 123) == "2020-03-14T00:00:00.123456Z W  [123]: ");
+    // Seconds change within the cached minute.
+    BOOST_TEST(header(t + Seconds{59}, Log::Dump, 123)
+               == "2020-03-14T00:00:59.123456Z V10 [123]: ");
+    // Minute and thread change.
+    BOOST_TEST(header(t + Seconds{61}, Log::Info, -1) == "2020-03-14T00:01:01.123456Z I  [-1]: ");
+
+    set_log_time_format(LogTimeFormat::EpochNs);
+    BOOST_TEST(header(t, Log::Error, 123) == "1584144000123456789 E  [123]: ");
+
+    Config config;
+    config.read_section(istringstream{"log_time_format=iso8601\n"});
+    set_log_config(config);
+    BOOST_TEST((get_log_time_format() == LogTimeFormat::Iso8601));
+
+    config.clear();
+    config.read_section(istringstream{"log_time_format=foo\n"});
+    BOOST_CHECK_THROW(set_log_config(config), runtime_error);
+    BOOST_TEST((get_log_time_format() == LogTimeFormat::Iso8601));
+}
+
+BOOST_AUTO_TEST_CASE(LogForkCase)
+{
+    char path[] = "/tmp/tb-log-XXXXXX";
+    const auto fd = ::mkstemp(path);
+    BOOST_REQUIRE(fd >= 0);
+    ::close(fd);
+    const auto finally = make_finally([&path]() noexcept { ::unlink(path); });
+
+    // Cache the thread id before forking.
+    std_logger(Log::Info, "before fork");
+    const auto pid = ::fork();
+    BOOST_REQUIRE(pid >= 0);
+    if (pid == 0) {
+        // The child's only thread has the same id as the process.
+        std_logger_set_file(path);
+        std_logger(Log::Info, "child");
+        ::_exit(0);
+    }
+    int status;
+    BOOST_TEST(::waitpid(pid, &status, 0) == pid);
+    ifstream is{path};
+    const string text{istreambuf_iterator<char>{is}, istreambuf_iterator<char>{}};
+    BOOST_TEST(text.find("[" + to_string(pid) + "]: child\n") != string::npos);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
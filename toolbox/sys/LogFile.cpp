@@ -0,0 +1,284 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "LogFile.hpp"
+
+#include <toolbox/io/File.hpp>
+#include <toolbox/io/Runner.hpp>
+
+#include <cstdio> // rename()
+
+namespace toolbox {
+inline namespace sys {
+using namespace std;
+namespace {
+
+constexpr int OpenFlags{O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC};
+constexpr mode_t OpenMode{S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH};
+
+atomic<LogFile*> file_{nullptr};
+
+} // namespace
+
+LogFile::LogFile(LogFileConfig config)
+: config_{move(config)}
+, fh_{os::open(config_.path.c_str(), OpenFlags, OpenMode)}
+{
+    struct stat st;
+    os::fstat(fh_.get(), st);
+    size_ = st.st_size;
+    opened_ = flushed_ = MonoClock::now();
+    buf_.reserve(config_.batch_size + LogFileAlign);
+    // In synchronous mode, the thread only flushes the remainder after a burst of writes.
+    if (config_.async || config_.flush_interval > Duration::zero()) {
+        thread_ = thread{[this]() {
+            auto fn = [this]() { run(); };
+            run_thread(fn, config_.thread);
+        }};
+    }
+}
+
+LogFile::~LogFile()
+{
+    if (thread_.joinable()) {
+        {
+            Lock lock{mutex_};
+            stop_ = true;
+        }
+        cond_.notify_one();
+        thread_.join();
+    }
+    flush();
+}
+
+void LogFile::set_header(string header)
+{
+    Lock io_lock{io_mutex_};
+    header_ = move(header);
+    if (size_ == 0 && buf_.empty()) {
+        buf_ = header_;
+    }
+}
+
+void LogFile::write(string_view data) noexcept
+{
+    if (config_.async) {
+        bool notify;
+        {
+            Lock lock{mutex_};
+            if (front_.size() + data.size() > config_.max_buffer) {
+                dropped_.fetch_add(1, memory_order_relaxed);
+                return;
+            }
+            try {
+                front_.append(data.data(), data.size());
+                front_ends_.push_back(front_.size());
+            } catch (...) {
+                front_.resize(front_ends_.empty() ? 0 : front_ends_.back());
+                dropped_.fetch_add(1, memory_order_relaxed);
+                return;
+            }
+            notify = front_.size() >= config_.batch_size;
+        }
+        if (notify) {
+            cond_.notify_one();
+        }
+    } else {
+        const auto now = MonoClock::now();
+        Lock io_lock{io_mutex_};
+        drain(data, now - flushed_ >= config_.flush_interval, now);
+    }
+}
+
+void LogFile::flush() noexcept
+{
+    const auto now = MonoClock::now();
+    Lock io_lock{io_mutex_};
+    {
+        Lock lock{mutex_};
+        back_.swap(front_);
+        back_ends_.swap(front_ends_);
+    }
+    drain_back(true, now);
+}
+
+void LogFile::poll() noexcept
+{
+    const auto now = MonoClock::now();
+    Lock io_lock{io_mutex_};
+    if (now - flushed_ >= config_.flush_interval) {
+        drain({}, true, now);
+    }
+}
+
+void LogFile::drain(string_view data, bool force, MonoTime now) noexcept
+{
+    // Rotation and reopening happen between writes, so that each write is kept within one file.
+    const auto pending = size_ + buf_.size();
+    if (reopen_.exchange(false, memory_order_relaxed)) {
+        write_out(buf_.size());
+        open(false);
+    } else if (pending > 0
+               && ((config_.max_size > 0 && pending + data.size() > config_.max_size)
+                   || (config_.max_age > Duration::zero() && now - opened_ >= config_.max_age))) {
+        write_out(buf_.size());
+        open(true);
+        opened_ = now;
+    }
+    try {
+        buf_.append(data.data(), data.size());
+    } catch (...) {
+        dropped_.fetch_add(1, memory_order_relaxed);
+    }
+    if (force) {
+        write_out(buf_.size());
+        flushed_ = now;
+    } else if (buf_.size() >= config_.batch_size) {
+        // Write up to the last aligned offset within the file, and carry the remainder. A batch
+        // smaller than LogFileAlign may not reach the next aligned offset.
+        const auto end = size_ + buf_.size();
+        if (const auto aligned = end - end % LogFileAlign; aligned > size_) {
+            write_out(aligned - size_);
+        }
+    }
+}
+
+void LogFile::drain_back(bool force, MonoTime now) noexcept
+{
+    // Drain each write separately, so that the size limit is checked before each one.
+    size_t pos{0};
+    for (const auto end : back_ends_) {
+        drain({back_.data() + pos, end - pos}, false, now);
+        pos = end;
+    }
+    if (force) {
+        drain({}, true, now);
+    }
+    back_.clear();
+    back_ends_.clear();
+}
+
+void LogFile::write_out(size_t len) noexcept
+{
+    size_t n{0};
+    while (n < len) {
+        error_code ec;
+        const auto ret = os::write(fh_.get(), buf_.data() + n, len - n, ec);
+        if (ec) {
+            if (ec.value() == EINTR) {
+                continue;
+            }
+            // Best effort given that this is the logger; discard data that cannot be written,
+            // rather than allowing the buffer to grow without bound.
+            dropped_.fetch_add(1, memory_order_relaxed);
+            n = len;
+            break;
+        }
+        n += ret;
+        size_ += ret;
+    }
+    buf_.erase(0, n);
+}
+
+void LogFile::open(bool rotate) noexcept
+{
+    const auto& path = config_.path;
+    int flags{OpenFlags};
+    if (rotate) {
+        if (config_.max_files > 0) {
+            for (auto i = config_.max_files - 1; i > 0; --i) {
+                const auto from = path + '.' + to_string(i);
+                const auto to = path + '.' + to_string(i + 1);
+                ::rename(from.c_str(), to.c_str());
+            }
+            ::rename(path.c_str(), (path + ".1").c_str());
+        } else {
+            flags |= O_TRUNC;
+        }
+    }
+    // The new file replaces the old one only if it was opened successfully.
+    error_code ec;
+    auto fh = os::open(path.c_str(), flags, OpenMode, ec);
+    if (ec) {
+        return;
+    }
+    struct stat st;
+    os::fstat(fh.get(), st, ec);
+    fh_ = move(fh);
+    size_ = ec ? 0 : st.st_size;
+    if (size_ == 0) {
+        buf_.insert(0, header_);
+    }
+}
+
+void LogFile::run()
+{
+    for (;;) {
+        bool stop;
+        {
+            Lock lock{mutex_};
+            cond_.wait_for(lock, config_.flush_interval,
+                           [this]() { return stop_ || front_.size() >= config_.batch_size; });
+            stop = stop_;
+        }
+        const auto now = MonoClock::now();
+        Lock io_lock{io_mutex_};
+        {
+            Lock lock{mutex_};
+            back_.swap(front_);
+            back_ends_.swap(front_ends_);
+        }
+        drain_back(now - flushed_ >= config_.flush_interval, now);
+        if (stop) {
+            break;
+        }
+    }
+}
+
+LogFile* set_log_file(LogFile* file) noexcept
+{
+    return file_.exchange(file, memory_order_acq_rel);
+}
+
+void reopen_log_file() noexcept
+{
+    auto* const file = file_.load(memory_order_acquire);
+    if (file) {
+        file->reopen();
+    }
+}
+
+void file_logger(int level, string_view msg) noexcept
+{
+    auto* const file = file_.load(memory_order_acquire);
+    if (!file) {
+        std_logger(level, msg);
+        return;
+    }
+    thread_local string buf;
+    try {
+        char head[MaxLogHeader + 1];
+        buf.assign(head, format_log_header(head, WallClock::now(), level, thread_id()));
+        buf.append(msg.data(), msg.size());
+        buf += '\n';
+        file->write(buf);
+    } catch (...) {
+        // Best effort given that this is the logger.
+    }
+}
+
+} // namespace sys
+} // namespace toolbox
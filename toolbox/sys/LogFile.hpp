@@ -0,0 +1,159 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOOLBOX_SYS_LOGFILE_HPP
+#define TOOLBOX_SYS_LOGFILE_HPP
+
+#include <toolbox/io/Handle.hpp>
+#include <toolbox/sys/Log.hpp>
+#include <toolbox/sys/Thread.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace toolbox {
+inline namespace sys {
+
+/// Log file writes are aligned to this boundary, so that whole pages are written.
+constexpr std::size_t LogFileAlign{4096};
+
+/// LogFileConfig holds the log file attributes.
+struct LogFileConfig {
+    /// The path of the current log file.
+    std::string path;
+    /// Rotate before the file exceeds this size. Zero disables size-based rotation.
+    std::size_t max_size{0};
+    /// Rotate once the file has been open for this long. Zero disables time-based rotation.
+    Duration max_age{};
+    /// The number of rotated files to keep, named "path.1" to "path.N", where "path.1" is the most
+    /// recent. If zero, the file is truncated on rotation.
+    int max_files{10};
+    /// Buffered data is written in aligned chunks once it reaches this size.
+    std::size_t batch_size{1 << 16};
+    /// Buffered data is written at least this often, even if there are no further writes. If zero,
+    /// each write is written immediately and no I/O thread is started in synchronous mode.
+    Duration flush_interval{Millis{100}};
+    /// Write from a dedicated I/O thread, so that writers never block on the file.
+    bool async{false};
+    /// The maximum amount of data buffered by an asynchronous log file, beyond which writes are
+    /// dropped.
+    std::size_t max_buffer{1 << 24};
+    /// The I/O thread's attributes.
+    ThreadConfig thread{"log-file"};
+};
+
+/// LogFile is a size-bounded log file sink that rotates by size or age.
+///
+/// Writes are buffered and issued in batches of at least LogFileConfig::batch_size bytes, which end
+/// on a LogFileAlign boundary within the file, so that whole pages are written. The remainder is
+/// carried over to the next batch, or written when the flush interval elapses. Each write() is
+/// kept within a single file, so that rotation never splits a message, and the size limit is
+/// checked before each write() in both synchronous and asynchronous modes.
+///
+/// By default, writes are performed on the calling thread, and a dedicated I/O thread only writes
+/// the remainder when the flush interval elapses. If LogFileConfig::async is set, the calling
+/// thread only copies the data into a buffer, and the I/O thread writes all of it.
+///
+/// All member functions are thread-safe.
+class TOOLBOX_API LogFile {
+    using Lock = std::unique_lock<std::mutex>;
+
+  public:
+    /// \throw std::system_error if the file cannot be opened.
+    explicit LogFile(LogFileConfig config);
+    ~LogFile();
+
+    // Copy.
+    LogFile(const LogFile&) = delete;
+    LogFile& operator=(const LogFile&) = delete;
+
+    // Move.
+    LogFile(LogFile&&) = delete;
+    LogFile& operator=(LogFile&&) = delete;
+
+    const std::string& path() const noexcept { return config_.path; }
+    /// Returns the number of writes dropped because the buffer was full or the file could not be
+    /// written.
+    std::size_t dropped() const noexcept { return dropped_.load(std::memory_order_relaxed); }
+
+    /// Set data written at the start of each new file, such as a binary log header.
+    void set_header(std::string header);
+
+    /// Append data to the file.
+    void write(std::string_view data) noexcept;
+
+    /// Synchronously write all buffered data.
+    void flush() noexcept;
+
+    /// Write buffered data if the flush interval has elapsed.
+    void poll() noexcept;
+
+    /// Request that the file is reopened before the next write. This is typically called on
+    /// SIGHUP, after an external tool has moved the file away, and is called for the current file
+    /// by wait_termination_signal(). The new file replaces the old one between writes, so no data
+    /// is lost or split. This function is async-signal-safe.
+    void reopen() noexcept { reopen_.store(true, std::memory_order_relaxed); }
+
+  private:
+    void drain(std::string_view data, bool force, MonoTime now) noexcept;
+    void drain_back(bool force, MonoTime now) noexcept;
+    void write_out(std::size_t len) noexcept;
+    void open(bool rotate) noexcept;
+    void run();
+
+    const LogFileConfig config_;
+    std::atomic<bool> reopen_{false};
+    std::atomic<std::size_t> dropped_{0};
+
+    // Producer state in async mode.
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::string front_;
+    /// The end offset of each write() in front_.
+    std::vector<std::size_t> front_ends_;
+    bool stop_{false};
+
+    // File state.
+    std::mutex io_mutex_;
+    FileHandle fh_;
+    std::string header_;
+    std::string buf_, back_;
+    std::vector<std::size_t> back_ends_;
+    /// The size of the file, excluding buffered data.
+    std::size_t size_{0};
+    MonoTime opened_{};
+    MonoTime flushed_{};
+    std::thread thread_;
+};
+
+/// Set the LogFile used by file_logger(). The file must outlive any concurrent logging.
+TOOLBOX_API LogFile* set_log_file(LogFile* file) noexcept;
+
+/// Request that the LogFile used by file_logger() is reopened. This function is async-signal-safe.
+TOOLBOX_API void reopen_log_file() noexcept;
+
+/// File logger. This logger formats messages in the same way as std_logger() and writes them to the
+/// current LogFile, or calls std_logger() if there is none.
+TOOLBOX_API void file_logger(int level, std::string_view msg) noexcept;
+
+} // namespace sys
+} // namespace toolbox
+
+#endif // TOOLBOX_SYS_LOGFILE_HPP
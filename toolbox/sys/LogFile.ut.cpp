@@ -0,0 +1,236 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "LogFile.hpp"
+
+#include <toolbox/io/Runner.hpp>
+#include <toolbox/sys/LogFormat.hpp>
+#include <toolbox/util/TempDir.ut.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+
+using namespace std;
+using namespace toolbox;
+
+namespace {
+
+/// Adds the names of the current and rotated log files to the shared fixture.
+struct LogDir : test::TempDir {
+    /// Returns the name of the current log file if n is zero, otherwise the nth rotated file.
+    static string name(int n) { return "test.log" + (n > 0 ? '.' + to_string(n) : string{}); }
+    string file(int n = 0) const { return path(name(n)); }
+    string read(int n = 0) const { return TempDir::read(name(n)); }
+    bool exists(int n = 0) const { return TempDir::exists(name(n)); }
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(LogFileSuite)
+
+BOOST_AUTO_TEST_CASE(LogFileBatchCase)
+{
+    LogDir tmp;
+    LogFile file{{tmp.file(), 0, {}, 10, 1 << 16, Seconds{60}}};
+    const string line(99, 'x');
+    for (int i{0}; i < 1000; ++i) {
+        file.write(line + '\n');
+    }
+    // Only whole pages have been written so far.
+    const auto size = tmp.read().size();
+    BOOST_TEST(size > 0U);
+    BOOST_TEST(size % LogFileAlign == 0U);
+    file.flush();
+    BOOST_TEST(tmp.read().size() == 100000U);
+    BOOST_TEST(file.dropped() == 0U);
+}
+
+BOOST_AUTO_TEST_CASE(LogFileSmallBatchCase)
+{
+    LogDir tmp;
+    LogFile file{{tmp.file(), 0, {}, 10, 8, Seconds{60}}};
+    // Leave the file size unaligned.
+    file.write(string(99, 'x') + '\n');
+    file.flush();
+    // Each batch is full, but ends before the next aligned offset, so nothing is written.
+    for (int i{0}; i < 10; ++i) {
+        file.write("123456789\n");
+    }
+    BOOST_TEST(tmp.read().size() == 100U);
+    // Writes resume once the next aligned offset is reached.
+    const string line(99, 'y');
+    for (int i{0}; i < 50; ++i) {
+        file.write(line + '\n');
+    }
+    BOOST_TEST(tmp.read().size() == LogFileAlign);
+    file.flush();
+    BOOST_TEST(tmp.read().size() == 5200U);
+    BOOST_TEST(file.dropped() == 0U);
+}
+
+BOOST_AUTO_TEST_CASE(LogFileIntervalCase)
+{
+    using namespace literals::chrono_literals;
+
+    LogDir tmp;
+    LogFile file{{tmp.file(), 0, {}, 10, 1 << 16, Millis{50}}};
+    file.write("foo\n");
+
+    // The buffered write is written once the interval elapses, without further writes.
+    for (int i{0}; i < 1000 && tmp.read().empty(); ++i) {
+        this_thread::sleep_for(1ms);
+    }
+    BOOST_TEST(tmp.read() == "foo\n");
+}
+
+BOOST_AUTO_TEST_CASE(LogFileRotateCase)
+{
+    LogDir tmp;
+    {
+        LogFile file{{tmp.file(), 1000, {}, 2, 1 << 16, Seconds{60}}};
+        file.set_header("header\n");
+        for (int i{0}; i < 40; ++i) {
+            file.write(string(99, 'a' + i / 10) + '\n');
+            file.flush();
+        }
+    }
+    // Each file holds whole lines, is bounded, and starts with the header.
+    for (int i{0}; i <= 2; ++i) {
+        const auto text = tmp.read(i);
+        BOOST_TEST(text.size() <= 1000U);
+        BOOST_TEST(text.compare(0, 7, "header\n") == 0);
+        BOOST_TEST((text.size() - 7) % 100 == 0U);
+    }
+    BOOST_TEST(!tmp.exists(3));
+    BOOST_TEST(tmp.read(0).back() == '\n');
+    BOOST_TEST(tmp.read(0).find('d') != string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(LogFileReopenCase)
+{
+    LogDir tmp;
+    LogFile file{{tmp.file(), 0, {}, 10, 1 << 16, Seconds{60}}};
+    file.write("foo\n");
+    file.flush();
+    ::rename(tmp.file().c_str(), tmp.file(1).c_str());
+
+    // Writes continue to the moved file until the file is reopened.
+    file.write("bar\n");
+    file.reopen();
+    file.write("baz\n");
+    file.flush();
+    BOOST_TEST(tmp.read(1) == "foo\nbar\n");
+    BOOST_TEST(tmp.read() == "baz\n");
+}
+
+BOOST_AUTO_TEST_CASE(LogFileSignalCase)
+{
+    LogDir tmp;
+    LogFile file{{tmp.file(), 0, {}, 10, 1 << 16, Seconds{60}}};
+    auto* const prev = set_log_file(&file);
+    file.write("foo\n");
+    file.flush();
+    ::rename(tmp.file().c_str(), tmp.file(1).c_str());
+
+    // The signals remain pending until the thread waits for them.
+    sigset_t mask, old_mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGHUP);
+    sigaddset(&mask, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &mask, &old_mask);
+    thread t{wait_termination_signal};
+    pthread_kill(t.native_handle(), SIGHUP);
+    pthread_kill(t.native_handle(), SIGTERM);
+    t.join();
+    pthread_sigmask(SIG_SETMASK, &old_mask, nullptr);
+    set_log_file(prev);
+
+    file.write("bar\n");
+    file.flush();
+    BOOST_TEST(tmp.read(1) == "foo\n");
+    BOOST_TEST(tmp.read() == "bar\n");
+}
+
+BOOST_AUTO_TEST_CASE(LogFileAsyncCase)
+{
+    LogDir tmp;
+    {
+        LogFile file{{tmp.file(), 0, {}, 10, 1 << 16, Millis{1}, true}};
+        auto* const prev = set_log_file(&file);
+        const auto prev_logger = set_logger(file_logger);
+        for (int i{0}; i < 100; ++i) {
+            write_log(Log::Warning, "foo" + to_string(i));
+        }
+        set_logger(prev_logger);
+        set_log_file(prev);
+    }
+    const auto text = tmp.read();
+    BOOST_TEST(text.find(" W ") != string::npos);
+    BOOST_TEST(text.find("]: foo0\n") != string::npos);
+    BOOST_TEST(text.find("]: foo99\n") != string::npos);
+    BOOST_TEST(text.find("]: foo99\n") + 9 == text.size());
+}
+
+BOOST_AUTO_TEST_CASE(LogFileAsyncRotateCase)
+{
+    LogDir tmp;
+    {
+        // The writes are drained together when the file is destroyed.
+        LogFile file{{tmp.file(), 1000, {}, 10, 1 << 16, Seconds{60}, true}};
+        for (int i{0}; i < 40; ++i) {
+            file.write(string(99, 'a' + i / 10) + '\n');
+        }
+    }
+    // The size limit is checked before each write.
+    BOOST_TEST(tmp.exists(3));
+    for (int i{0}; i <= 3; ++i) {
+        const auto text = tmp.read(i);
+        BOOST_TEST(text.size() <= 1000U);
+        BOOST_TEST(text.size() % 100 == 0U);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(LogFileAsyncLoggerCase)
+{
+    LogDir tmp;
+    {
+        LogFile file{{tmp.file(), 1 << 12, {}, 10, 1 << 16, Seconds{60}}};
+        AsyncLogger logger{{1 << 16, Seconds{60}, -1, true, {"logger"}, &file}};
+        for (int i{0}; i < 200; ++i) {
+            TOOLBOX_LOGF(Log::Warning, "foo {}", i);
+            if (i % 10 == 9) {
+                logger.flush();
+            }
+        }
+    }
+    // Each rotated file can be decoded on its own, and defines the format once.
+    BOOST_TEST(tmp.exists(1));
+    string out;
+    for (int i{10}; i >= 0; --i) {
+        if (tmp.exists(i)) {
+            const auto bin = tmp.read(i);
+            BOOST_TEST(LogDecoder{}.decode(bin, out) == bin.size());
+            const auto pos = bin.find("foo {}");
+            BOOST_TEST(pos != string::npos);
+            BOOST_TEST(bin.find("foo {}", pos + 1) == string::npos);
+        }
+    }
+    BOOST_TEST(out.find("]: foo 0\n") != string::npos);
+    BOOST_TEST(out.find("]: foo 199\n") != string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
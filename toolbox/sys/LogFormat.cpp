@@ -0,0 +1,281 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "LogFormat.hpp"
+
+#include <charconv>
+
+namespace toolbox {
+inline namespace sys {
+using namespace std;
+namespace {
+
+constexpr string_view LogMagic{"TBLOG"};
+constexpr uint32_t LogVersion{2};
+
+template <typename ValueT>
+bool get(string_view& buf, ValueT& val) noexcept
+{
+    if (buf.size() < sizeof(val)) {
+        return false;
+    }
+    memcpy(&val, buf.data(), sizeof(val));
+    buf.remove_prefix(sizeof(val));
+    return true;
+}
+
+template <typename LenT>
+bool get_str(string_view& buf, string_view& val) noexcept
+{
+    LenT len;
+    if (!get(buf, len) || buf.size() < len) {
+        return false;
+    }
+    val = buf.substr(0, len);
+    buf.remove_prefix(len);
+    return true;
+}
+
+template <typename ValueT>
+void put(string& out, ValueT val)
+{
+    out.append(reinterpret_cast<const char*>(&val), sizeof(val));
+}
+
+void put_str(string& out, string_view val)
+{
+    put(out, static_cast<uint32_t>(val.size()));
+    out.append(val.data(), val.size());
+}
+
+template <typename ValueT>
+bool format_int(string& out, string_view& buf) noexcept
+{
+    ValueT val;
+    if (!get(buf, val)) {
+        return false;
+    }
+    char tmp[24];
+    const auto [end, ec] = to_chars(tmp, tmp + sizeof(tmp), val);
+    out.append(tmp, end);
+    return true;
+}
+
+template <typename ValueT>
+bool format_float(string& out, string_view& buf) noexcept
+{
+    ValueT val;
+    if (!get(buf, val)) {
+        return false;
+    }
+    // Same as the default ostream format.
+    char tmp[32];
+    out.append(tmp, snprintf(tmp, sizeof(tmp), "%g", static_cast<double>(val)));
+    return true;
+}
+
+bool format_arg(string& out, char type, string_view& buf)
+{
+    switch (type) {
+    case '?': {
+        bool val;
+        if (!get(buf, val)) {
+            return false;
+        }
+        out += val ? '1' : '0';
+        return true;
+    }
+    case 'c': {
+        char val;
+        if (!get(buf, val)) {
+            return false;
+        }
+        out += val;
+        return true;
+    }
+    case 'h':
+        return format_int<int16_t>(out, buf);
+    case 'H':
+        return format_int<uint16_t>(out, buf);
+    case 'i':
+        return format_int<int32_t>(out, buf);
+    case 'I':
+        return format_int<uint32_t>(out, buf);
+    case 'q':
+        return format_int<int64_t>(out, buf);
+    case 'Q':
+        return format_int<uint64_t>(out, buf);
+    case 'f':
+        return format_float<float>(out, buf);
+    case 'd':
+        return format_float<double>(out, buf);
+    case 's': {
+        string_view val;
+        if (!get_str<uint32_t>(buf, val)) {
+            return false;
+        }
+        out.append(val.data(), val.size());
+        return true;
+    }
+    }
+    return false;
+}
+
+} // namespace
+
+bool format_log_args(string& out, string_view fmt, string_view types, string_view args)
+{
+    size_t n{0};
+    for (size_t i{0}; i < fmt.size(); ++i) {
+        const auto c = fmt[i];
+        if (i + 1 < fmt.size()) {
+            if (c == '{' && fmt[i + 1] == '}') {
+                if (n >= types.size() || !format_arg(out, types[n++], args)) {
+                    return false;
+                }
+                ++i;
+                continue;
+            }
+            if ((c == '{' || c == '}') && fmt[i + 1] == c) {
+                ++i;
+            }
+        }
+        out += c;
+    }
+    return n == types.size() && args.empty();
+}
+
+void write_log_args(int level, const LogFormat& fmt, string_view args) noexcept
+{
+    thread_local string buf;
+    try {
+        buf.clear();
+        format_log_args(buf, fmt.fmt, fmt.types, args);
+        write_log(level, buf);
+    } catch (...) {
+        // Best effort given that this is the logger.
+    }
+}
+
+void put_log_header(string& out)
+{
+    put(out, static_cast<uint32_t>(1 + LogMagic.size() + sizeof(LogVersion)));
+    out += LogFrameHeader;
+    out.append(LogMagic.data(), LogMagic.size());
+    put(out, LogVersion);
+}
+
+void put_log_format(string& out, uint32_t id, const LogFormat& fmt)
+{
+    const auto file = fmt.file ? string_view{fmt.file} : string_view{};
+    const auto size = 1 + sizeof(id) + sizeof(int32_t) + 3 * sizeof(uint32_t) + file.size()
+        + fmt.fmt.size() + fmt.types.size();
+    put(out, static_cast<uint32_t>(size));
+    out += LogFrameFormat;
+    put(out, id);
+    put(out, static_cast<int32_t>(fmt.line));
+    put_str(out, file);
+    put_str(out, fmt.fmt);
+    put_str(out, fmt.types);
+}
+
+void put_log_msg(string& out, WallTime t, int level, int tid, uint32_t id, string_view payload)
+{
+    const auto size = 1 + sizeof(int64_t) + 2 * sizeof(int32_t) + sizeof(id) + payload.size();
+    put(out, static_cast<uint32_t>(size));
+    out += LogFrameMsg;
+    put(out, static_cast<int64_t>(ns_since_epoch(t)));
+    put(out, static_cast<int32_t>(level));
+    put(out, static_cast<int32_t>(tid));
+    put(out, id);
+    out.append(payload.data(), payload.size());
+}
+
+LogDecoder::LogDecoder() = default;
+LogDecoder::~LogDecoder() = default;
+
+// Move.
+LogDecoder::LogDecoder(LogDecoder&&) = default;
+LogDecoder& LogDecoder::operator=(LogDecoder&&) = default;
+
+size_t LogDecoder::decode(string_view buf, string& out)
+{
+    const auto* const begin = buf.data();
+    for (;;) {
+        auto frame = buf;
+        uint32_t size;
+        if (!get(frame, size) || frame.size() < size) {
+            break;
+        }
+        frame = frame.substr(0, size);
+        buf.remove_prefix(sizeof(size) + size);
+
+        char kind;
+        if (!get(frame, kind)) {
+            throw runtime_error{"invalid log frame"};
+        }
+        if (kind == LogFrameHeader) {
+            uint32_t version;
+            if (frame.substr(0, LogMagic.size()) != LogMagic
+                || (frame.remove_prefix(LogMagic.size()), !get(frame, version))
+                || version != LogVersion) {
+                throw runtime_error{"invalid log header"};
+            }
+            // Format ids are scoped to a logging session.
+            formats_.clear();
+            header_ = true;
+            continue;
+        }
+        if (!header_) {
+            throw runtime_error{"missing log header"};
+        }
+        if (kind == LogFrameFormat) {
+            uint32_t id;
+            int32_t line;
+            string_view file, fmt, types;
+            if (!get(frame, id) || !get(frame, line) || !get_str<uint32_t>(frame, file)
+                || !get_str<uint32_t>(frame, fmt) || !get_str<uint32_t>(frame, types)) {
+                throw runtime_error{"invalid log format"};
+            }
+            formats_[id] = {string{fmt}, string{types}};
+        } else if (kind == LogFrameMsg) {
+            int64_t ns;
+            int32_t level, tid;
+            uint32_t id;
+            if (!get(frame, ns) || !get(frame, level) || !get(frame, tid) || !get(frame, id)) {
+                throw runtime_error{"invalid log message"};
+            }
+            char head[MaxLogHeader + 1];
+            out.append(head, format_log_header(head, WallTime{Nanos{ns}}, level, tid));
+            if (id == 0) {
+                out.append(frame.data(), frame.size());
+            } else {
+                const auto it = formats_.find(id);
+                if (it == formats_.end()
+                    || !format_log_args(out, it->second.fmt, it->second.types, frame)) {
+                    throw runtime_error{"invalid log message"};
+                }
+            }
+            out += '\n';
+        } else {
+            throw runtime_error{"invalid log frame"};
+        }
+    }
+    return buf.data() - begin;
+}
+
+} // namespace sys
+} // namespace toolbox
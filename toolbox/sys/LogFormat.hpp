@@ -0,0 +1,283 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOOLBOX_SYS_LOGFORMAT_HPP
+#define TOOLBOX_SYS_LOGFORMAT_HPP
+
+#include <toolbox/sys/AsyncLogger.hpp>
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+
+namespace toolbox {
+inline namespace sys {
+
+/// LogSite holds the format string and source location of a TOOLBOX_LOGF() call.
+struct LogSite {
+    std::string_view fmt;
+    const char* file;
+    int line;
+};
+
+/// LogFormat describes a TOOLBOX_LOGF() call site. There is one constant instance per call site,
+/// so its address identifies the format within a process.
+struct LogFormat {
+    /// The format string, in which each "{}" is replaced by the next argument.
+    std::string_view fmt;
+    /// The argument type codes, one per argument.
+    std::string_view types;
+    const char* file;
+    int line;
+};
+
+/// Returns the number of "{}" placeholders in the format string. The sequences "{{" and "}}" are
+/// escapes for literal braces.
+constexpr std::size_t log_placeholders(std::string_view fmt) noexcept
+{
+    std::size_t n{0};
+    for (std::size_t i{0}; i + 1 < fmt.size(); ++i) {
+        if (fmt[i] == '{' && fmt[i + 1] == '}') {
+            ++n;
+            ++i;
+        } else if ((fmt[i] == '{' && fmt[i + 1] == '{') || (fmt[i] == '}' && fmt[i + 1] == '}')) {
+            ++i;
+        }
+    }
+    return n;
+}
+
+/// Returns the type code of an arithmetic argument. Character types, including int8_t and uint8_t,
+/// which are aliases of signed and unsigned char, are formatted as characters, as they are by
+/// operator<<().
+template <typename ValueT>
+constexpr char log_arg_code() noexcept
+{
+    static_assert(sizeof(ValueT) <= 8, "unsupported log argument type");
+    constexpr auto Size = sizeof(ValueT);
+    if constexpr (std::is_same_v<ValueT, bool>) {
+        return '?';
+    } else if constexpr (std::is_same_v<ValueT, char> || std::is_same_v<ValueT, signed char>
+                         || std::is_same_v<ValueT, unsigned char>) {
+        return 'c';
+    } else if constexpr (std::is_floating_point_v<ValueT>) {
+        return Size == 4 ? 'f' : 'd';
+    } else if constexpr (std::is_signed_v<ValueT>) {
+        return Size == 2 ? 'h' : Size == 4 ? 'i' : 'q';
+    } else {
+        return Size == 2 ? 'H' : Size == 4 ? 'I' : 'Q';
+    }
+}
+
+/// LogArgTraits encodes a TOOLBOX_LOGF() argument. The primary template is not defined, so that
+/// unsupported argument types fail to compile.
+template <typename ValueT, typename EnableT = void>
+struct LogArgTraits;
+
+/// Arithmetic types are copied as is.
+template <typename ValueT>
+struct LogArgTraits<ValueT, std::enable_if_t<std::is_arithmetic_v<ValueT>>> {
+    static constexpr char Code{log_arg_code<ValueT>()};
+    static constexpr std::size_t size(ValueT val) noexcept { return sizeof(val); }
+    static char* encode(char* buf, ValueT val) noexcept
+    {
+        std::memcpy(buf, &val, sizeof(val));
+        return buf + sizeof(val);
+    }
+};
+
+/// Enums are copied as their underlying type.
+template <typename ValueT>
+struct LogArgTraits<ValueT, std::enable_if_t<std::is_enum_v<ValueT>>> {
+    using UnderlyingTraits = LogArgTraits<std::underlying_type_t<ValueT>>;
+    static constexpr char Code{UnderlyingTraits::Code};
+    static constexpr std::size_t size(ValueT val) noexcept { return sizeof(val); }
+    static char* encode(char* buf, ValueT val) noexcept
+    {
+        return UnderlyingTraits::encode(buf, static_cast<std::underlying_type_t<ValueT>>(val));
+    }
+};
+
+/// Strings are copied with a 32-bit length prefix.
+template <typename ValueT>
+struct LogArgTraits<ValueT, std::enable_if_t<std::is_convertible_v<const ValueT&, std::string_view>>> {
+    static constexpr char Code{'s'};
+    static std::string_view view(const ValueT& val) noexcept
+    {
+        if constexpr (std::is_pointer_v<ValueT>) {
+            return val ? std::string_view{val} : std::string_view{};
+        } else {
+            return val;
+        }
+    }
+    static std::size_t size(const ValueT& val) noexcept
+    {
+        return sizeof(std::uint32_t) + view(val).size();
+    }
+    static char* encode(char* buf, const ValueT& val) noexcept
+    {
+        const auto sv = view(val);
+        const auto len = static_cast<std::uint32_t>(sv.size());
+        std::memcpy(buf, &len, sizeof(len));
+        std::memcpy(buf + sizeof(len), sv.data(), len);
+        return buf + sizeof(len) + len;
+    }
+};
+
+/// The encoded type of an argument, where arrays decay to pointers to const.
+template <typename ValueT>
+using LogArgT = std::decay_t<const ValueT&>;
+
+/// The argument type codes of a TOOLBOX_LOGF() call site.
+template <typename... ArgsT>
+struct LogArgTypes {
+    static constexpr char Value[] = {LogArgTraits<ArgsT>::Code..., '\0'};
+};
+
+/// Returns the encoded size of the arguments.
+template <typename... ArgsT, typename... ValuesT>
+std::size_t log_args_size(const ValuesT&... vals) noexcept
+{
+    return (std::size_t{0} + ... + LogArgTraits<ArgsT>::size(vals));
+}
+
+/// Encode the arguments into buf, which must have room for log_args_size() bytes.
+template <typename... ArgsT, typename... ValuesT>
+char* encode_log_args(char* buf, const ValuesT&... vals) noexcept
+{
+    ((buf = LogArgTraits<ArgsT>::encode(buf, vals)), ...);
+    return buf;
+}
+
+/// Append the formatted arguments to out.
+///
+/// \param out The output string.
+/// \param fmt The format string.
+/// \param types The argument type codes.
+/// \param args The encoded arguments.
+/// \return false if the encoded arguments are malformed.
+TOOLBOX_API bool format_log_args(std::string& out, std::string_view fmt, std::string_view types,
+                                 std::string_view args);
+
+/// Format the encoded arguments and write the message to the current logger.
+TOOLBOX_API void write_log_args(int level, const LogFormat& fmt, std::string_view args) noexcept;
+
+/// Write log message with deferred formatting. The function object encodes size bytes of
+/// arguments.
+template <typename FnT>
+void write_logf(int level, const LogFormat& fmt, std::size_t size, FnT fn) noexcept
+{
+    if (auto* const logger = get_async_logger(); logger) {
+        logger->write(level, &fmt, size, fn);
+    } else {
+        // Format synchronously when the asynchronous logger is not installed.
+        char buf[MaxMsgSize];
+        if (size <= sizeof(buf)) {
+            fn(buf);
+            write_log_args(level, fmt, {buf, size});
+        } else if (std::unique_ptr<char[]> ptr{new (std::nothrow) char[size]}; ptr) {
+            fn(ptr.get());
+            write_log_args(level, fmt, {ptr.get(), size});
+        }
+    }
+}
+
+/// Write log message with deferred formatting. The call site's format is a constant that is
+/// initialised at compile time, so that only the arguments are encoded at runtime.
+template <typename SiteT, typename... ArgsT>
+void write_logf(SiteT site, int level, const ArgsT&... args) noexcept
+{
+    static_assert(log_placeholders(site().fmt) == sizeof...(ArgsT),
+                  "number of placeholders does not match number of arguments");
+    static constexpr LogFormat Format{site().fmt, LogArgTypes<LogArgT<ArgsT>...>::Value,
+                                      site().file, site().line};
+    write_logf(level, Format, log_args_size<LogArgT<ArgsT>...>(args...),
+               [&](char* buf) noexcept { encode_log_args<LogArgT<ArgsT>...>(buf, args...); });
+}
+
+enum : char {
+    /// Binary log header frame, which starts each session.
+    LogFrameHeader = 'H',
+    /// Binary log format frame, which precedes the first message with that format.
+    LogFrameFormat = 'F',
+    /// Binary log message frame.
+    LogFrameMsg = 'M'
+};
+
+/// Append a binary log header frame to out.
+TOOLBOX_API void put_log_header(std::string& out);
+
+/// Append a binary log format frame to out.
+TOOLBOX_API void put_log_format(std::string& out, std::uint32_t id, const LogFormat& fmt);
+
+/// Append a binary log message frame to out.
+///
+/// \param out The output string.
+/// \param t The time of the message.
+/// \param level The log level.
+/// \param tid The thread id.
+/// \param id The format id, or zero if the payload is preformatted text.
+/// \param payload The encoded arguments or text.
+TOOLBOX_API void put_log_msg(std::string& out, WallTime t, int level, int tid, std::uint32_t id,
+                             std::string_view payload);
+
+/// LogDecoder converts a binary log, as written by an AsyncLogger, to text.
+///
+/// Frames are in host byte order. Each frame starts with its size and kind, followed by:
+///  - Header: "TBLOG" and a version number.
+///  - Format: id, line, and the file name, format string and argument type codes, each with a
+///    32-bit length prefix.
+///  - Message: nanoseconds since epoch, level, thread id, format id and payload.
+class TOOLBOX_API LogDecoder {
+  public:
+    LogDecoder();
+    ~LogDecoder();
+
+    // Copy.
+    LogDecoder(const LogDecoder&) = delete;
+    LogDecoder& operator=(const LogDecoder&) = delete;
+
+    // Move.
+    LogDecoder(LogDecoder&&);
+    LogDecoder& operator=(LogDecoder&&);
+
+    /// Decode the complete frames in buf, appending one line per message to out.
+    ///
+    /// \return the number of bytes decoded, excluding any trailing partial frame.
+    /// \throw std::runtime_error if the log is malformed.
+    std::size_t decode(std::string_view buf, std::string& out);
+
+  private:
+    struct Format {
+        std::string fmt, types;
+    };
+    bool header_{false};
+    std::unordered_map<std::uint32_t, Format> formats_;
+};
+
+} // namespace sys
+} // namespace toolbox
+
+// clang-format off
+#define TOOLBOX_LOGF(LEVEL, FMT, ...)                                                              \
+    (toolbox::is_log_level(LEVEL)                                                                  \
+     && (toolbox::write_logf([]() constexpr { return toolbox::LogSite{FMT, __FILE__, __LINE__}; }, \
+                             LEVEL, ##__VA_ARGS__), true))
+// clang-format on
+
+#endif // TOOLBOX_SYS_LOGFORMAT_HPP
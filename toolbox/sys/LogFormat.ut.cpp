@@ -0,0 +1,175 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "LogFormat.hpp"
+
+#include <toolbox/util/Finally.hpp>
+#include <toolbox/util/TempDir.ut.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+using namespace toolbox;
+
+namespace {
+
+enum class Side : char { Buy = 'B', Sell = 'S' };
+
+int last_level{};
+string last_msg{};
+
+void test_logger(int level, string_view msg)
+{
+    last_level = level;
+    last_msg.assign(msg.data(), msg.size());
+}
+
+template <typename... ArgsT>
+string format(string_view fmt, const ArgsT&... args)
+{
+    string buf(log_args_size<ArgsT...>(args...), '\0');
+    encode_log_args<ArgsT...>(buf.data(), args...);
+    string out;
+    BOOST_TEST(format_log_args(out, fmt, LogArgTypes<ArgsT...>::Value, buf));
+    return out;
+}
+
+using test::TempFile;
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(LogFormatSuite)
+
+BOOST_AUTO_TEST_CASE(LogPlaceholdersCase)
+{
+    static_assert(log_placeholders("") == 0);
+    static_assert(log_placeholders("foo") == 0);
+    static_assert(log_placeholders("{}") == 1);
+    static_assert(log_placeholders("{} {}") == 2);
+    static_assert(log_placeholders("{{}} {}") == 1);
+    static_assert(log_placeholders("{{{}}}") == 1);
+}
+
+BOOST_AUTO_TEST_CASE(LogArgTypesCase)
+{
+    BOOST_TEST(string_view{LogArgTypes<>::Value} == "");
+    BOOST_TEST((string_view{LogArgTypes<bool, char, int8_t, uint16_t, int, uint64_t>::Value}
+                == "?ccHiQ"));
+    BOOST_TEST((string_view{LogArgTypes<signed char, unsigned char, uint8_t, int16_t>::Value}
+                == "ccch"));
+    BOOST_TEST(
+        (string_view{LogArgTypes<float, double, const char*, string_view, string, Side>::Value}
+         == "fdsssc"));
+}
+
+BOOST_AUTO_TEST_CASE(LogFormatArgsCase)
+{
+    BOOST_TEST(format("foo") == "foo");
+    BOOST_TEST(format("{{}} {}", 1) == "{} 1");
+    // Character types are formatted as characters, as they are by operator<<().
+    BOOST_TEST(format("{} {} {} {}", true, 'x', int8_t{'y'}, uint8_t{'z'}) == "1 x y z");
+    BOOST_TEST(format("{} {}", int16_t{-1}, uint16_t{65535}) == "-1 65535");
+    BOOST_TEST(format("{}/{}", numeric_limits<int64_t>::min(), numeric_limits<uint64_t>::max())
+               == "-9223372036854775808/18446744073709551615");
+    BOOST_TEST(format("{} {}", 1.5F, 0.25) == "1.5 0.25");
+    const char* null{nullptr};
+    BOOST_TEST(format("[{}] [{}] [{}]", "foo"sv, string{"bar"}, null) == "[foo] [bar] []");
+    BOOST_TEST(format("{}", Side::Sell) == "S");
+
+    string out;
+    // Too few arguments.
+    BOOST_TEST(!format_log_args(out, "{} {}", "i", "\1\0\0\0"sv));
+    // Truncated argument.
+    BOOST_TEST(!format_log_args(out, "{}", "q", "\1\0\0\0"sv));
+}
+
+BOOST_AUTO_TEST_CASE(LogFormatSyncCase)
+{
+    auto prev_level = set_log_level(Log::Info);
+    auto prev_logger = set_logger(test_logger);
+    // clang-format off
+    const auto finally = make_finally([prev_level, prev_logger]() noexcept {
+        set_log_level(prev_level);
+        set_logger(prev_logger);
+    });
+    // clang-format on
+
+    TOOLBOX_LOGF(Log::Warning, "foo {} {}", 101, "bar");
+    BOOST_TEST(last_level == Log::Warning);
+    BOOST_TEST(last_msg == "foo 101 bar");
+
+    // This should not be logged.
+    TOOLBOX_LOGF(Log::Debug, "baz");
+    BOOST_TEST(last_msg == "foo 101 bar");
+}
+
+BOOST_AUTO_TEST_CASE(LogFormatAsyncCase)
+{
+    TempFile tmp;
+    AsyncLogger logger{{1 << 16, Seconds{60}, tmp.fd(), false, {"logger"}}};
+    TOOLBOX_LOGF(Log::Warning, "foo {} {}", 101, "bar");
+    logger.flush();
+    const auto text = tmp.read();
+    BOOST_TEST(text.find(" W ") != string::npos);
+    BOOST_TEST(text.find("]: foo 101 bar\n") != string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(LogFormatBinaryCase)
+{
+    TempFile tmp;
+    {
+        AsyncLogger logger{{1 << 16, Seconds{60}, tmp.fd(), true, {"logger"}}};
+        for (int i{0}; i < 3; ++i) {
+            TOOLBOX_LOGF(Log::Warning, "foo {} {}", i, Side::Buy);
+        }
+        logger.write(Log::Info, "bar");
+    }
+    const auto bin = tmp.read();
+
+    // Decode in two parts to exercise partial frames.
+    LogDecoder decoder;
+    string out;
+    auto n = decoder.decode(string_view{bin}.substr(0, bin.size() / 2), out);
+    n += decoder.decode(string_view{bin}.substr(n), out);
+    BOOST_TEST(n == bin.size());
+    BOOST_TEST(out.find("]: foo 0 B\n") != string::npos);
+    BOOST_TEST(out.find("]: foo 1 B\n") != string::npos);
+    BOOST_TEST(out.find("]: foo 2 B\n") != string::npos);
+    BOOST_TEST(out.find(" I ") != string::npos);
+    BOOST_TEST(out.find("]: bar\n") != string::npos);
+
+    // Frames must follow a header.
+    string hdr;
+    put_log_header(hdr);
+    BOOST_CHECK_THROW(LogDecoder{}.decode(string_view{bin}.substr(hdr.size()), out), runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(LogFormatLongCase)
+{
+    // Strings in format frames are not limited to 64KiB.
+    const string text(70000, 'x');
+    const string fmt{text + " {}"};
+    const LogFormat format{fmt, "i", __FILE__, __LINE__};
+    string bin;
+    put_log_header(bin);
+    put_log_format(bin, 1, format);
+    put_log_msg(bin, WallClock::now(), Log::Info, 1, 1, "\1\0\0\0"sv);
+    string out;
+    BOOST_TEST(LogDecoder{}.decode(bin, out) == bin.size());
+    BOOST_TEST(out.find("]: " + text + " 1\n") != string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -19,10 +19,50 @@
 #include <toolbox/sys/Error.hpp>
 #include <toolbox/util/Tokeniser.hpp>
 
+#include <atomic>
+
+#include <pthread.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
 namespace toolbox {
 inline namespace sys {
 using namespace std;
 namespace {
+// The gettid() function is a Linux-specific function call.
+#if defined(__linux__)
+inline pid_t gettid()
+{
+    return syscall(SYS_gettid);
+}
+#else
+inline pid_t gettid()
+{
+    return getpid();
+}
+#endif
+
+/// Incremented in the child process after fork(), so that the forking thread's cached id, which
+/// the child inherits, is refreshed.
+atomic<unsigned> fork_gen_{0};
+
+struct AtFork {
+    AtFork() noexcept
+    {
+        pthread_atfork(nullptr, nullptr, []() { fork_gen_.fetch_add(1, memory_order_relaxed); });
+    }
+} at_fork_;
+
+struct TidCache {
+    unsigned gen{~0U};
+    int tid{0};
+};
+
+thread_local TidCache tid_cache_;
+
 pair<int, int> split_range(string_view s) noexcept
 {
     auto [first, last] = split_pair(s, '-');
@@ -63,5 +103,15 @@ void set_thread_attrs(const ThreadConfig& config)
     }
 }
 
+int thread_id() noexcept
+{
+    auto& cache = tid_cache_;
+    if (const auto gen = fork_gen_.load(memory_order_relaxed); gen != cache.gen) {
+        cache.tid = static_cast<int>(gettid());
+        cache.gen = gen;
+    }
+    return cache.tid;
+}
+
 } // namespace sys
 } // namespace toolbox
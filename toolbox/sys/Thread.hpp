@@ -64,6 +64,10 @@ TOOLBOX_API cpu_set_t parse_cpu_set(std::string_view s) noexcept;
 /// \param config The configuration.
 TOOLBOX_API void set_thread_attrs(const ThreadConfig& config);
 
+/// Returns the calling thread's id, or the process id on platforms without gettid(). The id is
+/// cached per thread to avoid a system call, and is refreshed in the child process after fork().
+TOOLBOX_API int thread_id() noexcept;
+
 } // namespace sys
 } // namespace toolbox
 
@@ -18,6 +18,8 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <thread>
+
 using namespace std;
 using namespace toolbox;
 
@@ -46,4 +48,17 @@ BOOST_AUTO_TEST_CASE(ThreadParseCpuSetCase)
     BOOST_TEST(to_bitset(parse_cpu_set("0-3,5,6,8-11"sv)) == 0b111101101111);
 }
 
+BOOST_AUTO_TEST_CASE(ThreadIdCase)
+{
+    const auto tid = thread_id();
+    BOOST_TEST(tid > 0);
+    BOOST_TEST(thread_id() == tid);
+    int other{0};
+    thread t{[&other]() { other = thread_id(); }};
+    t.join();
+    BOOST_TEST(other > 0);
+    // Each thread has its own id.
+    BOOST_TEST(other != tid);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
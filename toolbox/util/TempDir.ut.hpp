@@ -0,0 +1,121 @@
+// The Reactive C++ Toolbox.
+// Copyright (C) 2013-2019 Swirly Cloud Limited
+// Copyright (C) 2020 Reactive Markets Limited
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef TOOLBOX_UTIL_TEMPDIR_UT_HPP
+#define TOOLBOX_UTIL_TEMPDIR_UT_HPP
+
+// Temporary-file fixtures shared by the tests that need a file system.
+
+#include <toolbox/io/File.hpp>
+#include <toolbox/util/Path.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace toolbox {
+inline namespace util {
+namespace test {
+
+/// Private directory that is removed, with everything in it, when the fixture is destroyed.
+///
+/// Cleanup runs from the destructor, so files are not leaked when a BOOST_REQUIRE fails.
+class TempDir {
+  public:
+    TempDir()
+    {
+        char tmpl[] = "/tmp/tb-test-XXXXXX";
+        if (!::mkdtemp(tmpl)) {
+            throw std::system_error{make_sys_error(errno), "mkdtemp"};
+        }
+        dir_ = tmpl;
+    }
+    ~TempDir()
+    {
+        std::error_code ec;
+        std::experimental::filesystem::remove_all(dir_, ec);
+    }
+
+    // Copy.
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+
+    // Move.
+    TempDir(TempDir&&) = delete;
+    TempDir& operator=(TempDir&&) = delete;
+
+    const std::string& dir() const noexcept { return dir_; }
+    /// Returns the path of the named file in the directory.
+    std::string path(std::string_view name) const
+    {
+        std::string s{dir_};
+        s += '/';
+        s += name;
+        return s;
+    }
+    bool exists(std::string_view name) const { return ::access(path(name).c_str(), F_OK) == 0; }
+    /// Returns the contents of the named file.
+    std::string read(std::string_view name) const
+    {
+        std::ifstream is{path(name)};
+        return {std::istreambuf_iterator<char>{is}, std::istreambuf_iterator<char>{}};
+    }
+    /// Returns the lines of the named file, without line terminators.
+    std::vector<std::string> lines(std::string_view name) const
+    {
+        std::vector<std::string> v;
+        std::ifstream is{path(name)};
+        for (std::string line; std::getline(is, line);) {
+            v.push_back(line);
+        }
+        return v;
+    }
+
+  private:
+    std::string dir_;
+};
+
+/// Open file in a TempDir, for tests that write through a file descriptor.
+class TempFile {
+  public:
+    TempFile()
+    : path_{dir_.path("file")}
+    , fh_{os::open(path_.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR)}
+    {
+    }
+
+    int fd() const noexcept { return fh_.get(); }
+    const std::string& path() const noexcept { return path_; }
+    std::string read() const { return dir_.read("file"); }
+    std::vector<std::string> lines() const { return dir_.lines("file"); }
+
+  private:
+    // Declared first so that the file is closed before the directory is removed.
+    TempDir dir_;
+    std::string path_;
+    FileHandle fh_;
+};
+
+} // namespace test
+} // namespace util
+} // namespace toolbox
+
+#endif // TOOLBOX_UTIL_TEMPDIR_UT_HPP